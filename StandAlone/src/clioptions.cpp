@@ -74,6 +74,15 @@ CliOptions::CliOptions():
                                    "PATH", "");
     this->addOption(*this->m_vcamPathOpt);
 
+    this->m_traceOpt =
+            new QCommandLineOption(QString("trace"),
+                                   QObject::tr("Record the path of the frames "
+                                               "through the pipeline, and save "
+                                               "it to FILE on exit, in Chrome "
+                                               "trace format."),
+                                   "FILE", "");
+    this->addOption(*this->m_traceOpt);
+
     this->process(*QCoreApplication::instance());
 
     // Set path for loading user settings.
@@ -100,6 +109,7 @@ CliOptions::~CliOptions()
     delete this->m_pluginPathsOpt;
     delete this->m_blackListOpt;
     delete this->m_vcamPathOpt;
+    delete this->m_traceOpt;
 }
 
 QCommandLineOption CliOptions::configPathOpt() const
@@ -132,6 +142,11 @@ QCommandLineOption CliOptions::vcamPathOpt() const
     return *this->m_vcamPathOpt;
 }
 
+QCommandLineOption CliOptions::traceOpt() const
+{
+    return *this->m_traceOpt;
+}
+
 QString CliOptions::convertToAbsolute(const QString &path) const
 {
     if (!QDir::isRelativePath(path))
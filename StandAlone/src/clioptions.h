@@ -34,6 +34,7 @@ class CliOptions: public QCommandLineParser
         QCommandLineOption pluginPathsOpt() const;
         QCommandLineOption blackListOpt() const;
         QCommandLineOption vcamPathOpt() const;
+        QCommandLineOption traceOpt() const;
 
     private:
         QCommandLineOption *m_configPathOpt;
@@ -42,6 +43,7 @@ class CliOptions: public QCommandLineParser
         QCommandLineOption *m_pluginPathsOpt;
         QCommandLineOption *m_blackListOpt;
         QCommandLineOption *m_vcamPathOpt;
+        QCommandLineOption *m_traceOpt;
 
         QString convertToAbsolute(const QString &path) const;
 };
@@ -34,6 +34,7 @@
 #include <akutils.h>
 #include <akcaps.h>
 #include <akvideocaps.h>
+#include <aktracer.h>
 
 #include "mediatools.h"
 #include "videodisplay.h"
@@ -88,6 +89,9 @@ MediaTools::MediaTools(QObject *parent):
 {
     this->d = new MediaToolsPrivate;
 
+    if (this->d->m_cliOptions.isSet(this->d->m_cliOptions.traceOpt()))
+        AkTracer::setEnabled(true);
+
     // Initialize environment.
     this->d->m_trayIcon = new QSystemTrayIcon(QApplication::windowIcon(), this);
     this->d->m_engine = new QQmlApplicationEngine();
@@ -105,9 +109,19 @@ MediaTools::MediaTools(QObject *parent):
     this->d->m_virtualCamera = AkElement::create("VirtualCamera");
 
     if (this->d->m_virtualCamera) {
-        AkElement::link(this->d->m_videoEffects.data(),
-                        this->d->m_virtualCamera.data(),
-                        Qt::DirectConnection);
+        // A late frame is useless for a live client, skip it and catch up.
+        // VideoEffects is not an element, so AkElement::link() would call
+        // iStream() directly, send the frames through operator () instead,
+        // where late frames are dropped.
+        this->d->m_virtualCamera->setFrameDropPolicy(AkElement::FrameDropPolicy_Late);
+        auto virtualCamera = this->d->m_virtualCamera.data();
+        QObject::connect(this->d->m_videoEffects.data(),
+                         &VideoEffects::oStream,
+                         virtualCamera,
+                         [virtualCamera] (const AkPacket &packet) {
+                            (*virtualCamera)(packet);
+                         },
+                         Qt::DirectConnection);
         QObject::connect(this->d->m_virtualCamera.data(),
                          SIGNAL(stateChanged(AkElement::ElementState)),
                          this,
@@ -206,6 +220,14 @@ MediaTools::~MediaTools()
 {
     this->saveConfigs();
     delete this->d->m_engine;
+
+    if (this->d->m_cliOptions.isSet(this->d->m_cliOptions.traceOpt())) {
+        auto traceFile =
+                this->d->m_cliOptions.value(this->d->m_cliOptions.traceOpt());
+        AkTracer::setEnabled(false);
+        AkTracer::save(traceFile);
+    }
+
     delete this->d;
 }
 
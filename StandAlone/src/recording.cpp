@@ -69,6 +69,8 @@ Recording::Recording(QQmlApplicationEngine *engine, QObject *parent):
     this->d->m_record = AkElement::create("MultiSink");
 
     if (this->d->m_record) {
+        // Every frame must end in the recording, no matter how late it is.
+        this->d->m_record->setFrameDropPolicy(AkElement::FrameDropPolicy_Never);
         QObject::connect(this->d->m_record.data(),
                          SIGNAL(outputFormatChanged(const QString &)),
                          this,
@@ -438,7 +440,7 @@ void Recording::savePhoto(const QString &fileName)
 
 AkPacket Recording::iStream(const AkPacket &packet)
 {
-    if (packet.caps().mimeType() == "video/x-raw") {
+    if (packet.caps().type() == AkCaps::CapsVideo) {
         this->d->m_mutex.lock();
         this->d->m_curPacket = packet;
         this->d->m_mutex.unlock();
@@ -21,6 +21,7 @@
 #include <QQuickWindow>
 #include <QSGSimpleTextureNode>
 #include <akutils.h>
+#include <aktracer.h>
 
 #include "videodisplay.h"
 
@@ -28,10 +29,14 @@ class VideoDisplayPrivate
 {
     public:
         QImage m_frame;
+        qint64 m_id;
+        qint64 m_pts;
         QMutex m_mutex;
         bool m_fillDisplay;
 
         VideoDisplayPrivate():
+            m_id(-1),
+            m_pts(0),
             m_fillDisplay(false)
         {
         }
@@ -58,6 +63,7 @@ QSGNode *VideoDisplay::updatePaintNode(QSGNode *oldNode,
                                        QQuickItem::UpdatePaintNodeData *updatePaintNodeData)
 {
     Q_UNUSED(updatePaintNodeData)
+    AK_TRACE_SCOPE("display", "VideoDisplay::updatePaintNode");
 
     this->d->m_mutex.lock();
 
@@ -67,6 +73,8 @@ QSGNode *VideoDisplay::updatePaintNode(QSGNode *oldNode,
         return nullptr;
     }
 
+    AK_TRACE_SET_PACKET(this->d->m_id, this->d->m_pts);
+
     auto frame = this->d->m_frame.format() == QImage::Format_ARGB32?
                      this->d->m_frame.copy():
                      this->d->m_frame.convertToFormat(QImage::Format_ARGB32);
@@ -124,8 +132,11 @@ QSGNode *VideoDisplay::updatePaintNode(QSGNode *oldNode,
 
 void VideoDisplay::iStream(const AkPacket &packet)
 {
+    AK_TRACE_PACKET_SCOPE("display", "VideoDisplay::iStream", packet);
     this->d->m_mutex.lock();
     this->d->m_frame = AkUtils::packetToImage(packet);
+    this->d->m_id = packet.id();
+    this->d->m_pts = packet.pts();
     this->d->m_mutex.unlock();
 
     QMetaObject::invokeMethod(this, "update");
@@ -17,40 +17,119 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <memory>
+#include <QMetaProperty>
 #include <QMutex>
 #include <QSettings>
+#include <QThread>
+#include <QWaitCondition>
 #include <QQuickItem>
 #include <QQmlContext>
 #include <QQmlProperty>
 #include <QQmlApplicationEngine>
 #include <akpacket.h>
+#include <aktracer.h>
+#include <akframedropper.h>
+#include <akpointoperator.h>
+#include <akpipelinedchain.h>
+#include <akframedispatcher.h>
 
 #include "videoeffects.h"
 
+// The chain of effects used by iStream(). A chain is never modified once
+// published, every change builds a new one.
+//
+// The chain runs its own instances of the effects, copied from the ones the
+// user edits (m_sources), so the frames still going through a replaced chain
+// never share an effect with the new one.
+struct VideoEffectsChain
+{
+    QList<AkElement *> m_sources;
+    QList<AkElementPtr> m_effects;
+    QSharedPointer<AkPipelinedChain> m_pipelinedChain;
+    QSharedPointer<AkFrameDispatcher> m_frameDispatcher;
+
+    ~VideoEffectsChain();
+};
+
+using VideoEffectsChainPtr = std::shared_ptr<VideoEffectsChain>;
+
+// Drains and frees the replaced chains, so neither the capture thread nor
+// the thread changing the effects waits for them.
+class VideoEffectsDisposer: public QThread
+{
+    public:
+        QMutex m_mutex;
+        QWaitCondition m_chainsAvailable;
+        QList<VideoEffectsChain *> m_chains;
+        bool m_run {true};
+
+        void dispose(VideoEffectsChain *chain);
+        void stop();
+
+    protected:
+        void run();
+};
+
 class VideoEffectsPrivate
 {
     public:
+        VideoEffects *self;
         QQmlApplicationEngine *m_engine;
         QStringList m_availableEffects;
-        AkElement::ElementState m_state;
+        QAtomicInt m_state;
         bool m_advancedMode;
         QList<AkElementPtr> m_effects;
         QStringList m_effectsId;
         AkElementPtr m_videoMux;
+        AkFrameDropper m_frameDropper;
+        bool m_pipelined;
+        bool m_parallelFrames;
+
+        // Only accessed with std::atomic_load() and std::atomic_store(). The
+        // last frame using a replaced chain hands it to the disposer.
+        VideoEffectsChainPtr m_chain;
+        VideoEffectsDisposer m_disposer;
+
+        // Serializes the changes to the effects, iStream() never takes it.
         QMutex m_mutex;
 
-        VideoEffectsPrivate():
+        VideoEffectsPrivate(VideoEffects *self):
+            self(self),
             m_engine(nullptr),
             m_state(AkElement::ElementStateNull),
-            m_advancedMode(false)
+            m_advancedMode(false),
+            m_pipelined(false),
+            m_parallelFrames(false)
+        {
+            this->m_disposer.setObjectName("VideoEffectsDisposer");
+            this->m_disposer.start();
+            this->m_chain = this->createChain();
+        }
+
+        ~VideoEffectsPrivate()
+        {
+            std::atomic_store(&this->m_chain, VideoEffectsChainPtr());
+            this->m_disposer.stop();
+        }
+
+        inline VideoEffectsChainPtr chain() const
         {
+            return std::atomic_load(&this->m_chain);
         }
+
+        inline VideoEffectsChainPtr createChain();
+        inline static void copyProperties(const AkElement *src, AkElement *dst);
+
+        // Must be called with the mutex locked, every time the effects or the
+        // processing mode change.
+        void updateChains();
 };
 
 VideoEffects::VideoEffects(QQmlApplicationEngine *engine, QObject *parent):
     QObject(parent)
 {
-    this->d = new VideoEffectsPrivate;
+    this->d = new VideoEffectsPrivate(this);
     this->setQmlEngine(engine);
     this->d->m_videoMux = AkElement::create("Multiplex");
 
@@ -136,7 +215,7 @@ QString VideoEffects::effectDescription(const QString &effectId) const
 
 AkElement::ElementState VideoEffects::state() const
 {
-    return this->d->m_state;
+    return AkElement::ElementState(this->d->m_state.load());
 }
 
 bool VideoEffects::advancedMode() const
@@ -144,6 +223,48 @@ bool VideoEffects::advancedMode() const
     return this->d->m_advancedMode;
 }
 
+AkElement::FrameDropPolicy VideoEffects::frameDropPolicy() const
+{
+    return this->d->m_frameDropper.dropPolicy();
+}
+
+qreal VideoEffects::maxLateness() const
+{
+    return this->d->m_frameDropper.maxLateness();
+}
+
+bool VideoEffects::pipelined() const
+{
+    return this->d->m_pipelined;
+}
+
+bool VideoEffects::parallelFrames() const
+{
+    return this->d->m_parallelFrames;
+}
+
+QVariantMap VideoEffects::stats() const
+{
+    auto chain = this->d->chain();
+    QVariantList effects;
+
+    for (const AkElementPtr &effect: chain->m_effects)
+        effects << effect->stats();
+
+    QVariantMap stats {
+        {"frameDropper", this->d->m_frameDropper.stats()},
+        {"effects"     , effects                        },
+    };
+
+    if (chain->m_pipelinedChain)
+        stats["pipelinedChain"] = chain->m_pipelinedChain->stats();
+
+    if (chain->m_frameDispatcher)
+        stats["frameDispatcher"] = chain->m_frameDispatcher->stats();
+
+    return stats;
+}
+
 bool VideoEffects::embedControls(const QString &where,
                                  int effectIndex,
                                  const QString &name) const
@@ -208,61 +329,43 @@ void VideoEffects::setEffects(const QStringList &effects, bool emitSignal)
     if (this->d->m_effectsId == effects)
         return;
 
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
-    this->d->m_mutex.lock();
-
-    if (!this->d->m_effects.isEmpty()) {
-        if (this->d->m_videoMux)
-            this->d->m_effects.last()->unlink(this->d->m_videoMux);
-
-        this->d->m_effects.clear();
-        this->d->m_effectsId.clear();
-    }
-
-    QStringList curEffects;
-    AkElementPtr prevEffect;
+    // The effects are loaded before locking, the current chain keeps
+    // running meanwhile.
+    QList<AkElementPtr> curEffects;
+    QStringList curEffectsId;
 
     for (const QString &effectId: effects)
         if (auto effect = AkElement::create(effectId)) {
-            this->d->m_effects << effect;
-            this->d->m_effectsId << effectId;
-            curEffects << effectId;
-
-            if (prevEffect)
-                prevEffect->link(effect, Qt::DirectConnection);
-            else
-                prevEffect = effect;
+            curEffects << effect;
+            curEffectsId << effectId;
         }
 
-    if (!this->d->m_effects.isEmpty() && this->d->m_videoMux)
-        this->d->m_effects.last()->link(this->d->m_videoMux, Qt::DirectConnection);
-
+    this->d->m_mutex.lock();
+    this->d->m_effects = curEffects;
+    this->d->m_effectsId = curEffectsId;
+    this->d->updateChains();
     this->d->m_mutex.unlock();
-    this->setState(state);
 
     if (emitSignal)
-        emit this->effectsChanged(curEffects);
+        emit this->effectsChanged(curEffectsId);
 }
 
 void VideoEffects::setState(AkElement::ElementState state)
 {
-    if (this->d->m_state == state)
+    if (this->d->m_state.load() == state)
         return;
 
     this->d->m_mutex.lock();
+    auto chain = this->d->chain();
 
     if (state == AkElement::ElementStatePlaying)
-        for (int i = this->d->m_effects.size() - 1; i >= 0; i--)
-            this->d->m_effects[i]->setState(state);
+        for (int i = chain->m_effects.size() - 1; i >= 0; i--)
+            chain->m_effects[i]->setState(state);
     else
-        for (AkElementPtr &effect: this->d->m_effects)
+        for (AkElementPtr &effect: chain->m_effects)
             effect->setState(state);
 
-    this->d->m_state = state;
+    this->d->m_state.store(state);
 
     this->d->m_mutex.unlock();
 
@@ -278,6 +381,48 @@ void VideoEffects::setAdvancedMode(bool advancedMode)
     emit this->advancedModeChanged(advancedMode);
 }
 
+void VideoEffects::setFrameDropPolicy(AkElement::FrameDropPolicy frameDropPolicy)
+{
+    if (this->d->m_frameDropper.dropPolicy() == frameDropPolicy)
+        return;
+
+    this->d->m_frameDropper.setDropPolicy(frameDropPolicy);
+    emit this->frameDropPolicyChanged(frameDropPolicy);
+}
+
+void VideoEffects::setMaxLateness(qreal maxLateness)
+{
+    if (qFuzzyIsNull(this->d->m_frameDropper.maxLateness() - maxLateness))
+        return;
+
+    this->d->m_frameDropper.setMaxLateness(maxLateness);
+    emit this->maxLatenessChanged(this->d->m_frameDropper.maxLateness());
+}
+
+void VideoEffects::setPipelined(bool pipelined)
+{
+    if (this->d->m_pipelined == pipelined)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_pipelined = pipelined;
+    this->d->updateChains();
+    this->d->m_mutex.unlock();
+    emit this->pipelinedChanged(pipelined);
+}
+
+void VideoEffects::setParallelFrames(bool parallelFrames)
+{
+    if (this->d->m_parallelFrames == parallelFrames)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_parallelFrames = parallelFrames;
+    this->d->updateChains();
+    this->d->m_mutex.unlock();
+    emit this->parallelFramesChanged(parallelFrames);
+}
+
 void VideoEffects::resetEffects()
 {
     this->setEffects({});
@@ -293,6 +438,26 @@ void VideoEffects::resetAdvancedMode()
     this->setAdvancedMode(false);
 }
 
+void VideoEffects::resetFrameDropPolicy()
+{
+    this->setFrameDropPolicy(AkElement::FrameDropPolicy_Never);
+}
+
+void VideoEffects::resetMaxLateness()
+{
+    this->setMaxLateness(AkFrameDropper::defaultMaxLateness());
+}
+
+void VideoEffects::resetPipelined()
+{
+    this->setPipelined(false);
+}
+
+void VideoEffects::resetParallelFrames()
+{
+    this->setParallelFrames(false);
+}
+
 AkElementPtr VideoEffects::appendEffect(const QString &effectId, bool preview)
 {
     auto effect = AkElement::create(effectId);
@@ -303,34 +468,15 @@ AkElementPtr VideoEffects::appendEffect(const QString &effectId, bool preview)
     if (preview)
         effect->setProperty("preview", preview);
 
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
     this->d->m_mutex.lock();
-
-    if (!this->d->m_effects.isEmpty()) {
-        auto prevEffect = this->d->m_effects.last();
-
-        if (this->d->m_videoMux)
-            prevEffect->unlink(this->d->m_videoMux);
-
-        prevEffect->link(effect, Qt::DirectConnection);
-    }
-
-    if (this->d->m_videoMux)
-        effect->link(this->d->m_videoMux, Qt::DirectConnection);
-
     this->d->m_effects << effect;
 
     if (!preview)
         this->d->m_effectsId << effectId;
 
+    this->d->updateChains();
     this->d->m_mutex.unlock();
 
-    this->setState(state);
-
     if (!preview)
         emit this->effectsChanged(this->d->m_effectsId);
 
@@ -372,86 +518,29 @@ void VideoEffects::moveEffect(int from, int to)
         || to > this->d->m_effects.size())
         return;
 
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
     this->d->m_mutex.lock();
-
-    // Diconnect effect from list.
-    auto effect = this->d->m_effects.value(from);
-    auto prev = this->d->m_effects.value(from - 1);
-    auto next = this->d->m_effects.value(from + 1);
-
-    if (!next)
-        next = this->d->m_videoMux;
-
-    if (prev) {
-        prev->unlink(effect);
-        prev->link(next, Qt::DirectConnection);
-    }
-
-    effect->unlink(next);
-
-    // Reconnect effect.
-    prev = this->d->m_effects.value(to - 1);
-    next = this->d->m_effects.value(to);
-
-    if (!next)
-        next = this->d->m_videoMux;
-
-    if (prev) {
-        prev->unlink(next);
-        prev->link(effect, Qt::DirectConnection);
-    }
-
-    effect->link(next, Qt::DirectConnection);
-
-    // Move the effect in the list.
     this->d->m_effects.move(from, to);
     this->d->m_effectsId.move(from, to);
 
+    this->d->updateChains();
     this->d->m_mutex.unlock();
-
-    this->setState(state);
     emit this->effectsChanged(this->d->m_effectsId);
 }
 
 void VideoEffects::removeEffect(int index)
 {
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
     this->d->m_mutex.lock();
 
     auto effect = this->d->m_effects.value(index);
 
     if (effect) {
-        auto next = this->d->m_effects.value(index + 1);
-
-        if (!next)
-            next = this->d->m_videoMux;
-
-        effect->unlink(next);
-
-        auto prev = this->d->m_effects.value(index - 1);
-
-        if (prev) {
-            prev->unlink(effect);
-            prev->link(next, Qt::DirectConnection);
-        }
-
         this->d->m_effects.removeAt(index);
         this->d->m_effectsId.removeAt(index);
     }
 
+    this->d->updateChains();
     this->d->m_mutex.unlock();
 
-    this->setState(state);
-
     if (effect)
         emit this->effectsChanged(this->d->m_effectsId);
 }
@@ -470,36 +559,16 @@ void VideoEffects::removeAllPreviews()
     if (!hasPreview)
         return;
 
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
     this->d->m_mutex.lock();
 
-    for (int i = 0; i < this->d->m_effects.size(); i++) {
-        auto effect = this->d->m_effects[i];
-
-        if (effect->property("preview").toBool()) {
-            auto prev = this->d->m_effects.value(i - 1);
-            auto next = this->d->m_effects.value(i + 1);
-
-            if (!next)
-                next = this->d->m_videoMux;
-
-            if (prev) {
-                prev->unlink(effect);
-                prev->link(next, Qt::DirectConnection);
-            }
-
-            effect->unlink(next);
+    for (int i = 0; i < this->d->m_effects.size(); i++)
+        if (this->d->m_effects[i]->property("preview").toBool()) {
             this->d->m_effects.removeAt(i);
             i--;
         }
-    }
 
+    this->d->updateChains();
     this->d->m_mutex.unlock();
-    this->setState(state);
 }
 
 void VideoEffects::updateEffects()
@@ -521,17 +590,31 @@ void VideoEffects::updateEffects()
 
 AkPacket VideoEffects::iStream(const AkPacket &packet)
 {
-    this->d->m_mutex.lock();
+    AK_TRACE_PACKET_SCOPE("effects", "VideoEffects::iStream", packet);
 
-    if (this->d->m_state == AkElement::ElementStatePlaying) {
-        if (this->d->m_effects.isEmpty()) {
-            if (this->d->m_videoMux)
-                (*this->d->m_videoMux)(packet);
-        } else
-            (*this->d->m_effects.first())(packet);
-    }
+    // Drop the frames that are already late before running the whole chain
+    // on them.
+    if (this->d->m_frameDropper.drop(packet))
+        return AkPacket();
 
-    this->d->m_mutex.unlock();
+    if (this->d->m_state.load() != AkElement::ElementStatePlaying)
+        return AkPacket();
+
+    // The chain can be replaced meanwhile, this frame keeps the one it took.
+    auto chain = this->d->chain();
+
+    // The effects are not linked between them, the chain is run here so the
+    // consecutive point operators can be fused in a single pass.
+    if (chain->m_frameDispatcher) {
+        chain->m_frameDispatcher->iStream(packet);
+    } else if (chain->m_pipelinedChain) {
+        chain->m_pipelinedChain->iStream(packet);
+    } else {
+        auto oPacket = AkPointOperator::run(chain->m_effects, packet);
+
+        if (oPacket && this->d->m_videoMux)
+            (*this->d->m_videoMux)(oPacket);
+    }
 
     return AkPacket();
 }
@@ -547,6 +630,35 @@ void VideoEffects::setQmlEngine(QQmlApplicationEngine *engine)
         engine->rootContext()->setContextProperty("VideoEffects", this);
 }
 
+void VideoEffects::updateEffectProperty()
+{
+    auto effect = qobject_cast<AkElement *>(this->sender());
+    int signal = this->senderSignalIndex();
+
+    if (!effect || signal < 0)
+        return;
+
+    // Send the change to the instance of the effect running in the chain.
+    this->d->m_mutex.lock();
+    auto chain = this->d->chain();
+    int index = chain->m_sources.indexOf(effect);
+
+    if (index >= 0) {
+        auto metaObject = effect->metaObject();
+
+        for (int i = 0; i < metaObject->propertyCount(); i++) {
+            auto property = metaObject->property(i);
+
+            if (property.notifySignalIndex() == signal
+                && property.isWritable())
+                property.write(chain->m_effects[index].data(),
+                               property.read(effect));
+        }
+    }
+
+    this->d->m_mutex.unlock();
+}
+
 void VideoEffects::advancedModeUpdated(bool advancedMode)
 {
     if (advancedMode || this->d->m_effects.size() < 1)
@@ -555,17 +667,11 @@ void VideoEffects::advancedModeUpdated(bool advancedMode)
     auto effect = this->d->m_effects.last();
     effect->setProperty("preview", QVariant());
 
-    auto state = this->state();
-
-    if (state != AkElement::ElementStateNull)
-        this->setState(AkElement::ElementStatePaused);
-
     this->d->m_mutex.lock();
     this->d->m_effects = {effect};
     this->d->m_effectsId = QStringList {effect->pluginId()};
+    this->d->updateChains();
     this->d->m_mutex.unlock();
-
-    this->setState(state);
     emit this->effectsChanged(this->d->m_effectsId);
 }
 
@@ -575,6 +681,12 @@ void VideoEffects::loadProperties()
 
     config.beginGroup("VideoEffects");
     this->setAdvancedMode(config.value("advancedMode").toBool());
+    this->setFrameDropPolicy(AkElement::FrameDropPolicy(config.value("frameDropPolicy",
+                                                                     AkElement::FrameDropPolicy_Never).toInt()));
+    this->setMaxLateness(config.value("maxLateness",
+                                      AkFrameDropper::defaultMaxLateness()).toReal());
+    this->setPipelined(config.value("pipelined", false).toBool());
+    this->setParallelFrames(config.value("parallelFrames", false).toBool());
 
     int size = config.beginReadArray("effects");
     QStringList effects;
@@ -597,6 +709,11 @@ void VideoEffects::loadProperties()
 
         config.endGroup();
     }
+
+    // Not every property notifies its changes, copy all of them to the chain.
+    this->d->m_mutex.lock();
+    this->d->updateChains();
+    this->d->m_mutex.unlock();
 }
 
 void VideoEffects::saveEffects(const QStringList &effects)
@@ -647,12 +764,162 @@ void VideoEffects::saveAdvancedMode(bool advancedMode)
     config.endGroup();
 }
 
+VideoEffectsChainPtr VideoEffectsPrivate::createChain()
+{
+    auto disposer = &this->m_disposer;
+
+    return VideoEffectsChainPtr(new VideoEffectsChain,
+                                [disposer] (VideoEffectsChain *chain) {
+        disposer->dispose(chain);
+    });
+}
+
+void VideoEffectsPrivate::copyProperties(const AkElement *src, AkElement *dst)
+{
+    auto metaObject = src->metaObject();
+
+    for (int i = 0; i < metaObject->propertyCount(); i++) {
+        auto property = metaObject->property(i);
+
+        if (property.isWritable())
+            property.write(dst, property.read(src));
+    }
+}
+
+void VideoEffectsPrivate::updateChains()
+{
+    // Build the new chain and prepare its effects, while the current one
+    // keeps processing frames.
+    auto chain = this->createChain();
+    auto state = AkElement::ElementState(this->m_state.load());
+    auto selfMetaObject = self->metaObject();
+    auto updateProperty =
+            selfMetaObject->method(selfMetaObject->indexOfSlot("updateEffectProperty()"));
+
+    for (const AkElementPtr &effect: this->m_effects) {
+        auto chainEffect = AkElement::create(effect->pluginId());
+
+        if (!chainEffect)
+            continue;
+
+        this->copyProperties(effect.data(), chainEffect.data());
+        chain->m_sources << effect.data();
+        chain->m_effects << chainEffect;
+
+        // Keep the instance in the chain up to date with the user changes.
+        auto metaObject = effect->metaObject();
+
+        for (int i = 0; i < metaObject->propertyCount(); i++) {
+            auto property = metaObject->property(i);
+
+            if (property.hasNotifySignal() && property.isWritable())
+                QObject::connect(effect.data(),
+                                 property.notifySignal(),
+                                 self,
+                                 updateProperty,
+                                 Qt::UniqueConnection);
+        }
+    }
+
+    for (int i = chain->m_effects.size() - 1; i >= 0; i--)
+        chain->m_effects[i]->setState(state);
+
+    // The frames are processed in parallel only if all effects are
+    // stateless, otherwise the pipelined mode is used if enabled.
+    if (this->m_parallelFrames
+        && !chain->m_effects.isEmpty()
+        && AkFrameDispatcher::canDispatch(chain->m_effects)) {
+        chain->m_frameDispatcher = QSharedPointer<AkFrameDispatcher>::create();
+        chain->m_frameDispatcher->setElements(chain->m_effects);
+
+        if (this->m_videoMux)
+            AkElement::link(chain->m_frameDispatcher.data(),
+                            this->m_videoMux.data(),
+                            Qt::DirectConnection);
+    } else if (this->m_pipelined && !chain->m_effects.isEmpty()) {
+        chain->m_pipelinedChain = QSharedPointer<AkPipelinedChain>::create();
+        chain->m_pipelinedChain->setElements(chain->m_effects);
+
+        if (this->m_videoMux)
+            AkElement::link(chain->m_pipelinedChain.data(),
+                            this->m_videoMux.data(),
+                            Qt::DirectConnection);
+    }
+
+    // The next frame takes the new chain. The old one is released by the
+    // last frame still using it, and then drained and freed by the disposer.
+    std::atomic_store(&this->m_chain, chain);
+}
+
+// Sends the frames still queued in the chain, and stops its effects.
+VideoEffectsChain::~VideoEffectsChain()
+{
+    if (this->m_frameDispatcher)
+        this->m_frameDispatcher->flush();
+
+    if (this->m_pipelinedChain)
+        this->m_pipelinedChain->flush();
+
+    for (const AkElementPtr &effect: this->m_effects)
+        effect->setState(AkElement::ElementStateNull);
+}
+
+void VideoEffectsDisposer::dispose(VideoEffectsChain *chain)
+{
+    this->m_mutex.lock();
+
+    // The disposer is gone, only at exit.
+    if (!this->m_run) {
+        this->m_mutex.unlock();
+        delete chain;
+
+        return;
+    }
+
+    this->m_chains << chain;
+    this->m_chainsAvailable.wakeAll();
+    this->m_mutex.unlock();
+}
+
+void VideoEffectsDisposer::stop()
+{
+    this->m_mutex.lock();
+    this->m_run = false;
+    this->m_chainsAvailable.wakeAll();
+    this->m_mutex.unlock();
+    this->wait();
+}
+
+void VideoEffectsDisposer::run()
+{
+    forever {
+        this->m_mutex.lock();
+
+        while (this->m_run && this->m_chains.isEmpty())
+            this->m_chainsAvailable.wait(&this->m_mutex);
+
+        if (this->m_chains.isEmpty()) {
+            this->m_mutex.unlock();
+
+            break;
+        }
+
+        auto chain = this->m_chains.takeFirst();
+        this->m_mutex.unlock();
+        delete chain;
+    }
+}
+
 void VideoEffects::saveProperties()
 {
     QSettings config;
 
     config.beginGroup("VideoEffects");
     config.setValue("advancedMode", this->advancedMode());
+    config.setValue("frameDropPolicy", int(this->frameDropPolicy()));
+    config.setValue("maxLateness", this->maxLateness());
+    config.setValue("pipelined", this->pipelined());
+    config.setValue("parallelFrames", this->parallelFrames());
 
     config.beginWriteArray("effects");
 
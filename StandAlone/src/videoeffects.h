@@ -49,6 +49,26 @@ class VideoEffects: public QObject
                WRITE setAdvancedMode
                RESET resetAdvancedMode
                NOTIFY advancedModeChanged)
+    Q_PROPERTY(AkElement::FrameDropPolicy frameDropPolicy
+               READ frameDropPolicy
+               WRITE setFrameDropPolicy
+               RESET resetFrameDropPolicy
+               NOTIFY frameDropPolicyChanged)
+    Q_PROPERTY(qreal maxLateness
+               READ maxLateness
+               WRITE setMaxLateness
+               RESET resetMaxLateness
+               NOTIFY maxLatenessChanged)
+    Q_PROPERTY(bool pipelined
+               READ pipelined
+               WRITE setPipelined
+               RESET resetPipelined
+               NOTIFY pipelinedChanged)
+    Q_PROPERTY(bool parallelFrames
+               READ parallelFrames
+               WRITE setParallelFrames
+               RESET resetParallelFrames
+               NOTIFY parallelFramesChanged)
 
     public:
         explicit VideoEffects(QQmlApplicationEngine *engine=nullptr,
@@ -61,6 +81,16 @@ class VideoEffects: public QObject
         Q_INVOKABLE QString effectDescription(const QString &effectId) const;
         Q_INVOKABLE AkElement::ElementState state() const;
         Q_INVOKABLE bool advancedMode() const;
+        Q_INVOKABLE AkElement::FrameDropPolicy frameDropPolicy() const;
+        Q_INVOKABLE qreal maxLateness() const;
+
+        // In pipelined mode every effect runs in its own thread.
+        Q_INVOKABLE bool pipelined() const;
+
+        // If all the effects are stateless, several frames are processed at
+        // the same time, this has priority over the pipelined mode.
+        Q_INVOKABLE bool parallelFrames() const;
+        Q_INVOKABLE QVariantMap stats() const;
         Q_INVOKABLE bool embedControls(const QString &where,
                                        int effectIndex,
                                        const QString &name="") const;
@@ -75,14 +105,26 @@ class VideoEffects: public QObject
         void oStream(const AkPacket &packet);
         void stateChanged(AkElement::ElementState state);
         void advancedModeChanged(bool advancedMode);
+        void frameDropPolicyChanged(AkElement::FrameDropPolicy frameDropPolicy);
+        void maxLatenessChanged(qreal maxLateness);
+        void pipelinedChanged(bool pipelined);
+        void parallelFramesChanged(bool parallelFrames);
 
     public slots:
         void setEffects(const QStringList &effects, bool emitSignal=true);
         void setState(AkElement::ElementState state);
         void setAdvancedMode(bool advancedMode);
+        void setFrameDropPolicy(AkElement::FrameDropPolicy frameDropPolicy);
+        void setMaxLateness(qreal maxLateness);
+        void setPipelined(bool pipelined);
+        void setParallelFrames(bool parallelFrames);
         void resetEffects();
         void resetState();
         void resetAdvancedMode();
+        void resetFrameDropPolicy();
+        void resetMaxLateness();
+        void resetPipelined();
+        void resetParallelFrames();
         AkElementPtr appendEffect(const QString &effectId, bool preview=false);
         void showPreview(const QString &effectId);
         void setAsPreview(int index, bool preview=false);
@@ -94,6 +136,7 @@ class VideoEffects: public QObject
         void setQmlEngine(QQmlApplicationEngine *engine=nullptr);
 
     private slots:
+        void updateEffectProperty();
         void advancedModeUpdated(bool advancedMode);
         void loadProperties();
         void saveEffects(const QStringList &effects);
@@ -22,6 +22,7 @@ VER_PAT = 0
 VERSION = $${VER_MAJ}.$${VER_MIN}.$${VER_PAT}
 
 isEmpty(BUILDDOCS): BUILDDOCS = 0
+isEmpty(BUILDBENCHMARKS): BUILDBENCHMARKS = 0
 isEmpty(QDOCTOOL): {
     unix: QDOCTOOL = $$[QT_INSTALL_BINS]/qdoc
     !unix: QDOCTOOL = $$[QT_INSTALL_LIBEXECS]/qdoc
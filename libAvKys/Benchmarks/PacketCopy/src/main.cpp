@@ -0,0 +1,210 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariant>
+#include <iostream>
+#include <akcaps.h>
+#include <akfrac.h>
+#include <akpacket.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
+
+// Reproduces the copy semantics of the old QObject based AkPacket: a new
+// private structure per copy, plus a deep copy of the caps, the data and the
+// timestamps. It's used as the baseline for the measurements.
+class DeepCopyPacketPrivate
+{
+    public:
+        AkCaps m_caps;
+        QVariant m_data;
+        QByteArray m_buffer;
+        qint64 m_pts;
+        AkFrac m_timeBase;
+        int m_index;
+        qint64 m_id;
+};
+
+class DeepCopyPacket: public QObject
+{
+    public:
+        DeepCopyPacket(const AkPacket &packet):
+            QObject()
+        {
+            this->d = new DeepCopyPacketPrivate();
+            this->d->m_caps = packet.caps();
+            this->d->m_data = packet.data();
+            this->d->m_buffer = packet.buffer();
+            this->d->m_pts = packet.pts();
+            this->d->m_timeBase = packet.timeBase();
+            this->d->m_index = packet.index();
+            this->d->m_id = packet.id();
+        }
+
+        DeepCopyPacket(const DeepCopyPacket &other):
+            QObject()
+        {
+            this->d = new DeepCopyPacketPrivate();
+            this->d->m_caps = other.d->m_caps;
+            this->d->m_data = other.d->m_data;
+            this->d->m_buffer = other.d->m_buffer;
+            this->d->m_pts = other.d->m_pts;
+            this->d->m_timeBase = other.d->m_timeBase;
+            this->d->m_index = other.d->m_index;
+            this->d->m_id = other.d->m_id;
+        }
+
+        ~DeepCopyPacket()
+        {
+            delete this->d;
+        }
+
+        qint64 pts() const
+        {
+            return this->d->m_pts;
+        }
+
+    private:
+        DeepCopyPacketPrivate *d;
+};
+
+template<typename T, typename F>
+inline QJsonObject measure(const QString &name,
+                           const T &source,
+                           int iterations,
+                           F copy)
+{
+    qint64 sink = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < iterations; i++)
+        sink += copy(source);
+
+    qint64 elapsed = timer.nsecsElapsed();
+
+    return QJsonObject {
+        {"name"      , name                       },
+        {"iterations", iterations                 },
+        {"nsPerCopy" , qreal(elapsed) / iterations},
+        {"checksum"  , double(sink)               }
+    };
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("packetcopy");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the cost of copying packets.");
+    parser.addHelpOption();
+    QCommandLineOption iterationsOpt("iterations",
+                                     "Number of copies per test.",
+                                     "N",
+                                     "1000000");
+    parser.addOption(iterationsOpt);
+    parser.process(app);
+
+    int iterations = qMax(1, parser.value(iterationsOpt).toInt());
+
+    AkVideoCaps caps;
+    caps.isValid() = true;
+    caps.format() = AkVideoCaps::Format_rgb24;
+    caps.bpp() = AkVideoCaps::bitsPerPixel(caps.format());
+    caps.width() = 640;
+    caps.height() = 480;
+    caps.fps() = AkFrac(30, 1);
+
+    AkVideoPacket videoPacket(caps,
+                              QByteArray(caps.pictureSize(), 0),
+                              0,
+                              AkFrac(1, 30),
+                              0,
+                              0);
+    AkPacket packet = videoPacket.toPacket();
+    DeepCopyPacket deepCopyPacket(packet);
+
+    QJsonArray results {
+        measure("DeepCopyPacket copy (baseline)",
+                deepCopyPacket,
+                iterations,
+                [] (const DeepCopyPacket &packet) {
+                    DeepCopyPacket copy(packet);
+
+                    return copy.pts() + 1;
+                }),
+        measure("AkPacket copy",
+                packet,
+                iterations,
+                [] (const AkPacket &packet) {
+                    AkPacket copy(packet);
+
+                    return copy.pts() + 1;
+                }),
+        measure("AkPacket move",
+                packet,
+                iterations,
+                [] (const AkPacket &packet) {
+                    AkPacket copy(packet);
+                    AkPacket moved(std::move(copy));
+
+                    return moved.pts() + 1;
+                }),
+        measure("AkVideoPacket copy",
+                videoPacket,
+                iterations,
+                [] (const AkVideoPacket &packet) {
+                    AkVideoPacket copy(packet);
+
+                    return copy.pts() + 1;
+                }),
+        measure("AkPacket to AkVideoPacket",
+                packet,
+                iterations,
+                [] (const AkPacket &packet) {
+                    AkVideoPacket copy(packet);
+
+                    return copy.pts() + 1;
+                }),
+        measure("AkVideoPacket to AkPacket",
+                videoPacket,
+                iterations,
+                [] (const AkVideoPacket &packet) {
+                    AkPacket copy = packet.toPacket();
+
+                    return copy.pts() + 1;
+                }),
+    };
+
+    QJsonObject report {
+        {"benchmark", "packetcopy"},
+        {"caps"     , caps.toString()},
+        {"results"  , results}
+    };
+
+    std::cout << QJsonDocument(report).toJson().toStdString();
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariant>
+#include <iostream>
+#include <akfrac.h>
+#include <aksimd.h>
+#include <akvideocaps.h>
+#include <akvideoconverter.h>
+#include <akvideopacket.h>
+
+#ifdef HAVE_FFMPEG
+extern "C"
+{
+    #include <libswscale/swscale.h>
+    #include <libavutil/imgutils.h>
+    #include <libavutil/pixdesc.h>
+}
+#endif
+
+struct ConversionCase
+{
+    AkVideoCaps::PixelFormat iFormat;
+    AkVideoCaps::PixelFormat oFormat;
+
+    // Equivalent formats in QImage and FFmpeg, the 32 bits formats are
+    // native endian words in AkVideoConverter and QImage, so the FFmpeg names
+    // are given for little endian machines.
+    QImage::Format iImageFormat;
+    QImage::Format oImageFormat;
+    const char *iAvFormat;
+    const char *oAvFormat;
+};
+
+static const QVector<ConversionCase> conversionCases = {
+    {AkVideoCaps::Format_yuyv422, AkVideoCaps::Format_argb   , QImage::Format_Invalid, QImage::Format_Invalid   , "yuyv422", "bgra"   },
+    {AkVideoCaps::Format_nv12   , AkVideoCaps::Format_argb   , QImage::Format_Invalid, QImage::Format_Invalid   , "nv12"   , "bgra"   },
+    {AkVideoCaps::Format_yuv420p, AkVideoCaps::Format_argb   , QImage::Format_Invalid, QImage::Format_Invalid   , "yuv420p", "bgra"   },
+    {AkVideoCaps::Format_argb   , AkVideoCaps::Format_yuv420p, QImage::Format_Invalid, QImage::Format_Invalid   , "bgra"   , "yuv420p"},
+    {AkVideoCaps::Format_argb   , AkVideoCaps::Format_yuyv422, QImage::Format_Invalid, QImage::Format_Invalid   , "bgra"   , "yuyv422"},
+    {AkVideoCaps::Format_argb   , AkVideoCaps::Format_rgb24  , QImage::Format_ARGB32 , QImage::Format_RGB888    , "bgra"   , "rgb24"  },
+    {AkVideoCaps::Format_rgb24  , AkVideoCaps::Format_argb   , QImage::Format_RGB888 , QImage::Format_ARGB32    , "rgb24"  , "bgra"   },
+    {AkVideoCaps::Format_argb   , AkVideoCaps::Format_abgr   , QImage::Format_ARGB32 , QImage::Format_RGBA8888  , "bgra"   , "rgba"   },
+    {AkVideoCaps::Format_argb   , AkVideoCaps::Format_gray   , QImage::Format_ARGB32 , QImage::Format_Grayscale8, "bgra"   , "gray"   },
+};
+
+static const QVector<QSize> frameSizes = {
+    {640, 480},
+    {1280, 720},
+    {1920, 1080},
+};
+
+template<typename F>
+inline QJsonObject measure(const QString &name,
+                           const QSize &size,
+                           int frames,
+                           F convert)
+{
+    // Warm up caches and buffer pools.
+    convert();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < frames; i++)
+        convert();
+
+    qint64 elapsed = timer.nsecsElapsed();
+    qreal pixels = qreal(size.width()) * size.height() * frames;
+
+    return QJsonObject {
+        {"name"      , name                                          },
+        {"frames"    , frames                                        },
+        {"fps"       , elapsed > 0? 1e9 * frames / elapsed: 0.0      },
+        {"nsPerPixel", elapsed / pixels                              }
+    };
+}
+
+static QByteArray randomFrame(int size)
+{
+    QByteArray frame(size, 0);
+    quint32 seed = 0x12345678;
+
+    for (char &byte: frame) {
+        seed = 1664525 * seed + 1013904223;
+        byte = char(seed >> 24);
+    }
+
+    return frame;
+}
+
+#ifdef HAVE_FFMPEG
+static QJsonObject measureSwscale(const ConversionCase &conversionCase,
+                                  const QSize &size,
+                                  int frames)
+{
+    AVPixelFormat iFormat = av_get_pix_fmt(conversionCase.iAvFormat);
+    AVPixelFormat oFormat = av_get_pix_fmt(conversionCase.oAvFormat);
+    SwsContext *context = sws_getContext(size.width(),
+                                         size.height(),
+                                         iFormat,
+                                         size.width(),
+                                         size.height(),
+                                         oFormat,
+                                         SWS_POINT,
+                                         nullptr,
+                                         nullptr,
+                                         nullptr);
+
+    if (!context)
+        return QJsonObject();
+
+    int iSize = av_image_get_buffer_size(iFormat,
+                                         size.width(),
+                                         size.height(),
+                                         1);
+    QByteArray iBuffer = randomFrame(iSize);
+    uint8_t *iData[4];
+    int iLineSize[4];
+    av_image_fill_arrays(iData,
+                         iLineSize,
+                         reinterpret_cast<const uint8_t *>(iBuffer.constData()),
+                         iFormat,
+                         size.width(),
+                         size.height(),
+                         1);
+    uint8_t *oData[4];
+    int oLineSize[4];
+    av_image_alloc(oData,
+                   oLineSize,
+                   size.width(),
+                   size.height(),
+                   oFormat,
+                   32);
+
+    QJsonObject result =
+            measure("sws_scale", size, frames, [&] () {
+                sws_scale(context,
+                          iData,
+                          iLineSize,
+                          0,
+                          size.height(),
+                          oData,
+                          oLineSize);
+            });
+
+    av_freep(&oData[0]);
+    sws_freeContext(context);
+
+    return result;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("videoconverter");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares AkVideoConverter with "
+                                     "QImage::convertToFormat and sws_scale.");
+    parser.addHelpOption();
+    QCommandLineOption framesOpt("frames",
+                                 "Number of frames converted per test.",
+                                 "N",
+                                 "100");
+    parser.addOption(framesOpt);
+    parser.process(app);
+
+    int frames = qMax(1, parser.value(framesOpt).toInt());
+    AkSimd::InstructionSet supported = AkSimd::supportedInstructionSet();
+    AkVideoConverter converter;
+    QJsonArray results;
+
+    for (const QSize &size: frameSizes)
+        for (const ConversionCase &conversionCase: conversionCases) {
+            AkVideoCaps caps;
+            caps.isValid() = true;
+            caps.format() = conversionCase.iFormat;
+            caps.bpp() = AkVideoCaps::bitsPerPixel(caps.format());
+            caps.width() = size.width();
+            caps.height() = size.height();
+            caps.fps() = AkFrac(30, 1);
+
+            AkVideoPacket packet(caps,
+                                 randomFrame(caps.pictureSize()),
+                                 0,
+                                 AkFrac(1, 30));
+            QJsonArray measures;
+
+            for (int i = AkSimd::InstructionSet_None; i <= supported; i++) {
+                auto instructionSet = AkSimd::InstructionSet(i);
+                AkSimd::setInstructionSet(instructionSet);
+                AkVideoCaps::PixelFormat oFormat = conversionCase.oFormat;
+                measures << measure("AkVideoConverter ("
+                                    + AkSimd::toString(instructionSet)
+                                    + ")",
+                                    size,
+                                    frames,
+                                    [&] () {
+                                        converter.convert(packet, oFormat);
+                                    });
+            }
+
+            AkSimd::resetInstructionSet();
+
+            if (conversionCase.iImageFormat != QImage::Format_Invalid) {
+                QImage image(size, conversionCase.iImageFormat);
+                QByteArray pixels = randomFrame(image.byteCount());
+                memcpy(image.bits(), pixels.constData(), size_t(pixels.size()));
+                QImage::Format oFormat = conversionCase.oImageFormat;
+                measures << measure("QImage::convertToFormat",
+                                    size,
+                                    frames,
+                                    [&] () {
+                                        image.convertToFormat(oFormat);
+                                    });
+            }
+
+#ifdef HAVE_FFMPEG
+            QJsonObject swscale = measureSwscale(conversionCase, size, frames);
+
+            if (!swscale.isEmpty())
+                measures << swscale;
+#endif
+
+            results << QJsonObject {
+                {"input"   , AkVideoCaps::pixelFormatToString(conversionCase.iFormat)},
+                {"output"  , AkVideoCaps::pixelFormatToString(conversionCase.oFormat)},
+                {"width"   , size.width()                                           },
+                {"height"  , size.height()                                          },
+                {"measures", measures                                               }
+            };
+        }
+
+    QJsonObject report {
+        {"benchmark"     , "videoconverter"                         },
+        {"instructionSet", AkSimd::toString(supported)              },
+        {"results"       , results                                  }
+    };
+
+    std::cout << QJsonDocument(report).toJson().toStdString();
+
+    return 0;
+}
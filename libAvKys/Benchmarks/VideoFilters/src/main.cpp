@@ -0,0 +1,375 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include <QVariant>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <akbufferpool.h>
+#include <akelement.h>
+#include <akfrac.h>
+#include <akscheduler.h>
+#include <aksimd.h>
+#include <akutils.h>
+#include <akvideocaps.h>
+#include <akvideopacket.h>
+
+// Number of distinct frames fed in a loop, so the filters that depend on the
+// previous frames see some motion.
+#define N_SOURCE_FRAMES 4
+
+static std::atomic<qint64> allocations(0);
+
+#ifdef __GLIBC__
+// Count all heap allocations, including the ones done by Qt and the plugins.
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t count, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void *__libc_memalign(size_t alignment, size_t size);
+
+    void *malloc(size_t size)
+    {
+        allocations++;
+
+        return __libc_malloc(size);
+    }
+
+    void *calloc(size_t count, size_t size)
+    {
+        allocations++;
+
+        return __libc_calloc(count, size);
+    }
+
+    void *realloc(void *ptr, size_t size)
+    {
+        allocations++;
+
+        return __libc_realloc(ptr, size);
+    }
+
+    // The buffer pool and the SIMD code allocate aligned memory.
+    int posix_memalign(void **ptr, size_t alignment, size_t size)
+    {
+        allocations++;
+
+        if (alignment % sizeof(void *) != 0
+            || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        auto data = __libc_memalign(alignment, size);
+
+        if (!data)
+            return ENOMEM;
+
+        *ptr = data;
+
+        return 0;
+    }
+
+    void *memalign(size_t alignment, size_t size)
+    {
+        allocations++;
+
+        return __libc_memalign(alignment, size);
+    }
+
+    void *aligned_alloc(size_t alignment, size_t size)
+    {
+        allocations++;
+
+        return __libc_memalign(alignment, size);
+    }
+}
+#else
+// Only the C++ allocations can be counted portably.
+void *operator new(size_t size)
+{
+    allocations++;
+
+    if (auto ptr = std::malloc(size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+static const QVector<QSize> frameSizes = {
+    {320, 240},
+    {640, 480},
+    {1280, 720},
+    {1920, 1080},
+    {3840, 2160},
+};
+
+// A gradient with some noise on top, always the same for a given seed.
+static AkPacket syntheticFrame(const QSize &size,
+                               int seed,
+                               AkVideoCaps::PixelFormat format)
+{
+    AkVideoCaps caps;
+    caps.isValid() = true;
+    caps.format() = AkVideoCaps::Format_argb;
+    caps.bpp() = AkVideoCaps::bitsPerPixel(caps.format());
+    caps.width() = size.width();
+    caps.height() = size.height();
+    caps.fps() = AkFrac(30, 1);
+
+    QByteArray buffer(caps.pictureSize(), 0);
+    auto pixels = reinterpret_cast<quint32 *>(buffer.data());
+    auto random = quint32(0x12345678 + seed);
+
+    for (int y = 0; y < size.height(); y++)
+        for (int x = 0; x < size.width(); x++) {
+            random = 1664525 * random + 1013904223;
+            int noise = int(random >> 27) - 16;
+            int r = qBound(0, 255 * x / size.width() + noise, 255);
+            int g = qBound(0, 255 * y / size.height() + noise, 255);
+            int b = qBound(0, (r + g) / 2 + 32 * seed - noise, 255);
+            *pixels++ = 0xff000000 | quint32(r << 16) | quint32(g << 8) | quint32(b);
+        }
+
+    AkVideoPacket packet(caps, buffer, seed, AkFrac(1, 30));
+
+    return AkUtils::convertVideo(packet, format).toPacket();
+}
+
+static QJsonObject measure(const AkElementPtr &element,
+                           const QSize &size,
+                           AkVideoCaps::PixelFormat format,
+                           int frames)
+{
+    QVector<AkPacket> packets;
+
+    for (int i = 0; i < N_SOURCE_FRAMES; i++)
+        packets << syntheticFrame(size, i, format);
+
+    // Warm up caches and buffer pools.
+    for (auto &packet: packets)
+        element->iStream(packet);
+
+    auto poolMisses = AkBufferPool::misses();
+    qint64 allocs = allocations;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < frames; i++) {
+        auto &packet = packets[i % N_SOURCE_FRAMES];
+        packet.pts() = N_SOURCE_FRAMES + i;
+        element->iStream(packet);
+    }
+
+    qint64 elapsed = timer.nsecsElapsed();
+    allocs = allocations - allocs;
+    poolMisses = AkBufferPool::misses() - poolMisses;
+    qreal pixels = qreal(size.width()) * size.height() * frames;
+
+    return QJsonObject {
+        {"width"             , size.width()},
+        {"height"            , size.height()},
+        {"frames"            , frames},
+        {"fps"               , elapsed > 0? 1e9 * frames / elapsed: 0.0},
+        {"nsPerPixel"        , elapsed / pixels},
+        {"allocsPerFrame"    , qreal(allocs) / frames},
+        {"poolMissesPerFrame", qreal(poolMisses) / frames}
+    };
+}
+
+// Sends frames to the element through operator (), as the virtual camera gets
+// them, with a stall in the middle. Only the frame after the stall must be
+// dropped.
+static bool dropsLateFrames(const AkElementPtr &element)
+{
+    auto framesDropped = [&element] () {
+        return element->stats()["frameDropper"].toMap()["framesDropped"].toLongLong();
+    };
+
+    auto policy = element->frameDropPolicy();
+    element->setFrameDropPolicy(AkElement::FrameDropPolicy_Late);
+    auto packet = syntheticFrame({320, 240}, 0, AkVideoCaps::Format_argb);
+    auto dropped = framesDropped();
+
+    for (int i = 0; i < N_SOURCE_FRAMES; i++) {
+        packet.pts() = i;
+        (*element)(packet);
+    }
+
+    bool ontimeDropped = framesDropped() != dropped;
+    QThread::msleep(500);
+    packet.pts() = N_SOURCE_FRAMES;
+    bool lateDropped = !(*element)(packet) && framesDropped() == dropped + 1;
+    element->setFrameDropPolicy(policy);
+
+    return !ontimeDropped && lateDropped;
+}
+
+int main(int argc, char *argv[])
+{
+    // Some filters draw text, which needs a GUI application, but not a screen.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("videofilters");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the throughput of every "
+                                     "VideoFilter plugin.");
+    parser.addHelpOption();
+    QCommandLineOption framesOpt("frames",
+                                 "Number of frames processed per test.",
+                                 "N",
+                                 "30");
+    parser.addOption(framesOpt);
+    QCommandLineOption pathsOpt({"p", "paths"},
+                                "Semi-colon separated list of paths to "
+                                "search for plugins.",
+                                "PATH1;PATH2;PATH3;...");
+    parser.addOption(pathsOpt);
+    QCommandLineOption pluginsOpt("plugins",
+                                  "Comma separated list of plugins to "
+                                  "measure, all if not set.",
+                                  "ID1,ID2,ID3,...");
+    parser.addOption(pluginsOpt);
+    QCommandLineOption formatOpt("format",
+                                 "Pixel format of the input frames.",
+                                 "FORMAT",
+                                 "argb");
+    parser.addOption(formatOpt);
+    QCommandLineOption checkDropsOpt("check-drops",
+                                     "Check that late frames are dropped, "
+                                     "fails if they aren't.");
+    parser.addOption(checkDropsOpt);
+    parser.process(app);
+
+    int frames = qMax(1, parser.value(framesOpt).toInt());
+    auto format = AkVideoCaps::pixelFormatFromString(parser.value(formatOpt));
+
+    if (format == AkVideoCaps::Format_none) {
+        std::cerr << "Invalid pixel format: "
+                  << parser.value(formatOpt).toStdString()
+                  << std::endl;
+
+        return -1;
+    }
+
+    if (parser.isSet(pathsOpt)) {
+        AkElement::setRecursiveSearch(true);
+        AkElement::setSearchPaths(parser.value(pathsOpt).split(';'));
+    }
+
+    auto plugins = AkElement::listPlugins("VideoFilter");
+    plugins.sort();
+
+    if (parser.isSet(pluginsOpt)) {
+        auto selected = parser.value(pluginsOpt).split(',');
+
+        for (auto it = plugins.begin(); it != plugins.end();)
+            if (selected.contains(*it))
+                it++;
+            else
+                it = plugins.erase(it);
+    }
+
+    QJsonArray results;
+    bool dropsChecked = true;
+
+    for (auto &plugin: plugins) {
+        auto element = AkElement::create(plugin);
+
+        if (!element) {
+            std::cerr << "Can't load " << plugin.toStdString() << std::endl;
+
+            continue;
+        }
+
+        element->setState(AkElement::ElementStatePlaying);
+        QJsonArray measures;
+
+        for (auto &size: frameSizes) {
+            std::cerr << plugin.toStdString()
+                      << " " << size.width() << "x" << size.height()
+                      << std::endl;
+            measures << measure(element, size, format, frames);
+        }
+
+        QJsonObject result {
+            {"plugin"  , plugin},
+            {"measures", measures}
+        };
+
+        if (parser.isSet(checkDropsOpt)) {
+            bool dropsLate = dropsLateFrames(element);
+            result["dropsLateFrames"] = dropsLate;
+
+            if (!dropsLate) {
+                std::cerr << plugin.toStdString()
+                          << " doesn't drop late frames"
+                          << std::endl;
+                dropsChecked = false;
+            }
+        }
+
+        element->setState(AkElement::ElementStateNull);
+        results << result;
+    }
+
+    QJsonObject report {
+        {"benchmark"     , "videofilters"                                     },
+        {"instructionSet", AkSimd::toString(AkSimd::instructionSet())         },
+        {"threads"       , AkScheduler::threadCount()                         },
+        {"format"        , AkVideoCaps::pixelFormatToString(format)           },
+#ifdef __GLIBC__
+        {"allocations"   , "malloc"                                           },
+#else
+        {"allocations"   , "new"                                              },
+#endif
+        {"results"       , results                                            }
+    };
+
+    std::cout << QJsonDocument(report).toJson().toStdString();
+
+    return dropsChecked? 0: 1;
+}
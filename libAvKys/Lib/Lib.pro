@@ -37,6 +37,19 @@ DEFINES += \
 HEADERS = \
     src/ak.h \
     src/akutils.h \
+    src/akbufferpool.h \
+    src/aksimd.h \
+    src/akscheduler.h \
+    src/aklatencyhistogram.h \
+    src/aktracer.h \
+    src/akqueuedlink.h \
+    src/akframedropper.h \
+    src/akpixelview.h \
+    src/akpointoperator.h \
+    src/akpipelinedchain.h \
+    src/akframedispatcher.h \
+    src/akvideoconverter.h \
+    src/akvideoscaler.h \
     src/akcaps.h \
     src/akcommons.h \
     src/akelement.h \
@@ -54,6 +67,18 @@ QT += qml
 SOURCES = \
     src/ak.cpp \
     src/akutils.cpp \
+    src/akbufferpool.cpp \
+    src/aksimd.cpp \
+    src/akscheduler.cpp \
+    src/aklatencyhistogram.cpp \
+    src/aktracer.cpp \
+    src/akqueuedlink.cpp \
+    src/akframedropper.cpp \
+    src/akpointoperator.cpp \
+    src/akpipelinedchain.cpp \
+    src/akframedispatcher.cpp \
+    src/akvideoconverter.cpp \
+    src/akvideoscaler.cpp \
     src/akcaps.cpp \
     src/akelement.cpp \
     src/akfrac.cpp \
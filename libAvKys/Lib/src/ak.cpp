@@ -67,6 +67,8 @@ class AkPrivate
             qRegisterMetaType<AkElement::ElementState>("AkElement::ElementState");
             qRegisterMetaType<AkElement::ElementState>("ElementState");
             qRegisterMetaTypeStreamOperators<AkElement::ElementState>("AkElement::ElementState");
+            qRegisterMetaType<AkElement::FrameDropPolicy>("AkElement::FrameDropPolicy");
+            qRegisterMetaType<AkElement::FrameDropPolicy>("FrameDropPolicy");
             qRegisterMetaType<AkFrac>("AkFrac");
             qRegisterMetaTypeStreamOperators<AkFrac>("AkFrac");
             qRegisterMetaType<AkPacket>("AkPacket");
@@ -256,29 +256,18 @@ AkAudioCaps::AkAudioCaps(const QString &caps)
 AkAudioCaps::AkAudioCaps(const AkCaps &caps)
 {
     this->d = new AkAudioCapsPrivate();
+    this->d->m_isValid = false;
+    this->d->m_format = SampleFormat_none;
+    this->d->m_bps = 0;
+    this->d->m_channels = 0;
+    this->d->m_rate = 0;
+    this->d->m_layout = Layout_none;
+    this->d->m_samples = 0;
+    this->d->m_align = false;
 
-    if (caps.mimeType() == "audio/x-raw") {
+    if (caps.type() == AkCaps::CapsAudio) {
         this->d->m_isValid = caps.isValid();
-
-        this->d->m_format = this->sampleFormatFromString(caps.property("format").toString());
-        this->d->m_bps = caps.property("bps").toInt();
-        this->d->m_channels = caps.property("channels").toInt();
-        this->d->m_rate = caps.property("rate").toInt();
-
-        QString layout = caps.property("layout").toString();
-        this->d->m_layout = ChannelLayouts::byDescription(layout)->layout;
-
-        this->d->m_samples = caps.property("samples").toInt();
-        this->d->m_align = caps.property("align").toBool();
-    } else {
-        this->d->m_isValid = false;
-        this->d->m_format = SampleFormat_none;
-        this->d->m_bps = 0;
-        this->d->m_channels = 0;
-        this->d->m_rate = 0;
-        this->d->m_layout = Layout_none;
-        this->d->m_samples = 0;
-        this->d->m_align = false;
+        this->update(caps);
     }
 }
 
@@ -334,28 +323,18 @@ AkAudioCaps &AkAudioCaps::operator =(const AkAudioCaps &other)
 
 AkAudioCaps &AkAudioCaps::operator =(const AkCaps &caps)
 {
-    if (caps.mimeType() == "audio/x-raw") {
-        this->d->m_isValid = caps.isValid();
+    this->d->m_isValid = false;
+    this->d->m_format = SampleFormat_none;
+    this->d->m_bps = 0;
+    this->d->m_channels = 0;
+    this->d->m_rate = 0;
+    this->d->m_layout = Layout_none;
+    this->d->m_samples = 0;
+    this->d->m_align = false;
 
-        this->d->m_format = this->sampleFormatFromString(caps.property("format").toString());
-        this->d->m_bps = caps.property("bps").toInt();
-        this->d->m_channels = caps.property("channels").toInt();
-        this->d->m_rate = caps.property("rate").toInt();
-
-        QString layout = caps.property("layout").toString();
-        this->d->m_layout = ChannelLayouts::byDescription(layout)->layout;
-
-        this->d->m_samples = caps.property("samples").toInt();
-        this->d->m_align = caps.property("align").toBool();
-    } else {
-        this->d->m_isValid = false;
-        this->d->m_format = SampleFormat_none;
-        this->d->m_bps = 0;
-        this->d->m_channels = 0;
-        this->d->m_rate = 0;
-        this->d->m_layout = Layout_none;
-        this->d->m_samples = 0;
-        this->d->m_align = false;
+    if (caps.type() == AkCaps::CapsAudio) {
+        this->d->m_isValid = caps.isValid();
+        this->update(caps);
     }
 
     return *this;
@@ -531,38 +510,53 @@ QString AkAudioCaps::toString() const
 
 AkAudioCaps &AkAudioCaps::update(const AkCaps &caps)
 {
-    if (caps.mimeType() != "audio/x-raw")
+    if (caps.type() != AkCaps::CapsAudio)
         return *this;
 
-    if (caps.contains("format"))
-        this->d->m_format = this->sampleFormatFromString(caps.property("format").toString());
+    // Read the raw fields directly, no string conversion needed.
+    auto &audioCaps = caps.audioCaps();
 
-    if (caps.contains("bps"))
-        this->d->m_bps = caps.property("bps").toInt();
+    if (audioCaps.fields & AkCaps::AudioCaps::Format)
+        this->d->m_format = SampleFormat(audioCaps.format);
 
-    if (caps.contains("channels"))
-        this->d->m_channels = caps.property("channels").toInt();
+    if (audioCaps.fields & AkCaps::AudioCaps::Bps)
+        this->d->m_bps = audioCaps.bps;
 
-    if (caps.contains("rate"))
-        this->d->m_rate = caps.property("rate").toInt();
+    if (audioCaps.fields & AkCaps::AudioCaps::Channels)
+        this->d->m_channels = audioCaps.channels;
 
-    if (caps.contains("layout")) {
-        QString layout = caps.property("layout").toString();
-        this->d->m_layout = ChannelLayouts::byDescription(layout)->layout;
-    }
+    if (audioCaps.fields & AkCaps::AudioCaps::Rate)
+        this->d->m_rate = audioCaps.rate;
+
+    if (audioCaps.fields & AkCaps::AudioCaps::Layout)
+        this->d->m_layout = ChannelLayout(audioCaps.layout);
 
-    if (caps.contains("samples"))
-        this->d->m_samples = caps.property("samples").toInt();
+    if (audioCaps.fields & AkCaps::AudioCaps::Samples)
+        this->d->m_samples = audioCaps.samples;
 
-    if (caps.contains("align"))
-        this->d->m_align = caps.property("align").toBool();
+    if (audioCaps.fields & AkCaps::AudioCaps::Align)
+        this->d->m_align = audioCaps.align;
 
     return *this;
 }
 
 AkCaps AkAudioCaps::toCaps() const
 {
-    return AkCaps(this->toString());
+    AkCaps caps;
+
+    if (!this->d->m_isValid)
+        return caps;
+
+    caps.setAudioCaps({AkCaps::AudioCaps::All,
+                       this->d->m_format,
+                       this->d->m_bps,
+                       this->d->m_channels,
+                       this->d->m_rate,
+                       this->d->m_layout,
+                       this->d->m_samples,
+                       this->d->m_align});
+
+    return caps;
 }
 
 int AkAudioCaps::bitsPerSample(AkAudioCaps::SampleFormat sampleFormat)
@@ -577,9 +571,9 @@ int AkAudioCaps::bitsPerSample(const QString &sampleFormat)
 
 QString AkAudioCaps::sampleFormatToString(AkAudioCaps::SampleFormat sampleFormat)
 {
-    AkAudioCaps caps;
-    int formatIndex = caps.metaObject()->indexOfEnumerator("SampleFormat");
-    QMetaEnum formatEnum = caps.metaObject()->enumerator(formatIndex);
+    static const int formatIndex =
+            AkAudioCaps::staticMetaObject.indexOfEnumerator("SampleFormat");
+    QMetaEnum formatEnum = AkAudioCaps::staticMetaObject.enumerator(formatIndex);
     QString format(formatEnum.valueToKey(sampleFormat));
     format.remove("SampleFormat_");
 
@@ -588,10 +582,10 @@ QString AkAudioCaps::sampleFormatToString(AkAudioCaps::SampleFormat sampleFormat
 
 AkAudioCaps::SampleFormat AkAudioCaps::sampleFormatFromString(const QString &sampleFormat)
 {
-    AkAudioCaps caps;
     QString format = "SampleFormat_" + sampleFormat;
-    int formatIndex = caps.metaObject()->indexOfEnumerator("SampleFormat");
-    QMetaEnum formatEnum = caps.metaObject()->enumerator(formatIndex);
+    static const int formatIndex =
+            AkAudioCaps::staticMetaObject.indexOfEnumerator("SampleFormat");
+    QMetaEnum formatEnum = AkAudioCaps::staticMetaObject.enumerator(formatIndex);
     int formatInt = formatEnum.keyToValue(format.toStdString().c_str());
 
     return static_cast<SampleFormat>(formatInt);
@@ -24,14 +24,14 @@
 #include "akaudiocaps.h"
 #include "akcaps.h"
 
-class AkAudioPacketPrivate
+class AkAudioPacketPrivate: public QSharedData
 {
     public:
         AkAudioCaps m_caps;
 };
 
-AkAudioPacket::AkAudioPacket(QObject *parent):
-    AkPacket(parent)
+AkAudioPacket::AkAudioPacket():
+    AkPacket()
 {
     this->d = new AkAudioPacketPrivate();
 }
@@ -52,45 +52,33 @@ AkAudioPacket::AkAudioPacket(const AkAudioCaps &caps,
     this->id() = id;
 }
 
-AkAudioPacket::AkAudioPacket(const AkPacket &other)
+AkAudioPacket::AkAudioPacket(const AkPacket &other):
+    AkPacket(other)
 {
     this->d = new AkAudioPacketPrivate();
     this->d->m_caps = other.caps();
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 }
 
 AkAudioPacket::AkAudioPacket(const AkAudioPacket &other):
-    AkPacket()
+    AkPacket(other),
+    d(other.d)
+{
+}
+
+AkAudioPacket::AkAudioPacket(AkAudioPacket &&other) noexcept:
+    AkPacket(std::move(other)),
+    d(std::move(other.d))
 {
-    this->d = new AkAudioPacketPrivate();
-    this->d->m_caps = other.d->m_caps;
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 }
 
 AkAudioPacket::~AkAudioPacket()
 {
-    delete this->d;
 }
 
 AkAudioPacket &AkAudioPacket::operator =(const AkPacket &other)
 {
+    AkPacket::operator =(other);
     this->d->m_caps = other.caps();
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 
     return *this;
 }
@@ -98,13 +86,18 @@ AkAudioPacket &AkAudioPacket::operator =(const AkPacket &other)
 AkAudioPacket &AkAudioPacket::operator =(const AkAudioPacket &other)
 {
     if (this != &other) {
-        this->d->m_caps = other.d->m_caps;
-        this->data() = other.data();
-        this->buffer() = other.buffer();
-        this->pts() = other.pts();
-        this->timeBase() = other.timeBase();
-        this->index() = other.index();
-        this->id() = other.id();
+        AkPacket::operator =(other);
+        this->d = other.d;
+    }
+
+    return *this;
+}
+
+AkAudioPacket &AkAudioPacket::operator =(AkAudioPacket &&other) noexcept
+{
+    if (this != &other) {
+        AkPacket::operator =(std::move(other));
+        this->d.swap(other.d);
     }
 
     return *this;
@@ -164,24 +157,18 @@ QString AkAudioPacket::toString() const
 
 AkPacket AkAudioPacket::toPacket() const
 {
-    AkPacket packet;
-    packet.caps() =  this->d->m_caps.toCaps();
-    packet.buffer() = this->buffer();
-    packet.pts() = this->pts();
-    packet.timeBase() = this->timeBase();
-    packet.index() = this->index();
-    packet.id() = this->id();
+    AkPacket packet(*this);
+    packet.caps() = this->d->m_caps.toCaps();
 
     return packet;
 }
 
 void AkAudioPacket::setCaps(const AkAudioCaps &caps)
 {
-    if (this->d->m_caps == caps)
+    if (this->d.constData()->m_caps == caps)
         return;
 
     this->d->m_caps = caps;
-    emit this->capsChanged(caps);
 }
 
 void AkAudioPacket::resetCaps()
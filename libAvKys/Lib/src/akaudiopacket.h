@@ -27,15 +27,14 @@ class AkAudioCaps;
 
 class AKCOMMONS_EXPORT AkAudioPacket: public AkPacket
 {
-    Q_OBJECT
+    Q_GADGET
     Q_PROPERTY(AkAudioCaps caps
                READ caps
                WRITE setCaps
-               RESET resetCaps
-               NOTIFY capsChanged)
+               RESET resetCaps)
 
     public:
-        explicit AkAudioPacket(QObject *parent=nullptr);
+        AkAudioPacket();
         AkAudioPacket(const AkAudioCaps &caps,
                       const QByteArray &buffer=QByteArray(),
                       qint64 pts=0,
@@ -44,9 +43,11 @@ class AKCOMMONS_EXPORT AkAudioPacket: public AkPacket
                       qint64 id=-1);
         AkAudioPacket(const AkPacket &other);
         AkAudioPacket(const AkAudioPacket &other);
+        AkAudioPacket(AkAudioPacket &&other) noexcept;
         ~AkAudioPacket();
         AkAudioPacket &operator =(const AkPacket &other);
         AkAudioPacket &operator =(const AkAudioPacket &other);
+        AkAudioPacket &operator =(AkAudioPacket &&other) noexcept;
         operator bool() const;
 
         Q_INVOKABLE AkAudioCaps caps() const;
@@ -55,15 +56,11 @@ class AKCOMMONS_EXPORT AkAudioPacket: public AkPacket
         Q_INVOKABLE QString toString() const;
         Q_INVOKABLE AkPacket toPacket() const;
 
-    private:
-        AkAudioPacketPrivate *d;
-
-    Q_SIGNALS:
-        void capsChanged(const AkAudioCaps &caps);
+        Q_INVOKABLE void setCaps(const AkAudioCaps &caps);
+        Q_INVOKABLE void resetCaps();
 
-    public Q_SLOTS:
-        void setCaps(const AkAudioCaps &caps);
-        void resetCaps();
+    private:
+        QSharedDataPointer<AkAudioPacketPrivate> d;
 
         friend QDebug operator <<(QDebug debug, const AkAudioPacket &packet);
 };
@@ -0,0 +1,461 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+#include "akbufferpool.h"
+#include "akpacket.h"
+#include "akvideocaps.h"
+
+// Memory alignment of the pooled buffers, large enough for any SIMD
+// instruction set.
+#define POOL_MEMORY_ALIGN 64
+
+// Buffers with variable size (compressed frames, scratch arrays) are rounded
+// up to this size, so they can be reused for similar requests.
+#define POOL_CAPACITY_ALIGN 4096
+
+#define POOL_DEFAULT_MAX_FREE_BYTES (256 << 20)
+
+struct AkPoolBufferKey
+{
+    int format;
+    int width;
+    int height;
+    int align;
+
+    inline bool operator ==(const AkPoolBufferKey &other) const
+    {
+        return this->format == other.format
+            && this->width == other.width
+            && this->height == other.height
+            && this->align == other.align;
+    }
+};
+
+inline uint qHash(const AkPoolBufferKey &key, uint seed=0)
+{
+    return qHash(quint64(uint(key.format)) << 32 | uint(key.align), seed)
+         ^ qHash(quint64(uint(key.width)) << 32 | uint(key.height), seed);
+}
+
+class AkPoolBufferPrivate
+{
+    public:
+        QAtomicInt m_ref;
+        AkPoolBufferKey m_key;
+        char *m_data;
+        int m_size;
+        int m_capacity;
+        quint64 m_recycled;
+};
+
+class AkBufferPoolPrivate
+{
+    public:
+        QMutex m_mutex;
+        QHash<AkPoolBufferKey, QVector<AkPoolBufferPrivate *>> m_freeBuffers;
+        qint64 m_hits;
+        qint64 m_misses;
+        qint64 m_residentBytes;
+        qint64 m_freeBytes;
+        qint64 m_maxFreeBytes;
+        quint64 m_recycled;
+
+        AkBufferPoolPrivate():
+            m_hits(0),
+            m_misses(0),
+            m_residentBytes(0),
+            m_freeBytes(0),
+            m_maxFreeBytes(POOL_DEFAULT_MAX_FREE_BYTES),
+            m_recycled(0)
+        {
+        }
+
+        ~AkBufferPoolPrivate()
+        {
+            this->clear();
+        }
+
+        AkPoolBuffer acquire(const AkPoolBufferKey &key, int size);
+        void recycle(AkPoolBufferPrivate *buffer);
+        void trim();
+        void clear();
+
+        static inline AkPoolBufferPrivate *take(AkPoolBuffer &buffer);
+        static void release(AkPoolBufferPrivate *buffer);
+        static void releaseImage(void *userData);
+        static inline void freeBuffer(AkPoolBufferPrivate *buffer);
+};
+
+Q_GLOBAL_STATIC(AkBufferPoolPrivate, akBufferPool)
+
+AkPoolBuffer::AkPoolBuffer():
+    d(nullptr)
+{
+}
+
+AkPoolBuffer::AkPoolBuffer(const AkPoolBuffer &other):
+    d(other.d)
+{
+    if (this->d)
+        this->d->m_ref.ref();
+}
+
+AkPoolBuffer::AkPoolBuffer(AkPoolBuffer &&other) noexcept:
+    d(other.d)
+{
+    other.d = nullptr;
+}
+
+AkPoolBuffer::AkPoolBuffer(AkPoolBufferPrivate *d):
+    d(d)
+{
+}
+
+AkPoolBuffer::~AkPoolBuffer()
+{
+    AkBufferPoolPrivate::release(this->d);
+}
+
+AkPoolBuffer &AkPoolBuffer::operator =(const AkPoolBuffer &other)
+{
+    if (this->d != other.d) {
+        if (other.d)
+            other.d->m_ref.ref();
+
+        AkBufferPoolPrivate::release(this->d);
+        this->d = other.d;
+    }
+
+    return *this;
+}
+
+AkPoolBuffer &AkPoolBuffer::operator =(AkPoolBuffer &&other) noexcept
+{
+    qSwap(this->d, other.d);
+
+    return *this;
+}
+
+AkPoolBuffer::operator bool() const
+{
+    return this->d != nullptr;
+}
+
+char *AkPoolBuffer::data()
+{
+    return this->d? this->d->m_data: nullptr;
+}
+
+const char *AkPoolBuffer::constData() const
+{
+    return this->d? this->d->m_data: nullptr;
+}
+
+int AkPoolBuffer::size() const
+{
+    return this->d? this->d->m_size: 0;
+}
+
+QByteArray AkPoolBuffer::toByteArray() const
+{
+    if (!this->d)
+        return QByteArray();
+
+    return QByteArray::fromRawData(this->d->m_data, this->d->m_size);
+}
+
+void AkPoolBuffer::attachTo(AkPacket &packet) const
+{
+    packet.buffer() = this->toByteArray();
+    packet.setBufferOwner(QVariant::fromValue(*this));
+}
+
+AkPoolBuffer AkBufferPoolPrivate::acquire(const AkPoolBufferKey &key, int size)
+{
+    if (size < 1)
+        return AkPoolBuffer();
+
+    AkPoolBufferPrivate *buffer = nullptr;
+
+    this->m_mutex.lock();
+    auto it = this->m_freeBuffers.find(key);
+
+    if (it != this->m_freeBuffers.end()) {
+        // Prefer the most recently used buffer, it's likely still in cache.
+        buffer = it->takeLast();
+        this->m_freeBytes -= buffer->m_capacity;
+
+        if (it->isEmpty())
+            this->m_freeBuffers.erase(it);
+
+        if (buffer->m_capacity < size) {
+            this->m_residentBytes -= buffer->m_capacity;
+            this->freeBuffer(buffer);
+            buffer = nullptr;
+        }
+    }
+
+    if (buffer)
+        this->m_hits++;
+    else
+        this->m_misses++;
+
+    this->m_mutex.unlock();
+
+    if (!buffer) {
+        int capacity = POOL_CAPACITY_ALIGN
+                     * ((size + POOL_CAPACITY_ALIGN - 1) / POOL_CAPACITY_ALIGN);
+        auto data = reinterpret_cast<char *>(qMallocAligned(size_t(capacity),
+                                                            POOL_MEMORY_ALIGN));
+
+        if (!data)
+            return AkPoolBuffer();
+
+        buffer = new AkPoolBufferPrivate;
+        buffer->m_key = key;
+        buffer->m_data = data;
+        buffer->m_capacity = capacity;
+
+        this->m_mutex.lock();
+        this->m_residentBytes += capacity;
+        this->m_mutex.unlock();
+    }
+
+    buffer->m_ref.store(1);
+    buffer->m_size = size;
+
+    return AkPoolBuffer(buffer);
+}
+
+void AkBufferPoolPrivate::recycle(AkPoolBufferPrivate *buffer)
+{
+    QMutexLocker mutexLocker(&this->m_mutex);
+
+    if (buffer->m_capacity > this->m_maxFreeBytes) {
+        this->m_residentBytes -= buffer->m_capacity;
+        this->freeBuffer(buffer);
+
+        return;
+    }
+
+    buffer->m_recycled = this->m_recycled++;
+    this->m_freeBuffers[buffer->m_key] << buffer;
+    this->m_freeBytes += buffer->m_capacity;
+    this->trim();
+}
+
+// Frees the least recently returned buffers until the free memory fits in
+// the cap. The buffers of each key are sorted by return order, so the
+// oldest one is the first buffer of some key. Must be called locked.
+void AkBufferPoolPrivate::trim()
+{
+    while (this->m_freeBytes > this->m_maxFreeBytes) {
+        auto oldest = this->m_freeBuffers.end();
+
+        for (auto it = this->m_freeBuffers.begin();
+             it != this->m_freeBuffers.end();
+             it++)
+            if (oldest == this->m_freeBuffers.end()
+                || it->first()->m_recycled < oldest->first()->m_recycled)
+                oldest = it;
+
+        auto buffer = oldest->takeFirst();
+
+        if (oldest->isEmpty())
+            this->m_freeBuffers.erase(oldest);
+
+        this->m_freeBytes -= buffer->m_capacity;
+        this->m_residentBytes -= buffer->m_capacity;
+        this->freeBuffer(buffer);
+    }
+}
+
+void AkBufferPoolPrivate::clear()
+{
+    QMutexLocker mutexLocker(&this->m_mutex);
+
+    for (auto &buffers: this->m_freeBuffers)
+        for (auto buffer: buffers) {
+            this->m_residentBytes -= buffer->m_capacity;
+            this->freeBuffer(buffer);
+        }
+
+    this->m_freeBuffers.clear();
+    this->m_freeBytes = 0;
+}
+
+AkPoolBufferPrivate *AkBufferPoolPrivate::take(AkPoolBuffer &buffer)
+{
+    auto bufferPrivate = buffer.d;
+    buffer.d = nullptr;
+
+    return bufferPrivate;
+}
+
+void AkBufferPoolPrivate::release(AkPoolBufferPrivate *buffer)
+{
+    if (!buffer || buffer->m_ref.deref())
+        return;
+
+    // The buffer can outlive the pool if it's released at exit.
+    if (akBufferPool.isDestroyed())
+        AkBufferPoolPrivate::freeBuffer(buffer);
+    else
+        akBufferPool->recycle(buffer);
+}
+
+void AkBufferPoolPrivate::releaseImage(void *userData)
+{
+    AkBufferPoolPrivate::release(reinterpret_cast<AkPoolBufferPrivate *>(userData));
+}
+
+void AkBufferPoolPrivate::freeBuffer(AkPoolBufferPrivate *buffer)
+{
+    qFreeAligned(buffer->m_data);
+    delete buffer;
+}
+
+AkPoolBuffer AkBufferPool::buffer(int format,
+                                  int width,
+                                  int height,
+                                  int align,
+                                  int size)
+{
+    return akBufferPool->acquire({format, width, height, align}, size);
+}
+
+AkPoolBuffer AkBufferPool::buffer(const AkVideoCaps &caps, int align)
+{
+    align = qMax(align, 1);
+    int lineSize = (caps.width() * caps.bpp() + 7) / 8;
+    lineSize = align * ((lineSize + align - 1) / align);
+
+    return akBufferPool->acquire({caps.format(),
+                                  caps.width(),
+                                  caps.height(),
+                                  align},
+                                 lineSize * caps.height());
+}
+
+AkPoolBuffer AkBufferPool::buffer(int size)
+{
+    return akBufferPool->acquire({AkVideoCaps::Format_none, 0, 0, 0}, size);
+}
+
+QImage AkBufferPool::image(const QSize &size, QImage::Format format)
+{
+    return AkBufferPool::image(size.width(), size.height(), format);
+}
+
+QImage AkBufferPool::image(int width, int height, QImage::Format format)
+{
+    if (width < 1 || height < 1 || format == QImage::Format_Invalid)
+        return QImage();
+
+    // QImage requires 32 bits aligned lines.
+    int bpp = int(QImage::toPixelFormat(format).bitsPerPixel());
+    int bytesPerLine = 4 * ((width * bpp + 31) / 32);
+
+    // QImage formats are offset so they don't share keys with the
+    // AkVideoCaps formats.
+    auto buffer = akBufferPool->acquire({int(format) + 0x10000,
+                                         width,
+                                         height,
+                                         4},
+                                        bytesPerLine * height);
+
+    if (!buffer)
+        return QImage();
+
+    // The image takes the reference of the buffer, and releases it when the
+    // image data is destroyed.
+    auto bufferPrivate = AkBufferPoolPrivate::take(buffer);
+
+    return QImage(reinterpret_cast<uchar *>(bufferPrivate->m_data),
+                  width,
+                  height,
+                  bytesPerLine,
+                  format,
+                  AkBufferPoolPrivate::releaseImage,
+                  bufferPrivate);
+}
+
+qint64 AkBufferPool::hits()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return akBufferPool->m_hits;
+}
+
+qint64 AkBufferPool::misses()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return akBufferPool->m_misses;
+}
+
+qint64 AkBufferPool::residentBytes()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return akBufferPool->m_residentBytes;
+}
+
+qint64 AkBufferPool::freeBytes()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return akBufferPool->m_freeBytes;
+}
+
+qint64 AkBufferPool::maxFreeBytes()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return akBufferPool->m_maxFreeBytes;
+}
+
+void AkBufferPool::setMaxFreeBytes(qint64 maxFreeBytes)
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+    akBufferPool->m_maxFreeBytes = qMax<qint64>(maxFreeBytes, 0);
+    akBufferPool->trim();
+}
+
+QVariantMap AkBufferPool::stats()
+{
+    QMutexLocker mutexLocker(&akBufferPool->m_mutex);
+
+    return QVariantMap {
+        {"hits"         , akBufferPool->m_hits         },
+        {"misses"       , akBufferPool->m_misses       },
+        {"residentBytes", akBufferPool->m_residentBytes},
+        {"freeBytes"    , akBufferPool->m_freeBytes    },
+        {"maxFreeBytes" , akBufferPool->m_maxFreeBytes }
+    };
+}
+
+void AkBufferPool::clear()
+{
+    akBufferPool->clear();
+}
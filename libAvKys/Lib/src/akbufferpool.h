@@ -0,0 +1,104 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKBUFFERPOOL_H
+#define AKBUFFERPOOL_H
+
+#include <QImage>
+#include <QVariant>
+
+#include "akcommons.h"
+
+class AkPoolBufferPrivate;
+class AkPacket;
+class AkVideoCaps;
+
+// A block of memory borrowed from the buffer pool. The memory goes back to
+// the pool when the last copy of the buffer is destroyed.
+class AKCOMMONS_EXPORT AkPoolBuffer
+{
+    public:
+        AkPoolBuffer();
+        AkPoolBuffer(const AkPoolBuffer &other);
+        AkPoolBuffer(AkPoolBuffer &&other) noexcept;
+        ~AkPoolBuffer();
+        AkPoolBuffer &operator =(const AkPoolBuffer &other);
+        AkPoolBuffer &operator =(AkPoolBuffer &&other) noexcept;
+        operator bool() const;
+
+        char *data();
+        const char *constData() const;
+        int size() const;
+
+        template<typename T>
+        inline T *data()
+        {
+            return reinterpret_cast<T *>(this->data());
+        }
+
+        template<typename T>
+        inline const T *constData() const
+        {
+            return reinterpret_cast<const T *>(this->constData());
+        }
+
+        // Returns a QByteArray pointing to the pooled memory, no copy is done.
+        // The memory is valid only while the buffer is alive.
+        QByteArray toByteArray() const;
+
+        // Sets the packet buffer, and keeps the memory alive as the buffer
+        // owner of the packet.
+        void attachTo(AkPacket &packet) const;
+
+    private:
+        AkPoolBufferPrivate *d;
+
+        explicit AkPoolBuffer(AkPoolBufferPrivate *d);
+
+    friend class AkBufferPoolPrivate;
+};
+
+Q_DECLARE_TYPEINFO(AkPoolBuffer, Q_MOVABLE_TYPE);
+Q_DECLARE_METATYPE(AkPoolBuffer)
+
+// Process wide pool of frame buffers, keyed by format, size and alignment.
+// It's safe to use from any thread.
+namespace AkBufferPool
+{
+    AKCOMMONS_EXPORT AkPoolBuffer buffer(int format,
+                                         int width,
+                                         int height,
+                                         int align,
+                                         int size);
+    AKCOMMONS_EXPORT AkPoolBuffer buffer(const AkVideoCaps &caps,
+                                         int align=1);
+    AKCOMMONS_EXPORT AkPoolBuffer buffer(int size);
+    AKCOMMONS_EXPORT QImage image(const QSize &size, QImage::Format format);
+    AKCOMMONS_EXPORT QImage image(int width, int height, QImage::Format format);
+    AKCOMMONS_EXPORT qint64 hits();
+    AKCOMMONS_EXPORT qint64 misses();
+    AKCOMMONS_EXPORT qint64 residentBytes();
+    AKCOMMONS_EXPORT qint64 freeBytes();
+    AKCOMMONS_EXPORT qint64 maxFreeBytes();
+    AKCOMMONS_EXPORT void setMaxFreeBytes(qint64 maxFreeBytes);
+    AKCOMMONS_EXPORT QVariantMap stats();
+    AKCOMMONS_EXPORT void clear();
+}
+
+#endif // AKBUFFERPOOL_H
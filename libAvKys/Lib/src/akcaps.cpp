@@ -19,46 +19,348 @@
 
 #include <QDataStream>
 #include <QDebug>
+#include <QHash>
 #include <QRegExp>
 #include <QStringList>
 #include <QVariant>
 
 #include "akcaps.h"
+#include "akfrac.h"
+#include "akaudiocaps.h"
+#include "akvideocaps.h"
 
 class AkCapsPrivate
 {
     public:
         QString m_mimeType;
+        AkCaps::CapsType m_type;
+        AkCaps::VideoCaps m_video;
+        AkCaps::AudioCaps m_audio;
+        mutable QString m_string;
+        mutable uint m_hash;
+        mutable bool m_stringReady;
+        mutable bool m_hashReady;
         bool m_isValid;
+
+        AkCapsPrivate():
+            m_type(AkCaps::CapsUnknown),
+            m_hash(0),
+            m_stringReady(false),
+            m_hashReady(false),
+            m_isValid(false)
+        {
+            this->clearTyped();
+        }
+
+        inline void clearTyped()
+        {
+            this->m_video = {0,
+                             AkVideoCaps::Format_none,
+                             0,
+                             0,
+                             0,
+                             0,
+                             0};
+            this->m_audio = {0,
+                             AkAudioCaps::SampleFormat_none,
+                             0,
+                             0,
+                             0,
+                             AkAudioCaps::Layout_none,
+                             0,
+                             false};
+        }
+
+        inline void invalidate()
+        {
+            this->m_stringReady = false;
+            this->m_hashReady = false;
+        }
+
+        static inline AkCaps::CapsType typeFromMimeType(const QString &mimeType)
+        {
+            if (mimeType == "video/x-raw")
+                return AkCaps::CapsVideo;
+
+            if (mimeType == "audio/x-raw")
+                return AkCaps::CapsAudio;
+
+            if (mimeType == "text/x-raw")
+                return AkCaps::CapsSubtitle;
+
+            return AkCaps::CapsUnknown;
+        }
+
+        static inline const QList<QByteArray> &typedNames(AkCaps::CapsType type)
+        {
+            static const QList<QByteArray> videoNames {
+                "format", "bpp", "width", "height", "fps"
+            };
+            static const QList<QByteArray> audioNames {
+                "format", "bps", "channels", "rate", "layout", "samples", "align"
+            };
+            static const QList<QByteArray> noNames;
+
+            switch (type) {
+            case AkCaps::CapsVideo:
+                return videoNames;
+            case AkCaps::CapsAudio:
+                return audioNames;
+            default:
+                break;
+            }
+
+            return noNames;
+        }
+
+        // Returns the bit that represents the property 'name' in the typed
+        // caps, or 0 if the property is not stored in binary form.
+        inline quint32 field(const QByteArray &name) const
+        {
+            int index = AkCapsPrivate::typedNames(this->m_type).indexOf(name);
+
+            return index < 0? 0: quint32(1) << index;
+        }
+
+        inline quint32 fields() const
+        {
+            switch (this->m_type) {
+            case AkCaps::CapsVideo:
+                return this->m_video.fields;
+            case AkCaps::CapsAudio:
+                return this->m_audio.fields;
+            default:
+                break;
+            }
+
+            return 0;
+        }
+
+        inline QVariant typed(quint32 field) const
+        {
+            if (!(this->fields() & field))
+                return QVariant();
+
+            if (this->m_type == AkCaps::CapsVideo)
+                switch (field) {
+                case AkCaps::VideoCaps::Format:
+                    return AkVideoCaps::pixelFormatToString(AkVideoCaps::PixelFormat(this->m_video.format));
+                case AkCaps::VideoCaps::Bpp:
+                    return this->m_video.bpp;
+                case AkCaps::VideoCaps::Width:
+                    return this->m_video.width;
+                case AkCaps::VideoCaps::Height:
+                    return this->m_video.height;
+                case AkCaps::VideoCaps::Fps:
+                    return QString("%1/%2").arg(this->m_video.fpsNum)
+                                           .arg(this->m_video.fpsDen);
+                default:
+                    break;
+                }
+            else
+                switch (field) {
+                case AkCaps::AudioCaps::Format:
+                    return AkAudioCaps::sampleFormatToString(AkAudioCaps::SampleFormat(this->m_audio.format));
+                case AkCaps::AudioCaps::Bps:
+                    return this->m_audio.bps;
+                case AkCaps::AudioCaps::Channels:
+                    return this->m_audio.channels;
+                case AkCaps::AudioCaps::Rate:
+                    return this->m_audio.rate;
+                case AkCaps::AudioCaps::Layout:
+                    return AkAudioCaps::channelLayoutToString(AkAudioCaps::ChannelLayout(this->m_audio.layout));
+                case AkCaps::AudioCaps::Samples:
+                    return this->m_audio.samples;
+                case AkCaps::AudioCaps::Align:
+                    return int(this->m_audio.align);
+                default:
+                    break;
+                }
+
+            return QVariant();
+        }
+
+        inline void setTyped(quint32 field, const QVariant &value)
+        {
+            bool isString = value.type() == QVariant::String;
+
+            if (this->m_type == AkCaps::CapsVideo) {
+                if (!value.isValid()) {
+                    this->m_video.fields &= ~field;
+
+                    return;
+                }
+
+                switch (field) {
+                case AkCaps::VideoCaps::Format:
+                    this->m_video.format =
+                            isString?
+                                AkVideoCaps::pixelFormatFromString(value.toString()):
+                                value.toInt();
+
+                    break;
+                case AkCaps::VideoCaps::Bpp:
+                    this->m_video.bpp = value.toInt();
+
+                    break;
+                case AkCaps::VideoCaps::Width:
+                    this->m_video.width = value.toInt();
+
+                    break;
+                case AkCaps::VideoCaps::Height:
+                    this->m_video.height = value.toInt();
+
+                    break;
+                case AkCaps::VideoCaps::Fps: {
+                    AkFrac fps = value.canConvert<AkFrac>() && !isString?
+                                     value.value<AkFrac>():
+                                     AkFrac(value.toString());
+                    this->m_video.fpsNum = fps.num();
+                    this->m_video.fpsDen = fps.den();
+
+                    break;
+                }
+                default:
+                    return;
+                }
+
+                this->m_video.fields |= field;
+            } else {
+                if (!value.isValid()) {
+                    this->m_audio.fields &= ~field;
+
+                    return;
+                }
+
+                switch (field) {
+                case AkCaps::AudioCaps::Format:
+                    this->m_audio.format =
+                            isString?
+                                AkAudioCaps::sampleFormatFromString(value.toString()):
+                                value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Bps:
+                    this->m_audio.bps = value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Channels:
+                    this->m_audio.channels = value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Rate:
+                    this->m_audio.rate = value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Layout:
+                    this->m_audio.layout =
+                            isString?
+                                AkAudioCaps::channelLayoutFromString(value.toString()):
+                                value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Samples:
+                    this->m_audio.samples = value.toInt();
+
+                    break;
+                case AkCaps::AudioCaps::Align:
+                    this->m_audio.align = value.toBool();
+
+                    break;
+                default:
+                    return;
+                }
+
+                this->m_audio.fields |= field;
+            }
+        }
+
+        inline bool typedEquals(const AkCapsPrivate *other) const
+        {
+            switch (this->m_type) {
+            case AkCaps::CapsVideo:
+                return this->m_video.fields == other->m_video.fields
+                    && this->m_video.format == other->m_video.format
+                    && this->m_video.bpp == other->m_video.bpp
+                    && this->m_video.width == other->m_video.width
+                    && this->m_video.height == other->m_video.height
+                    && this->m_video.fpsNum == other->m_video.fpsNum
+                    && this->m_video.fpsDen == other->m_video.fpsDen;
+            case AkCaps::CapsAudio:
+                return this->m_audio.fields == other->m_audio.fields
+                    && this->m_audio.format == other->m_audio.format
+                    && this->m_audio.bps == other->m_audio.bps
+                    && this->m_audio.channels == other->m_audio.channels
+                    && this->m_audio.rate == other->m_audio.rate
+                    && this->m_audio.layout == other->m_audio.layout
+                    && this->m_audio.samples == other->m_audio.samples
+                    && this->m_audio.align == other->m_audio.align;
+            default:
+                break;
+            }
+
+            return true;
+        }
+
+        // Move the properties between the binary and the dynamic storage when
+        // the caps type changes.
+        inline void setType(AkCaps *caps, AkCaps::CapsType type)
+        {
+            if (this->m_type == type)
+                return;
+
+            auto &oldNames = AkCapsPrivate::typedNames(this->m_type);
+
+            for (int i = 0; i < oldNames.size(); i++) {
+                auto value = this->typed(quint32(1) << i);
+
+                if (value.isValid())
+                    caps->QObject::setProperty(oldNames[i].constData(), value);
+            }
+
+            this->clearTyped();
+            this->m_type = type;
+
+            auto &newNames = AkCapsPrivate::typedNames(this->m_type);
+            auto properties = caps->QObject::dynamicPropertyNames();
+
+            for (int i = 0; i < newNames.size(); i++)
+                if (properties.contains(newNames[i])) {
+                    this->setTyped(quint32(1) << i,
+                                   caps->QObject::property(newNames[i].constData()));
+                    caps->QObject::setProperty(newNames[i].constData(),
+                                               QVariant());
+                }
+
+            this->invalidate();
+        }
 };
 
 AkCaps::AkCaps(QObject *parent): QObject(parent)
 {
     this->d = new AkCapsPrivate();
-    this->d->m_isValid = false;
 }
 
 AkCaps::AkCaps(const QVariantMap &caps)
 {
     this->d = new AkCapsPrivate();
-    this->d->m_isValid = false;
     this->fromMap(caps);
 }
 
 AkCaps::AkCaps(const QString &caps)
 {
     this->d = new AkCapsPrivate();
-    this->d->m_isValid = false;
     this->fromString(caps);
 }
 
 AkCaps::AkCaps(const AkCaps &other):
     QObject()
 {
-    this->d = new AkCapsPrivate();
-    this->d->m_isValid = other.d->m_isValid;
-    this->d->m_mimeType = other.d->m_mimeType;
-    this->update(other);
+    this->d = new AkCapsPrivate(*other.d);
+
+    for (auto &property: other.QObject::dynamicPropertyNames())
+        this->QObject::setProperty(property.constData(),
+                                   other.QObject::property(property.constData()));
 }
 
 AkCaps::~AkCaps()
@@ -70,9 +372,11 @@ AkCaps &AkCaps::operator =(const AkCaps &other)
 {
     if (this != &other) {
         this->clear();
-        this->d->m_isValid = other.d->m_isValid;
-        this->d->m_mimeType = other.d->m_mimeType;
-        this->update(other);
+        *this->d = *other.d;
+
+        for (auto &property: other.QObject::dynamicPropertyNames())
+            this->QObject::setProperty(property.constData(),
+                                       other.QObject::property(property.constData()));
     }
 
     return *this;
@@ -85,6 +389,21 @@ AkCaps &AkCaps::operator =(const QString &other)
 
 bool AkCaps::operator ==(const AkCaps &other) const
 {
+    if (!this->d->m_isValid || !other.d->m_isValid)
+        return this->d->m_isValid == other.d->m_isValid;
+
+    if (this->hash() != other.hash()
+        || this->d->m_type != other.d->m_type
+        || this->d->m_mimeType != other.d->m_mimeType
+        || !this->d->typedEquals(other.d))
+        return false;
+
+    auto properties = this->QObject::dynamicPropertyNames();
+
+    if (properties.isEmpty()
+        && other.QObject::dynamicPropertyNames().isEmpty())
+        return true;
+
     return this->toString() == other.toString();
 }
 
@@ -115,6 +434,8 @@ bool AkCaps::isValid() const
 
 bool &AkCaps::isValid()
 {
+    this->d->invalidate();
+
     return this->d->m_isValid;
 }
 
@@ -123,58 +444,98 @@ QString AkCaps::mimeType() const
     return this->d->m_mimeType;
 }
 
-AkCaps &AkCaps::fromMap(const QVariantMap &caps)
+AkCaps::CapsType AkCaps::type() const
 {
-    QList<QByteArray> properties = this->dynamicPropertyNames();
+    return this->d->m_type;
+}
 
-    for (const QByteArray &property: properties)
-        this->setProperty(property, QVariant());
+uint AkCaps::hash() const
+{
+    if (this->d->m_hashReady)
+        return this->d->m_hash;
+
+    uint hash = 0;
+
+    if (this->d->m_isValid) {
+        hash = qHash(this->d->m_mimeType);
+
+        switch (this->d->m_type) {
+        case CapsVideo:
+            hash = 31 * hash + this->d->m_video.fields;
+            hash = 31 * hash + uint(this->d->m_video.format);
+            hash = 31 * hash + uint(this->d->m_video.bpp);
+            hash = 31 * hash + uint(this->d->m_video.width);
+            hash = 31 * hash + uint(this->d->m_video.height);
+            hash = 31 * hash + qHash(this->d->m_video.fpsNum);
+            hash = 31 * hash + qHash(this->d->m_video.fpsDen);
+
+            break;
+        case CapsAudio:
+            hash = 31 * hash + this->d->m_audio.fields;
+            hash = 31 * hash + uint(this->d->m_audio.format);
+            hash = 31 * hash + uint(this->d->m_audio.bps);
+            hash = 31 * hash + uint(this->d->m_audio.channels);
+            hash = 31 * hash + uint(this->d->m_audio.rate);
+            hash = 31 * hash + uint(this->d->m_audio.layout);
+            hash = 31 * hash + uint(this->d->m_audio.samples);
+            hash = 31 * hash + uint(this->d->m_audio.align);
+
+            break;
+        default:
+            break;
+        }
+
+        for (auto &property: this->QObject::dynamicPropertyNames())
+            hash ^= qHash(property)
+                  ^ qHash(this->QObject::property(property.constData()).toString());
+    }
+
+    this->d->m_hash = hash;
+    this->d->m_hashReady = true;
+
+    return hash;
+}
 
-    if (!caps.contains("mimeType")) {
-        this->d->m_isValid = false;
-        this->d->m_mimeType = "";
+AkCaps &AkCaps::fromMap(const QVariantMap &caps)
+{
+    this->clear();
 
+    if (!caps.contains("mimeType"))
         return *this;
-    }
+
+    this->setMimeType(caps["mimeType"].toString());
 
     for (const QString &key: caps.keys())
-        if (key == "mimeType") {
-            this->d->m_isValid = QRegExp("\\s*[a-z]+/\\w+(?:(?:-|\\+|\\.)\\w+)*\\s*")
-                                 .exactMatch(caps[key].toString());
-            this->d->m_mimeType = caps[key].toString().trimmed();
-        } else
-            this->setProperty(key.trimmed().toStdString().c_str(), caps[key]);
+        if (key != "mimeType")
+            this->setCapsProperty(key.trimmed().toStdString().c_str(), caps[key]);
 
     return *this;
 }
 
 AkCaps &AkCaps::fromString(const QString &caps)
 {
-    this->d->m_isValid = QRegExp("\\s*[a-z]+/\\w+(?:(?:-|\\+|\\.)\\w+)*"
-                                 "(?:\\s*,\\s*[a-zA-Z_]\\w*\\s*="
-                                 "\\s*[^,=]+)*\\s*").exactMatch(caps);
+    this->clear();
 
-    QList<QByteArray> properties = this->dynamicPropertyNames();
+    bool isValid = QRegExp("\\s*[a-z]+/\\w+(?:(?:-|\\+|\\.)\\w+)*"
+                           "(?:\\s*,\\s*[a-zA-Z_]\\w*\\s*="
+                           "\\s*[^,=]+)*\\s*").exactMatch(caps);
 
-    for (const QByteArray &property: properties)
-        this->setProperty(property, QVariant());
+    if (!isValid)
+        return *this;
 
-    QStringList capsChunks;
+    QStringList capsChunks = caps.split(QRegExp("\\s*,\\s*"),
+                                        QString::SkipEmptyParts);
 
-    if (this->d->m_isValid)
-        capsChunks = caps.split(QRegExp("\\s*,\\s*"),
-                                      QString::SkipEmptyParts);
+    this->setMimeType(capsChunks[0].trimmed());
 
     for (int i = 1; i < capsChunks.length(); i++) {
         QStringList pair = capsChunks[i].split(QRegExp("\\s*=\\s*"),
                                                QString::SkipEmptyParts);
 
-        this->setProperty(pair[0].trimmed().toStdString().c_str(),
+        this->setCapsProperty(pair[0].trimmed().toStdString().c_str(),
                           pair[1].trimmed());
     }
 
-    this->setMimeType(this->d->m_isValid? capsChunks[0].trimmed(): QString(""));
-
     return *this;
 }
 
@@ -186,9 +547,9 @@ QVariantMap AkCaps::toMap() const
     QVariantMap caps;
     caps["mimeType"] = this->d->m_mimeType;
 
-    for (const QByteArray &property: this->dynamicPropertyNames()) {
+    for (const QByteArray &property: this->capsPropertyNames()) {
         QString key = QString::fromUtf8(property.constData());
-        caps[key] = this->property(property.toStdString().c_str());
+        caps[key] = this->capsProperty(property.constData());
     }
 
     return caps;
@@ -199,17 +560,23 @@ QString AkCaps::toString() const
     if (!this->d->m_isValid)
         return QString();
 
+    if (this->d->m_stringReady)
+        return this->d->m_string;
+
     QString caps = this->d->m_mimeType;
     QStringList properties;
 
-    for (const QByteArray &property: this->dynamicPropertyNames())
+    for (const QByteArray &property: this->capsPropertyNames())
         properties << QString::fromUtf8(property.constData());
 
     properties.sort();
 
     for (const QString &property: properties)
         caps.append(QString(",%1=%2").arg(property)
-                                     .arg(this->property(property.toStdString().c_str()).toString()));
+                                     .arg(this->capsProperty(property.toStdString().c_str()).toString()));
+
+    this->d->m_string = caps;
+    this->d->m_stringReady = true;
 
     return caps;
 }
@@ -219,9 +586,9 @@ AkCaps &AkCaps::update(const AkCaps &other)
     if (this->d->m_mimeType != other.d->m_mimeType)
         return *this;
 
-    for (const QByteArray &property: other.dynamicPropertyNames())
-        this->setProperty(property.constData(),
-                          other.property(property.constData()));
+    for (const QByteArray &property: other.capsPropertyNames())
+        this->setCapsProperty(property.constData(),
+                              other.capsProperty(property.constData()));
 
     return *this;
 }
@@ -231,9 +598,11 @@ bool AkCaps::isCompatible(const AkCaps &other) const
     if (this->d->m_mimeType != other.d->m_mimeType)
         return false;
 
-    for (const QByteArray &property: other.dynamicPropertyNames())
-        if (!this->dynamicPropertyNames().contains(property) ||
-            this->property(property.constData()) != other.property(property.constData()))
+    auto properties = this->capsPropertyNames();
+
+    for (const QByteArray &property: other.capsPropertyNames())
+        if (!properties.contains(property) ||
+            this->capsProperty(property.constData()) != other.capsProperty(property.constData()))
             return false;
 
     return true;
@@ -241,18 +610,91 @@ bool AkCaps::isCompatible(const AkCaps &other) const
 
 bool AkCaps::contains(const QString &property) const
 {
-    return this->dynamicPropertyNames().contains(property.toUtf8());
+    auto name = property.toUtf8();
+
+    if (this->d->fields() & this->d->field(name))
+        return true;
+
+    return this->QObject::dynamicPropertyNames().contains(name);
+}
+
+QVariant AkCaps::capsProperty(const char *name) const
+{
+    if (auto field = this->d->field(name))
+        return this->d->typed(field);
+
+    return this->QObject::property(name);
+}
+
+bool AkCaps::setCapsProperty(const char *name, const QVariant &value)
+{
+    this->d->invalidate();
+
+    if (auto field = this->d->field(name)) {
+        this->d->setTyped(field, value);
+
+        return false;
+    }
+
+    return this->QObject::setProperty(name, value);
+}
+
+QList<QByteArray> AkCaps::capsPropertyNames() const
+{
+    QList<QByteArray> properties;
+    auto &names = AkCapsPrivate::typedNames(this->d->m_type);
+    auto fields = this->d->fields();
+
+    for (int i = 0; i < names.size(); i++)
+        if (fields & (quint32(1) << i))
+            properties << names[i];
+
+    properties << this->QObject::dynamicPropertyNames();
+
+    return properties;
+}
+
+const AkCaps::VideoCaps &AkCaps::videoCaps() const
+{
+    return this->d->m_video;
+}
+
+const AkCaps::AudioCaps &AkCaps::audioCaps() const
+{
+    return this->d->m_audio;
+}
+
+void AkCaps::setVideoCaps(const AkCaps::VideoCaps &caps)
+{
+    this->d->m_mimeType = QStringLiteral("video/x-raw");
+    this->d->m_isValid = true;
+    this->d->m_type = CapsVideo;
+    this->d->clearTyped();
+    this->d->m_video = caps;
+    this->d->invalidate();
+}
+
+void AkCaps::setAudioCaps(const AkCaps::AudioCaps &caps)
+{
+    this->d->m_mimeType = QStringLiteral("audio/x-raw");
+    this->d->m_isValid = true;
+    this->d->m_type = CapsAudio;
+    this->d->clearTyped();
+    this->d->m_audio = caps;
+    this->d->invalidate();
 }
 
 void AkCaps::setMimeType(const QString &mimeType)
 {
     this->d->m_isValid = QRegExp("\\s*[a-z]+/\\w+(?:(?:-|\\+|\\.)\\w+)*\\s*").exactMatch(mimeType);
     QString _mimeType = this->d->m_isValid? mimeType.trimmed(): QString("");
+    this->d->invalidate();
 
     if (this->d->m_mimeType == _mimeType)
         return;
 
     this->d->m_mimeType = _mimeType;
+    this->d->setType(this, AkCapsPrivate::typeFromMimeType(_mimeType));
     emit this->mimeTypeChanged(this->d->m_mimeType);
 }
 
@@ -265,11 +707,14 @@ void AkCaps::clear()
 {
     this->d->m_mimeType.clear();
     this->d->m_isValid = false;
+    this->d->m_type = CapsUnknown;
+    this->d->clearTyped();
+    this->d->invalidate();
 
-    QList<QByteArray> properties = this->dynamicPropertyNames();
+    QList<QByteArray> properties = this->QObject::dynamicPropertyNames();
 
     for (const QByteArray &property: properties)
-        this->setProperty(property.constData(), QVariant());
+        this->QObject::setProperty(property.constData(), QVariant());
 }
 
 QDebug operator <<(QDebug debug, const AkCaps &caps)
@@ -25,6 +25,8 @@
 #include "akcommons.h"
 
 class AkCapsPrivate;
+class AkVideoCaps;
+class AkAudioCaps;
 class QDataStream;
 
 class AKCOMMONS_EXPORT AkCaps: public QObject
@@ -38,6 +40,10 @@ class AKCOMMONS_EXPORT AkCaps: public QObject
                WRITE setMimeType
                RESET resetMimeType
                NOTIFY mimeTypeChanged)
+    Q_PROPERTY(CapsType type
+               READ type)
+    Q_PROPERTY(uint hash
+               READ hash)
 
     public:
         enum CapsType
@@ -64,6 +70,8 @@ class AKCOMMONS_EXPORT AkCaps: public QObject
         Q_INVOKABLE virtual bool isValid() const;
         Q_INVOKABLE virtual bool &isValid();
         Q_INVOKABLE virtual QString mimeType() const;
+        Q_INVOKABLE CapsType type() const;
+        Q_INVOKABLE uint hash() const;
         Q_INVOKABLE AkCaps &fromMap(const QVariantMap &caps);
         Q_INVOKABLE AkCaps &fromString(const QString &caps);
         Q_INVOKABLE QVariantMap toMap() const;
@@ -72,9 +80,66 @@ class AKCOMMONS_EXPORT AkCaps: public QObject
         Q_INVOKABLE bool isCompatible(const AkCaps &other) const;
         Q_INVOKABLE bool contains(const QString &property) const;
 
+        // Raw video and audio properties are stored in binary form, they are
+        // read and written by name with these, as well as the other dynamic
+        // properties.
+        QVariant capsProperty(const char *name) const;
+        bool setCapsProperty(const char *name, const QVariant &value);
+        QList<QByteArray> capsPropertyNames() const;
+
     private:
         AkCapsPrivate *d;
 
+        struct VideoCaps
+        {
+            enum Field
+            {
+                Format = 0x1,
+                Bpp    = 0x2,
+                Width  = 0x4,
+                Height = 0x8,
+                Fps    = 0x10,
+                All    = 0x1f
+            };
+
+            quint32 fields;
+            int format;
+            int bpp;
+            int width;
+            int height;
+            qint64 fpsNum;
+            qint64 fpsDen;
+        };
+
+        struct AudioCaps
+        {
+            enum Field
+            {
+                Format   = 0x1,
+                Bps      = 0x2,
+                Channels = 0x4,
+                Rate     = 0x8,
+                Layout   = 0x10,
+                Samples  = 0x20,
+                Align    = 0x40,
+                All      = 0x7f
+            };
+
+            quint32 fields;
+            int format;
+            int bps;
+            int channels;
+            int rate;
+            int layout;
+            int samples;
+            bool align;
+        };
+
+        const VideoCaps &videoCaps() const;
+        const AudioCaps &audioCaps() const;
+        void setVideoCaps(const VideoCaps &caps);
+        void setAudioCaps(const AudioCaps &caps);
+
     Q_SIGNALS:
         void mimeTypeChanged(const QString &mimeType);
 
@@ -83,6 +148,9 @@ class AKCOMMONS_EXPORT AkCaps: public QObject
         virtual void resetMimeType();
         void clear();
 
+    friend class AkCapsPrivate;
+    friend class AkVideoCaps;
+    friend class AkAudioCaps;
     friend QDebug operator <<(QDebug debug, const AkCaps &caps);
     friend QDataStream &operator >>(QDataStream &istream, AkCaps &caps);
     friend QDataStream &operator <<(QDataStream &ostream, const AkCaps &caps);
@@ -20,16 +20,25 @@
 #include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMetaMethod>
 #include <QPluginLoader>
 #include <QQmlComponent>
 #include <QQmlContext>
 #include <QQmlEngine>
 #include <QRegExp>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
 #include <QVector>
 
 #include "akelement.h"
@@ -38,8 +47,15 @@
 #include "akpacket.h"
 #include "akaudiopacket.h"
 #include "akvideopacket.h"
+#include "aklatencyhistogram.h"
+#include "akscheduler.h"
+#include "akqueuedlink.h"
+#include "akframedropper.h"
+#include "akpointoperator.h"
 
 #define SUBMODULES_PATH "submodules"
+#define PLUGINS_CACHE_MAGIC quint32(0x414b5043)
+#define PLUGINS_CACHE_VERSION quint32(1)
 
 class AkPluginInfoPrivate
 {
@@ -50,6 +66,86 @@ class AkPluginInfoPrivate
         bool m_used;
 };
 
+class AkPluginFile
+{
+    public:
+        QString m_path;
+        qint64 m_lastModified;
+        qint64 m_size;
+};
+
+// Plugin information stored in the plugins cache file. m_metaData is empty
+// for the files that are not elements, like submodules.
+class AkPluginCacheEntry
+{
+    public:
+        qint64 m_lastModified;
+        qint64 m_size;
+        QVariantMap m_metaData;
+};
+
+class AkPluginScanItem
+{
+    public:
+        AkPluginFile m_file;
+        int m_index;
+        QVariantMap m_metaData;
+        bool m_probe;
+        bool m_loaded;
+};
+
+class AkElementStats
+{
+    public:
+        AkLatencyHistogram m_latency;
+        QAtomicInteger<qint64> m_packetsIn;
+        QAtomicInteger<qint64> m_packetsOut;
+        QAtomicInteger<qint64> m_packetsDropped;
+        QAtomicInteger<qint64> m_packetsConsumed;
+        QAtomicInteger<qint64> m_bytesIn;
+        QAtomicInteger<qint64> m_bytesOut;
+        QAtomicInteger<qint64> m_firstTime;
+        QAtomicInteger<qint64> m_lastTime;
+
+        AkElementStats():
+            m_packetsIn(0),
+            m_packetsOut(0),
+            m_packetsDropped(0),
+            m_packetsConsumed(0),
+            m_bytesIn(0),
+            m_bytesOut(0),
+            m_firstTime(-1),
+            m_lastTime(-1)
+        {
+        }
+
+        template<typename PacketType>
+        inline AkPacket measure(AkElement *element,
+                                const PacketType &packet,
+                                bool hasOutputs);
+        QVariantMap toMap() const;
+        void reset();
+};
+
+// Time spent in the element being measured in the current thread, used to
+// subtract the time spent by the elements it calls.
+struct AkElementStatsFrame
+{
+    qint64 m_children;
+    AkElementStatsFrame *m_parent;
+};
+
+static thread_local AkElementStatsFrame *akElementStatsFrame = nullptr;
+static QAtomicInt akElementStatsEnabled(qEnvironmentVariableIntValue("AK_ELEMENT_STATS") > 0);
+
+// Elements with nothing connected to oStream() are sinks.
+static inline QMetaMethod akElementOStream()
+{
+    static const auto oStream = QMetaMethod::fromSignal(&AkElement::oStream);
+
+    return oStream;
+}
+
 class AkElementPrivate
 {
     public:
@@ -60,16 +156,26 @@ class AkElementPrivate
         QStringList m_defaultPluginsSearchPaths;
         QStringList m_pluginsBlackList;
         QList<AkPluginInfoPrivate> m_pluginsList;
+        QHash<QString, AkPluginCacheEntry> m_pluginsCache;
+        QString m_pluginsCacheFile;
         QString m_subModulesPath;
         QDir m_applicationDir;
         AkElement::ElementState m_state;
+        AkElementStats *m_stats;
+        AkFrameDropper *m_frameDropper;
         bool m_recursiveSearchPaths;
         bool m_pluginsScanned;
+        bool m_pluginsCacheLoaded;
+        bool m_defaultPluginsCache;
 
         AkElementPrivate()
         {
+            this->m_stats = nullptr;
+            this->m_frameDropper = nullptr;
             this->m_recursiveSearchPaths = false;
             this->m_pluginsScanned = false;
+            this->m_pluginsCacheLoaded = false;
+            this->m_defaultPluginsCache = true;
 
             this->m_defaultPluginsSearchPaths << QString("%1/%2")
                                                  .arg(LIBDIR)
@@ -135,6 +241,54 @@ class AkElementPrivate
             return false;
         }
 
+        static inline bool measurableLink(const QObject *srcElement,
+                                          const QObject *dstElement)
+        {
+            return qobject_cast<const AkElement *>(srcElement)
+                   && qobject_cast<const AkElement *>(dstElement);
+        }
+
+        static inline bool isPacketStream(const QMetaMethod &signal,
+                                          const QMetaMethod &slot)
+        {
+            return signal.methodSignature() == "oStream(AkPacket)"
+                   && slot.methodSignature() == "iStream(AkPacket)";
+        }
+
+        using PacketOperator = AkPacket (AkElement::*)(const AkPacket &);
+
+        static inline PacketOperator packetOperator()
+        {
+            return &AkElement::operator ();
+        }
+
+        // Only check the deadline when a policy is set, or when the stats are
+        // collected, so the lateness is known before enabling the policy.
+        inline bool checkDeadline() const
+        {
+            return this->m_frameDropper->dropPolicy() != AkElement::FrameDropPolicy_Never
+                   || akElementStatsEnabled.load();
+        }
+
+        static inline QString defaultPluginsCacheFile()
+        {
+            auto cacheDir =
+                    QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+
+            if (cacheDir.isEmpty())
+                return QString();
+
+            return QString("%1/%2/plugins.cache").arg(cacheDir, COMMONS_TARGET);
+        }
+
+        inline QString pluginsCacheFile() const
+        {
+            if (this->m_defaultPluginsCache)
+                return this->defaultPluginsCacheFile();
+
+            return this->m_pluginsCacheFile;
+        }
+
         static inline QString pluginId(const QString &fileName)
         {
             auto pluginId = QFileInfo(fileName).baseName();
@@ -157,13 +311,179 @@ class AkElementPrivate
             return QDir::cleanPath(absPath);
         }
 
+        inline static bool isElementPlugin(const QVariantMap &metaData)
+        {
+            return metaData["MetaData"].toMap().value("pluginType").toString()
+                   == AK_PLUGIN_TYPE_ELEMENT;
+        }
+
+        // Walks a search path, and returns the plugins candidates in the
+        // same order they are found.
+        inline QVector<AkPluginFile> scanPath(const QString &searchDir) const
+        {
+            QVector<AkPluginFile> files;
+            QRegExp pluginFilePattern(this->m_pluginFilePattern,
+                                      Qt::CaseSensitive,
+                                      QRegExp::Wildcard);
+            QStringList searchPaths(searchDir);
+
+            while (!searchPaths.isEmpty()) {
+                QString path = searchPaths.takeFirst();
+
+                if (this->m_pluginsBlackList.contains(path))
+                    continue;
+
+                QFileInfo pathInfo(path);
+
+                if (pathInfo.isFile()) {
+                    if (pluginFilePattern.exactMatch(pathInfo.fileName()))
+                        files << AkPluginFile {
+                                     path,
+                                     pathInfo.lastModified().toMSecsSinceEpoch(),
+                                     pathInfo.size()
+                                 };
+
+                    continue;
+                }
+
+                QDir dir(path);
+
+                // The file information comes from the directory listing, so
+                // every file is stat'ed just once.
+                auto fileList = dir.entryInfoList({this->m_pluginFilePattern},
+                                                  QDir::Files
+                                                  | QDir::CaseSensitive,
+                                                  QDir::Name);
+
+                for (auto &fileInfo: fileList) {
+                    auto filePath = dir.absoluteFilePath(fileInfo.fileName());
+
+                    if (!this->m_pluginsBlackList.contains(filePath))
+                        files << AkPluginFile {
+                                     filePath,
+                                     fileInfo.lastModified().toMSecsSinceEpoch(),
+                                     fileInfo.size()
+                                 };
+                }
+
+                if (this->m_recursiveSearchPaths) {
+                    auto dirList = dir.entryList(QDir::Dirs
+                                                 | QDir::NoDotAndDotDot,
+                                                 QDir::Name);
+
+                    for (const QString &path: dirList)
+                        searchPaths << dir.absoluteFilePath(path);
+                }
+            }
+
+            return files;
+        }
+
+        inline void loadPluginsCache()
+        {
+            if (this->m_pluginsCacheLoaded)
+                return;
+
+            this->m_pluginsCacheLoaded = true;
+            this->m_pluginsCache.clear();
+
+            auto fileName = this->pluginsCacheFile();
+
+            if (fileName.isEmpty())
+                return;
+
+            QFile file(fileName);
+
+            if (!file.open(QIODevice::ReadOnly))
+                return;
+
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_5_0);
+            quint32 magic = 0;
+            quint32 version = 0;
+            QString commonsVersion;
+            QString qtVersion;
+            stream >> magic >> version >> commonsVersion >> qtVersion;
+
+            // The cache is discarded when the format, the library or Qt
+            // change.
+            if (magic != PLUGINS_CACHE_MAGIC
+                || version != PLUGINS_CACHE_VERSION
+                || commonsVersion != COMMONS_VERSION
+                || qtVersion != qVersion())
+                return;
+
+            quint32 count = 0;
+            stream >> count;
+
+            for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+                QString path;
+                AkPluginCacheEntry entry;
+                QByteArray metaData;
+                stream >> path >> entry.m_lastModified >> entry.m_size >> metaData;
+
+                if (!metaData.isEmpty())
+                    entry.m_metaData =
+                            QJsonDocument::fromJson(metaData).toVariant().toMap();
+
+                this->m_pluginsCache[path] = entry;
+            }
+
+            if (stream.status() != QDataStream::Ok)
+                this->m_pluginsCache.clear();
+        }
+
+        inline void savePluginsCache() const
+        {
+            auto fileName = this->pluginsCacheFile();
+
+            if (fileName.isEmpty())
+                return;
+
+            QDir().mkpath(QFileInfo(fileName).absolutePath());
+            QSaveFile file(fileName);
+
+            if (!file.open(QIODevice::WriteOnly))
+                return;
+
+            QDataStream stream(&file);
+            stream.setVersion(QDataStream::Qt_5_0);
+            stream << PLUGINS_CACHE_MAGIC
+                   << PLUGINS_CACHE_VERSION
+                   << QString(COMMONS_VERSION)
+                   << QString(qVersion())
+                   << quint32(this->m_pluginsCache.size());
+
+            for (auto it = this->m_pluginsCache.begin();
+                 it != this->m_pluginsCache.end();
+                 it++) {
+                QByteArray metaData;
+
+                if (!it->m_metaData.isEmpty())
+                    metaData = QJsonDocument::fromVariant(it->m_metaData)
+                               .toJson(QJsonDocument::Compact);
+
+                stream << it.key()
+                       << it->m_lastModified
+                       << it->m_size
+                       << metaData;
+            }
+
+            file.commit();
+        }
+
         inline void listPlugins()
         {
+            QElapsedTimer timer;
+            timer.start();
+
             QVector<QStringList *> sPaths {
                 &this->m_pluginsSearchPaths,
                 &this->m_defaultPluginsSearchPaths
             };
 
+            QStringList searchDirs;
+
             for (auto sPath: sPaths)
                 for (int i = sPath->length() - 1; i >= 0; i--) {
                     QString searchDir(sPath->at(i));
@@ -174,110 +494,226 @@ class AkElementPrivate
                     while (searchDir.endsWith(QDir::separator()))
                         searchDir.resize(searchDir.size() - 1);
 
-                    QStringList searchPaths(searchDir);
-
-                    while (!searchPaths.isEmpty()) {
-                        QString path = searchPaths.takeFirst();
-
-                        if (this->m_pluginsBlackList.contains(path))
-                            continue;
-
-                        auto pluginId = this->pluginId(path);
-                        bool found = false;
-
-                        for (auto &pluginInfo: this->m_pluginsList)
-                            if (pluginInfo.m_path == path) {
-                                if (pluginInfo.m_metaData.isEmpty()) {
-                                    QPluginLoader pluginLoader(path);
-
-                                    if (pluginLoader.load()) {
-                                        if (pluginInfo.m_id.isEmpty())
-                                            pluginInfo.m_id = pluginId;
-
-                                        pluginInfo.m_metaData =
-                                                pluginLoader.metaData().toVariantMap();
-                                        pluginInfo.m_used = true;
-
-                                        pluginLoader.unload();
-                                    }
-                                } else {
-                                    if (pluginInfo.m_id.isEmpty())
-                                        pluginInfo.m_id = pluginId;
-
-                                    pluginInfo.m_used = true;
-                                }
-
-                                found = true;
-
-                                break;
-                            }
-
-                        if (found)
-                            continue;
-
-                        if (QFileInfo(path).isFile()) {
-                            QString fileName = QFileInfo(path).fileName();
-
-                            if (QRegExp(this->m_pluginFilePattern,
-                                        Qt::CaseSensitive,
-                                        QRegExp::Wildcard).exactMatch(fileName)) {
-                                QPluginLoader pluginLoader(path);
-
-                                if (pluginLoader.load()) {
-                                    auto metaData = pluginLoader.metaData();
-
-                                    if (metaData["MetaData"].toObject().contains("pluginType")
-                                        && metaData["MetaData"].toObject()["pluginType"] == AK_PLUGIN_TYPE_ELEMENT) {
-                                        this->m_pluginsList <<
-                                            AkPluginInfoPrivate {
-                                                pluginId,
-                                                path,
-                                                metaData.toVariantMap(),
-                                                true
-                                            };
-                                    }
-
-                                    pluginLoader.unload();
-                                }
-                            }
-                        } else {
-                            QDir dir(path);
-                            auto fileList = dir.entryList({this->m_pluginFilePattern},
-                                                          QDir::Files
-                                                          | QDir::CaseSensitive,
-                                                          QDir::Name);
-
-                            for (const QString &file: fileList)
-                                searchPaths << dir.absoluteFilePath(file);
-
-                            if (this->m_recursiveSearchPaths) {
-                                auto dirList = dir.entryList(QDir::Dirs
-                                                             | QDir::NoDotAndDotDot,
-                                                             QDir::Name);
-
-                                for (const QString &path: dirList)
-                                    searchPaths << dir.absoluteFilePath(path);
-                            }
+                    searchDirs << searchDir;
+                }
+
+            // Walk all search paths in parallel.
+            QVector<QVector<AkPluginFile>> searchDirsFiles(searchDirs.size());
+            auto searchDirFiles = searchDirsFiles.data();
+
+            AkScheduler::parallelFor(searchDirs.size(), 1, [&] (int begin, int end) {
+                for (int i = begin; i < end; i++)
+                    searchDirFiles[i] = this->scanPath(searchDirs.at(i));
+            });
+
+            qint64 walkTime = timer.nsecsElapsed();
+            this->loadPluginsCache();
+            QVector<AkPluginScanItem> items;
+            QSet<QString> paths;
+            int nCached = 0;
+
+            for (auto &files: searchDirsFiles)
+                for (auto &file: files) {
+                    if (paths.contains(file.m_path))
+                        continue;
+
+                    paths << file.m_path;
+                    AkPluginScanItem item {file, -1, {}, false, false};
+
+                    for (int i = 0; i < this->m_pluginsList.size(); i++)
+                        if (this->m_pluginsList[i].m_path == file.m_path) {
+                            item.m_index = i;
+
+                            break;
                         }
+
+                    auto entry = this->m_pluginsCache.constFind(file.m_path);
+
+                    if (item.m_index >= 0
+                        && !this->m_pluginsList[item.m_index].m_metaData.isEmpty()) {
+                        item.m_metaData = this->m_pluginsList[item.m_index].m_metaData;
+                        item.m_loaded = true;
+                    } else if (entry != this->m_pluginsCache.constEnd()
+                               && entry->m_lastModified == file.m_lastModified
+                               && entry->m_size == file.m_size) {
+                        item.m_metaData = entry->m_metaData;
+                        item.m_loaded = true;
+                        nCached++;
+                    } else {
+                        item.m_probe = true;
                     }
+
+                    items << item;
+                }
+
+            // Only the new and the modified plugins are loaded. They are
+            // loaded one at a time, since loading a plugin runs its static
+            // initializers, and they don't expect to run concurrently.
+            QVector<int> probes;
+
+            for (int i = 0; i < items.size(); i++)
+                if (items[i].m_probe)
+                    probes << i;
+
+            for (int i: probes) {
+                auto &item = items[i];
+                QPluginLoader pluginLoader(item.m_file.m_path);
+
+                if (!pluginLoader.load())
+                    continue;
+
+                item.m_metaData = pluginLoader.metaData().toVariantMap();
+                item.m_loaded = true;
+                pluginLoader.unload();
+            }
+
+            qint64 probeTime = timer.nsecsElapsed() - walkTime;
+            QHash<QString, AkPluginCacheEntry> pluginsCache;
+
+            for (auto &item: items) {
+                auto &path = item.m_file.m_path;
+
+                // The plugins that failed to load aren't cached, so they are
+                // tried again in the next scan.
+                if (!item.m_loaded)
+                    continue;
+
+                bool isElement = this->isElementPlugin(item.m_metaData);
+
+                if (item.m_probe || this->m_pluginsCache.contains(path))
+                    pluginsCache[path] = AkPluginCacheEntry {
+                        item.m_file.m_lastModified,
+                        item.m_file.m_size,
+                        isElement? item.m_metaData: QVariantMap()
+                    };
+
+                if (item.m_index >= 0) {
+                    auto &pluginInfo = this->m_pluginsList[item.m_index];
+
+                    if (pluginInfo.m_id.isEmpty())
+                        pluginInfo.m_id = this->pluginId(path);
+
+                    if (pluginInfo.m_metaData.isEmpty())
+                        pluginInfo.m_metaData = item.m_metaData;
+
+                    pluginInfo.m_used = true;
+                } else if (isElement) {
+                    this->m_pluginsList <<
+                        AkPluginInfoPrivate {
+                            this->pluginId(path),
+                            path,
+                            item.m_metaData,
+                            true
+                        };
                 }
+            }
+
+            if (!probes.isEmpty()
+                || pluginsCache.size() != this->m_pluginsCache.size()) {
+                this->m_pluginsCache = pluginsCache;
+                this->savePluginsCache();
+            }
 
             this->m_pluginsScanned = true;
+
+            if (qEnvironmentVariableIntValue("AK_PLUGINS_TIMING") > 0)
+                qInfo() << "Plugins scan:"
+                        << items.size() << "files,"
+                        << nCached << "cached,"
+                        << probes.size() << "loaded, walk"
+                        << walkTime / 1000000.0 << "ms, load"
+                        << probeTime / 1000000.0 << "ms, total"
+                        << timer.nsecsElapsed() / 1000000.0 << "ms";
         }
 };
 
 Q_GLOBAL_STATIC(AkElementPrivate, akElementGlobalStuff)
 
+template<typename PacketType>
+AkPacket AkElementStats::measure(AkElement *element,
+                                 const PacketType &packet,
+                                 bool hasOutputs)
+{
+    AkElementStatsFrame frame {0, akElementStatsFrame};
+    akElementStatsFrame = &frame;
+
+    QElapsedTimer timer;
+    timer.start();
+    auto oPacket = element->iStream(packet);
+    qint64 elapsed = timer.nsecsElapsed();
+
+    akElementStatsFrame = frame.m_parent;
+
+    if (frame.m_parent)
+        frame.m_parent->m_children += elapsed;
+
+    this->m_latency.record(elapsed - frame.m_children);
+    this->m_packetsIn.fetchAndAddRelaxed(1);
+    this->m_bytesIn.fetchAndAddRelaxed(packet.buffer().size());
+
+    // An element that doesn't return a packet dropped it, or consumed it if
+    // nothing is connected to its output (a sink).
+    if (oPacket) {
+        this->m_packetsOut.fetchAndAddRelaxed(1);
+        this->m_bytesOut.fetchAndAddRelaxed(oPacket.buffer().size());
+    } else if (hasOutputs)
+        this->m_packetsDropped.fetchAndAddRelaxed(1);
+    else
+        this->m_packetsConsumed.fetchAndAddRelaxed(1);
+
+    qint64 now = timer.msecsSinceReference();
+    this->m_firstTime.testAndSetRelaxed(-1, now);
+    this->m_lastTime.store(now);
+
+    return oPacket;
+}
+
+QVariantMap AkElementStats::toMap() const
+{
+    qint64 packetsIn = this->m_packetsIn.load();
+    qint64 duration = this->m_lastTime.load() - this->m_firstTime.load();
+    qreal packetsPerSecond = duration > 0?
+                                 1000.0 * (packetsIn - 1) / duration: 0.0;
+
+    return QVariantMap {
+        {"packetsIn"       , packetsIn                     },
+        {"packetsOut"      , this->m_packetsOut.load()     },
+        {"packetsDropped"  , this->m_packetsDropped.load() },
+        {"packetsConsumed" , this->m_packetsConsumed.load()},
+        {"bytesIn"         , this->m_bytesIn.load()        },
+        {"bytesOut"        , this->m_bytesOut.load()       },
+        {"packetsPerSecond", packetsPerSecond              },
+        {"latency"         , this->m_latency.toMap()       },
+    };
+}
+
+void AkElementStats::reset()
+{
+    this->m_latency.reset();
+    this->m_packetsIn.store(0);
+    this->m_packetsOut.store(0);
+    this->m_packetsDropped.store(0);
+    this->m_packetsConsumed.store(0);
+    this->m_bytesIn.store(0);
+    this->m_bytesOut.store(0);
+    this->m_firstTime.store(-1);
+    this->m_lastTime.store(-1);
+}
+
 AkElement::AkElement(QObject *parent):
     QObject(parent)
 {
     this->d = new AkElementPrivate();
     this->d->m_state = ElementStateNull;
+    this->d->m_stats = new AkElementStats;
+    this->d->m_frameDropper = new AkFrameDropper;
 }
 
 AkElement::~AkElement()
 {
     this->setState(AkElement::ElementStateNull);
+    delete this->d->m_frameDropper;
+    delete this->d->m_stats;
     delete this->d;
 }
 
@@ -389,13 +825,28 @@ bool AkElement::link(const QObject *srcElement,
 
     QList<QMetaMethod> signalList = AkElementPrivate::methodsByName(srcElement, "oStream");
     QList<QMetaMethod> slotList = AkElementPrivate::methodsByName(dstElement, "iStream");
+    bool measure = AkElementPrivate::measurableLink(srcElement, dstElement);
+
+    // Packets sent between elements go through operator (), so they can be
+    // measured.
+    if (measure)
+        QObject::connect(qobject_cast<const AkElement *>(srcElement),
+                         &AkElement::oStream,
+                         qobject_cast<const AkElement *>(dstElement),
+                         AkElementPrivate::packetOperator(),
+                         connectionType);
 
     for (const QMetaMethod &signal: signalList)
         for (const QMetaMethod &slot: slotList)
             if (AkElementPrivate::methodCompat(signal, slot) &&
                 signal.methodType() == QMetaMethod::Signal &&
-                slot.methodType() == QMetaMethod::Slot)
+                slot.methodType() == QMetaMethod::Slot) {
+                if (measure
+                    && AkElementPrivate::isPacketStream(signal, slot))
+                    continue;
+
                 QObject::connect(srcElement, signal, dstElement, slot, connectionType);
+            }
 
     return true;
 }
@@ -417,6 +868,14 @@ bool AkElement::unlink(const QObject *srcElement, const QObject *dstElement)
     if (!srcElement || !dstElement)
         return false;
 
+    AkQueuedLink::unlink(srcElement, dstElement);
+
+    if (AkElementPrivate::measurableLink(srcElement, dstElement))
+        QObject::disconnect(qobject_cast<const AkElement *>(srcElement),
+                            &AkElement::oStream,
+                            qobject_cast<const AkElement *>(dstElement),
+                            AkElementPrivate::packetOperator());
+
     for (const QMetaMethod &signal: AkElementPrivate::methodsByName(srcElement, "oStream"))
         for (const QMetaMethod &slot: AkElementPrivate::methodsByName(dstElement, "iStream"))
             if (AkElementPrivate::methodCompat(signal, slot) &&
@@ -821,20 +1280,116 @@ void AkElement::clearCache()
 {
     akElementGlobalStuff->m_pluginsList.clear();
     akElementGlobalStuff->m_pluginsScanned = false;
+
+    // Load all plugins again in the next scan.
+    akElementGlobalStuff->m_pluginsCache.clear();
+    akElementGlobalStuff->m_pluginsCacheLoaded = true;
+}
+
+QString AkElement::pluginsCacheFile()
+{
+    return akElementGlobalStuff->pluginsCacheFile();
+}
+
+void AkElement::setPluginsCacheFile(const QString &fileName)
+{
+    akElementGlobalStuff->m_pluginsCacheFile = fileName;
+    akElementGlobalStuff->m_defaultPluginsCache = false;
+    akElementGlobalStuff->m_pluginsCache.clear();
+    akElementGlobalStuff->m_pluginsCacheLoaded = false;
+}
+
+void AkElement::resetPluginsCacheFile()
+{
+    akElementGlobalStuff->m_pluginsCacheFile.clear();
+    akElementGlobalStuff->m_defaultPluginsCache = true;
+    akElementGlobalStuff->m_pluginsCache.clear();
+    akElementGlobalStuff->m_pluginsCacheLoaded = false;
+}
+
+QVariantMap AkElement::stats() const
+{
+    auto stats = this->d->m_stats->toMap();
+    stats["pluginId"] = this->d->m_pluginId;
+    stats["objectName"] = this->objectName();
+    stats["frameDropper"] = this->d->m_frameDropper->stats();
+
+    return stats;
+}
+
+QByteArray AkElement::statsJson() const
+{
+    auto stats = QJsonObject::fromVariantMap(this->stats());
+
+    return QJsonDocument(stats).toJson();
+}
+
+bool AkElement::statsEnabled()
+{
+    return akElementStatsEnabled.load();
+}
+
+void AkElement::setStatsEnabled(bool enabled)
+{
+    akElementStatsEnabled.store(enabled);
+}
+
+AkElement::FrameDropPolicy AkElement::frameDropPolicy() const
+{
+    return this->d->m_frameDropper->dropPolicy();
+}
+
+qreal AkElement::maxLateness() const
+{
+    return this->d->m_frameDropper->maxLateness();
+}
+
+bool AkElement::isStateless() const
+{
+    return AkElement::pluginInfo(this->pluginId())["MetaData"].toMap()
+                                                   ["stateless"].toBool();
+}
+
+AkPointOperator AkElement::pointOperator() const
+{
+    return AkPointOperator();
 }
 
 AkPacket AkElement::operator ()(const AkPacket &packet)
 {
+    if (this->d->checkDeadline()
+        && this->d->m_frameDropper->drop(packet))
+        return AkPacket();
+
+    if (akElementStatsEnabled.load())
+        return this->d->m_stats->measure(this,
+                                         packet,
+                                         this->isSignalConnected(akElementOStream()));
+
     return this->iStream(packet);
 }
 
 AkPacket AkElement::operator ()(const AkAudioPacket &packet)
 {
+    if (akElementStatsEnabled.load())
+        return this->d->m_stats->measure(this,
+                                         packet,
+                                         this->isSignalConnected(akElementOStream()));
+
     return this->iStream(packet);
 }
 
 AkPacket AkElement::operator ()(const AkVideoPacket &packet)
 {
+    if (this->d->checkDeadline()
+        && this->d->m_frameDropper->drop(packet.toPacket()))
+        return AkPacket();
+
+    if (akElementStatsEnabled.load())
+        return this->d->m_stats->measure(this,
+                                         packet,
+                                         this->isSignalConnected(akElementOStream()));
+
     return this->iStream(packet);
 }
 
@@ -860,10 +1415,14 @@ void AkElement::stateChange(AkElement::ElementState from, AkElement::ElementStat
 
 AkPacket AkElement::iStream(const AkPacket &packet)
 {
-    if (packet.caps().mimeType() == "audio/x-raw")
+    switch (packet.caps().type()) {
+    case AkCaps::CapsAudio:
         return this->iStream(AkAudioPacket(packet));
-    else if (packet.caps().mimeType() == "video/x-raw")
+    case AkCaps::CapsVideo:
         return this->iStream(AkVideoPacket(packet));
+    default:
+        break;
+    }
 
     return AkPacket();
 }
@@ -957,6 +1516,40 @@ void AkElement::resetState()
     this->setState(ElementStateNull);
 }
 
+void AkElement::resetStats()
+{
+    this->d->m_stats->reset();
+    this->d->m_frameDropper->reset();
+}
+
+void AkElement::setFrameDropPolicy(AkElement::FrameDropPolicy frameDropPolicy)
+{
+    if (this->d->m_frameDropper->dropPolicy() == frameDropPolicy)
+        return;
+
+    this->d->m_frameDropper->setDropPolicy(frameDropPolicy);
+    emit this->frameDropPolicyChanged(frameDropPolicy);
+}
+
+void AkElement::setMaxLateness(qreal maxLateness)
+{
+    if (qFuzzyIsNull(this->d->m_frameDropper->maxLateness() - maxLateness))
+        return;
+
+    this->d->m_frameDropper->setMaxLateness(maxLateness);
+    emit this->maxLatenessChanged(this->d->m_frameDropper->maxLateness());
+}
+
+void AkElement::resetFrameDropPolicy()
+{
+    this->setFrameDropPolicy(FrameDropPolicy_Never);
+}
+
+void AkElement::resetMaxLateness()
+{
+    this->setMaxLateness(AkFrameDropper::defaultMaxLateness());
+}
+
 QDataStream &operator >>(QDataStream &istream, AkElement::ElementState &state)
 {
     int stateInt;
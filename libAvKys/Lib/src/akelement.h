@@ -36,6 +36,7 @@ class AkElementPrivate;
 class AkPacket;
 class AkAudioPacket;
 class AkVideoPacket;
+class AkPointOperator;
 class QDataStream;
 class QQmlEngine;
 class QQmlContext;
@@ -47,6 +48,7 @@ class AKCOMMONS_EXPORT AkElement: public QObject
 {
     Q_OBJECT
     Q_ENUMS(ElementState)
+    Q_ENUMS(FrameDropPolicy)
     Q_PROPERTY(QString pluginId
                READ pluginId)
     Q_PROPERTY(QString pluginPath
@@ -56,6 +58,19 @@ class AKCOMMONS_EXPORT AkElement: public QObject
                WRITE setState
                RESET resetState
                NOTIFY stateChanged)
+    Q_PROPERTY(QVariantMap stats
+               READ stats
+               RESET resetStats)
+    Q_PROPERTY(AkElement::FrameDropPolicy frameDropPolicy
+               READ frameDropPolicy
+               WRITE setFrameDropPolicy
+               RESET resetFrameDropPolicy
+               NOTIFY frameDropPolicyChanged)
+    Q_PROPERTY(qreal maxLateness
+               READ maxLateness
+               WRITE setMaxLateness
+               RESET resetMaxLateness
+               NOTIFY maxLatenessChanged)
 
     public:
         enum ElementState
@@ -65,6 +80,12 @@ class AKCOMMONS_EXPORT AkElement: public QObject
             ElementStatePlaying
         };
 
+        enum FrameDropPolicy
+        {
+            FrameDropPolicy_Never,
+            FrameDropPolicy_Late
+        };
+
         explicit AkElement(QObject *parent=nullptr);
         virtual ~AkElement();
 
@@ -132,6 +153,41 @@ class AKCOMMONS_EXPORT AkElement: public QObject
                                               const QVariantMap &metaData);
         Q_INVOKABLE static void clearCache();
 
+        // The metadata of the plugins is cached in this file, and the plugins
+        // are loaded again only if they change. An empty file name disables
+        // the cache.
+        Q_INVOKABLE static QString pluginsCacheFile();
+        Q_INVOKABLE static void setPluginsCacheFile(const QString &fileName);
+        Q_INVOKABLE static void resetPluginsCacheFile();
+
+        // Packets counters and iStream() latency in nanoseconds, the latency
+        // doesn't include the time spent by the elements linked after it.
+        Q_INVOKABLE QVariantMap stats() const;
+        Q_INVOKABLE QByteArray statsJson() const;
+
+        // Stats are collected only while enabled, it can also be enabled with
+        // the AK_ELEMENT_STATS environment variable.
+        Q_INVOKABLE static bool statsEnabled();
+        Q_INVOKABLE static void setStatsEnabled(bool enabled);
+
+        // Video frames that arrive later than maxLateness frame durations to
+        // the element are dropped without calling iStream(), if the policy
+        // is FrameDropPolicy_Late.
+        Q_INVOKABLE AkElement::FrameDropPolicy frameDropPolicy() const;
+        Q_INVOKABLE qreal maxLateness() const;
+
+        // Stateless elements declare it in the plugin metadata with
+        // "stateless": true. Their output only depends on the input frame and
+        // the properties, and iStream() can run in several threads at the
+        // same time, so frames can be processed in parallel.
+        Q_INVOKABLE bool isStateless() const;
+
+        // Per-pixel operator equivalent to iStream() with the current
+        // properties, or an invalid operator if the element is not a point
+        // operator. Consecutive point operators are fused by
+        // AkPointOperator::run().
+        virtual AkPointOperator pointOperator() const;
+
         virtual AkPacket operator ()(const AkPacket &packet);
         virtual AkPacket operator ()(const AkAudioPacket &packet);
         virtual AkPacket operator ()(const AkVideoPacket &packet);
@@ -148,6 +204,8 @@ class AKCOMMONS_EXPORT AkElement: public QObject
     Q_SIGNALS:
         void stateChanged(AkElement::ElementState state);
         void oStream(const AkPacket &packet);
+        void frameDropPolicyChanged(AkElement::FrameDropPolicy frameDropPolicy);
+        void maxLatenessChanged(qreal maxLateness);
 
     public Q_SLOTS:
         virtual AkPacket iStream(const AkPacket &packet);
@@ -155,10 +213,16 @@ class AKCOMMONS_EXPORT AkElement: public QObject
         virtual AkPacket iStream(const AkVideoPacket &packet);
         virtual bool setState(AkElement::ElementState state);
         virtual void resetState();
+        void resetStats();
+        void setFrameDropPolicy(AkElement::FrameDropPolicy frameDropPolicy);
+        void setMaxLateness(qreal maxLateness);
+        void resetFrameDropPolicy();
+        void resetMaxLateness();
 };
 
 QDataStream &operator >>(QDataStream &istream, AkElement::ElementState &state);
 QDataStream &operator <<(QDataStream &ostream, AkElement::ElementState state);
 Q_DECLARE_METATYPE(AkElement::ElementState)
+Q_DECLARE_METATYPE(AkElement::FrameDropPolicy)
 
 #endif // AKELEMENT_H
@@ -0,0 +1,244 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "akframedispatcher.h"
+#include "akpacket.h"
+#include "akpointoperator.h"
+#include "akscheduler.h"
+#include "aklatencyhistogram.h"
+
+struct AkFrameDispatcherItem
+{
+    AkPacket m_packet;
+    qint64 m_startTime;
+};
+
+class AkFrameDispatcherPrivate
+{
+    public:
+        AkFrameDispatcher *self;
+        QList<AkElementPtr> m_elements;
+        int m_maxFrames;
+        QMutex m_mutex;
+        QWaitCondition m_frameSent;
+        QMap<quint64, AkFrameDispatcherItem> m_reorderBuffer;
+        quint64 m_nextIn {0};
+        quint64 m_nextOut {0};
+        bool m_sending {false};
+        int m_maxReorder {0};
+        QElapsedTimer m_timer;
+        AkLatencyHistogram m_latency;
+        QAtomicInteger<qint64> m_framesIn {0};
+        QAtomicInteger<qint64> m_framesOut {0};
+
+        // Declared last, so the pending tasks finish before destroying the
+        // rest of the members.
+        AkTaskGroup m_tasks;
+
+        explicit AkFrameDispatcherPrivate(AkFrameDispatcher *self);
+        static inline int defaultMaxFrames();
+        void send(quint64 index, const AkPacket &packet, qint64 startTime);
+};
+
+AkFrameDispatcher::AkFrameDispatcher(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkFrameDispatcherPrivate(this);
+}
+
+AkFrameDispatcher::~AkFrameDispatcher()
+{
+    this->flush();
+    delete this->d;
+}
+
+QList<AkElementPtr> AkFrameDispatcher::elements() const
+{
+    return this->d->m_elements;
+}
+
+int AkFrameDispatcher::maxFrames() const
+{
+    return this->d->m_maxFrames;
+}
+
+bool AkFrameDispatcher::canDispatch(const QList<AkElementPtr> &elements)
+{
+    for (const AkElementPtr &element: elements)
+        if (!element->isStateless())
+            return false;
+
+    return true;
+}
+
+QVariantMap AkFrameDispatcher::stats() const
+{
+    this->d->m_mutex.lock();
+    auto inFlight = qint64(this->d->m_nextIn - this->d->m_nextOut);
+    int maxReorder = this->d->m_maxReorder;
+    this->d->m_mutex.unlock();
+
+    return {
+        {"maxFrames" , this->d->m_maxFrames       },
+        {"framesIn"  , this->d->m_framesIn.load() },
+        {"framesOut" , this->d->m_framesOut.load()},
+        {"inFlight"  , inFlight                   },
+        {"maxReorder", maxReorder                 },
+        {"latency"   , this->d->m_latency.toMap() },
+    };
+}
+
+void AkFrameDispatcher::flush()
+{
+    this->d->m_tasks.wait();
+}
+
+void AkFrameDispatcher::setElements(const QList<AkElementPtr> &elements)
+{
+    this->flush();
+    this->d->m_mutex.lock();
+    this->d->m_elements = elements;
+    this->d->m_mutex.unlock();
+}
+
+void AkFrameDispatcher::setMaxFrames(int maxFrames)
+{
+    maxFrames = qMax(maxFrames, 1);
+
+    if (this->d->m_maxFrames == maxFrames)
+        return;
+
+    this->d->m_mutex.lock();
+    this->d->m_maxFrames = maxFrames;
+    this->d->m_frameSent.wakeAll();
+    this->d->m_mutex.unlock();
+    emit this->maxFramesChanged(maxFrames);
+}
+
+void AkFrameDispatcher::resetElements()
+{
+    this->setElements({});
+}
+
+void AkFrameDispatcher::resetMaxFrames()
+{
+    this->setMaxFrames(AkFrameDispatcherPrivate::defaultMaxFrames());
+}
+
+void AkFrameDispatcher::resetStats()
+{
+    this->d->m_mutex.lock();
+    this->d->m_maxReorder = 0;
+    this->d->m_mutex.unlock();
+    this->d->m_framesIn.store(0);
+    this->d->m_framesOut.store(0);
+    this->d->m_latency.reset();
+}
+
+void AkFrameDispatcher::iStream(const AkPacket &packet)
+{
+    auto startTime = this->d->m_timer.nsecsElapsed();
+    this->d->m_framesIn.fetchAndAddRelaxed(1);
+    this->d->m_mutex.lock();
+
+    while (this->d->m_nextIn - this->d->m_nextOut
+           >= quint64(this->d->m_maxFrames))
+        this->d->m_frameSent.wait(&this->d->m_mutex);
+
+    auto index = this->d->m_nextIn++;
+    auto elements = this->d->m_elements;
+    this->d->m_mutex.unlock();
+
+    // Without worker threads the tasks only run while waiting for them, so
+    // the frame is processed here.
+    if (AkScheduler::threadCount() < 2) {
+        this->d->send(index,
+                      AkPointOperator::run(elements, packet),
+                      startTime);
+
+        return;
+    }
+
+    auto d = this->d;
+
+    this->d->m_tasks.run([d, index, elements, packet, startTime] () {
+        d->send(index, AkPointOperator::run(elements, packet), startTime);
+    });
+}
+
+AkFrameDispatcherPrivate::AkFrameDispatcherPrivate(AkFrameDispatcher *self):
+    self(self),
+    m_maxFrames(defaultMaxFrames())
+{
+    this->m_timer.start();
+}
+
+int AkFrameDispatcherPrivate::defaultMaxFrames()
+{
+    return AkScheduler::threadCount();
+}
+
+void AkFrameDispatcherPrivate::send(quint64 index,
+                                    const AkPacket &packet,
+                                    qint64 startTime)
+{
+    this->m_mutex.lock();
+    this->m_reorderBuffer[index] = {packet, startTime};
+    this->m_maxReorder = qMax(this->m_maxReorder,
+                              this->m_reorderBuffer.size());
+
+    // Only one thread sends the frames at a time, the others just leave
+    // their frame in the buffer.
+    if (this->m_sending) {
+        this->m_mutex.unlock();
+
+        return;
+    }
+
+    this->m_sending = true;
+
+    while (!this->m_reorderBuffer.isEmpty()
+           && this->m_reorderBuffer.firstKey() == this->m_nextOut) {
+        auto item = this->m_reorderBuffer.take(this->m_nextOut);
+        this->m_mutex.unlock();
+
+        // Frames dropped by the elements only advance the sequence.
+        if (item.m_packet) {
+            this->m_latency.record(this->m_timer.nsecsElapsed()
+                                   - item.m_startTime);
+            this->m_framesOut.fetchAndAddRelaxed(1);
+            emit self->oStream(item.m_packet);
+        }
+
+        this->m_mutex.lock();
+        this->m_nextOut++;
+        this->m_frameSent.wakeAll();
+    }
+
+    this->m_sending = false;
+    this->m_mutex.unlock();
+}
+
+#include "moc_akframedispatcher.cpp"
@@ -0,0 +1,87 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKFRAMEDISPATCHER_H
+#define AKFRAMEDISPATCHER_H
+
+#include "akelement.h"
+
+class AkFrameDispatcherPrivate;
+
+// Processes several frames at the same time through a chain of stateless
+// elements, and sends them in the same order they arrived.
+//
+// Every frame runs the whole chain in a task of the scheduler, at most
+// maxFrames frames are in flight, and iStream() waits when the window is
+// full, so no frame is dropped. The frames that finish are kept in a reorder
+// buffer, indexed by arrival order, until all the frames before them are
+// sent. This favors throughput over latency, and is intended for offline
+// processing.
+//
+// The elements must declare themselves stateless in the plugin metadata, see
+// AkElement::isStateless().
+class AKCOMMONS_EXPORT AkFrameDispatcher: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int maxFrames
+               READ maxFrames
+               WRITE setMaxFrames
+               RESET resetMaxFrames
+               NOTIFY maxFramesChanged)
+    Q_PROPERTY(QVariantMap stats
+               READ stats
+               RESET resetStats)
+
+    public:
+        explicit AkFrameDispatcher(QObject *parent=nullptr);
+        ~AkFrameDispatcher();
+
+        Q_INVOKABLE QList<AkElementPtr> elements() const;
+        Q_INVOKABLE int maxFrames() const;
+
+        // Returns true if all the elements are stateless.
+        Q_INVOKABLE static bool canDispatch(const QList<AkElementPtr> &elements);
+
+        // Frames counters, the reorder buffer occupancy, and the time from
+        // iStream() until the frame is sent, in nanoseconds.
+        Q_INVOKABLE QVariantMap stats() const;
+
+        // Waits until all the frames in flight are sent.
+        Q_INVOKABLE void flush();
+
+    private:
+        AkFrameDispatcherPrivate *d;
+
+    signals:
+        void maxFramesChanged(int maxFrames);
+
+        // Emitted from the thread that completed the frame, but never from
+        // two threads at the same time.
+        void oStream(const AkPacket &packet);
+
+    public slots:
+        void setElements(const QList<AkElementPtr> &elements);
+        void setMaxFrames(int maxFrames);
+        void resetElements();
+        void resetMaxFrames();
+        void resetStats();
+        void iStream(const AkPacket &packet);
+};
+
+#endif // AKFRAMEDISPATCHER_H
@@ -0,0 +1,164 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include "akframedropper.h"
+#include "akcaps.h"
+#include "akpacket.h"
+#include "akvideocaps.h"
+#include "aklatencyhistogram.h"
+
+#define DEFAULT_FRAME_DURATION (1e9 / 30)
+#define DEFAULT_MAX_LATENESS 2.0
+
+// A pts jump bigger than this restarts the clock mapping.
+#define MAX_PTS_JUMP 1e9
+
+// The reference delay slowly follows the current delay, so a small drift
+// between the source clock and the local clock doesn't end up dropping all
+// frames.
+#define DELAY_DRIFT_FACTOR (1.0 / 1024)
+
+class AkFrameDropperPrivate
+{
+    public:
+        mutable QMutex m_mutex;
+        QElapsedTimer m_timer;
+        AkLatencyHistogram m_lateness;
+        QAtomicInt m_dropPolicy {AkElement::FrameDropPolicy_Never};
+        qreal m_maxLateness {DEFAULT_MAX_LATENESS};
+        qint64 m_id {-1};
+        uint m_capsHash {0};
+        qreal m_frameDuration {DEFAULT_FRAME_DURATION};
+        qreal m_lastPts {0.0};
+        qreal m_delay {0.0};
+        bool m_synced {false};
+        QAtomicInteger<qint64> m_framesChecked {0};
+        QAtomicInteger<qint64> m_framesDropped {0};
+};
+
+AkFrameDropper::AkFrameDropper()
+{
+    this->d = new AkFrameDropperPrivate;
+    this->d->m_timer.start();
+}
+
+AkFrameDropper::~AkFrameDropper()
+{
+    delete this->d;
+}
+
+AkElement::FrameDropPolicy AkFrameDropper::dropPolicy() const
+{
+    return AkElement::FrameDropPolicy(this->d->m_dropPolicy.load());
+}
+
+void AkFrameDropper::setDropPolicy(AkElement::FrameDropPolicy dropPolicy)
+{
+    this->d->m_dropPolicy = dropPolicy;
+}
+
+qreal AkFrameDropper::maxLateness() const
+{
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+
+    return this->d->m_maxLateness;
+}
+
+void AkFrameDropper::setMaxLateness(qreal maxLateness)
+{
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+    this->d->m_maxLateness = qMax(maxLateness, 0.0);
+}
+
+qreal AkFrameDropper::defaultMaxLateness()
+{
+    return DEFAULT_MAX_LATENESS;
+}
+
+bool AkFrameDropper::drop(const AkPacket &packet)
+{
+    auto caps = packet.caps();
+
+    if (caps.type() != AkCaps::CapsVideo || !packet.timeBase().isValid())
+        return false;
+
+    qint64 now = this->d->m_timer.nsecsElapsed();
+    qreal pts = 1e9 * packet.pts() * packet.timeBase().value();
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+
+    // Take the frame duration from the caps when they change.
+    if (packet.id() != this->d->m_id || caps.hash() != this->d->m_capsHash) {
+        this->d->m_id = packet.id();
+        this->d->m_capsHash = caps.hash();
+        qreal fps = AkVideoCaps(caps).fps().value();
+        this->d->m_frameDuration = fps > 0? 1e9 / fps: DEFAULT_FRAME_DURATION;
+        this->d->m_synced = false;
+    }
+
+    qreal delay = now - pts;
+    qreal ptsDiff = pts - this->d->m_lastPts;
+
+    if (!this->d->m_synced || ptsDiff < 0 || ptsDiff > MAX_PTS_JUMP) {
+        this->d->m_delay = delay;
+        this->d->m_synced = true;
+    } else if (delay < this->d->m_delay) {
+        this->d->m_delay = delay;
+    } else {
+        this->d->m_delay += DELAY_DRIFT_FACTOR * (delay - this->d->m_delay);
+    }
+
+    this->d->m_lastPts = pts;
+    auto lateness = qint64(delay - this->d->m_delay);
+    bool late = this->dropPolicy() == AkElement::FrameDropPolicy_Late
+                && lateness > this->d->m_maxLateness * this->d->m_frameDuration;
+    mutexLocker.unlock();
+
+    this->d->m_lateness.record(lateness);
+    this->d->m_framesChecked.fetchAndAddRelaxed(1);
+
+    if (late)
+        this->d->m_framesDropped.fetchAndAddRelaxed(1);
+
+    return late;
+}
+
+QVariantMap AkFrameDropper::stats() const
+{
+    return {
+        {"dropPolicy"   , this->dropPolicy() == AkElement::FrameDropPolicy_Late?
+                              "late": "never"             },
+        {"maxLateness"  , this->maxLateness()             },
+        {"framesChecked", this->d->m_framesChecked.load() },
+        {"framesDropped", this->d->m_framesDropped.load() },
+        {"lateness"     , this->d->m_lateness.toMap()     },
+    };
+}
+
+void AkFrameDropper::reset()
+{
+    this->d->m_framesChecked = 0;
+    this->d->m_framesDropped = 0;
+    this->d->m_lateness.reset();
+    QMutexLocker mutexLocker(&this->d->m_mutex);
+    this->d->m_synced = false;
+}
@@ -0,0 +1,61 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKFRAMEDROPPER_H
+#define AKFRAMEDROPPER_H
+
+#include "akelement.h"
+
+class AkFrameDropperPrivate;
+
+// Decides when a video frame arrives too late to be worth processing.
+//
+// The pts of every frame is mapped to the local clock, taking as reference
+// the frame that arrived earliest relative to its pts, so the deadline of a
+// frame is its pts plus the best delay seen so far, plus the tolerated
+// lateness. The lateness is given in frames, the frame duration is taken from
+// the frame rate in the caps. Audio and other packets are never dropped.
+class AKCOMMONS_EXPORT AkFrameDropper
+{
+    public:
+        AkFrameDropper();
+        ~AkFrameDropper();
+
+        AkElement::FrameDropPolicy dropPolicy() const;
+        void setDropPolicy(AkElement::FrameDropPolicy dropPolicy);
+        qreal maxLateness() const;
+        void setMaxLateness(qreal maxLateness);
+        static qreal defaultMaxLateness();
+
+        // Returns true if the packet must be dropped. The lateness is
+        // recorded even if the policy never drops.
+        bool drop(const AkPacket &packet);
+
+        // Frames checked and dropped, and the lateness histogram in
+        // nanoseconds.
+        QVariantMap stats() const;
+        void reset();
+
+    private:
+        AkFrameDropperPrivate *d;
+
+        Q_DISABLE_COPY(AkFrameDropper)
+};
+
+#endif // AKFRAMEDROPPER_H
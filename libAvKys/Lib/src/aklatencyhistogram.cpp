@@ -0,0 +1,186 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QtAlgorithms>
+#include <QtMath>
+
+#include "aklatencyhistogram.h"
+
+// Sub-buckets per bucket, the first half of every bucket overlaps with the
+// previous one, so only the upper half is stored.
+#define SUB_BUCKET_MAGNITUDE 7
+#define SUB_BUCKET_COUNT (1 << SUB_BUCKET_MAGNITUDE)
+#define SUB_BUCKET_HALF_MAGNITUDE (SUB_BUCKET_MAGNITUDE - 1)
+#define SUB_BUCKET_HALF_COUNT (1 << SUB_BUCKET_HALF_MAGNITUDE)
+#define SUB_BUCKET_MASK quint64(SUB_BUCKET_COUNT - 1)
+
+// Values are clamped to 2^37 - 1 ns.
+#define MAX_VALUE_MAGNITUDE 37
+#define MAX_VALUE ((qint64(1) << MAX_VALUE_MAGNITUDE) - 1)
+#define BUCKET_COUNT (MAX_VALUE_MAGNITUDE - SUB_BUCKET_HALF_MAGNITUDE)
+#define COUNTS_SIZE ((BUCKET_COUNT + 1) << SUB_BUCKET_HALF_MAGNITUDE)
+
+class AkLatencyHistogramPrivate
+{
+    public:
+        QAtomicInteger<quint32> m_counts[COUNTS_SIZE];
+        QAtomicInteger<qint64> m_count;
+        QAtomicInteger<qint64> m_sum;
+        QAtomicInteger<qint64> m_min;
+        QAtomicInteger<qint64> m_max;
+
+        AkLatencyHistogramPrivate():
+            m_count(0),
+            m_sum(0),
+            m_min(MAX_VALUE),
+            m_max(0)
+        {
+            for (auto &count: this->m_counts)
+                count.store(0);
+        }
+
+        inline static int index(qint64 value)
+        {
+            auto v = quint64(value) | SUB_BUCKET_MASK;
+            int bucket = 64
+                       - int(qCountLeadingZeroBits(v))
+                       - (SUB_BUCKET_HALF_MAGNITUDE + 1);
+            int subBucket = int(quint64(value) >> bucket);
+
+            return ((bucket + 1) << SUB_BUCKET_HALF_MAGNITUDE)
+                   + subBucket - SUB_BUCKET_HALF_COUNT;
+        }
+
+        // Highest value that falls in the same sub-bucket.
+        inline static qint64 highestEquivalentValue(int index)
+        {
+            int bucket = (index >> SUB_BUCKET_HALF_MAGNITUDE) - 1;
+            int subBucket = (index & (SUB_BUCKET_HALF_COUNT - 1))
+                          + SUB_BUCKET_HALF_COUNT;
+
+            if (bucket < 0) {
+                bucket = 0;
+                subBucket -= SUB_BUCKET_HALF_COUNT;
+            }
+
+            return (qint64(subBucket) << bucket) + (qint64(1) << bucket) - 1;
+        }
+};
+
+AkLatencyHistogram::AkLatencyHistogram()
+{
+    this->d = new AkLatencyHistogramPrivate;
+}
+
+AkLatencyHistogram::~AkLatencyHistogram()
+{
+    delete this->d;
+}
+
+void AkLatencyHistogram::record(qint64 value)
+{
+    value = qBound<qint64>(0, value, MAX_VALUE);
+    this->d->m_counts[AkLatencyHistogramPrivate::index(value)].fetchAndAddRelaxed(1);
+    this->d->m_count.fetchAndAddRelaxed(1);
+    this->d->m_sum.fetchAndAddRelaxed(value);
+
+    qint64 min = this->d->m_min.load();
+
+    while (value < min
+           && !this->d->m_min.testAndSetRelaxed(min, value, min)) {
+    }
+
+    qint64 max = this->d->m_max.load();
+
+    while (value > max
+           && !this->d->m_max.testAndSetRelaxed(max, value, max)) {
+    }
+}
+
+qint64 AkLatencyHistogram::count() const
+{
+    return this->d->m_count.load();
+}
+
+qint64 AkLatencyHistogram::min() const
+{
+    return this->d->m_count.load() > 0? this->d->m_min.load(): 0;
+}
+
+qint64 AkLatencyHistogram::max() const
+{
+    return this->d->m_max.load();
+}
+
+qreal AkLatencyHistogram::mean() const
+{
+    auto count = this->d->m_count.load();
+
+    return count > 0? qreal(this->d->m_sum.load()) / count: 0;
+}
+
+qint64 AkLatencyHistogram::percentile(qreal percent) const
+{
+    qint64 total = 0;
+
+    for (auto &count: this->d->m_counts)
+        total += count.load();
+
+    if (total < 1)
+        return 0;
+
+    percent = qBound<qreal>(0.0, percent, 100.0);
+    auto target = qMax<qint64>(1, qint64(qCeil(percent * total / 100.0)));
+    qint64 accumulated = 0;
+
+    for (int i = 0; i < COUNTS_SIZE; i++) {
+        accumulated += this->d->m_counts[i].load();
+
+        if (accumulated >= target)
+            return qMin(AkLatencyHistogramPrivate::highestEquivalentValue(i),
+                        this->max());
+    }
+
+    return this->max();
+}
+
+QVariantMap AkLatencyHistogram::toMap() const
+{
+    return QVariantMap {
+        {"count", this->count()},
+        {"min"  , this->min()  },
+        {"max"  , this->max()  },
+        {"mean" , this->mean() },
+        {"p50"  , this->percentile(50)},
+        {"p95"  , this->percentile(95)},
+        {"p99"  , this->percentile(99)},
+    };
+}
+
+void AkLatencyHistogram::reset()
+{
+    for (auto &count: this->d->m_counts)
+        count.store(0);
+
+    this->d->m_count.store(0);
+    this->d->m_sum.store(0);
+    this->d->m_min.store(MAX_VALUE);
+    this->d->m_max.store(0);
+}
@@ -0,0 +1,61 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKLATENCYHISTOGRAM_H
+#define AKLATENCYHISTOGRAM_H
+
+#include <QVariantMap>
+
+#include "akcommons.h"
+
+class AkLatencyHistogramPrivate;
+
+// High dynamic range histogram of durations in nanoseconds.
+//
+// Values are stored in logarithmic buckets split in linear sub-buckets, so
+// percentiles are reported with less than 1.6% of error, from 1 ns up to
+// ~137 s. record() is lock free and can be called from several threads at the
+// same time.
+class AKCOMMONS_EXPORT AkLatencyHistogram
+{
+    public:
+        AkLatencyHistogram();
+        ~AkLatencyHistogram();
+
+        void record(qint64 value);
+        qint64 count() const;
+        qint64 min() const;
+        qint64 max() const;
+        qreal mean() const;
+
+        // Smallest value such that the given percent of the recorded values
+        // are less or equal than it.
+        qint64 percentile(qreal percent) const;
+
+        // count, min, max, mean, p50, p95 and p99.
+        QVariantMap toMap() const;
+        void reset();
+
+    private:
+        AkLatencyHistogramPrivate *d;
+
+        Q_DISABLE_COPY(AkLatencyHistogram)
+};
+
+#endif // AKLATENCYHISTOGRAM_H
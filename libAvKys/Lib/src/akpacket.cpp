@@ -23,25 +23,29 @@
 #include "akpacket.h"
 #include "akcaps.h"
 
-class AkPacketPrivate
+class AkPacketPrivate: public QSharedData
 {
     public:
         AkCaps m_caps;
         QVariant m_data;
         QByteArray m_buffer;
+        QVariant m_bufferOwner;
         qint64 m_pts;
         AkFrac m_timeBase;
         int m_index;
         qint64 m_id;
+
+        AkPacketPrivate():
+            m_pts(0),
+            m_index(-1),
+            m_id(-1)
+        {
+        }
 };
 
-AkPacket::AkPacket(QObject *parent):
-    QObject(parent)
+AkPacket::AkPacket()
 {
     this->d = new AkPacketPrivate();
-    this->d->m_pts = 0;
-    this->d->m_index = -1;
-    this->d->m_id = -1;
 }
 
 AkPacket::AkPacket(const AkCaps &caps,
@@ -62,34 +66,31 @@ AkPacket::AkPacket(const AkCaps &caps,
 }
 
 AkPacket::AkPacket(const AkPacket &other):
-    QObject()
+    d(other.d)
+{
+}
+
+AkPacket::AkPacket(AkPacket &&other) noexcept:
+    d(std::move(other.d))
 {
-    this->d = new AkPacketPrivate();
-    this->d->m_caps = other.d->m_caps;
-    this->d->m_data = other.d->m_data;
-    this->d->m_buffer = other.d->m_buffer;
-    this->d->m_pts = other.d->m_pts;
-    this->d->m_timeBase = other.d->m_timeBase;
-    this->d->m_index = other.d->m_index;
-    this->d->m_id = other.d->m_id;
 }
 
 AkPacket::~AkPacket()
 {
-    delete this->d;
 }
 
 AkPacket &AkPacket::operator =(const AkPacket &other)
 {
-    if (this != &other) {
-        this->d->m_caps = other.d->m_caps;
-        this->d->m_data = other.d->m_data;
-        this->d->m_buffer = other.d->m_buffer;
-        this->d->m_pts = other.d->m_pts;
-        this->d->m_timeBase = other.d->m_timeBase;
-        this->d->m_index = other.d->m_index;
-        this->d->m_id = other.d->m_id;
-    }
+    if (this != &other)
+        this->d = other.d;
+
+    return *this;
+}
+
+AkPacket &AkPacket::operator =(AkPacket &&other) noexcept
+{
+    if (this != &other)
+        this->d.swap(other.d);
 
     return *this;
 }
@@ -208,65 +209,58 @@ int &AkPacket::index()
 
 void AkPacket::setCaps(const AkCaps &caps)
 {
-    if (this->d->m_caps == caps)
+    if (this->d.constData()->m_caps == caps)
         return;
 
     this->d->m_caps = caps;
-    emit this->capsChanged(caps);
 }
 
 void AkPacket::setData(const QVariant &data)
 {
-    if (this->d->m_data == data)
+    if (this->d.constData()->m_data == data)
         return;
 
     this->d->m_data = data;
-    emit this->dataChanged(data);
 }
 
 void AkPacket::setBuffer(const QByteArray &buffer)
 {
-    if (this->d->m_buffer == buffer)
+    if (this->d.constData()->m_buffer == buffer)
         return;
 
     this->d->m_buffer = buffer;
-    emit this->bufferChanged(buffer);
 }
 
 void AkPacket::setId(qint64 id)
 {
-    if (this->d->m_id == id)
+    if (this->d.constData()->m_id == id)
         return;
 
     this->d->m_id = id;
-    emit this->idChanged(id);
 }
 
 void AkPacket::setPts(qint64 pts)
 {
-    if (this->d->m_pts == pts)
+    if (this->d.constData()->m_pts == pts)
         return;
 
     this->d->m_pts = pts;
-    emit this->ptsChanged(pts);
 }
 
 void AkPacket::setTimeBase(const AkFrac &timeBase)
 {
-    if (this->d->m_timeBase == timeBase)
+    if (this->d.constData()->m_timeBase == timeBase)
         return;
 
     this->d->m_timeBase = timeBase;
-    emit this->timeBaseChanged(timeBase);
 }
 
 void AkPacket::setIndex(int index)
 {
-    if (this->d->m_index == index)
+    if (this->d.constData()->m_index == index)
         return;
 
     this->d->m_index = index;
-    emit this->indexChanged(index);
 }
 
 void AkPacket::resetCaps()
@@ -304,6 +298,17 @@ void AkPacket::resetIndex()
     this->setIndex(-1);
 }
 
+QVariant AkPacket::bufferOwner() const
+{
+    return this->d->m_bufferOwner;
+}
+
+// The owner is not compared, comparing images is expensive.
+void AkPacket::setBufferOwner(const QVariant &owner)
+{
+    this->d->m_bufferOwner = owner;
+}
+
 QDebug operator <<(QDebug debug, const AkPacket &packet)
 {
     debug.nospace() << packet.toString().toStdString().c_str();
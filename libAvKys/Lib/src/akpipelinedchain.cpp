@@ -0,0 +1,408 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QQueue>
+#include <QReadWriteLock>
+#include <QThread>
+#include <QWaitCondition>
+
+#include "akpipelinedchain.h"
+#include "akpacket.h"
+#include "akpointoperator.h"
+#include "aklatencyhistogram.h"
+
+#define DEFAULT_DEPTH 2
+
+class AkPipelinedChainPrivate;
+
+struct AkPipelinedChainItem
+{
+    AkPacket m_packet;
+    qint64 m_queuedTime;
+};
+
+class AkPipelinedChainStage: public QThread
+{
+    public:
+        AkPipelinedChainPrivate *m_chain;
+        QList<AkElementPtr> m_elements;
+        AkPipelinedChainStage *m_next {nullptr};
+        int m_depth;
+        bool m_dropOldest;
+        bool m_run {true};
+
+        // True while a packet is being processed or sent to the next stage.
+        bool m_busy {false};
+        QMutex m_mutex;
+        QWaitCondition m_notEmpty;
+        QWaitCondition m_notFull;
+        QWaitCondition m_idle;
+        QQueue<AkPipelinedChainItem> m_queue;
+        AkLatencyHistogram m_latency;
+        AkLatencyHistogram m_processing;
+        QAtomicInteger<qint64> m_packetsIn {0};
+        QAtomicInteger<qint64> m_packetsOut {0};
+        QAtomicInteger<qint64> m_packetsDropped {0};
+
+        AkPipelinedChainStage(AkPipelinedChainPrivate *chain,
+                              const QList<AkElementPtr> &elements,
+                              int depth,
+                              bool dropOldest);
+        void push(const AkPacket &packet);
+        void waitIdle();
+        QVariantMap stats() const;
+        void resetStats();
+
+    protected:
+        void run();
+
+    private:
+        void process(const AkPipelinedChainItem &item);
+};
+
+class AkPipelinedChainPrivate
+{
+    public:
+        AkPipelinedChain *self;
+        QList<AkElementPtr> m_elements;
+        QList<AkPipelinedChainStage *> m_stages;
+        int m_depth {DEFAULT_DEPTH};
+        QElapsedTimer m_timer;
+        QReadWriteLock m_stagesLock;
+
+        explicit AkPipelinedChainPrivate(AkPipelinedChain *self);
+        void startStages();
+        void flushStages();
+        void stopStages();
+};
+
+AkPipelinedChain::AkPipelinedChain(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkPipelinedChainPrivate(this);
+}
+
+AkPipelinedChain::~AkPipelinedChain()
+{
+    // The packets still queued are dropped, flush() sends them.
+    this->d->stopStages();
+    delete this->d;
+}
+
+QList<AkElementPtr> AkPipelinedChain::elements() const
+{
+    return this->d->m_elements;
+}
+
+int AkPipelinedChain::depth() const
+{
+    return this->d->m_depth;
+}
+
+int AkPipelinedChain::stages() const
+{
+    this->d->m_stagesLock.lockForRead();
+    int stages = this->d->m_stages.size();
+    this->d->m_stagesLock.unlock();
+
+    return stages;
+}
+
+QVariantMap AkPipelinedChain::stats() const
+{
+    QVariantList stages;
+    this->d->m_stagesLock.lockForRead();
+
+    for (auto stage: this->d->m_stages)
+        stages << stage->stats();
+
+    this->d->m_stagesLock.unlock();
+
+    return {
+        {"depth" , this->d->m_depth},
+        {"stages", stages          },
+    };
+}
+
+void AkPipelinedChain::flush()
+{
+    this->d->m_stagesLock.lockForRead();
+    this->d->flushStages();
+    this->d->m_stagesLock.unlock();
+}
+
+void AkPipelinedChain::setElements(const QList<AkElementPtr> &elements)
+{
+    this->d->m_stagesLock.lockForWrite();
+    this->d->flushStages();
+    this->d->stopStages();
+    this->d->m_elements = elements;
+    this->d->startStages();
+    this->d->m_stagesLock.unlock();
+}
+
+void AkPipelinedChain::setDepth(int depth)
+{
+    depth = qMax(depth, 1);
+
+    if (this->d->m_depth == depth)
+        return;
+
+    this->d->m_stagesLock.lockForWrite();
+    this->d->flushStages();
+    this->d->stopStages();
+    this->d->m_depth = depth;
+    this->d->startStages();
+    this->d->m_stagesLock.unlock();
+    emit this->depthChanged(depth);
+}
+
+void AkPipelinedChain::resetElements()
+{
+    this->setElements({});
+}
+
+void AkPipelinedChain::resetDepth()
+{
+    this->setDepth(DEFAULT_DEPTH);
+}
+
+void AkPipelinedChain::resetStats()
+{
+    this->d->m_stagesLock.lockForRead();
+
+    for (auto stage: this->d->m_stages)
+        stage->resetStats();
+
+    this->d->m_stagesLock.unlock();
+}
+
+void AkPipelinedChain::iStream(const AkPacket &packet)
+{
+    this->d->m_stagesLock.lockForRead();
+
+    if (this->d->m_stages.isEmpty())
+        emit this->oStream(packet);
+    else
+        this->d->m_stages.first()->push(packet);
+
+    this->d->m_stagesLock.unlock();
+}
+
+AkPipelinedChainPrivate::AkPipelinedChainPrivate(AkPipelinedChain *self):
+    self(self)
+{
+    this->m_timer.start();
+}
+
+void AkPipelinedChainPrivate::startStages()
+{
+    bool fusion = AkPointOperator::fusionEnabled();
+    QList<AkElementPtr> elements;
+
+    for (int i = 0; i < this->m_elements.size(); i++) {
+        auto element = this->m_elements[i];
+        elements << element;
+
+        // The consecutive point operators go in the same stage, since they
+        // are processed in a single pass.
+        auto next = this->m_elements.value(i + 1);
+
+        if (fusion
+            && next
+            && element->pointOperator()
+            && next->pointOperator())
+            continue;
+
+        auto stage = new AkPipelinedChainStage(this,
+                                               elements,
+                                               this->m_depth,
+                                               this->m_stages.isEmpty());
+
+        if (!this->m_stages.isEmpty())
+            this->m_stages.last()->m_next = stage;
+
+        this->m_stages << stage;
+        elements.clear();
+    }
+
+    for (int i = 0; i < this->m_stages.size(); i++) {
+        this->m_stages[i]->setObjectName(QString("AkPipelinedChain stage %1")
+                                         .arg(i));
+        this->m_stages[i]->start();
+    }
+}
+
+void AkPipelinedChainPrivate::flushStages()
+{
+    // A stage only becomes idle after sending its last packet to the next
+    // one, so waiting for the stages in order leaves the whole chain empty.
+    for (auto stage: this->m_stages)
+        stage->waitIdle();
+}
+
+void AkPipelinedChainPrivate::stopStages()
+{
+    // Stop all stages before waiting, so no stage keeps waiting for room in
+    // the next one.
+    for (auto stage: this->m_stages) {
+        stage->m_mutex.lock();
+        stage->m_run = false;
+        stage->m_notEmpty.wakeAll();
+        stage->m_notFull.wakeAll();
+        stage->m_idle.wakeAll();
+        stage->m_mutex.unlock();
+    }
+
+    for (auto stage: this->m_stages) {
+        stage->wait();
+        delete stage;
+    }
+
+    this->m_stages.clear();
+}
+
+AkPipelinedChainStage::AkPipelinedChainStage(AkPipelinedChainPrivate *chain,
+                                             const QList<AkElementPtr> &elements,
+                                             int depth,
+                                             bool dropOldest):
+    m_chain(chain),
+    m_elements(elements),
+    m_depth(depth),
+    m_dropOldest(dropOldest)
+{
+}
+
+void AkPipelinedChainStage::push(const AkPacket &packet)
+{
+    // The time waiting for room in the queue is part of the latency of the
+    // stage.
+    AkPipelinedChainItem item {packet, this->m_chain->m_timer.nsecsElapsed()};
+    this->m_packetsIn.fetchAndAddRelaxed(1);
+    this->m_mutex.lock();
+
+    while (this->m_run && this->m_queue.size() >= this->m_depth) {
+        if (this->m_dropOldest) {
+            this->m_queue.dequeue();
+            this->m_packetsDropped.fetchAndAddRelaxed(1);
+        } else {
+            this->m_notFull.wait(&this->m_mutex);
+        }
+    }
+
+    if (this->m_run) {
+        this->m_queue.enqueue(item);
+        this->m_notEmpty.wakeOne();
+    } else {
+        this->m_packetsDropped.fetchAndAddRelaxed(1);
+    }
+
+    this->m_mutex.unlock();
+}
+
+void AkPipelinedChainStage::waitIdle()
+{
+    this->m_mutex.lock();
+
+    while (this->m_run && (this->m_busy || !this->m_queue.isEmpty()))
+        this->m_idle.wait(&this->m_mutex);
+
+    this->m_mutex.unlock();
+}
+
+QVariantMap AkPipelinedChainStage::stats() const
+{
+    QStringList elements;
+
+    for (const AkElementPtr &element: this->m_elements)
+        elements << element->pluginId();
+
+    return {
+        {"elements"      , elements                       },
+        {"packetsIn"     , this->m_packetsIn.load()       },
+        {"packetsOut"    , this->m_packetsOut.load()      },
+        {"packetsDropped", this->m_packetsDropped.load()  },
+        {"processing"    , this->m_processing.toMap()     },
+        {"latency"       , this->m_latency.toMap()        },
+    };
+}
+
+void AkPipelinedChainStage::resetStats()
+{
+    this->m_packetsIn.store(0);
+    this->m_packetsOut.store(0);
+    this->m_packetsDropped.store(0);
+    this->m_processing.reset();
+    this->m_latency.reset();
+}
+
+void AkPipelinedChainStage::run()
+{
+    forever {
+        this->m_mutex.lock();
+
+        while (this->m_run && this->m_queue.isEmpty())
+            this->m_notEmpty.wait(&this->m_mutex);
+
+        if (!this->m_run) {
+            this->m_mutex.unlock();
+
+            break;
+        }
+
+        auto item = this->m_queue.dequeue();
+        this->m_busy = true;
+        this->m_notFull.wakeOne();
+        this->m_mutex.unlock();
+
+        this->process(item);
+
+        this->m_mutex.lock();
+        this->m_busy = false;
+
+        if (this->m_queue.isEmpty())
+            this->m_idle.wakeAll();
+
+        this->m_mutex.unlock();
+    }
+}
+
+void AkPipelinedChainStage::process(const AkPipelinedChainItem &item)
+{
+    auto startTime = this->m_chain->m_timer.nsecsElapsed();
+    auto oPacket = AkPointOperator::run(this->m_elements, item.m_packet);
+    auto endTime = this->m_chain->m_timer.nsecsElapsed();
+    this->m_processing.record(endTime - startTime);
+    this->m_latency.record(endTime - item.m_queuedTime);
+
+    if (!oPacket)
+        return;
+
+    this->m_packetsOut.fetchAndAddRelaxed(1);
+
+    if (this->m_next)
+        this->m_next->push(oPacket);
+    else
+        emit this->m_chain->self->oStream(oPacket);
+}
+
+#include "moc_akpipelinedchain.cpp"
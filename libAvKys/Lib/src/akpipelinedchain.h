@@ -0,0 +1,89 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKPIPELINEDCHAIN_H
+#define AKPIPELINEDCHAIN_H
+
+#include "akelement.h"
+
+class AkPipelinedChainPrivate;
+
+// Runs a chain of elements as a pipeline, with every stage in its own thread
+// and a small bounded queue in front of it.
+//
+// The throughput is limited by the slowest stage instead of the sum of all
+// the elements. Every stage processes the packets in the order they arrive,
+// so the order and the timestamps of the frames are preserved. Consecutive
+// point operators are grouped in a single stage and fused.
+//
+// When the queue of the first stage is full the oldest packet is dropped, so
+// the caller never waits, the rest of the stages wait for the next one to
+// make room, so no packet is lost inside the chain.
+class AKCOMMONS_EXPORT AkPipelinedChain: public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int depth
+               READ depth
+               WRITE setDepth
+               RESET resetDepth
+               NOTIFY depthChanged)
+    Q_PROPERTY(int stages
+               READ stages)
+    Q_PROPERTY(QVariantMap stats
+               READ stats
+               RESET resetStats)
+
+    public:
+        explicit AkPipelinedChain(QObject *parent=nullptr);
+        ~AkPipelinedChain();
+
+        Q_INVOKABLE QList<AkElementPtr> elements() const;
+        Q_INVOKABLE int depth() const;
+        Q_INVOKABLE int stages() const;
+
+        // For every stage, the elements it runs, the packets counters, the
+        // time spent processing the packets, and the latency added by the
+        // stage, from the moment the packet is queued until it leaves the
+        // stage, in nanoseconds.
+        Q_INVOKABLE QVariantMap stats() const;
+
+        // Waits until the packets queued so far went through all the stages.
+        Q_INVOKABLE void flush();
+
+    private:
+        AkPipelinedChainPrivate *d;
+
+    signals:
+        void depthChanged(int depth);
+
+        // Emitted from the thread of the last stage.
+        void oStream(const AkPacket &packet);
+
+    public slots:
+        // Sends the queued packets through the running stages, stops them,
+        // and starts new ones for the elements.
+        void setElements(const QList<AkElementPtr> &elements);
+        void setDepth(int depth);
+        void resetElements();
+        void resetDepth();
+        void resetStats();
+        void iStream(const AkPacket &packet);
+};
+
+#endif // AKPIPELINEDCHAIN_H
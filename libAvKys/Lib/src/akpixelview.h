@@ -0,0 +1,578 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKPIXELVIEW_H
+#define AKPIXELVIEW_H
+
+#include "akvideocaps.h"
+#include "akpacket.h"
+#include "akvideopacket.h"
+#include "akutils.h"
+#include "akbufferpool.h"
+#include "akscheduler.h"
+
+// Compile time access to the pixels of a raw video frame in its own format.
+//
+// AkPixelLayout<Format> describes how a pixel format is stored in memory, and
+// AkPixelView<Format> wraps the planes of a frame and gives scanline and
+// per-component access to it. Point-wise filters are written once as a
+// template and instantiated for each format through akPixelDispatch(), so
+// there is no per-pixel branching on the format and no conversion to ARGB32.
+//
+// The supported formats are the same layouts handled by AkVideoConverter:
+// 8 bits per component RGB (32 and 24 bits), gray, packed YUV 4:2:2, planar
+// YUV and semi-planar YUV.
+
+enum AkPixelLayoutType
+{
+    AkPixelLayout_RGB32,
+    AkPixelLayout_RGB24,
+    AkPixelLayout_Gray,
+    AkPixelLayout_PackedYUV,
+    AkPixelLayout_PlanarYUV,
+    AkPixelLayout_SemiPlanarYUV
+};
+
+// RGB32: Red, Green, Blue and Alpha are bit shifts in a native endian word.
+// RGB24: Red, Green and Blue are byte offsets.
+// Packed YUV: Luma, Cb and Cr are byte offsets in a 2 pixels macropixel, the
+// second luma sample is at Luma + 2.
+// Semi-planar YUV: Cb and Cr are byte offsets in the interleaved chroma
+// plane.
+template<AkVideoCaps::PixelFormat Format>
+struct AkPixelLayout;
+
+#define AK_PIXEL_LAYOUT(format, type, r, g, b, a, hasAlpha, y, u, v, xShift, yShift, fullRange) \
+    template<> \
+    struct AkPixelLayout<AkVideoCaps::format> \
+    { \
+        static const AkPixelLayoutType Type = type; \
+        \
+        enum \
+        { \
+            Red = r, \
+            Green = g, \
+            Blue = b, \
+            Alpha = a, \
+            HasAlpha = hasAlpha, \
+            Luma = y, \
+            Cb = u, \
+            Cr = v, \
+            XShift = xShift, \
+            YShift = yShift, \
+            FullRange = fullRange \
+        }; \
+    };
+
+AK_PIXEL_LAYOUT(Format_argb    , AkPixelLayout_RGB32        , 16,  8,  0, 24, 1, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_0rgb    , AkPixelLayout_RGB32        , 16,  8,  0, 24, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_rgba    , AkPixelLayout_RGB32        , 24, 16,  8,  0, 1, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_rgb0    , AkPixelLayout_RGB32        , 24, 16,  8,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_abgr    , AkPixelLayout_RGB32        ,  0,  8, 16, 24, 1, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_0bgr    , AkPixelLayout_RGB32        ,  0,  8, 16, 24, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_bgra    , AkPixelLayout_RGB32        ,  8, 16, 24,  0, 1, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_bgr0    , AkPixelLayout_RGB32        ,  8, 16, 24,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_rgb24   , AkPixelLayout_RGB24        ,  0,  1,  2,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_bgr24   , AkPixelLayout_RGB24        ,  2,  1,  0,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_gray    , AkPixelLayout_Gray         ,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_yuyv422 , AkPixelLayout_PackedYUV    ,  0,  0,  0,  0, 0, 0, 1, 3, 1, 0, 0)
+AK_PIXEL_LAYOUT(Format_uyvy422 , AkPixelLayout_PackedYUV    ,  0,  0,  0,  0, 0, 1, 0, 2, 1, 0, 0)
+AK_PIXEL_LAYOUT(Format_yvyu422 , AkPixelLayout_PackedYUV    ,  0,  0,  0,  0, 0, 0, 3, 1, 1, 0, 0)
+AK_PIXEL_LAYOUT(Format_yuv420p , AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 1, 1, 0)
+AK_PIXEL_LAYOUT(Format_yuvj420p, AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 1, 1, 1)
+AK_PIXEL_LAYOUT(Format_yuv422p , AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 1, 0, 0)
+AK_PIXEL_LAYOUT(Format_yuvj422p, AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 1, 0, 1)
+AK_PIXEL_LAYOUT(Format_yuv444p , AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, 0)
+AK_PIXEL_LAYOUT(Format_yuvj444p, AkPixelLayout_PlanarYUV    ,  0,  0,  0,  0, 0, 0, 0, 0, 0, 0, 1)
+AK_PIXEL_LAYOUT(Format_nv12    , AkPixelLayout_SemiPlanarYUV,  0,  0,  0,  0, 0, 0, 0, 1, 1, 1, 0)
+AK_PIXEL_LAYOUT(Format_nv21    , AkPixelLayout_SemiPlanarYUV,  0,  0,  0,  0, 0, 0, 1, 0, 1, 1, 0)
+AK_PIXEL_LAYOUT(Format_nv16    , AkPixelLayout_SemiPlanarYUV,  0,  0,  0,  0, 0, 0, 0, 1, 1, 0, 0)
+
+#undef AK_PIXEL_LAYOUT
+
+// T is quint8 for frames that are written, and const quint8 for frames that
+// are only read.
+template<AkVideoCaps::PixelFormat Format, typename T=quint8>
+class AkPixelView
+{
+    public:
+        using Layout = AkPixelLayout<Format>;
+
+        enum
+        {
+            IsRgb = Layout::Type == AkPixelLayout_RGB32
+                    || Layout::Type == AkPixelLayout_RGB24,
+            IsYuv = !IsRgb,
+            Planes = Layout::Type == AkPixelLayout_PlanarYUV? 3:
+                     Layout::Type == AkPixelLayout_SemiPlanarYUV? 2: 1,
+            BytesPerPixel = Layout::Type == AkPixelLayout_RGB32? 4:
+                            Layout::Type == AkPixelLayout_RGB24? 3:
+                            Layout::Type == AkPixelLayout_PackedYUV? 2: 1,
+
+            // Range of the luma samples.
+            MinLuma = Layout::FullRange? 0: 16,
+            MaxLuma = Layout::FullRange? 255: 235
+        };
+
+        AkPixelView():
+            m_width(0),
+            m_height(0)
+        {
+            for (int i = 0; i < 3; i++) {
+                this->m_planes[i] = nullptr;
+                this->m_lineSize[i] = 0;
+            }
+        }
+
+        // Single plane formats can have padding at the end of each line,
+        // given by lineSize. Planar formats are always tightly packed, one
+        // plane after the other.
+        AkPixelView(T *data, int width, int height, int lineSize=0):
+            m_width(width),
+            m_height(height)
+        {
+            for (int i = 0; i < 3; i++) {
+                this->m_planes[i] = nullptr;
+                this->m_lineSize[i] = 0;
+            }
+
+            if (!data || width < 1 || height < 1)
+                return;
+
+            T *plane = data;
+
+            for (int i = 0; i < Planes; i++) {
+                this->m_planes[i] = plane;
+                this->m_lineSize[i] = AkPixelView::planeLineSize(i, width);
+                plane += this->m_lineSize[i] * AkPixelView::planeHeight(i, height);
+            }
+
+            if (Planes == 1 && lineSize > this->m_lineSize[0])
+                this->m_lineSize[0] = lineSize;
+        }
+
+        // Wraps the buffer of a packet. Returns an invalid view if the packet
+        // is not in Format or the buffer is too small.
+        static inline AkPixelView<Format, const quint8> fromPacket(const AkPacket &packet)
+        {
+            AkVideoCaps caps(packet.caps());
+
+            if (!caps
+                || caps.format() != Format
+                || caps.width() < 1
+                || caps.height() < 1)
+                return {};
+
+            auto size = packet.buffer().size();
+
+            if (size < AkPixelView::frameSize(caps.width(), caps.height()))
+                return {};
+
+            return {reinterpret_cast<const quint8 *>(packet.buffer().constData()),
+                    caps.width(),
+                    caps.height(),
+                    Planes == 1? size / caps.height(): 0};
+        }
+
+        // Returns a pooled buffer big enough for a tightly packed frame.
+        static inline AkPoolBuffer createBuffer(int width, int height)
+        {
+            return AkBufferPool::buffer(Format,
+                                        width,
+                                        height,
+                                        1,
+                                        AkPixelView::frameSize(width, height));
+        }
+
+        // Creates a tightly packed frame of the same size of packet, in
+        // Format, and stores it in oPacket. The frame memory is taken from
+        // the buffer pool and kept alive by oPacket.
+        static inline AkPixelView<Format, quint8> createFrame(const AkPacket &packet,
+                                                              AkPacket *oPacket)
+        {
+            AkVideoCaps caps(packet.caps());
+            auto buffer = AkPixelView::createBuffer(caps.width(), caps.height());
+
+            if (!buffer)
+                return {};
+
+            caps.format() = Format;
+            caps.bpp() = AkVideoCaps::bitsPerPixel(Format);
+            *oPacket = packet;
+            oPacket->caps() = caps.toCaps();
+            buffer.attachTo(*oPacket);
+
+            return {buffer.template data<quint8>(), caps.width(), caps.height()};
+        }
+
+        static inline int planeLineSize(int plane, int width)
+        {
+            if (plane < 1)
+                return BytesPerPixel * width;
+
+            int chromaWidth = (width + Layout::XShift) >> Layout::XShift;
+
+            return Layout::Type == AkPixelLayout_SemiPlanarYUV?
+                        2 * chromaWidth: chromaWidth;
+        }
+
+        static inline int planeHeight(int plane, int height)
+        {
+            return plane < 1?
+                        height:
+                        (height + Layout::YShift) >> Layout::YShift;
+        }
+
+        static inline int frameSize(int width, int height)
+        {
+            int size = 0;
+
+            for (int i = 0; i < Planes; i++)
+                size += AkPixelView::planeLineSize(i, width)
+                        * AkPixelView::planeHeight(i, height);
+
+            return size;
+        }
+
+        inline operator bool() const
+        {
+            return this->m_planes[0] != nullptr;
+        }
+
+        inline int width() const
+        {
+            return this->m_width;
+        }
+
+        inline int height() const
+        {
+            return this->m_height;
+        }
+
+        inline int lineSize(int plane=0) const
+        {
+            return this->m_lineSize[plane];
+        }
+
+        inline int planeHeight(int plane=0) const
+        {
+            return AkPixelView::planeHeight(plane, this->m_height);
+        }
+
+        inline T *line(int y) const
+        {
+            return this->m_planes[0] + y * this->m_lineSize[0];
+        }
+
+        inline T *line(int plane, int y) const
+        {
+            return this->m_planes[plane] + y * this->m_lineSize[plane];
+        }
+
+        // RGB components of the pixel x of a line.
+
+        static inline int red(const quint8 *line, int x)
+        {
+            return AkPixelView::rgbComponent<Layout::Red>(line, x);
+        }
+
+        static inline int green(const quint8 *line, int x)
+        {
+            return AkPixelView::rgbComponent<Layout::Green>(line, x);
+        }
+
+        static inline int blue(const quint8 *line, int x)
+        {
+            return AkPixelView::rgbComponent<Layout::Blue>(line, x);
+        }
+
+        static inline int alpha(const quint8 *line, int x)
+        {
+            static_assert(IsRgb, "alpha() needs an RGB format");
+
+            return Layout::HasAlpha?
+                        (reinterpret_cast<const quint32 *>(line)[x] >> Layout::Alpha) & 0xff:
+                        0xff;
+        }
+
+        // Components must be in the [0, 255] range.
+        static inline void setPixel(quint8 *line, int x,
+                                    int r, int g, int b, int a=0xff)
+        {
+            static_assert(IsRgb, "setPixel() needs an RGB format");
+
+            if (Layout::Type == AkPixelLayout_RGB32) {
+                reinterpret_cast<quint32 *>(line)[x] =
+                        quint32(r) << Layout::Red
+                        | quint32(g) << Layout::Green
+                        | quint32(b) << Layout::Blue
+                        | quint32(a) << Layout::Alpha;
+            } else {
+                auto pixel = line + 3 * x;
+                pixel[Layout::Red] = quint8(r);
+                pixel[Layout::Green] = quint8(g);
+                pixel[Layout::Blue] = quint8(b);
+            }
+        }
+
+        // Luma of the pixel x of a line. For packed YUV the chroma is shared
+        // by two pixels, for planar and semi-planar YUV it's read from the
+        // chroma planes.
+
+        static inline int luma(const quint8 *line, int x)
+        {
+            static_assert(IsYuv, "luma() needs a YUV or gray format");
+
+            return line[BytesPerPixel * x + Layout::Luma];
+        }
+
+        static inline void setLuma(quint8 *line, int x, int y)
+        {
+            static_assert(IsYuv, "setLuma() needs a YUV or gray format");
+
+            line[BytesPerPixel * x + Layout::Luma] = quint8(y);
+        }
+
+        // Calls func(r, g, b) for every pixel, the components are changed in
+        // place, and stored in dst after clamping them. The alpha is kept.
+        template<typename Func>
+        inline void mapRgb(const AkPixelView<Format, quint8> &dst,
+                           Func func) const
+        {
+            static_assert(IsRgb, "mapRgb() needs an RGB format");
+            auto src = *this;
+
+            AkScheduler::parallelFor(this->m_height, 16, [&] (int begin, int end) {
+                for (int y = begin; y < end; y++) {
+                    auto srcLine = src.line(y);
+                    auto dstLine = dst.line(y);
+
+                    for (int x = 0; x < src.m_width; x++) {
+                        int r = AkPixelView::red(srcLine, x);
+                        int g = AkPixelView::green(srcLine, x);
+                        int b = AkPixelView::blue(srcLine, x);
+                        func(r, g, b);
+                        AkPixelView::setPixel(dstLine, x,
+                                              qBound(0, r, 255),
+                                              qBound(0, g, 255),
+                                              qBound(0, b, 255),
+                                              AkPixelView::alpha(srcLine, x));
+                    }
+                }
+            });
+        }
+
+        // Maps every luma sample through lumaTable and every chroma sample
+        // through chromaTable, both of 256 entries.
+        inline void mapYuv(const AkPixelView<Format, quint8> &dst,
+                           const quint8 *lumaTable,
+                           const quint8 *chromaTable) const
+        {
+            static_assert(IsYuv, "mapYuv() needs a YUV or gray format");
+            auto src = *this;
+
+            for (int plane = 0; plane < Planes; plane++) {
+                auto table = plane < 1? lumaTable: chromaTable;
+                int width = AkPixelView::planeLineSize(plane, this->m_width);
+
+                AkScheduler::parallelFor(this->planeHeight(plane), 16, [&] (int begin, int end) {
+                    for (int y = begin; y < end; y++) {
+                        auto srcLine = src.line(plane, y);
+                        auto dstLine = dst.line(plane, y);
+
+                        if (Layout::Type == AkPixelLayout_PackedYUV) {
+                            for (int x = 0; x + 3 < width; x += 4) {
+                                dstLine[x + Layout::Luma] = lumaTable[srcLine[x + Layout::Luma]];
+                                dstLine[x + Layout::Luma + 2] = lumaTable[srcLine[x + Layout::Luma + 2]];
+                                dstLine[x + Layout::Cb] = chromaTable[srcLine[x + Layout::Cb]];
+                                dstLine[x + Layout::Cr] = chromaTable[srcLine[x + Layout::Cr]];
+                            }
+                        } else {
+                            for (int x = 0; x < width; x++)
+                                dstLine[x] = table[srcLine[x]];
+                        }
+                    }
+                });
+            }
+        }
+
+    private:
+        T *m_planes[3];
+        int m_lineSize[3];
+        int m_width;
+        int m_height;
+
+        template<int Component>
+        static inline int rgbComponent(const quint8 *line, int x)
+        {
+            static_assert(IsRgb, "RGB components need an RGB format");
+
+            return Layout::Type == AkPixelLayout_RGB32?
+                        (reinterpret_cast<const quint32 *>(line)[x] >> Component) & 0xff:
+                        line[3 * x + Component];
+        }
+};
+
+template<AkVideoCaps::PixelFormat Format>
+using AkConstPixelView = AkPixelView<Format, const quint8>;
+
+#define AK_PIXEL_DISPATCH_CASE(format) \
+    case AkVideoCaps::format: \
+        functor.template process<AkVideoCaps::format>(); \
+        \
+        return true;
+
+// Calls functor.process<Format>() with the format of the frame, for the RGB
+// formats. Returns false if the format is not supported.
+template<typename Functor>
+inline bool akPixelDispatchRgb(AkVideoCaps::PixelFormat format, Functor &functor)
+{
+    switch (format) {
+    AK_PIXEL_DISPATCH_CASE(Format_argb)
+    AK_PIXEL_DISPATCH_CASE(Format_0rgb)
+    AK_PIXEL_DISPATCH_CASE(Format_rgba)
+    AK_PIXEL_DISPATCH_CASE(Format_rgb0)
+    AK_PIXEL_DISPATCH_CASE(Format_abgr)
+    AK_PIXEL_DISPATCH_CASE(Format_0bgr)
+    AK_PIXEL_DISPATCH_CASE(Format_bgra)
+    AK_PIXEL_DISPATCH_CASE(Format_bgr0)
+    AK_PIXEL_DISPATCH_CASE(Format_rgb24)
+    AK_PIXEL_DISPATCH_CASE(Format_bgr24)
+    default:
+        break;
+    }
+
+    return false;
+}
+
+// Same as above, for the gray and YUV formats.
+template<typename Functor>
+inline bool akPixelDispatchYuv(AkVideoCaps::PixelFormat format, Functor &functor)
+{
+    switch (format) {
+    AK_PIXEL_DISPATCH_CASE(Format_gray)
+    AK_PIXEL_DISPATCH_CASE(Format_yuyv422)
+    AK_PIXEL_DISPATCH_CASE(Format_uyvy422)
+    AK_PIXEL_DISPATCH_CASE(Format_yvyu422)
+    AK_PIXEL_DISPATCH_CASE(Format_yuv420p)
+    AK_PIXEL_DISPATCH_CASE(Format_yuvj420p)
+    AK_PIXEL_DISPATCH_CASE(Format_yuv422p)
+    AK_PIXEL_DISPATCH_CASE(Format_yuvj422p)
+    AK_PIXEL_DISPATCH_CASE(Format_yuv444p)
+    AK_PIXEL_DISPATCH_CASE(Format_yuvj444p)
+    AK_PIXEL_DISPATCH_CASE(Format_nv12)
+    AK_PIXEL_DISPATCH_CASE(Format_nv21)
+    AK_PIXEL_DISPATCH_CASE(Format_nv16)
+    default:
+        break;
+    }
+
+    return false;
+}
+
+template<typename Functor>
+inline bool akPixelDispatch(AkVideoCaps::PixelFormat format, Functor &functor)
+{
+    return akPixelDispatchRgb(format, functor)
+           || akPixelDispatchYuv(format, functor);
+}
+
+#undef AK_PIXEL_DISPATCH_CASE
+
+template<AkVideoCaps::PixelFormat Format, AkVideoCaps::PixelFormat OFormat>
+struct AkPixelMapOutput
+{
+    using View = AkPixelView<OFormat>;
+};
+
+template<AkVideoCaps::PixelFormat Format>
+struct AkPixelMapOutput<Format, AkVideoCaps::Format_none>
+{
+    using View = AkPixelView<Format>;
+};
+
+template<AkVideoCaps::PixelFormat OFormat, typename Filter>
+struct AkPixelMapFrame
+{
+    const Filter &m_filter;
+    AkPacket m_iPacket;
+    AkPacket m_oPacket;
+
+    template<AkVideoCaps::PixelFormat Format>
+    inline void process()
+    {
+        using OView = typename AkPixelMapOutput<Format, OFormat>::View;
+        auto src = AkConstPixelView<Format>::fromPacket(this->m_iPacket);
+
+        if (!src)
+            return;
+
+        auto dst = OView::createFrame(this->m_iPacket, &this->m_oPacket);
+
+        if (dst)
+            this->m_filter(src, dst);
+    }
+};
+
+template<AkVideoCaps::PixelFormat OFormat, bool RgbOnly, typename Filter>
+inline AkPacket akPixelMapFrame(const AkPacket &packet, const Filter &filter)
+{
+    AkVideoCaps caps(packet.caps());
+
+    if (!caps)
+        return {};
+
+    AkPixelMapFrame<OFormat, Filter> frame {filter, packet, {}};
+    bool dispatched = RgbOnly?
+                          akPixelDispatchRgb(caps.format(), frame):
+                          akPixelDispatch(caps.format(), frame);
+
+    if (dispatched && frame.m_oPacket)
+        return frame.m_oPacket;
+
+    frame.m_iPacket =
+            AkUtils::convertVideo(packet, AkVideoCaps::Format_argb).toPacket();
+    frame.template process<AkVideoCaps::Format_argb>();
+
+    return frame.m_oPacket;
+}
+
+// Runs filter(src, dst) on the frame and returns the filtered frame. Filter
+// has a template call operator taking an AkConstPixelView<Format> and an
+// AkPixelView of the output format.
+//
+// The frame is processed in its own format if it's supported, otherwise, or
+// if it can't be wrapped, it's converted to ARGB first. The output is in the
+// format of the frame, or in OFormat if it's set.
+template<AkVideoCaps::PixelFormat OFormat=AkVideoCaps::Format_none,
+         typename Filter>
+inline AkPacket akPixelMap(const AkPacket &packet, const Filter &filter)
+{
+    return akPixelMapFrame<OFormat, false>(packet, filter);
+}
+
+// Same as above, only RGB frames are processed in their own format.
+template<AkVideoCaps::PixelFormat OFormat=AkVideoCaps::Format_none,
+         typename Filter>
+inline AkPacket akPixelMapRgb(const AkPacket &packet, const Filter &filter)
+{
+    return akPixelMapFrame<OFormat, true>(packet, filter);
+}
+
+#endif // AKPIXELVIEW_H
@@ -0,0 +1,456 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <cstring>
+#include <QAtomicInt>
+#include <QVector>
+
+#include "akpointoperator.h"
+#include "akpacket.h"
+#include "akvideopacket.h"
+#include "akpixelview.h"
+#include "aksimd.h"
+#include "akscheduler.h"
+
+#ifdef AK_SIMD_X86
+    #define AK_POINTOPERATOR_SIMD
+    #include <immintrin.h>
+#endif
+
+static QAtomicInt akPointFusionEnabled(qEnvironmentVariableIntValue("AK_POINT_FUSION") > 0
+                                       || !qEnvironmentVariableIsSet("AK_POINT_FUSION"));
+
+struct AkPointOperatorStage
+{
+    enum Type
+    {
+        Type_Tables,
+        Type_Matrix
+    };
+
+    Type m_type;
+    quint8 m_tables[3][256];
+    qreal m_matrix[12];
+};
+
+class AkPointOperatorPrivate
+{
+    public:
+        QVector<AkPointOperatorStage> m_stages;
+        bool m_valid {false};
+
+        inline void append(const AkPointOperatorStage &stage);
+};
+
+// The pixels of a line are split in three planes of ints, every stage works
+// on the planes, and then the pixels are packed again. The lines are small
+// enough to stay in the cache between stages.
+using MatrixKernel = void (*)(qint32 *r,
+                              qint32 *g,
+                              qint32 *b,
+                              int width,
+                              const qreal *m);
+
+static void matrixScalar(qint32 *r,
+                         qint32 *g,
+                         qint32 *b,
+                         int width,
+                         const qreal *m)
+{
+    for (int x = 0; x < width; x++) {
+        // Clamping before the truncation gives the same result as clamping
+        // the truncated value.
+        qreal rt = r[x] * m[0] + g[x] * m[1] + b[x] * m[2]  + m[3];
+        qreal gt = r[x] * m[4] + g[x] * m[5] + b[x] * m[6]  + m[7];
+        qreal bt = r[x] * m[8] + g[x] * m[9] + b[x] * m[10] + m[11];
+        r[x] = int(qBound<qreal>(0.0, rt, 255.0));
+        g[x] = int(qBound<qreal>(0.0, gt, 255.0));
+        b[x] = int(qBound<qreal>(0.0, bt, 255.0));
+    }
+}
+
+#ifdef AK_POINTOPERATOR_SIMD
+// The SIMD kernels do the same double precision operations in the same order
+// than the scalar one, so the results are identical.
+
+AK_SIMD_TARGET("sse2")
+static void matrixSSE2(qint32 *r,
+                       qint32 *g,
+                       qint32 *b,
+                       int width,
+                       const qreal *m)
+{
+    __m128d k[12];
+
+    for (int i = 0; i < 12; i++)
+        k[i] = _mm_set1_pd(m[i]);
+
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d max = _mm_set1_pd(255.0);
+    int x = 0;
+
+    for (; x + 2 <= width; x += 2) {
+        auto rv = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(r + x)));
+        auto gv = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(g + x)));
+        auto bv = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(b + x)));
+        __m128d out[3];
+
+        for (int c = 0; c < 3; c++) {
+            auto v = _mm_add_pd(_mm_mul_pd(rv, k[4 * c]),
+                                _mm_mul_pd(gv, k[4 * c + 1]));
+            v = _mm_add_pd(v, _mm_mul_pd(bv, k[4 * c + 2]));
+            v = _mm_add_pd(v, k[4 * c + 3]);
+            out[c] = _mm_min_pd(_mm_max_pd(v, zero), max);
+        }
+
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(r + x), _mm_cvttpd_epi32(out[0]));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(g + x), _mm_cvttpd_epi32(out[1]));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(b + x), _mm_cvttpd_epi32(out[2]));
+    }
+
+    matrixScalar(r + x, g + x, b + x, width - x, m);
+}
+
+AK_SIMD_TARGET("avx2")
+static void matrixAVX2(qint32 *r,
+                       qint32 *g,
+                       qint32 *b,
+                       int width,
+                       const qreal *m)
+{
+    __m256d k[12];
+
+    for (int i = 0; i < 12; i++)
+        k[i] = _mm256_set1_pd(m[i]);
+
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d max = _mm256_set1_pd(255.0);
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+        auto rv = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r + x)));
+        auto gv = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(g + x)));
+        auto bv = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x)));
+        __m256d out[3];
+
+        for (int c = 0; c < 3; c++) {
+            auto v = _mm256_add_pd(_mm256_mul_pd(rv, k[4 * c]),
+                                   _mm256_mul_pd(gv, k[4 * c + 1]));
+            v = _mm256_add_pd(v, _mm256_mul_pd(bv, k[4 * c + 2]));
+            v = _mm256_add_pd(v, k[4 * c + 3]);
+            out[c] = _mm256_min_pd(_mm256_max_pd(v, zero), max);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(r + x), _mm256_cvttpd_epi32(out[0]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(g + x), _mm256_cvttpd_epi32(out[1]));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(b + x), _mm256_cvttpd_epi32(out[2]));
+    }
+
+    matrixScalar(r + x, g + x, b + x, width - x, m);
+}
+#endif
+
+static MatrixKernel matrixKernel(AkSimd::InstructionSet instructionSet)
+{
+#ifdef AK_POINTOPERATOR_SIMD
+    if (instructionSet >= AkSimd::InstructionSet_AVX2)
+        return matrixAVX2;
+
+    if (instructionSet >= AkSimd::InstructionSet_SSE2)
+        return matrixSSE2;
+#else
+    Q_UNUSED(instructionSet)
+#endif
+
+    return matrixScalar;
+}
+
+struct AkPointOperatorFrame
+{
+    const QVector<AkPointOperatorStage> *m_stages;
+    AkPacket m_iPacket;
+    AkPacket m_oPacket;
+
+    template<AkVideoCaps::PixelFormat Format>
+    inline void process()
+    {
+        using View = AkPixelView<Format>;
+        auto src = AkConstPixelView<Format>::fromPacket(this->m_iPacket);
+
+        if (!src)
+            return;
+
+        auto dst = View::createFrame(this->m_iPacket, &this->m_oPacket);
+
+        if (!dst)
+            return;
+
+        auto stages = this->m_stages;
+        auto matrix = matrixKernel(AkSimd::instructionSet());
+        int width = src.width();
+
+        AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+            QVector<qint32> planes(3 * width);
+            auto r = planes.data();
+            auto g = r + width;
+            auto b = g + width;
+
+            for (int y = begin; y < end; y++) {
+                auto srcLine = src.line(y);
+                auto dstLine = dst.line(y);
+
+                for (int x = 0; x < width; x++) {
+                    r[x] = View::red(srcLine, x);
+                    g[x] = View::green(srcLine, x);
+                    b[x] = View::blue(srcLine, x);
+                }
+
+                for (auto &stage: *stages)
+                    if (stage.m_type == AkPointOperatorStage::Type_Tables) {
+                        for (int x = 0; x < width; x++) {
+                            r[x] = stage.m_tables[0][r[x]];
+                            g[x] = stage.m_tables[1][g[x]];
+                            b[x] = stage.m_tables[2][b[x]];
+                        }
+                    } else {
+                        matrix(r, g, b, width, stage.m_matrix);
+                    }
+
+                for (int x = 0; x < width; x++)
+                    View::setPixel(dstLine, x,
+                                   r[x], g[x], b[x],
+                                   View::alpha(srcLine, x));
+            }
+        });
+    }
+};
+
+AkPointOperator::AkPointOperator()
+{
+    this->d = new AkPointOperatorPrivate;
+}
+
+AkPointOperator::AkPointOperator(const AkPointOperator &other)
+{
+    this->d = new AkPointOperatorPrivate;
+    this->d->m_stages = other.d->m_stages;
+    this->d->m_valid = other.d->m_valid;
+}
+
+AkPointOperator::~AkPointOperator()
+{
+    delete this->d;
+}
+
+AkPointOperator &AkPointOperator::operator =(const AkPointOperator &other)
+{
+    if (this != &other) {
+        this->d->m_stages = other.d->m_stages;
+        this->d->m_valid = other.d->m_valid;
+    }
+
+    return *this;
+}
+
+AkPointOperator::operator bool() const
+{
+    return this->d->m_valid;
+}
+
+AkPointOperator AkPointOperator::identity()
+{
+    AkPointOperator pointOperator;
+    pointOperator.d->m_valid = true;
+
+    return pointOperator;
+}
+
+AkPointOperator AkPointOperator::fromTables(const quint8 *redTable,
+                                            const quint8 *greenTable,
+                                            const quint8 *blueTable)
+{
+    AkPointOperatorStage stage;
+    stage.m_type = AkPointOperatorStage::Type_Tables;
+    memcpy(stage.m_tables[0], redTable, 256);
+    memcpy(stage.m_tables[1], greenTable, 256);
+    memcpy(stage.m_tables[2], blueTable, 256);
+    memset(stage.m_matrix, 0, sizeof(stage.m_matrix));
+
+    auto pointOperator = AkPointOperator::identity();
+    pointOperator.d->append(stage);
+
+    return pointOperator;
+}
+
+AkPointOperator AkPointOperator::fromMatrix(const qreal *matrix)
+{
+    // A diagonal matrix doesn't mix the channels, so it's converted to
+    // tables, which can be merged with the neighbour stages.
+    if (matrix[1] == 0.0 && matrix[2] == 0.0
+        && matrix[4] == 0.0 && matrix[6] == 0.0
+        && matrix[8] == 0.0 && matrix[9] == 0.0) {
+        quint8 tables[3][256];
+
+        for (int c = 0; c < 3; c++)
+            for (int i = 0; i < 256; i++) {
+                qreal value = i * matrix[5 * c] + matrix[4 * c + 3];
+                tables[c][i] = quint8(int(qBound<qreal>(0.0, value, 255.0)));
+            }
+
+        return AkPointOperator::fromTables(tables[0], tables[1], tables[2]);
+    }
+
+    AkPointOperatorStage stage;
+    stage.m_type = AkPointOperatorStage::Type_Matrix;
+    memset(stage.m_tables, 0, sizeof(stage.m_tables));
+    memcpy(stage.m_matrix, matrix, sizeof(stage.m_matrix));
+
+    auto pointOperator = AkPointOperator::identity();
+    pointOperator.d->append(stage);
+
+    return pointOperator;
+}
+
+AkPointOperator AkPointOperator::then(const AkPointOperator &other) const
+{
+    if (!this->d->m_valid || !other.d->m_valid)
+        return {};
+
+    AkPointOperator pointOperator(*this);
+
+    for (auto &stage: other.d->m_stages)
+        pointOperator.d->append(stage);
+
+    return pointOperator;
+}
+
+int AkPointOperator::stages() const
+{
+    return this->d->m_stages.size();
+}
+
+bool AkPointOperator::isIdentity() const
+{
+    return this->d->m_valid && this->d->m_stages.isEmpty();
+}
+
+AkPacket AkPointOperator::apply(const AkPacket &packet) const
+{
+    if (!this->d->m_valid)
+        return {};
+
+    AkVideoCaps caps(packet.caps());
+
+    if (!caps)
+        return {};
+
+    AkPointOperatorFrame frame;
+    frame.m_stages = &this->d->m_stages;
+    frame.m_iPacket = packet;
+
+    if (!akPixelDispatchRgb(caps.format(), frame))
+        return {};
+
+    return frame.m_oPacket;
+}
+
+AkPacket AkPointOperator::run(const QList<AkElementPtr> &elements,
+                              const AkPacket &packet)
+{
+    bool fusion = AkPointOperator::fusionEnabled();
+    auto oPacket = packet;
+
+    for (int i = 0; i < elements.size() && oPacket;) {
+        AkPointOperator pointOperator;
+        int end = i;
+
+        if (fusion)
+            for (; end < elements.size(); end++) {
+                auto elementOperator = elements[end]->pointOperator();
+
+                if (!elementOperator)
+                    break;
+
+                pointOperator = end > i?
+                                    pointOperator.then(elementOperator):
+                                    elementOperator;
+            }
+
+        // A single element runs by itself, so its stats and frame dropping
+        // still work.
+        if (end - i > 1) {
+            auto fused = pointOperator.apply(oPacket);
+
+            if (fused) {
+                oPacket = fused;
+                i = end;
+
+                continue;
+            }
+        }
+
+        // The frame is not RGB yet, or the element can't be fused.
+        oPacket = (*elements[i])(oPacket);
+        i++;
+    }
+
+    return oPacket;
+}
+
+bool AkPointOperator::fusionEnabled()
+{
+    return akPointFusionEnabled.load();
+}
+
+void AkPointOperator::setFusionEnabled(bool enabled)
+{
+    akPointFusionEnabled.store(enabled);
+}
+
+void AkPointOperatorPrivate::append(const AkPointOperatorStage &stage)
+{
+    if (stage.m_type == AkPointOperatorStage::Type_Tables) {
+        bool isIdentity = true;
+
+        for (int c = 0; c < 3 && isIdentity; c++)
+            for (int i = 0; i < 256; i++)
+                if (stage.m_tables[c][i] != i) {
+                    isIdentity = false;
+
+                    break;
+                }
+
+        if (isIdentity)
+            return;
+
+        // Two consecutive tables are composed into one.
+        if (!this->m_stages.isEmpty()
+            && this->m_stages.last().m_type == AkPointOperatorStage::Type_Tables) {
+            auto &last = this->m_stages.last();
+
+            for (int c = 0; c < 3; c++)
+                for (int i = 0; i < 256; i++)
+                    last.m_tables[c][i] = stage.m_tables[c][last.m_tables[c][i]];
+
+            return;
+        }
+    }
+
+    this->m_stages << stage;
+}
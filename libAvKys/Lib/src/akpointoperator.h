@@ -0,0 +1,84 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKPOINTOPERATOR_H
+#define AKPOINTOPERATOR_H
+
+#include "akelement.h"
+
+class AkPointOperatorPrivate;
+
+// A per-pixel RGB transform, made of a sequence of stages, each one a lookup
+// table per channel or a 3x4 color matrix. Every stage clamps its result to
+// [0, 255] just like the filters do, so a composed operator gives the same
+// pixels as running the filters one after the other.
+//
+// Filters that are point operators return it from
+// AkElement::pointOperator(), and run() uses it to process several of them
+// in a single pass over the frame.
+class AKCOMMONS_EXPORT AkPointOperator
+{
+    public:
+        // Invalid operator, the element is not a point operator.
+        AkPointOperator();
+        AkPointOperator(const AkPointOperator &other);
+        ~AkPointOperator();
+        AkPointOperator &operator =(const AkPointOperator &other);
+        operator bool() const;
+
+        static AkPointOperator identity();
+
+        // Three tables of 256 entries, one per channel.
+        static AkPointOperator fromTables(const quint8 *redTable,
+                                          const quint8 *greenTable,
+                                          const quint8 *blueTable);
+
+        // Row major 3x4 matrix, every channel is computed as
+        // int(r * m[0] + g * m[1] + b * m[2] + m[3]).
+        static AkPointOperator fromMatrix(const qreal *matrix);
+
+        // Returns an operator that applies this operator and then the other
+        // one. Consecutive tables are merged into one, matrices are kept as
+        // separate stages since the clamping between them is not linear.
+        AkPointOperator then(const AkPointOperator &other) const;
+
+        int stages() const;
+        bool isIdentity() const;
+
+        // Transforms a video frame in RGB format, the output has the same
+        // format as the input. Returns an invalid packet for other formats.
+        AkPacket apply(const AkPacket &packet) const;
+
+        // Runs the packet through the elements in order, returning the output
+        // of the last one. Runs of consecutive point operators are fused into
+        // a single apply() while the frames are in an RGB format.
+        static AkPacket run(const QList<AkElementPtr> &elements,
+                            const AkPacket &packet);
+
+        // Disabling the fusion makes run() call every element, so both
+        // outputs can be compared. It can also be disabled setting the
+        // AK_POINT_FUSION environment variable to 0.
+        static bool fusionEnabled();
+        static void setFusionEnabled(bool enabled);
+
+    private:
+        AkPointOperatorPrivate *d;
+};
+
+#endif // AKPOINTOPERATOR_H
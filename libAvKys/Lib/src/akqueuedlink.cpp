@@ -0,0 +1,469 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "akqueuedlink.h"
+#include "akelement.h"
+#include "akpacket.h"
+
+class AkQueuedLinkCell
+{
+    public:
+        QAtomicInteger<quint64> m_sequence;
+        AkPacket m_packet;
+};
+
+// Bounded multi producer ring, by Dmitry Vyukov. Every cell has a sequence
+// number that tells if it's ready to be written or read, so the producers and
+// the consumer never lock.
+class AkQueuedLinkRing
+{
+    public:
+        QVector<AkQueuedLinkCell> m_cells;
+        quint64 m_size;
+        QAtomicInteger<quint64> m_enqueuePos;
+        QAtomicInteger<quint64> m_dequeuePos;
+
+        AkQueuedLinkRing(int size):
+            m_cells(size),
+            m_size(quint64(size)),
+            m_enqueuePos(0),
+            m_dequeuePos(0)
+        {
+            for (int i = 0; i < size; i++)
+                this->m_cells[i].m_sequence.store(quint64(i));
+        }
+
+        inline bool enqueue(const AkPacket &packet)
+        {
+            auto pos = this->m_enqueuePos.load();
+            AkQueuedLinkCell *cell = nullptr;
+
+            forever {
+                cell = this->m_cells.data() + pos % this->m_size;
+                auto diff = qint64(cell->m_sequence.loadAcquire() - pos);
+
+                if (diff == 0) {
+                    if (this->m_enqueuePos.testAndSetRelaxed(pos, pos + 1, pos))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = this->m_enqueuePos.load();
+                }
+            }
+
+            cell->m_packet = packet;
+            cell->m_sequence.storeRelease(pos + 1);
+
+            return true;
+        }
+
+        inline bool dequeue(AkPacket &packet)
+        {
+            auto pos = this->m_dequeuePos.load();
+            AkQueuedLinkCell *cell = nullptr;
+
+            forever {
+                cell = this->m_cells.data() + pos % this->m_size;
+                auto diff = qint64(cell->m_sequence.loadAcquire() - (pos + 1));
+
+                if (diff == 0) {
+                    if (this->m_dequeuePos.testAndSetRelaxed(pos, pos + 1, pos))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = this->m_dequeuePos.load();
+                }
+            }
+
+            packet = cell->m_packet;
+            cell->m_packet = AkPacket();
+            cell->m_sequence.storeRelease(pos + this->m_size);
+
+            return true;
+        }
+
+        inline int size() const
+        {
+            auto size = qint64(this->m_enqueuePos.load()
+                               - this->m_dequeuePos.load());
+
+            return int(qBound<qint64>(0, size, qint64(this->m_size)));
+        }
+};
+
+class AkQueuedLinkThread: public QThread
+{
+    public:
+        AkQueuedLinkThread(AkQueuedLinkPrivate *link):
+            m_link(link)
+        {
+        }
+
+    protected:
+        void run();
+
+    private:
+        AkQueuedLinkPrivate *m_link;
+};
+
+class AkQueuedLinkPrivate
+{
+    public:
+        AkQueuedLink *self;
+        QObject *m_srcElement;
+        QObject *m_dstElement;
+        AkElement *m_dstAkElement;
+        AkQueuedLinkRing m_ring;
+        AkQueuedLinkThread m_thread;
+        int m_depth;
+        AkQueuedLink::DropPolicy m_dropPolicy;
+        QMutex m_mutex;
+        QWaitCondition m_notEmpty;
+        QWaitCondition m_notFull;
+        QAtomicInt m_consumerWaiting;
+        QAtomicInt m_producersWaiting;
+        QAtomicInt m_run;
+        QMetaObject::Connection m_connection;
+        QAtomicInteger<qint64> m_packetsIn;
+        QAtomicInteger<qint64> m_packetsOut;
+        QAtomicInteger<qint64> m_packetsDropped;
+        QAtomicInt m_maxOccupancy;
+
+        AkQueuedLinkPrivate(AkQueuedLink *self,
+                            QObject *srcElement,
+                            QObject *dstElement,
+                            int depth,
+                            AkQueuedLink::DropPolicy dropPolicy);
+        inline void enqueue(const AkPacket &packet);
+        inline void push(const AkPacket &packet);
+        inline void send(const AkPacket &packet);
+        inline void wake(QAtomicInt &waiting, QWaitCondition &condition);
+        void consume();
+};
+
+AkQueuedLink::AkQueuedLink(AkElement *srcElement,
+                           QObject *dstElement,
+                           int depth,
+                           DropPolicy dropPolicy):
+    QObject(srcElement)
+{
+    this->d.reset(new AkQueuedLinkPrivate(this,
+                                          srcElement,
+                                          dstElement,
+                                          depth,
+                                          dropPolicy));
+
+    // The connection holds its own reference to the link state, so a
+    // producer the signal already dispatched can still use it after the link
+    // is destroyed. The source is the context object, it outlives the link.
+    auto d = this->d;
+    this->d->m_connection =
+            QObject::connect(srcElement,
+                             &AkElement::oStream,
+                             srcElement,
+                             [d] (const AkPacket &packet) {
+                                 d->enqueue(packet);
+                             },
+                             Qt::DirectConnection);
+
+    this->d->m_thread.setObjectName(QString("AkQueuedLink %1")
+                                    .arg(dstElement->objectName()));
+    this->d->m_thread.start();
+}
+
+AkQueuedLink::~AkQueuedLink()
+{
+    QObject::disconnect(this->d->m_connection);
+
+    // Disconnecting doesn't wait for the producers the signal already
+    // dispatched. The blocked ones are woken up, and all of them drop their
+    // packet from now on. The state is released by the last of them.
+    this->d->m_run.fetchAndStoreOrdered(0);
+    this->d->m_mutex.lock();
+    this->d->m_notEmpty.wakeAll();
+    this->d->m_notFull.wakeAll();
+    this->d->m_mutex.unlock();
+    this->d->m_thread.wait();
+}
+
+QObject *AkQueuedLink::srcElement() const
+{
+    return this->d->m_srcElement;
+}
+
+QObject *AkQueuedLink::dstElement() const
+{
+    return this->d->m_dstElement;
+}
+
+int AkQueuedLink::depth() const
+{
+    return this->d->m_depth;
+}
+
+AkQueuedLink::DropPolicy AkQueuedLink::dropPolicy() const
+{
+    return this->d->m_dropPolicy;
+}
+
+int AkQueuedLink::occupancy() const
+{
+    return this->d->m_ring.size();
+}
+
+qint64 AkQueuedLink::packetsIn() const
+{
+    return this->d->m_packetsIn.load();
+}
+
+qint64 AkQueuedLink::packetsOut() const
+{
+    return this->d->m_packetsOut.load();
+}
+
+qint64 AkQueuedLink::packetsDropped() const
+{
+    return this->d->m_packetsDropped.load();
+}
+
+QVariantMap AkQueuedLink::stats() const
+{
+    return {
+        {"srcElement"    , this->d->m_srcElement->objectName()     },
+        {"dstElement"    , this->d->m_dstElement->objectName()     },
+        {"depth"         , this->d->m_depth                        },
+        {"dropPolicy"    , dropPolicyToString(this->d->m_dropPolicy)},
+        {"occupancy"     , this->occupancy()                       },
+        {"maxOccupancy"  , this->d->m_maxOccupancy.load()          },
+        {"packetsIn"     , this->packetsIn()                       },
+        {"packetsOut"    , this->packetsOut()                      },
+        {"packetsDropped", this->packetsDropped()                  },
+    };
+}
+
+AkQueuedLink::DropPolicy AkQueuedLink::dropPolicyFromString(const QString &dropPolicy)
+{
+    static const QMap<QString, DropPolicy> dropPolicies = {
+        {"dropoldest", DropPolicy_DropOldest},
+        {"dropnewest", DropPolicy_DropNewest},
+        {"block"     , DropPolicy_Block     },
+    };
+
+    return dropPolicies.value(dropPolicy.toLower().remove('-'),
+                              DropPolicy_DropOldest);
+}
+
+QString AkQueuedLink::dropPolicyToString(DropPolicy dropPolicy)
+{
+    static const QMap<DropPolicy, QString> dropPolicies = {
+        {DropPolicy_DropOldest, "DropOldest"},
+        {DropPolicy_DropNewest, "DropNewest"},
+        {DropPolicy_Block     , "Block"     },
+    };
+
+    return dropPolicies.value(dropPolicy);
+}
+
+AkQueuedLink *AkQueuedLink::link(AkElement *srcElement,
+                                 QObject *dstElement,
+                                 int depth,
+                                 DropPolicy dropPolicy)
+{
+    if (!srcElement || !dstElement)
+        return nullptr;
+
+    return new AkQueuedLink(srcElement, dstElement, depth, dropPolicy);
+}
+
+bool AkQueuedLink::unlink(const QObject *srcElement, const QObject *dstElement)
+{
+    if (!srcElement || !dstElement)
+        return false;
+
+    bool unlinked = false;
+
+    for (auto link: AkQueuedLink::links(srcElement))
+        if (link->d->m_dstElement == dstElement) {
+            delete link;
+            unlinked = true;
+        }
+
+    return unlinked;
+}
+
+QList<AkQueuedLink *> AkQueuedLink::links(const QObject *srcElement)
+{
+    if (!srcElement)
+        return {};
+
+    return srcElement->findChildren<AkQueuedLink *>(QString(),
+                                                    Qt::FindDirectChildrenOnly);
+}
+
+void AkQueuedLink::enqueue(const AkPacket &packet)
+{
+    this->d->enqueue(packet);
+}
+
+AkQueuedLinkPrivate::AkQueuedLinkPrivate(AkQueuedLink *self,
+                                         QObject *srcElement,
+                                         QObject *dstElement,
+                                         int depth,
+                                         AkQueuedLink::DropPolicy dropPolicy):
+    self(self),
+    m_srcElement(srcElement),
+    m_dstElement(dstElement),
+    m_dstAkElement(qobject_cast<AkElement *>(dstElement)),
+    m_ring(qMax(depth, 1)),
+    m_thread(this),
+    m_depth(qMax(depth, 1)),
+    m_dropPolicy(dropPolicy),
+    m_consumerWaiting(0),
+    m_producersWaiting(0),
+    m_run(1),
+    m_packetsIn(0),
+    m_packetsOut(0),
+    m_packetsDropped(0),
+    m_maxOccupancy(0)
+{
+}
+
+void AkQueuedLinkPrivate::enqueue(const AkPacket &packet)
+{
+    this->m_packetsIn.fetchAndAddRelaxed(1);
+
+    if (this->m_run.load())
+        this->push(packet);
+    else
+        this->m_packetsDropped.fetchAndAddRelaxed(1);
+}
+
+void AkQueuedLinkPrivate::push(const AkPacket &packet)
+{
+    forever {
+        if (this->m_ring.enqueue(packet))
+            break;
+
+        if (this->m_dropPolicy == AkQueuedLink::DropPolicy_DropNewest) {
+            this->m_packetsDropped.fetchAndAddRelaxed(1);
+
+            return;
+        }
+
+        if (this->m_dropPolicy == AkQueuedLink::DropPolicy_DropOldest) {
+            AkPacket oldest;
+
+            if (this->m_ring.dequeue(oldest))
+                this->m_packetsDropped.fetchAndAddRelaxed(1);
+
+            continue;
+        }
+
+        // Wait until the consumer makes room.
+        this->m_mutex.lock();
+        this->m_producersWaiting.fetchAndAddOrdered(1);
+
+        if (this->m_run.load() && this->m_ring.size() >= this->m_depth)
+            this->m_notFull.wait(&this->m_mutex);
+
+        this->m_producersWaiting.fetchAndAddOrdered(-1);
+        this->m_mutex.unlock();
+
+        if (!this->m_run.load()) {
+            this->m_packetsDropped.fetchAndAddRelaxed(1);
+
+            return;
+        }
+    }
+
+    int occupancy = this->m_ring.size();
+    int maxOccupancy = this->m_maxOccupancy.load();
+
+    while (occupancy > maxOccupancy
+           && !this->m_maxOccupancy.testAndSetRelaxed(maxOccupancy,
+                                                      occupancy,
+                                                      maxOccupancy)) {
+    }
+
+    this->wake(this->m_consumerWaiting, this->m_notEmpty);
+}
+
+void AkQueuedLinkPrivate::send(const AkPacket &packet)
+{
+    if (this->m_dstAkElement)
+        (*this->m_dstAkElement)(packet);
+    else
+        QMetaObject::invokeMethod(this->m_dstElement,
+                                  "iStream",
+                                  Qt::DirectConnection,
+                                  Q_ARG(AkPacket, packet));
+
+    this->m_packetsOut.fetchAndAddRelaxed(1);
+}
+
+void AkQueuedLinkPrivate::wake(QAtomicInt &waiting, QWaitCondition &condition)
+{
+    // Pairs with the waiting counter increment, so either the waiting thread
+    // sees the ring change, or the wake up happens after it starts waiting.
+    if (waiting.fetchAndAddOrdered(0) < 1)
+        return;
+
+    this->m_mutex.lock();
+    condition.wakeAll();
+    this->m_mutex.unlock();
+}
+
+void AkQueuedLinkPrivate::consume()
+{
+    while (this->m_run.load()) {
+        AkPacket packet;
+
+        if (this->m_ring.dequeue(packet)) {
+            this->wake(this->m_producersWaiting, this->m_notFull);
+            this->send(packet);
+
+            continue;
+        }
+
+        this->m_mutex.lock();
+        this->m_consumerWaiting.fetchAndStoreOrdered(1);
+
+        if (this->m_run.load() && this->m_ring.size() < 1)
+            this->m_notEmpty.wait(&this->m_mutex);
+
+        this->m_consumerWaiting.fetchAndStoreOrdered(0);
+        this->m_mutex.unlock();
+    }
+}
+
+void AkQueuedLinkThread::run()
+{
+    this->m_link->consume();
+}
+
+#include "moc_akqueuedlink.cpp"
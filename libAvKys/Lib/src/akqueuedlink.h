@@ -0,0 +1,112 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKQUEUEDLINK_H
+#define AKQUEUEDLINK_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QVariantMap>
+
+#include "akcommons.h"
+
+class AkQueuedLinkPrivate;
+class AkElement;
+class AkPacket;
+
+// Link between two elements with a bounded queue in the middle.
+//
+// The source element only pushes the packet to a lock-free ring and returns,
+// a dedicated thread takes the packets from the ring and sends them to the
+// destination element. When the ring is full the packets are dropped or the
+// source waits, depending on the drop policy. The link is owned by the source
+// element, and it must be unlinked before deleting the destination.
+class AKCOMMONS_EXPORT AkQueuedLink: public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(DropPolicy)
+    Q_PROPERTY(int depth
+               READ depth
+               CONSTANT)
+    Q_PROPERTY(DropPolicy dropPolicy
+               READ dropPolicy
+               CONSTANT)
+    Q_PROPERTY(int occupancy
+               READ occupancy)
+    Q_PROPERTY(qint64 packetsIn
+               READ packetsIn)
+    Q_PROPERTY(qint64 packetsOut
+               READ packetsOut)
+    Q_PROPERTY(qint64 packetsDropped
+               READ packetsDropped)
+    Q_PROPERTY(QVariantMap stats
+               READ stats)
+
+    public:
+        enum DropPolicy
+        {
+            DropPolicy_DropOldest,
+            DropPolicy_DropNewest,
+            DropPolicy_Block
+        };
+
+        AkQueuedLink(AkElement *srcElement,
+                     QObject *dstElement,
+                     int depth=8,
+                     DropPolicy dropPolicy=DropPolicy_DropOldest);
+        ~AkQueuedLink();
+
+        Q_INVOKABLE QObject *srcElement() const;
+        Q_INVOKABLE QObject *dstElement() const;
+        Q_INVOKABLE int depth() const;
+        Q_INVOKABLE DropPolicy dropPolicy() const;
+        Q_INVOKABLE int occupancy() const;
+        Q_INVOKABLE qint64 packetsIn() const;
+        Q_INVOKABLE qint64 packetsOut() const;
+        Q_INVOKABLE qint64 packetsDropped() const;
+        Q_INVOKABLE QVariantMap stats() const;
+
+        Q_INVOKABLE static DropPolicy dropPolicyFromString(const QString &dropPolicy);
+        Q_INVOKABLE static QString dropPolicyToString(DropPolicy dropPolicy);
+
+        // Creates a queued link from srcElement oStream() to dstElement
+        // iStream().
+        Q_INVOKABLE static AkQueuedLink *link(AkElement *srcElement,
+                                              QObject *dstElement,
+                                              int depth=8,
+                                              DropPolicy dropPolicy=DropPolicy_DropOldest);
+
+        // Removes the queued links from srcElement to dstElement, and returns
+        // true if any.
+        Q_INVOKABLE static bool unlink(const QObject *srcElement,
+                                       const QObject *dstElement);
+        Q_INVOKABLE static QList<AkQueuedLink *> links(const QObject *srcElement);
+
+    private:
+        QSharedPointer<AkQueuedLinkPrivate> d;
+
+    public Q_SLOTS:
+        void enqueue(const AkPacket &packet);
+
+    friend class AkQueuedLinkPrivate;
+};
+
+Q_DECLARE_METATYPE(AkQueuedLink::DropPolicy)
+
+#endif // AKQUEUEDLINK_H
@@ -0,0 +1,387 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#ifdef Q_OS_WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "akscheduler.h"
+
+class AkSchedulerPrivate;
+
+class AkSchedulerQueue
+{
+    public:
+        QMutex m_mutex;
+        QList<AkScheduler::Task> m_tasks;
+};
+
+class AkSchedulerWorker: public QThread
+{
+    public:
+        AkSchedulerWorker(AkSchedulerPrivate *scheduler, int index):
+            m_scheduler(scheduler),
+            m_index(index)
+        {
+            this->setObjectName(QString("AkScheduler#%1").arg(index));
+        }
+
+    protected:
+        void run();
+
+    private:
+        AkSchedulerPrivate *m_scheduler;
+        int m_index;
+};
+
+class AkSchedulerPrivate
+{
+    public:
+        // One queue per worker, plus the queue for tasks sent from threads
+        // outside the scheduler, at the end.
+        QVector<AkSchedulerQueue *> m_queues;
+        QVector<AkSchedulerWorker *> m_workers;
+        QMutex m_sleepMutex;
+        QWaitCondition m_wakeUp;
+        QAtomicInt m_queued;
+        bool m_running;
+
+        AkSchedulerPrivate();
+        ~AkSchedulerPrivate();
+        void push(const AkScheduler::Task &task);
+        bool take(AkScheduler::Task &task);
+        void workerLoop(int index);
+        static int defaultThreadCount();
+};
+
+class AkTaskGroupPrivate
+{
+    public:
+        QAtomicInt m_pending;
+        QMutex m_mutex;
+        QWaitCondition m_done;
+};
+
+Q_GLOBAL_STATIC(AkSchedulerPrivate, akScheduler)
+
+// Index of the worker running in the current thread, -1 if the thread does
+// not belong to the scheduler.
+static thread_local int akSchedulerWorkerIndex = -1;
+
+// Innermost CPU timer of the current thread.
+static thread_local AkCpuTimer *akCpuTimer = nullptr;
+
+int AkScheduler::threadCount()
+{
+    return akScheduler->m_workers.size() + 1;
+}
+
+void AkScheduler::parallelFor(int count,
+                              int grain,
+                              const AkScheduler::RangeTask &task)
+{
+    if (count < 1)
+        return;
+
+    // Use a few chunks per thread, so a thread that gets preempted doesn't
+    // delay the whole loop.
+    int threads = AkScheduler::threadCount();
+    int chunkSize = qMax(qMax(grain, 1), (count + 4 * threads - 1) / (4 * threads));
+    int chunks = (count + chunkSize - 1) / chunkSize;
+
+    if (threads < 2 || chunks < 2) {
+        task(0, count);
+
+        return;
+    }
+
+    QAtomicInt next(0);
+
+    auto runChunks = [&] () {
+        forever {
+            int chunk = next.fetchAndAddRelaxed(1);
+
+            if (chunk >= chunks)
+                break;
+
+            int begin = chunk * chunkSize;
+            task(begin, qMin(begin + chunkSize, count));
+        }
+    };
+
+    AkTaskGroup group;
+
+    for (int i = 1; i < qMin(threads, chunks); i++)
+        group.run(runChunks);
+
+    runChunks();
+    group.wait();
+}
+
+qint64 AkScheduler::threadCpuTime()
+{
+#ifdef Q_OS_WIN32
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+
+    if (!GetThreadTimes(GetCurrentThread(),
+                        &creationTime,
+                        &exitTime,
+                        &kernelTime,
+                        &userTime))
+        return -1;
+
+    // The times are in units of 100 nanoseconds.
+    auto toNsecs = [] (const FILETIME &time) {
+        return 100 * ((qint64(time.dwHighDateTime) << 32)
+                      | qint64(time.dwLowDateTime));
+    };
+
+    return toNsecs(kernelTime) + toNsecs(userTime);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time))
+        return -1;
+
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+    return -1;
+#endif
+}
+
+AkCpuTimer::AkCpuTimer(QAtomicInteger<qint64> *counter):
+    m_counter(counter),
+    m_parent(akCpuTimer),
+    m_start(AkScheduler::threadCpuTime()),
+    m_children(0)
+{
+    akCpuTimer = this;
+}
+
+AkCpuTimer::~AkCpuTimer()
+{
+    akCpuTimer = this->m_parent;
+
+    if (this->m_start < 0)
+        return;
+
+    qint64 time = AkScheduler::threadCpuTime() - this->m_start;
+
+    if (this->m_parent)
+        this->m_parent->m_children += time;
+
+    this->m_counter->fetchAndAddRelaxed(time - this->m_children);
+}
+
+AkTaskGroup::AkTaskGroup()
+{
+    this->d = new AkTaskGroupPrivate;
+}
+
+AkTaskGroup::~AkTaskGroup()
+{
+    this->wait();
+    delete this->d;
+}
+
+void AkTaskGroup::run(const AkScheduler::Task &task)
+{
+    auto d = this->d;
+    d->m_pending.ref();
+
+    akScheduler->push([d, task] () {
+        task();
+
+        // The group can be destroyed as soon as m_pending reaches 0, so
+        // don't touch it after releasing the lock.
+        QMutexLocker locker(&d->m_mutex);
+
+        if (!d->m_pending.deref())
+            d->m_done.wakeAll();
+    });
+}
+
+void AkTaskGroup::wait()
+{
+    // Help running tasks while waiting, this keeps the cores busy and avoids
+    // dead locks when tasks wait for other tasks.
+    while (this->d->m_pending.loadAcquire() > 0) {
+        AkScheduler::Task task;
+
+        if (akScheduler->take(task)) {
+            task();
+
+            continue;
+        }
+
+        this->d->m_mutex.lock();
+
+        if (this->d->m_pending.loadAcquire() > 0)
+            this->d->m_done.wait(&this->d->m_mutex);
+
+        this->d->m_mutex.unlock();
+    }
+
+    // Wait for the last task to release the lock.
+    this->d->m_mutex.lock();
+    this->d->m_mutex.unlock();
+}
+
+void AkSchedulerWorker::run()
+{
+    this->m_scheduler->workerLoop(this->m_index);
+}
+
+AkSchedulerPrivate::AkSchedulerPrivate():
+    m_running(true)
+{
+    int workers = AkSchedulerPrivate::defaultThreadCount() - 1;
+
+    for (int i = 0; i <= workers; i++)
+        this->m_queues << new AkSchedulerQueue;
+
+    for (int i = 0; i < workers; i++) {
+        auto worker = new AkSchedulerWorker(this, i);
+        this->m_workers << worker;
+        worker->start();
+    }
+}
+
+AkSchedulerPrivate::~AkSchedulerPrivate()
+{
+    this->m_sleepMutex.lock();
+    this->m_running = false;
+    this->m_wakeUp.wakeAll();
+    this->m_sleepMutex.unlock();
+
+    for (auto worker: this->m_workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    for (auto queue: this->m_queues)
+        delete queue;
+}
+
+void AkSchedulerPrivate::push(const AkScheduler::Task &task)
+{
+    // Workers push to their own queue, so the tasks they spawn stay hot in
+    // their cache, other threads push to the shared queue.
+    int index = akSchedulerWorkerIndex < 0?
+                    this->m_queues.size() - 1: akSchedulerWorkerIndex;
+    auto queue = this->m_queues[index];
+    this->m_queued.ref();
+
+    queue->m_mutex.lock();
+    queue->m_tasks << task;
+    queue->m_mutex.unlock();
+
+    this->m_sleepMutex.lock();
+    this->m_wakeUp.wakeOne();
+    this->m_sleepMutex.unlock();
+}
+
+bool AkSchedulerPrivate::take(AkScheduler::Task &task)
+{
+    if (this->m_queued.loadAcquire() < 1)
+        return false;
+
+    int nQueues = this->m_queues.size();
+    int self = akSchedulerWorkerIndex;
+
+    // The own queue is used as a stack, newest tasks first.
+    if (self >= 0) {
+        auto queue = this->m_queues[self];
+        QMutexLocker locker(&queue->m_mutex);
+
+        if (!queue->m_tasks.isEmpty()) {
+            task = queue->m_tasks.takeLast();
+            this->m_queued.deref();
+
+            return true;
+        }
+    }
+
+    // Then the shared queue, and then steal the oldest task of the other
+    // workers.
+    for (int i = 0; i < nQueues; i++) {
+        int index = (nQueues - 1 + i) % nQueues;
+
+        if (index == self)
+            continue;
+
+        auto queue = this->m_queues[index];
+        QMutexLocker locker(&queue->m_mutex);
+
+        if (!queue->m_tasks.isEmpty()) {
+            task = queue->m_tasks.takeFirst();
+            this->m_queued.deref();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AkSchedulerPrivate::workerLoop(int index)
+{
+    akSchedulerWorkerIndex = index;
+
+    forever {
+        AkScheduler::Task task;
+
+        if (this->take(task)) {
+            task();
+
+            continue;
+        }
+
+        QMutexLocker locker(&this->m_sleepMutex);
+
+        if (!this->m_running)
+            break;
+
+        if (this->m_queued.loadAcquire() < 1)
+            this->m_wakeUp.wait(&this->m_sleepMutex);
+    }
+}
+
+int AkSchedulerPrivate::defaultThreadCount()
+{
+    int threads = QThread::idealThreadCount();
+    bool ok = false;
+    int maxThreads = qEnvironmentVariableIntValue("AK_THREADS", &ok);
+
+    if (ok && maxThreads > 0)
+        threads = qMin(threads, maxThreads);
+
+    return qMax(threads, 1);
+}
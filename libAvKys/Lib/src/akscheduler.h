@@ -0,0 +1,91 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKSCHEDULER_H
+#define AKSCHEDULER_H
+
+#include <functional>
+#include <QAtomicInteger>
+
+#include "akcommons.h"
+
+class AkTaskGroupPrivate;
+
+// Process wide work-stealing scheduler.
+//
+// The worker threads are created once, on first use, and live until the
+// process exits. There is one worker less than the number of cores, the
+// thread waiting for a parallelFor() or a task group runs tasks too. The
+// number of threads can be limited with the AK_THREADS environment variable.
+namespace AkScheduler
+{
+    using Task = std::function<void ()>;
+    using RangeTask = std::function<void (int begin, int end)>;
+
+    // Number of threads running tasks, including the calling thread.
+    AKCOMMONS_EXPORT int threadCount();
+
+    // Splits [0, count) in chunks of at least grain items, and calls
+    // task(begin, end) for every chunk. Returns when all chunks are done.
+    AKCOMMONS_EXPORT void parallelFor(int count,
+                                      int grain,
+                                      const RangeTask &task);
+
+    // CPU time used by the calling thread in nanoseconds, -1 if the platform
+    // can't measure it.
+    AKCOMMONS_EXPORT qint64 threadCpuTime();
+}
+
+// Adds the CPU time used by the calling thread while the timer is alive to
+// counter, in nanoseconds. The time of the timers nested in the same thread,
+// like the tasks run while waiting for a task group, is only added to their
+// own counter.
+class AKCOMMONS_EXPORT AkCpuTimer
+{
+    public:
+        explicit AkCpuTimer(QAtomicInteger<qint64> *counter);
+        ~AkCpuTimer();
+
+    private:
+        QAtomicInteger<qint64> *m_counter;
+        AkCpuTimer *m_parent;
+        qint64 m_start;
+        qint64 m_children;
+
+        Q_DISABLE_COPY(AkCpuTimer)
+};
+
+// A set of tasks that can be waited for. The destructor waits for all
+// pending tasks.
+class AKCOMMONS_EXPORT AkTaskGroup
+{
+    public:
+        AkTaskGroup();
+        ~AkTaskGroup();
+
+        void run(const AkScheduler::Task &task);
+        void wait();
+
+    private:
+        AkTaskGroupPrivate *d;
+
+        Q_DISABLE_COPY(AkTaskGroup)
+};
+
+#endif // AKSCHEDULER_H
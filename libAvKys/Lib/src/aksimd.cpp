@@ -0,0 +1,142 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QMetaEnum>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "aksimd.h"
+
+class AkSimdPrivate
+{
+    public:
+        AkSimd::InstructionSet m_supported;
+        QAtomicInt m_current;
+
+        AkSimdPrivate()
+        {
+            this->m_supported = AkSimdPrivate::detect();
+            this->m_current = AkSimdPrivate::defaultInstructionSet(this->m_supported);
+        }
+
+        static AkSimd::InstructionSet detect();
+        static AkSimd::InstructionSet defaultInstructionSet(AkSimd::InstructionSet supported);
+};
+
+Q_GLOBAL_STATIC(AkSimdPrivate, akSimd)
+
+AkSimd::InstructionSet AkSimd::supportedInstructionSet()
+{
+    return akSimd->m_supported;
+}
+
+AkSimd::InstructionSet AkSimd::instructionSet()
+{
+    return InstructionSet(akSimd->m_current.load());
+}
+
+void AkSimd::setInstructionSet(AkSimd::InstructionSet instructionSet)
+{
+    akSimd->m_current = qMin(instructionSet, akSimd->m_supported);
+}
+
+void AkSimd::resetInstructionSet()
+{
+    akSimd->m_current =
+            AkSimdPrivate::defaultInstructionSet(akSimd->m_supported);
+}
+
+QString AkSimd::toString(AkSimd::InstructionSet instructionSet)
+{
+    static const int index =
+            AkSimd::staticMetaObject.indexOfEnumerator("InstructionSet");
+    QMetaEnum instructionSetEnum = AkSimd::staticMetaObject.enumerator(index);
+    QString str(instructionSetEnum.valueToKey(instructionSet));
+    str.remove("InstructionSet_");
+
+    return str.toLower();
+}
+
+AkSimd::InstructionSet AkSimd::fromString(const QString &instructionSet)
+{
+    static const int index =
+            AkSimd::staticMetaObject.indexOfEnumerator("InstructionSet");
+    QMetaEnum instructionSetEnum = AkSimd::staticMetaObject.enumerator(index);
+
+    for (int i = 0; i < instructionSetEnum.keyCount(); i++) {
+        QString key(instructionSetEnum.key(i));
+        key.remove("InstructionSet_");
+
+        if (key.compare(instructionSet, Qt::CaseInsensitive) == 0)
+            return InstructionSet(instructionSetEnum.value(i));
+    }
+
+    return InstructionSet_None;
+}
+
+AkSimd::InstructionSet AkSimdPrivate::detect()
+{
+#ifdef AK_SIMD_X86
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return AkSimd::InstructionSet_AVX2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return AkSimd::InstructionSet_SSE2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = info[3] & (1 << 26);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+
+    // AVX2 also requires the OS to save the YMM registers.
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+
+        if (info[1] & (1 << 5))
+            return AkSimd::InstructionSet_AVX2;
+    }
+
+    if (sse2)
+        return AkSimd::InstructionSet_SSE2;
+#endif
+#endif
+
+    return AkSimd::InstructionSet_None;
+}
+
+AkSimd::InstructionSet AkSimdPrivate::defaultInstructionSet(AkSimd::InstructionSet supported)
+{
+    QByteArray instructionSet = qgetenv("AK_SIMD");
+
+    if (instructionSet.isEmpty())
+        return supported;
+
+    return qMin(AkSimd::fromString(QString::fromLatin1(instructionSet)),
+                supported);
+}
+
+#include "moc_aksimd.cpp"
@@ -0,0 +1,67 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKSIMD_H
+#define AKSIMD_H
+
+#include <QObject>
+
+#include "akcommons.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define AK_SIMD_X86
+#endif
+
+// Enables an instruction set for a single function, so the kernels can be
+// compiled without raising the minimum CPU required by the whole library.
+#if defined(__GNUC__) || defined(__clang__)
+    #define AK_SIMD_TARGET(instructionSet) __attribute__((target(instructionSet)))
+#else
+    #define AK_SIMD_TARGET(instructionSet)
+#endif
+
+class AKCOMMONS_EXPORT AkSimd
+{
+    Q_GADGET
+    Q_ENUMS(InstructionSet)
+
+    public:
+        enum InstructionSet
+        {
+            InstructionSet_None,
+            InstructionSet_SSE2,
+            InstructionSet_AVX2
+        };
+
+        // Instruction sets supported by the CPU.
+        static InstructionSet supportedInstructionSet();
+
+        // Instruction set used by the kernels, it's the supported one unless
+        // it was limited with setInstructionSet() or the AK_SIMD environment
+        // variable (none, sse2 or avx2).
+        static InstructionSet instructionSet();
+        static void setInstructionSet(InstructionSet instructionSet);
+        static void resetInstructionSet();
+        static QString toString(InstructionSet instructionSet);
+        static InstructionSet fromString(const QString &instructionSet);
+};
+
+Q_DECLARE_METATYPE(AkSimd::InstructionSet)
+
+#endif // AKSIMD_H
@@ -0,0 +1,404 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInteger>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <atomic>
+
+#include "aktracer.h"
+
+#define DEFAULT_RING_SIZE (1 << 15)
+
+struct AkTraceEvent
+{
+    const char *category;
+    const char *name;
+    qint64 start;
+    qint64 duration;
+    qint64 id;
+    qint64 pts;
+    int thread;
+    bool hasPacket;
+};
+
+// The sequence is 2 * n + 2 when the slot holds the event n of the ring, and
+// odd while the event is being written, so readers can detect torn events.
+struct AkTraceSlot
+{
+    QAtomicInteger<quint64> m_sequence;
+    AkTraceEvent m_event;
+};
+
+// Single producer ring, only the owner thread writes to it.
+class AkTracerRing
+{
+    public:
+        QVector<AkTraceSlot> m_slots;
+        QAtomicInteger<quint64> m_head;
+        quint64 m_mask;
+        int m_thread;
+
+        AkTracerRing(int size):
+            m_slots(size),
+            m_head(0),
+            m_mask(quint64(size - 1)),
+            m_thread(-1)
+        {
+        }
+};
+
+class AkTracerPrivate
+{
+    public:
+        QElapsedTimer m_timer;
+        QAtomicInteger<qint64> m_clearTime;
+        QMutex m_mutex;
+        QList<AkTracerRing *> m_rings;
+        QList<AkTracerRing *> m_freeRings;
+        QMap<int, QString> m_threadNames;
+        int m_threadCount;
+        int m_ringSize;
+
+        AkTracerPrivate();
+        ~AkTracerPrivate();
+        AkTracerRing *acquireRing();
+        void releaseRing(AkTracerRing *ring);
+        QVector<AkTraceEvent> events();
+        inline static QByteArray escape(const char *str);
+        inline static QByteArray escape(const QString &str);
+        inline static QByteArray microseconds(qint64 ns);
+};
+
+Q_GLOBAL_STATIC(AkTracerPrivate, akTracerGlobal)
+static QAtomicInt akTracerEnabled(0);
+
+// Returns the ring to the pool when the thread finishes.
+class AkTracerThreadRing
+{
+    public:
+        AkTracerRing *m_ring {nullptr};
+
+        ~AkTracerThreadRing()
+        {
+            if (this->m_ring && !akTracerGlobal.isDestroyed())
+                akTracerGlobal->releaseRing(this->m_ring);
+        }
+};
+
+static thread_local AkTracerThreadRing akTracerThreadRing;
+
+bool AkTracer::isEnabled()
+{
+    return akTracerEnabled.loadAcquire() != 0;
+}
+
+void AkTracer::setEnabled(bool enabled)
+{
+    akTracerEnabled.storeRelease(enabled);
+}
+
+qint64 AkTracer::timestamp()
+{
+    return akTracerGlobal->m_timer.nsecsElapsed();
+}
+
+void AkTracer::record(const char *category,
+                      const char *name,
+                      qint64 start,
+                      qint64 duration,
+                      qint64 id,
+                      qint64 pts,
+                      bool hasPacket)
+{
+    auto ring = akTracerThreadRing.m_ring;
+
+    if (!ring) {
+        if (akTracerGlobal.isDestroyed())
+            return;
+
+        ring = akTracerGlobal->acquireRing();
+        akTracerThreadRing.m_ring = ring;
+    }
+
+    auto head = ring->m_head.load();
+    auto &slot = ring->m_slots[int(head & ring->m_mask)];
+    slot.m_sequence.store(2 * head + 1);
+    std::atomic_thread_fence(std::memory_order_release);
+    auto &event = slot.m_event;
+    event.category = category;
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    event.id = id;
+    event.pts = pts;
+    event.thread = ring->m_thread;
+    event.hasPacket = hasPacket;
+    slot.m_sequence.storeRelease(2 * head + 2);
+    ring->m_head.storeRelease(head + 1);
+}
+
+void AkTracer::clear()
+{
+    // The rings belong to the recording threads, so instead of emptying them
+    // just ignore everything recorded before now.
+    akTracerGlobal->m_clearTime.storeRelease(AkTracer::timestamp());
+}
+
+QByteArray AkTracer::toJson()
+{
+    auto events = akTracerGlobal->events();
+    auto pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json;
+    json.reserve(160 * events.size() + 1024);
+    json += "{\"traceEvents\":[";
+    bool first = true;
+
+    auto beginEvent = [&json, &first] () {
+        if (!first)
+            json += ",\n";
+
+        first = false;
+    };
+
+    akTracerGlobal->m_mutex.lock();
+    auto threadNames = akTracerGlobal->m_threadNames;
+    akTracerGlobal->m_mutex.unlock();
+
+    for (auto it = threadNames.begin(); it != threadNames.end(); it++) {
+        beginEvent();
+        json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid
+              + ",\"tid\":" + QByteArray::number(it.key())
+              + ",\"args\":{\"name\":\""
+              + AkTracerPrivate::escape(it.value())
+              + "\"}}";
+    }
+
+    // Events of the same packet, in chronological order.
+    QMap<QPair<qint64, qint64>, QVector<int>> packets;
+
+    for (int i = 0; i < events.size(); i++) {
+        auto &event = events[i];
+        beginEvent();
+        json += "{\"name\":\"" + AkTracerPrivate::escape(event.name)
+              + "\",\"cat\":\"" + AkTracerPrivate::escape(event.category)
+              + "\",\"ph\":\"X\",\"ts\":"
+              + AkTracerPrivate::microseconds(event.start)
+              + ",\"dur\":" + AkTracerPrivate::microseconds(event.duration)
+              + ",\"pid\":" + pid
+              + ",\"tid\":" + QByteArray::number(event.thread);
+
+        if (event.hasPacket) {
+            json += ",\"args\":{\"id\":" + QByteArray::number(event.id)
+                  + ",\"pts\":" + QByteArray::number(event.pts) + "}";
+            packets[{event.id, event.pts}] << i;
+        }
+
+        json += "}";
+    }
+
+    // Link the events of every packet with flow arrows.
+    int flowId = 0;
+
+    for (auto &packet: packets) {
+        if (packet.size() < 2)
+            continue;
+
+        for (int i = 0; i < packet.size(); i++) {
+            auto &event = events[packet[i]];
+            const char *phase = "t";
+
+            if (i == 0)
+                phase = "s";
+            else if (i == packet.size() - 1)
+                phase = "f";
+
+            beginEvent();
+            json += "{\"name\":\"packet\",\"cat\":\"flow\",\"ph\":\""
+                  + QByteArray(phase)
+                  + "\",\"id\":" + QByteArray::number(flowId)
+                  + ",\"ts\":" + AkTracerPrivate::microseconds(event.start)
+                  + ",\"pid\":" + pid
+                  + ",\"tid\":" + QByteArray::number(event.thread);
+
+            if (i == packet.size() - 1)
+                json += ",\"bp\":\"e\"";
+
+            json += "}";
+        }
+
+        flowId++;
+    }
+
+    json += "],\n\"displayTimeUnit\":\"ms\"}\n";
+
+    return json;
+}
+
+bool AkTracer::save(const QString &fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Can't save trace to" << fileName
+                   << ":" << file.errorString();
+
+        return false;
+    }
+
+    auto json = AkTracer::toJson();
+
+    return file.write(json) == json.size();
+}
+
+AkTracerPrivate::AkTracerPrivate():
+    m_clearTime(0),
+    m_threadCount(0),
+    m_ringSize(DEFAULT_RING_SIZE)
+{
+    this->m_timer.start();
+    int ringSize = qEnvironmentVariableIntValue("AK_TRACE_EVENTS");
+
+    // Round up to a power of 2.
+    if (ringSize > 0) {
+        this->m_ringSize = 1;
+
+        while (this->m_ringSize < ringSize && this->m_ringSize < (1 << 24))
+            this->m_ringSize <<= 1;
+    }
+}
+
+AkTracerPrivate::~AkTracerPrivate()
+{
+    qDeleteAll(this->m_rings);
+}
+
+AkTracerRing *AkTracerPrivate::acquireRing()
+{
+    auto thread = QThread::currentThread();
+    auto app = QCoreApplication::instance();
+    QString threadName;
+
+    if (app && app->thread() == thread)
+        threadName = "Main";
+    else if (thread)
+        threadName = thread->objectName();
+
+    QMutexLocker mutexLocker(&this->m_mutex);
+    AkTracerRing *ring = nullptr;
+
+    if (this->m_freeRings.isEmpty()) {
+        ring = new AkTracerRing(this->m_ringSize);
+        this->m_rings << ring;
+    } else {
+        ring = this->m_freeRings.takeLast();
+    }
+
+    ring->m_thread = this->m_threadCount++;
+
+    if (threadName.isEmpty())
+        threadName = QString("Thread %1").arg(ring->m_thread);
+
+    this->m_threadNames[ring->m_thread] = threadName;
+
+    return ring;
+}
+
+void AkTracerPrivate::releaseRing(AkTracerRing *ring)
+{
+    QMutexLocker mutexLocker(&this->m_mutex);
+    this->m_freeRings << ring;
+}
+
+QVector<AkTraceEvent> AkTracerPrivate::events()
+{
+    auto clearTime = this->m_clearTime.loadAcquire();
+    QVector<AkTraceEvent> events;
+    QMutexLocker mutexLocker(&this->m_mutex);
+
+    for (auto &ring: this->m_rings) {
+        auto size = quint64(ring->m_slots.size());
+        auto head = ring->m_head.loadAcquire();
+        auto tail = head > size? head - size: 0;
+
+        for (auto i = tail; i < head; i++) {
+            auto &slot = ring->m_slots.at(int(i & ring->m_mask));
+            auto sequence = slot.m_sequence.loadAcquire();
+
+            if (sequence != 2 * i + 2)
+                continue;
+
+            auto event = slot.m_event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // The owner thread overwrote the event while copying it.
+            if (slot.m_sequence.load() != sequence)
+                continue;
+
+            if (event.start >= clearTime)
+                events << event;
+        }
+    }
+
+    mutexLocker.unlock();
+
+    std::sort(events.begin(),
+              events.end(),
+              [] (const AkTraceEvent &a, const AkTraceEvent &b) {
+        return a.start < b.start;
+    });
+
+    return events;
+}
+
+QByteArray AkTracerPrivate::escape(const char *str)
+{
+    return escape(QString::fromUtf8(str));
+}
+
+QByteArray AkTracerPrivate::escape(const QString &str)
+{
+    QString escaped;
+    escaped.reserve(str.size());
+
+    for (auto &c: str)
+        if (c == '"' || c == '\\')
+            escaped += QString("\\") + c;
+        else if (c.unicode() < 0x20)
+            escaped += QString("\\u%1").arg(int(c.unicode()),
+                                              4,
+                                              16,
+                                              QChar('0'));
+        else
+            escaped += c;
+
+    return escaped.toUtf8();
+}
+
+QByteArray AkTracerPrivate::microseconds(qint64 ns)
+{
+    return QByteArray::number(qreal(ns) / 1e3, 'f', 3);
+}
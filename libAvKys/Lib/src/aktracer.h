@@ -0,0 +1,124 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKTRACER_H
+#define AKTRACER_H
+
+#include "akpacket.h"
+
+// Lightweight timeline tracer.
+//
+// Every thread records its events in its own fixed size ring, so recording
+// never locks nor allocates, old events are overwritten when the ring is
+// full. The ring size can be changed with the AK_TRACE_EVENTS environment
+// variable. The collected events can be saved in Chrome trace event format,
+// and loaded in chrome://tracing or https://ui.perfetto.dev. Events recorded
+// with the same packet id and pts are linked with flow arrows, so a frame can
+// be followed from capture to display.
+namespace AkTracer
+{
+    AKCOMMONS_EXPORT bool isEnabled();
+    AKCOMMONS_EXPORT void setEnabled(bool enabled);
+
+    // Nanoseconds since the tracer was started.
+    AKCOMMONS_EXPORT qint64 timestamp();
+
+    AKCOMMONS_EXPORT void record(const char *category,
+                                 const char *name,
+                                 qint64 start,
+                                 qint64 duration,
+                                 qint64 id=-1,
+                                 qint64 pts=-1,
+                                 bool hasPacket=false);
+
+    // Removes all recorded events.
+    AKCOMMONS_EXPORT void clear();
+
+    AKCOMMONS_EXPORT QByteArray toJson();
+    AKCOMMONS_EXPORT bool save(const QString &fileName);
+}
+
+// Records an event spanning from its construction to its destruction.
+// category and name must be string literals.
+class AkTraceScope
+{
+    public:
+        inline AkTraceScope(const char *category, const char *name):
+            m_category(category),
+            m_name(name),
+            m_start(AkTracer::isEnabled()? AkTracer::timestamp(): -1),
+            m_id(-1),
+            m_pts(-1),
+            m_hasPacket(false)
+        {
+        }
+
+        inline AkTraceScope(const char *category,
+                            const char *name,
+                            const AkPacket &packet):
+            AkTraceScope(category, name)
+        {
+            this->setPacket(packet);
+        }
+
+        inline ~AkTraceScope()
+        {
+            if (this->m_start >= 0)
+                AkTracer::record(this->m_category,
+                                 this->m_name,
+                                 this->m_start,
+                                 AkTracer::timestamp() - this->m_start,
+                                 this->m_id,
+                                 this->m_pts,
+                                 this->m_hasPacket);
+        }
+
+        // Sets the packet the event belongs to, for when it's not known
+        // when the scope starts.
+        inline void setPacket(const AkPacket &packet)
+        {
+            this->setPacket(packet.id(), packet.pts());
+        }
+
+        inline void setPacket(qint64 id, qint64 pts)
+        {
+            this->m_id = id;
+            this->m_pts = pts;
+            this->m_hasPacket = true;
+        }
+
+    private:
+        const char *m_category;
+        const char *m_name;
+        qint64 m_start;
+        qint64 m_id;
+        qint64 m_pts;
+        bool m_hasPacket;
+
+        Q_DISABLE_COPY(AkTraceScope)
+};
+
+#define AK_TRACE_SCOPE(category, name) \
+    AkTraceScope akTraceScope(category, name)
+#define AK_TRACE_PACKET_SCOPE(category, name, packet) \
+    AkTraceScope akTraceScope(category, name, packet)
+#define AK_TRACE_SET_PACKET(...) \
+    akTraceScope.setPacket(__VA_ARGS__)
+
+#endif // AKTRACER_H
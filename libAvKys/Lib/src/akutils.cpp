@@ -17,6 +17,7 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
+#include <QColor>
 #include <QDataStream>
 #include <QImage>
 #include <QMap>
@@ -27,6 +28,9 @@
 #include "akvideocaps.h"
 #include "akpacket.h"
 #include "akvideopacket.h"
+#include "akvideoconverter.h"
+#include "akvideoscaler.h"
+#include "akpixelview.h"
 
 typedef QMap<QImage::Format, AkVideoCaps::PixelFormat> ImageToPixelFormatMap;
 
@@ -47,15 +51,60 @@ inline ImageToPixelFormatMap initImageToPixelFormatMap()
 }
 
 Q_GLOBAL_STATIC_WITH_ARGS(ImageToPixelFormatMap, AkImageToFormat, (initImageToPixelFormatMap()))
+Q_GLOBAL_STATIC(AkVideoConverter, akVideoConverter)
+Q_GLOBAL_STATIC(AkVideoScaler, akVideoScaler)
+
+// Keeps the packet storage alive while a QImage is wrapping it.
+struct AkImageBuffer
+{
+    QByteArray m_buffer;
+    QVariant m_owner;
+};
+
+class AkUtilsPrivate
+{
+    public:
+        static void releaseImageBuffer(void *userData)
+        {
+            delete reinterpret_cast<AkImageBuffer *>(userData);
+        }
+
+        template<AkVideoCaps::PixelFormat Format>
+        static inline typename std::enable_if<AkPixelView<Format>::IsRgb, QImage>::type
+        lumaImage(const AkConstPixelView<Format> &src,
+                  const AkPacket &packet,
+                  bool fullRange);
+        template<AkVideoCaps::PixelFormat Format>
+        static inline typename std::enable_if<AkPixelView<Format>::IsYuv, QImage>::type
+        lumaImage(const AkConstPixelView<Format> &src,
+                  const AkPacket &packet,
+                  bool fullRange);
+};
+
+struct AkLumaImage
+{
+    AkPacket m_packet;
+    bool m_fullRange;
+    QImage m_image;
+
+    template<AkVideoCaps::PixelFormat Format>
+    inline void process()
+    {
+        auto src = AkConstPixelView<Format>::fromPacket(this->m_packet);
+
+        if (src)
+            this->m_image = AkUtilsPrivate::lumaImage(src,
+                                                      this->m_packet,
+                                                      this->m_fullRange);
+    }
+};
 
 AkPacket AkUtils::imageToPacket(const QImage &image, const AkPacket &defaultPacket)
 {
     if (!AkImageToFormat->contains(image.format()))
         return AkPacket();
 
-    size_t imageSize = size_t(image.bytesPerLine()) * size_t(image.height());
-    QByteArray oBuffer(int(imageSize), 0);
-    memcpy(oBuffer.data(), image.constBits(), imageSize);
+    int imageSize = image.bytesPerLine() * image.height();
 
     AkVideoCaps caps(defaultPacket.caps());
     caps.format() = AkImageToFormat->value(image.format());
@@ -64,8 +113,21 @@ AkPacket AkUtils::imageToPacket(const QImage &image, const AkPacket &defaultPack
     caps.height() = image.height();
 
     AkPacket packet = defaultPacket;
-    packet.setCaps(caps.toCaps());
-    packet.setBuffer(oBuffer);
+    packet.caps() = caps.toCaps();
+
+    /* If the image is still wrapping the buffer of the input packet (the
+     * filter never wrote to it), reuse that buffer as is.
+     * Otherwise, adopt the image storage without copying it. The image is
+     * kept alive as the buffer owner, and the buffer will be detached (deep
+     * copied) only if someone writes to it.
+     */
+    if (image.constBits() != reinterpret_cast<const uchar *>(defaultPacket.buffer().constData())
+        || imageSize > defaultPacket.buffer().size()) {
+        packet.buffer() =
+                QByteArray::fromRawData(reinterpret_cast<const char *>(image.constBits()),
+                                        imageSize);
+        packet.setBufferOwner(QVariant::fromValue(image));
+    }
 
     return packet;
 }
@@ -80,22 +142,32 @@ QImage AkUtils::packetToImage(const AkPacket &packet)
     if (!AkImageToFormat->values().contains(caps.format()))
         return QImage();
 
-    QImage image(caps.width(),
-                 caps.height(),
-                 AkImageToFormat->key(caps.format()));
-    memcpy(image.bits(), packet.buffer().constData(), size_t(packet.buffer().size()));
+    if (caps.width() < 1 || caps.height() < 1)
+        return QImage();
+
+    int lineSize = (caps.width() * AkVideoCaps::bitsPerPixel(caps.format()) + 7) / 8;
+    int bytesPerLine = packet.buffer().size() / caps.height();
+
+    if (bytesPerLine < lineSize)
+        return QImage();
 
-    if (caps.format() == AkVideoCaps::Format_gray)
-        for (int i = 0; i < 256; i++)
-            image.setColor(i, QRgb(i));
+    // Wrap the packet buffer instead of copying it. The QImage will make a
+    // deep copy of the data only when a filter writes to it.
+    auto frameBuffer = new AkImageBuffer {packet.buffer(), packet.bufferOwner()};
 
-    return image;
+    return QImage(reinterpret_cast<const uchar *>(frameBuffer->m_buffer.constData()),
+                  caps.width(),
+                  caps.height(),
+                  bytesPerLine,
+                  AkImageToFormat->key(caps.format()),
+                  AkUtilsPrivate::releaseImageBuffer,
+                  frameBuffer);
 }
 
 AkPacket AkUtils::roundSizeTo(const AkPacket &packet, int align)
 {
-    int frameWidth = packet.caps().property("width").toInt();
-    int frameHeight = packet.caps().property("height").toInt();
+    int frameWidth = packet.caps().capsProperty("width").toInt();
+    int frameHeight = packet.caps().capsProperty("height").toInt();
 
     /* Explanation:
      *
@@ -125,36 +197,167 @@ AkPacket AkUtils::roundSizeTo(const AkPacket &packet, int align)
         && frameHeight == height)
         return packet;
 
+    AkVideoPacket videoPacket(packet);
+
+    if (AkVideoScaler::canScale(videoPacket.caps().format()))
+        return akVideoScaler->scale(videoPacket, width, height).toPacket();
+
     QImage frame = AkUtils::packetToImage(packet);
 
     if (frame.isNull())
         return packet;
 
-    return AkUtils::imageToPacket(frame.scaled(width, height), packet);
+    return AkUtils::imageToPacket(akVideoScaler->scale(frame, width, height),
+                                  packet);
 }
 
 AkVideoPacket AkUtils::convertVideo(const AkVideoPacket &packet,
                                     AkVideoCaps::PixelFormat format,
                                     const QSize &size)
 {
-    if (!AkImageToFormat->values().contains(format))
-        return AkVideoPacket();
+    AkVideoCaps::PixelFormat iFormat = packet.caps().format();
+    bool resize = !size.isEmpty() && packet.caps().size() != size;
 
-    if (packet.caps().format() == format
-        && (size.isEmpty() || packet.caps().size() == size))
+    if (iFormat == format && !resize)
         return packet;
 
+    if (AkVideoConverter::canConvert(iFormat, format)) {
+        if (!resize)
+            return akVideoConverter->convert(packet, format);
+
+        if (AkVideoScaler::canScale(format))
+            return akVideoScaler->scale(akVideoConverter->convert(packet,
+                                                                  format),
+                                        size);
+
+        if (AkVideoScaler::canScale(iFormat))
+            return akVideoConverter->convert(akVideoScaler->scale(packet, size),
+                                             format);
+
+        AkVideoPacket argbPacket =
+                akVideoConverter->convert(packet, AkVideoCaps::Format_argb);
+
+        return akVideoConverter->convert(akVideoScaler->scale(argbPacket, size),
+                                         format);
+    }
+
+    // Formats not supported by AkVideoConverter are converted with QImage.
+    if (!AkImageToFormat->values().contains(format))
+        return AkVideoPacket();
+
     QImage frame = AkUtils::packetToImage(packet.toPacket());
 
     if (frame.isNull())
         return packet;
 
-    QImage convertedFrame;
+    QImage convertedFrame = frame.convertToFormat(AkImageToFormat->key(format));
 
-    if (size.isEmpty())
-        convertedFrame = frame.convertToFormat(AkImageToFormat->key(format));
-    else
-        convertedFrame = frame.convertToFormat(AkImageToFormat->key(format)).scaled(size);
+    if (resize)
+        convertedFrame = akVideoScaler->scale(convertedFrame, size);
 
     return AkUtils::imageToPacket(convertedFrame, packet.toPacket());
 }
+
+template<AkVideoCaps::PixelFormat Format>
+typename std::enable_if<AkPixelView<Format>::IsRgb, QImage>::type
+AkUtilsPrivate::lumaImage(const AkConstPixelView<Format> &src,
+                          const AkPacket &packet,
+                          bool fullRange)
+{
+    Q_UNUSED(packet)
+    Q_UNUSED(fullRange)
+    using View = AkPixelView<Format>;
+
+    auto image = AkBufferPool::image(src.width(),
+                                     src.height(),
+                                     QImage::Format_Grayscale8);
+    auto bits = image.bits();
+    int lineSize = image.bytesPerLine();
+
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            auto srcLine = src.line(y);
+            auto dstLine = bits + y * lineSize;
+
+            for (int x = 0; x < src.width(); x++)
+                dstLine[x] = quint8(qGray(View::red(srcLine, x),
+                                          View::green(srcLine, x),
+                                          View::blue(srcLine, x)));
+        }
+    });
+
+    return image;
+}
+
+template<AkVideoCaps::PixelFormat Format>
+typename std::enable_if<AkPixelView<Format>::IsYuv, QImage>::type
+AkUtilsPrivate::lumaImage(const AkConstPixelView<Format> &src,
+                          const AkPacket &packet,
+                          bool fullRange)
+{
+    using View = AkPixelView<Format>;
+    bool expand = fullRange && !View::Layout::FullRange;
+
+    // The luma plane is a gray image already, just wrap it.
+    if (!expand && View::BytesPerPixel == 1) {
+        auto frameBuffer = new AkImageBuffer {packet.buffer(), packet.bufferOwner()};
+
+        return QImage(src.line(0),
+                      src.width(),
+                      src.height(),
+                      src.lineSize(0),
+                      QImage::Format_Grayscale8,
+                      AkUtilsPrivate::releaseImageBuffer,
+                      frameBuffer);
+    }
+
+    quint8 lumaTable[256];
+
+    for (int i = 0; i < 256; i++)
+        lumaTable[i] =
+                expand?
+                    quint8(qBound(0,
+                                  255 * (i - View::MinLuma)
+                                  / (View::MaxLuma - View::MinLuma),
+                                  255)):
+                    quint8(i);
+
+    auto image = AkBufferPool::image(src.width(),
+                                     src.height(),
+                                     QImage::Format_Grayscale8);
+    auto bits = image.bits();
+    int lineSize = image.bytesPerLine();
+
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            auto srcLine = src.line(y);
+            auto dstLine = bits + y * lineSize;
+
+            for (int x = 0; x < src.width(); x++)
+                dstLine[x] = lumaTable[View::luma(srcLine, x)];
+        }
+    });
+
+    return image;
+}
+
+QImage AkUtils::lumaImage(const AkVideoPacket &packet, bool fullRange)
+{
+    auto format = packet.caps().format();
+
+    if (format == AkVideoCaps::Format_none)
+        return QImage();
+
+    AkLumaImage luma {packet.toPacket(), fullRange, QImage()};
+
+    if (akPixelDispatch(format, luma))
+        return luma.m_image;
+
+    // Formats without a pixel view are converted with QImage.
+    QImage frame = AkUtils::packetToImage(packet.toPacket());
+
+    if (frame.isNull())
+        return QImage();
+
+    return frame.convertToFormat(QImage::Format_Grayscale8);
+}
@@ -36,6 +36,14 @@ namespace AkUtils
     AKCOMMONS_EXPORT AkVideoPacket convertVideo(const AkVideoPacket &packet,
                                                 AkVideoCaps::PixelFormat format,
                                                 const QSize &size=QSize());
+
+    // Returns the luma of the frame as a Format_Grayscale8 image. Gray and YUV
+    // frames are not color converted, only the luma samples are read, and if
+    // they can be used as is the image wraps the packet memory. Limited range
+    // luma is expanded to full range, unless fullRange is false. RGB frames
+    // are converted with qGray().
+    AKCOMMONS_EXPORT QImage lumaImage(const AkVideoPacket &packet,
+                                      bool fullRange=true);
 }
 
 #endif // AKUTILS_H
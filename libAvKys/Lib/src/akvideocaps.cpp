@@ -288,16 +288,15 @@ AkVideoCaps::AkVideoCaps(const QString &caps)
 AkVideoCaps::AkVideoCaps(const AkCaps &caps)
 {
     this->d = new AkVideoCapsPrivate();
+    this->d->m_isValid = false;
+    this->d->m_format = AkVideoCaps::Format_none;
+    this->d->m_bpp = 0;
+    this->d->m_width = 0;
+    this->d->m_height = 0;
 
-    if (caps.mimeType() == "video/x-raw") {
+    if (caps.type() == AkCaps::CapsVideo) {
         this->d->m_isValid = caps.isValid();
         this->update(caps);
-    } else {
-        this->d->m_isValid = false;
-        this->d->m_format = AkVideoCaps::Format_none;
-        this->d->m_bpp = 0;
-        this->d->m_width = 0;
-        this->d->m_height = 0;
     }
 }
 
@@ -346,7 +345,7 @@ AkVideoCaps &AkVideoCaps::operator =(const AkVideoCaps &other)
 
 AkVideoCaps &AkVideoCaps::operator =(const AkCaps &caps)
 {
-    if (caps.mimeType() == "video/x-raw") {
+    if (caps.type() == AkCaps::CapsVideo) {
         this->d->m_isValid = caps.isValid();
         this->update(caps);
     } else {
@@ -368,7 +367,30 @@ AkVideoCaps &AkVideoCaps::operator =(const QString &caps)
 
 bool AkVideoCaps::operator ==(const AkVideoCaps &other) const
 {
-    return this->toString() == other.toString();
+    if (this->d->m_isValid != other.d->m_isValid)
+        return false;
+
+    if (!this->d->m_isValid)
+        return true;
+
+    if (this->d->m_format != other.d->m_format
+        || this->d->m_bpp != other.d->m_bpp
+        || this->d->m_width != other.d->m_width
+        || this->d->m_height != other.d->m_height
+        || this->d->m_fps.num() != other.d->m_fps.num()
+        || this->d->m_fps.den() != other.d->m_fps.den())
+        return false;
+
+    QList<QByteArray> properties = this->dynamicPropertyNames();
+
+    if (properties.size() != other.dynamicPropertyNames().size())
+        return false;
+
+    for (const QByteArray &property: properties)
+        if (this->property(property) != other.property(property))
+            return false;
+
+    return true;
 }
 
 bool AkVideoCaps::operator !=(const AkVideoCaps &other) const
@@ -543,33 +565,56 @@ QString AkVideoCaps::toString() const
 
 AkVideoCaps &AkVideoCaps::update(const AkCaps &caps)
 {
-    if (caps.mimeType() != "video/x-raw")
+    if (caps.type() != AkCaps::CapsVideo)
         return *this;
 
     this->clear();
 
-    QList<QByteArray> properties = caps.dynamicPropertyNames();
+    // Read the raw fields directly, no string conversion needed.
+    auto &videoCaps = caps.videoCaps();
+
+    if (videoCaps.fields & AkCaps::VideoCaps::Format)
+        this->d->m_format = PixelFormat(videoCaps.format);
+
+    if (videoCaps.fields & AkCaps::VideoCaps::Bpp)
+        this->d->m_bpp = videoCaps.bpp;
+
+    if (videoCaps.fields & AkCaps::VideoCaps::Width)
+        this->d->m_width = videoCaps.width;
+
+    if (videoCaps.fields & AkCaps::VideoCaps::Height)
+        this->d->m_height = videoCaps.height;
+
+    if (videoCaps.fields & AkCaps::VideoCaps::Fps)
+        this->d->m_fps.setNumDen(videoCaps.fpsNum, videoCaps.fpsDen);
+
+    QList<QByteArray> properties = caps.QObject::dynamicPropertyNames();
 
     for (const QByteArray &property: properties)
-        if (property == "format")
-            this->d->m_format = this->pixelFormatFromString(caps.property(property).toString());
-        else if (property == "bpp")
-            this->d->m_bpp = caps.property(property).toInt();
-        else if (property == "width")
-            this->d->m_width = caps.property(property).toInt();
-        else if (property == "height")
-            this->d->m_height = caps.property(property).toInt();
-        else if (property == "fps")
-            this->d->m_fps = caps.property("fps").toString();
-        else
-            this->setProperty(property, caps.property(property));
+        this->setProperty(property, caps.QObject::property(property));
 
     return *this;
 }
 
 AkCaps AkVideoCaps::toCaps() const
 {
-    return AkCaps(this->toString());
+    AkCaps caps;
+
+    if (!this->d->m_isValid)
+        return caps;
+
+    caps.setVideoCaps({AkCaps::VideoCaps::All,
+                       this->d->m_format,
+                       this->d->m_bpp,
+                       this->d->m_width,
+                       this->d->m_height,
+                       this->d->m_fps.num(),
+                       this->d->m_fps.den()});
+
+    for (const QByteArray &property: this->dynamicPropertyNames())
+        caps.QObject::setProperty(property, this->property(property));
+
+    return caps;
 }
 
 int AkVideoCaps::bitsPerPixel(AkVideoCaps::PixelFormat pixelFormat)
@@ -584,9 +629,9 @@ int AkVideoCaps::bitsPerPixel(const QString &pixelFormat)
 
 QString AkVideoCaps::pixelFormatToString(AkVideoCaps::PixelFormat pixelFormat)
 {
-    AkVideoCaps caps;
-    int formatIndex = caps.metaObject()->indexOfEnumerator("PixelFormat");
-    QMetaEnum formatEnum = caps.metaObject()->enumerator(formatIndex);
+    static const int formatIndex =
+            AkVideoCaps::staticMetaObject.indexOfEnumerator("PixelFormat");
+    QMetaEnum formatEnum = AkVideoCaps::staticMetaObject.enumerator(formatIndex);
     QString format(formatEnum.valueToKey(pixelFormat));
     format.remove("Format_");
 
@@ -595,10 +640,10 @@ QString AkVideoCaps::pixelFormatToString(AkVideoCaps::PixelFormat pixelFormat)
 
 AkVideoCaps::PixelFormat AkVideoCaps::pixelFormatFromString(const QString &pixelFormat)
 {
-    AkVideoCaps caps;
     QString format = "Format_" + pixelFormat;
-    int enumIndex = caps.metaObject()->indexOfEnumerator("PixelFormat");
-    QMetaEnum enumType = caps.metaObject()->enumerator(enumIndex);
+    static const int enumIndex =
+            AkVideoCaps::staticMetaObject.indexOfEnumerator("PixelFormat");
+    QMetaEnum enumType = AkVideoCaps::staticMetaObject.enumerator(enumIndex);
     int enumValue = enumType.keyToValue(format.toStdString().c_str());
 
     return static_cast<PixelFormat>(enumValue);
@@ -0,0 +1,1824 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "akvideoconverter.h"
+#include "akvideopacket.h"
+#include "akbufferpool.h"
+#include "aksimd.h"
+#include "akscheduler.h"
+
+// The SIMD kernels read and write the 32 bits RGB words as bytes, so they are
+// only used in little endian machines.
+#if defined(AK_SIMD_X86) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    #define AK_VIDEOCONVERTER_SIMD
+    #include <immintrin.h>
+#endif
+
+// Frames smaller than this number of pixels are converted in the calling
+// thread.
+#define MIN_PARALLEL_PIXELS (320 * 240)
+
+// Minimum number of rows processed by a thread.
+#define MIN_BAND_HEIGHT 16
+
+#define MAX_CACHED_CONTEXTS 64
+
+// Fractional bits of the YUV to RGB and RGB to YUV coefficients.
+#define YUV2RGB_SHIFT 6
+#define RGB2YUV_SHIFT 14
+
+struct YuvToRgbCoefficients
+{
+    qint16 yOffset;
+    qint16 yMul;
+    qint16 vr;
+    qint16 ug;
+    qint16 vg;
+    qint16 ub;
+};
+
+struct RgbToYuvCoefficients
+{
+    qint16 yr;
+    qint16 yg;
+    qint16 yb;
+    qint16 ur;
+    qint16 ug;
+    qint16 ub;
+    qint16 vr;
+    qint16 vg;
+    qint16 vb;
+    int yOffset;
+};
+
+struct SwizzleParameters
+{
+    // Bit shifts of the r, g, b and a components in the source and the
+    // destination words.
+    int srcShift[4];
+    int dstShift[4];
+
+    // Number of components to move, alpha is not moved when any of the
+    // formats lacks it, and the destination is made opaque instead.
+    int components;
+    quint32 opaque;
+
+    // Byte shuffle of 4 pixels, equivalent to the shifts above.
+    qint8 shuffle[16];
+};
+
+// Byte offsets of the components inside a 2 pixels macropixel.
+struct Packed422Layout
+{
+    int y;
+    int u;
+    int v;
+};
+
+static inline int saturate16(int value)
+{
+    return qBound(-32768, value, 32767);
+}
+
+static inline quint32 clamp8(int value)
+{
+    return quint32(qBound(0, value, 255));
+}
+
+// Scalar kernels
+//
+// The SIMD kernels must give exactly the same results, so the scalar code
+// follows the same fixed point arithmetic, including the 16 bits saturation.
+
+static void yuvToArgbScalar(const quint8 *y,
+                            const quint8 *u,
+                            const quint8 *v,
+                            quint32 *dst,
+                            int width,
+                            int xShift,
+                            const YuvToRgbCoefficients &c)
+{
+    for (int x = 0; x < width; x++) {
+        int yy = saturate16((y[x] - c.yOffset) * c.yMul
+                            + (1 << (YUV2RGB_SHIFT - 1)));
+        int cu = u[x >> xShift] - 128;
+        int cv = v[x >> xShift] - 128;
+        int r = saturate16(yy + cv * c.vr) >> YUV2RGB_SHIFT;
+        int g = saturate16(saturate16(yy - cu * c.ug) - cv * c.vg) >> YUV2RGB_SHIFT;
+        int b = saturate16(yy + cu * c.ub) >> YUV2RGB_SHIFT;
+
+        dst[x] = 0xff000000
+               | clamp8(r) << 16
+               | clamp8(g) << 8
+               | clamp8(b);
+    }
+}
+
+static inline int dotY(quint32 pixel, const RgbToYuvCoefficients &c)
+{
+    return c.yr * int((pixel >> 16) & 0xff)
+         + c.yg * int((pixel >> 8) & 0xff)
+         + c.yb * int(pixel & 0xff);
+}
+
+static inline int dotU(quint32 pixel, const RgbToYuvCoefficients &c)
+{
+    return c.ur * int((pixel >> 16) & 0xff)
+         + c.ug * int((pixel >> 8) & 0xff)
+         + c.ub * int(pixel & 0xff);
+}
+
+static inline int dotV(quint32 pixel, const RgbToYuvCoefficients &c)
+{
+    return c.vr * int((pixel >> 16) & 0xff)
+         + c.vg * int((pixel >> 8) & 0xff)
+         + c.vb * int(pixel & 0xff);
+}
+
+static void argbToYScalar(const quint32 *src,
+                          quint8 *y,
+                          int width,
+                          const RgbToYuvCoefficients &c)
+{
+    int offset = (c.yOffset << RGB2YUV_SHIFT) + (1 << (RGB2YUV_SHIFT - 1));
+
+    for (int x = 0; x < width; x++)
+        y[x] = quint8(clamp8((dotY(src[x], c) + offset) >> RGB2YUV_SHIFT));
+}
+
+static void argbToUVScalar(const quint32 *src,
+                           quint8 *u,
+                           quint8 *v,
+                           int width,
+                           int xShift,
+                           const RgbToYuvCoefficients &c)
+{
+    if (xShift == 0) {
+        int offset = (128 << RGB2YUV_SHIFT) + (1 << (RGB2YUV_SHIFT - 1));
+
+        for (int x = 0; x < width; x++) {
+            u[x] = quint8(clamp8((dotU(src[x], c) + offset) >> RGB2YUV_SHIFT));
+            v[x] = quint8(clamp8((dotV(src[x], c) + offset) >> RGB2YUV_SHIFT));
+        }
+
+        return;
+    }
+
+    // Average the chroma of each pair of pixels, the sum has one bit more.
+    int offset = (128 << (RGB2YUV_SHIFT + 1)) + (1 << RGB2YUV_SHIFT);
+
+    for (int x = 0; x < width; x += 2) {
+        quint32 pixel0 = src[x];
+        quint32 pixel1 = x + 1 < width? src[x + 1]: pixel0;
+        int su = dotU(pixel0, c) + dotU(pixel1, c);
+        int sv = dotV(pixel0, c) + dotV(pixel1, c);
+        u[x >> 1] = quint8(clamp8((su + offset) >> (RGB2YUV_SHIFT + 1)));
+        v[x >> 1] = quint8(clamp8((sv + offset) >> (RGB2YUV_SHIFT + 1)));
+    }
+}
+
+static void swizzleScalar(const quint32 *src,
+                          quint32 *dst,
+                          int width,
+                          const SwizzleParameters &p)
+{
+    for (int x = 0; x < width; x++) {
+        quint32 pixel = src[x];
+        quint32 out = p.opaque;
+
+        for (int i = 0; i < p.components; i++)
+            out |= ((pixel >> p.srcShift[i]) & 0xff) << p.dstShift[i];
+
+        dst[x] = out;
+    }
+}
+
+static void splitUVScalar(const quint8 *src, quint8 *u, quint8 *v, int n)
+{
+    for (int x = 0; x < n; x++) {
+        u[x] = src[2 * x];
+        v[x] = src[2 * x + 1];
+    }
+}
+
+static void mergeUVScalar(const quint8 *u, const quint8 *v, quint8 *dst, int n)
+{
+    for (int x = 0; x < n; x++) {
+        dst[2 * x] = u[x];
+        dst[2 * x + 1] = v[x];
+    }
+}
+
+static void splitPackedScalar(const quint8 *src,
+                              quint8 *y,
+                              quint8 *u,
+                              quint8 *v,
+                              int width,
+                              const Packed422Layout &l)
+{
+    for (int x = 0; x < width; x += 2) {
+        const quint8 *macroPixel = src + 2 * x;
+        y[x] = macroPixel[l.y];
+        y[x + 1] = macroPixel[l.y + 2];
+        u[x >> 1] = macroPixel[l.u];
+        v[x >> 1] = macroPixel[l.v];
+    }
+}
+
+static void mergePackedScalar(const quint8 *y,
+                              const quint8 *u,
+                              const quint8 *v,
+                              quint8 *dst,
+                              int width,
+                              const Packed422Layout &l)
+{
+    for (int x = 0; x < width; x += 2) {
+        quint8 *macroPixel = dst + 2 * x;
+        macroPixel[l.y] = y[x];
+        macroPixel[l.y + 2] = y[x + 1];
+        macroPixel[l.u] = u[x >> 1];
+        macroPixel[l.v] = v[x >> 1];
+    }
+}
+
+static void averageScalar(const quint8 *a, const quint8 *b, quint8 *dst, int n)
+{
+    for (int x = 0; x < n; x++)
+        dst[x] = quint8((a[x] + b[x] + 1) >> 1);
+}
+
+#ifdef AK_VIDEOCONVERTER_SIMD
+static inline int load32(const void *data)
+{
+    int value;
+    memcpy(&value, data, sizeof(int));
+
+    return value;
+}
+
+static inline void store32(void *data, int value)
+{
+    memcpy(data, &value, sizeof(int));
+}
+
+// SSE2 kernels
+
+AK_SIMD_TARGET("sse2")
+static void yuvToArgbSSE2(const quint8 *y,
+                          const quint8 *u,
+                          const quint8 *v,
+                          quint32 *dst,
+                          int width,
+                          int xShift,
+                          const YuvToRgbCoefficients &c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yOffset = _mm_set1_epi16(c.yOffset);
+    const __m128i yMul = _mm_set1_epi16(c.yMul);
+    const __m128i cOffset = _mm_set1_epi16(128);
+    const __m128i round = _mm_set1_epi16(1 << (YUV2RGB_SHIFT - 1));
+    const __m128i vr = _mm_set1_epi16(c.vr);
+    const __m128i ug = _mm_set1_epi16(c.ug);
+    const __m128i vg = _mm_set1_epi16(c.vg);
+    const __m128i ub = _mm_set1_epi16(c.ub);
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m128i y8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(y + x));
+        __m128i u8;
+        __m128i v8;
+
+        if (xShift) {
+            u8 = _mm_cvtsi32_si128(load32(u + (x >> 1)));
+            v8 = _mm_cvtsi32_si128(load32(v + (x >> 1)));
+            u8 = _mm_unpacklo_epi8(u8, u8);
+            v8 = _mm_unpacklo_epi8(v8, v8);
+        } else {
+            u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x));
+            v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x));
+        }
+
+        __m128i y16 = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), yOffset);
+        __m128i u16 = _mm_sub_epi16(_mm_unpacklo_epi8(u8, zero), cOffset);
+        __m128i v16 = _mm_sub_epi16(_mm_unpacklo_epi8(v8, zero), cOffset);
+        __m128i yy = _mm_adds_epi16(_mm_mullo_epi16(y16, yMul), round);
+        __m128i r = _mm_adds_epi16(yy, _mm_mullo_epi16(v16, vr));
+        __m128i g = _mm_subs_epi16(_mm_subs_epi16(yy, _mm_mullo_epi16(u16, ug)),
+                                   _mm_mullo_epi16(v16, vg));
+        __m128i b = _mm_adds_epi16(yy, _mm_mullo_epi16(u16, ub));
+        r = _mm_packus_epi16(_mm_srai_epi16(r, YUV2RGB_SHIFT), zero);
+        g = _mm_packus_epi16(_mm_srai_epi16(g, YUV2RGB_SHIFT), zero);
+        b = _mm_packus_epi16(_mm_srai_epi16(b, YUV2RGB_SHIFT), zero);
+
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x + 4),
+                         _mm_unpackhi_epi16(bg, ra));
+    }
+
+    yuvToArgbScalar(y + x,
+                    u + (x >> xShift),
+                    v + (x >> xShift),
+                    dst + x,
+                    width - x,
+                    xShift,
+                    c);
+}
+
+// Returns the dot product of 4 pixels with the coefficients, the
+// coefficients are given as b, g, r, 0, b, g, r, 0.
+AK_SIMD_TARGET("sse2")
+static inline __m128i dot4SSE2(__m128i pixels, __m128i coefficients)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coefficients);
+    __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coefficients);
+    lo = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+    hi = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+    lo = _mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 0));
+    hi = _mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 0));
+
+    return _mm_unpacklo_epi64(lo, hi);
+}
+
+// Sums the dot products of each pair of pixels.
+AK_SIMD_TARGET("sse2")
+static inline __m128i sumPairsSSE2(__m128i a, __m128i b)
+{
+    a = _mm_add_epi32(a, _mm_srli_epi64(a, 32));
+    b = _mm_add_epi32(b, _mm_srli_epi64(b, 32));
+    a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 3, 2, 0));
+    b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 3, 2, 0));
+
+    return _mm_unpacklo_epi64(a, b);
+}
+
+AK_SIMD_TARGET("sse2")
+static void argbToYSSE2(const quint32 *src,
+                        quint8 *y,
+                        int width,
+                        const RgbToYuvCoefficients &c)
+{
+    const __m128i coefficients = _mm_setr_epi16(c.yb, c.yg, c.yr, 0,
+                                                c.yb, c.yg, c.yr, 0);
+    const __m128i offset =
+            _mm_set1_epi32((c.yOffset << RGB2YUV_SHIFT)
+                           + (1 << (RGB2YUV_SHIFT - 1)));
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m128i pixels0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i pixels1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 4));
+        __m128i y0 = _mm_add_epi32(dot4SSE2(pixels0, coefficients), offset);
+        __m128i y1 = _mm_add_epi32(dot4SSE2(pixels1, coefficients), offset);
+        y0 = _mm_srai_epi32(y0, RGB2YUV_SHIFT);
+        y1 = _mm_srai_epi32(y1, RGB2YUV_SHIFT);
+        __m128i y8 = _mm_packs_epi32(y0, y1);
+        y8 = _mm_packus_epi16(y8, y8);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(y + x), y8);
+    }
+
+    argbToYScalar(src + x, y + x, width - x, c);
+}
+
+AK_SIMD_TARGET("sse2")
+static void argbToUVSSE2(const quint32 *src,
+                         quint8 *u,
+                         quint8 *v,
+                         int width,
+                         int xShift,
+                         const RgbToYuvCoefficients &c)
+{
+    const __m128i uCoefficients = _mm_setr_epi16(c.ub, c.ug, c.ur, 0,
+                                                 c.ub, c.ug, c.ur, 0);
+    const __m128i vCoefficients = _mm_setr_epi16(c.vb, c.vg, c.vr, 0,
+                                                 c.vb, c.vg, c.vr, 0);
+    int shift = RGB2YUV_SHIFT + xShift;
+    const __m128i offset = _mm_set1_epi32((128 << shift) + (1 << (shift - 1)));
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m128i pixels0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i pixels1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x + 4));
+        __m128i u0 = dot4SSE2(pixels0, uCoefficients);
+        __m128i u1 = dot4SSE2(pixels1, uCoefficients);
+        __m128i v0 = dot4SSE2(pixels0, vCoefficients);
+        __m128i v1 = dot4SSE2(pixels1, vCoefficients);
+
+        if (xShift) {
+            u0 = _mm_add_epi32(sumPairsSSE2(u0, u1), offset);
+            v0 = _mm_add_epi32(sumPairsSSE2(v0, v1), offset);
+            u0 = _mm_srai_epi32(u0, shift);
+            v0 = _mm_srai_epi32(v0, shift);
+            u0 = _mm_packs_epi32(u0, u0);
+            v0 = _mm_packs_epi32(v0, v0);
+            store32(u + (x >> 1), _mm_cvtsi128_si32(_mm_packus_epi16(u0, u0)));
+            store32(v + (x >> 1), _mm_cvtsi128_si32(_mm_packus_epi16(v0, v0)));
+        } else {
+            u0 = _mm_srai_epi32(_mm_add_epi32(u0, offset), shift);
+            u1 = _mm_srai_epi32(_mm_add_epi32(u1, offset), shift);
+            v0 = _mm_srai_epi32(_mm_add_epi32(v0, offset), shift);
+            v1 = _mm_srai_epi32(_mm_add_epi32(v1, offset), shift);
+            u0 = _mm_packs_epi32(u0, u1);
+            v0 = _mm_packs_epi32(v0, v1);
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(u + x),
+                             _mm_packus_epi16(u0, u0));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(v + x),
+                             _mm_packus_epi16(v0, v0));
+        }
+    }
+
+    argbToUVScalar(src + x,
+                   u + (x >> xShift),
+                   v + (x >> xShift),
+                   width - x,
+                   xShift,
+                   c);
+}
+
+AK_SIMD_TARGET("sse2")
+static void swizzleSSE2(const quint32 *src,
+                        quint32 *dst,
+                        int width,
+                        const SwizzleParameters &p)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i opaque = _mm_set1_epi32(int(p.opaque));
+    __m128i srcShift[4];
+    __m128i dstShift[4];
+
+    for (int i = 0; i < p.components; i++) {
+        srcShift[i] = _mm_cvtsi32_si128(p.srcShift[i]);
+        dstShift[i] = _mm_cvtsi32_si128(p.dstShift[i]);
+    }
+
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        __m128i out = opaque;
+
+        for (int i = 0; i < p.components; i++) {
+            __m128i component =
+                    _mm_and_si128(_mm_srl_epi32(pixels, srcShift[i]), mask);
+            out = _mm_or_si128(out, _mm_sll_epi32(component, dstShift[i]));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), out);
+    }
+
+    swizzleScalar(src + x, dst + x, width - x, p);
+}
+
+AK_SIMD_TARGET("sse2")
+static void splitUVSSE2(const quint8 *src, quint8 *u, quint8 *v, int n)
+{
+    const __m128i mask = _mm_set1_epi16(0xff);
+    int x = 0;
+
+    for (; x + 16 <= n; x += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * x + 16));
+        __m128i u8 = _mm_packus_epi16(_mm_and_si128(a, mask),
+                                      _mm_and_si128(b, mask));
+        __m128i v8 = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                      _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(u + x), u8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(v + x), v8);
+    }
+
+    splitUVScalar(src + 2 * x, u + x, v + x, n - x);
+}
+
+AK_SIMD_TARGET("sse2")
+static void mergeUVSSE2(const quint8 *u, const quint8 *v, quint8 *dst, int n)
+{
+    int x = 0;
+
+    for (; x + 16 <= n; x += 16) {
+        __m128i u8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x));
+        __m128i v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x),
+                         _mm_unpacklo_epi8(u8, v8));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x + 16),
+                         _mm_unpackhi_epi8(u8, v8));
+    }
+
+    mergeUVScalar(u + x, v + x, dst + 2 * x, n - x);
+}
+
+AK_SIMD_TARGET("sse2")
+static void splitPackedSSE2(const quint8 *src,
+                            quint8 *y,
+                            quint8 *u,
+                            quint8 *v,
+                            int width,
+                            const Packed422Layout &l)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi16(0xff);
+    quint8 *chroma0 = l.u < l.v? u: v;
+    quint8 *chroma1 = l.u < l.v? v: u;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * x + 16));
+        __m128i even = _mm_packus_epi16(_mm_and_si128(a, mask),
+                                        _mm_and_si128(b, mask));
+        __m128i odd = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                       _mm_srli_epi16(b, 8));
+        __m128i luma = l.y == 0? even: odd;
+        __m128i chroma = l.y == 0? odd: even;
+        __m128i c0 = _mm_packus_epi16(_mm_and_si128(chroma, mask), zero);
+        __m128i c1 = _mm_packus_epi16(_mm_srli_epi16(chroma, 8), zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + x), luma);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(chroma0 + (x >> 1)), c0);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(chroma1 + (x >> 1)), c1);
+    }
+
+    splitPackedScalar(src + 2 * x,
+                      y + x,
+                      u + (x >> 1),
+                      v + (x >> 1),
+                      width - x,
+                      l);
+}
+
+AK_SIMD_TARGET("sse2")
+static void mergePackedSSE2(const quint8 *y,
+                            const quint8 *u,
+                            const quint8 *v,
+                            quint8 *dst,
+                            int width,
+                            const Packed422Layout &l)
+{
+    const quint8 *chroma0 = l.u < l.v? u: v;
+    const quint8 *chroma1 = l.u < l.v? v: u;
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+        __m128i c0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(chroma0 + (x >> 1)));
+        __m128i c1 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(chroma1 + (x >> 1)));
+        __m128i chroma = _mm_unpacklo_epi8(c0, c1);
+        __m128i even = l.y == 0? luma: chroma;
+        __m128i odd = l.y == 0? chroma: luma;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x),
+                         _mm_unpacklo_epi8(even, odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * x + 16),
+                         _mm_unpackhi_epi8(even, odd));
+    }
+
+    mergePackedScalar(y + x,
+                      u + (x >> 1),
+                      v + (x >> 1),
+                      dst + 2 * x,
+                      width - x,
+                      l);
+}
+
+AK_SIMD_TARGET("sse2")
+static void averageSSE2(const quint8 *a, const quint8 *b, quint8 *dst, int n)
+{
+    int x = 0;
+
+    for (; x + 16 <= n; x += 16) {
+        __m128i a8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + x));
+        __m128i b8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_avg_epu8(a8, b8));
+    }
+
+    averageScalar(a + x, b + x, dst + x, n - x);
+}
+
+// AVX2 kernels
+
+AK_SIMD_TARGET("avx2")
+static void yuvToArgbAVX2(const quint8 *y,
+                          const quint8 *u,
+                          const quint8 *v,
+                          quint32 *dst,
+                          int width,
+                          int xShift,
+                          const YuvToRgbCoefficients &c)
+{
+    const __m256i yOffset = _mm256_set1_epi16(c.yOffset);
+    const __m256i yMul = _mm256_set1_epi16(c.yMul);
+    const __m256i cOffset = _mm256_set1_epi16(128);
+    const __m256i round = _mm256_set1_epi16(1 << (YUV2RGB_SHIFT - 1));
+    const __m256i vr = _mm256_set1_epi16(c.vr);
+    const __m256i ug = _mm256_set1_epi16(c.ug);
+    const __m256i vg = _mm256_set1_epi16(c.vg);
+    const __m256i ub = _mm256_set1_epi16(c.ub);
+    const __m256i alpha = _mm256_set1_epi8(char(0xff));
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+        __m128i u8;
+        __m128i v8;
+
+        if (xShift) {
+            u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + (x >> 1)));
+            v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + (x >> 1)));
+            u8 = _mm_unpacklo_epi8(u8, u8);
+            v8 = _mm_unpacklo_epi8(v8, v8);
+        } else {
+            u8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x));
+            v8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x));
+        }
+
+        __m256i y16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(y8), yOffset);
+        __m256i u16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(u8), cOffset);
+        __m256i v16 = _mm256_sub_epi16(_mm256_cvtepu8_epi16(v8), cOffset);
+        __m256i yy = _mm256_adds_epi16(_mm256_mullo_epi16(y16, yMul), round);
+        __m256i r = _mm256_adds_epi16(yy, _mm256_mullo_epi16(v16, vr));
+        __m256i g = _mm256_subs_epi16(_mm256_subs_epi16(yy, _mm256_mullo_epi16(u16, ug)),
+                                      _mm256_mullo_epi16(v16, vg));
+        __m256i b = _mm256_adds_epi16(yy, _mm256_mullo_epi16(u16, ub));
+        r = _mm256_srai_epi16(r, YUV2RGB_SHIFT);
+        g = _mm256_srai_epi16(g, YUV2RGB_SHIFT);
+        b = _mm256_srai_epi16(b, YUV2RGB_SHIFT);
+
+        // The packs work in each 128 bits lane, so the low lane holds the
+        // pixels 0 to 7, and the high lane the pixels 8 to 15.
+        r = _mm256_packus_epi16(r, r);
+        g = _mm256_packus_epi16(g, g);
+        b = _mm256_packus_epi16(b, b);
+        __m256i bg = _mm256_unpacklo_epi8(b, g);
+        __m256i ra = _mm256_unpacklo_epi8(r, alpha);
+        __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+        __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x + 8),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+
+    yuvToArgbSSE2(y + x,
+                  u + (x >> xShift),
+                  v + (x >> xShift),
+                  dst + x,
+                  width - x,
+                  xShift,
+                  c);
+}
+
+AK_SIMD_TARGET("avx2")
+static void swizzleAVX2(const quint32 *src,
+                        quint32 *dst,
+                        int width,
+                        const SwizzleParameters &p)
+{
+    const __m256i shuffle =
+            _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p.shuffle)));
+    const __m256i opaque = _mm256_set1_epi32(int(p.opaque));
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+        pixels = _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), opaque);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x), pixels);
+    }
+
+    swizzleSSE2(src + x, dst + x, width - x, p);
+}
+
+AK_SIMD_TARGET("avx2")
+static void averageAVX2(const quint8 *a, const quint8 *b, quint8 *dst, int n)
+{
+    int x = 0;
+
+    for (; x + 32 <= n; x += 32) {
+        __m256i a8 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + x));
+        __m256i b8 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x),
+                            _mm256_avg_epu8(a8, b8));
+    }
+
+    averageSSE2(a + x, b + x, dst + x, n - x);
+}
+#endif
+
+struct ConvertKernels
+{
+    void (*yuvToArgb)(const quint8 *y,
+                      const quint8 *u,
+                      const quint8 *v,
+                      quint32 *dst,
+                      int width,
+                      int xShift,
+                      const YuvToRgbCoefficients &c);
+    void (*argbToY)(const quint32 *src,
+                    quint8 *y,
+                    int width,
+                    const RgbToYuvCoefficients &c);
+    void (*argbToUV)(const quint32 *src,
+                     quint8 *u,
+                     quint8 *v,
+                     int width,
+                     int xShift,
+                     const RgbToYuvCoefficients &c);
+    void (*swizzle)(const quint32 *src,
+                    quint32 *dst,
+                    int width,
+                    const SwizzleParameters &p);
+    void (*splitUV)(const quint8 *src, quint8 *u, quint8 *v, int n);
+    void (*mergeUV)(const quint8 *u, const quint8 *v, quint8 *dst, int n);
+    void (*splitPacked)(const quint8 *src,
+                        quint8 *y,
+                        quint8 *u,
+                        quint8 *v,
+                        int width,
+                        const Packed422Layout &l);
+    void (*mergePacked)(const quint8 *y,
+                        const quint8 *u,
+                        const quint8 *v,
+                        quint8 *dst,
+                        int width,
+                        const Packed422Layout &l);
+    void (*average)(const quint8 *a, const quint8 *b, quint8 *dst, int n);
+
+    static ConvertKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        ConvertKernels kernels = {
+            yuvToArgbScalar,
+            argbToYScalar,
+            argbToUVScalar,
+            swizzleScalar,
+            splitUVScalar,
+            mergeUVScalar,
+            splitPackedScalar,
+            mergePackedScalar,
+            averageScalar
+        };
+
+#ifdef AK_VIDEOCONVERTER_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_SSE2) {
+            kernels.yuvToArgb = yuvToArgbSSE2;
+            kernels.argbToY = argbToYSSE2;
+            kernels.argbToUV = argbToUVSSE2;
+            kernels.swizzle = swizzleSSE2;
+            kernels.splitUV = splitUVSSE2;
+            kernels.mergeUV = mergeUVSSE2;
+            kernels.splitPacked = splitPackedSSE2;
+            kernels.mergePacked = mergePackedSSE2;
+            kernels.average = averageSSE2;
+        }
+
+        if (instructionSet >= AkSimd::InstructionSet_AVX2) {
+            kernels.yuvToArgb = yuvToArgbAVX2;
+            kernels.swizzle = swizzleAVX2;
+            kernels.average = averageAVX2;
+        }
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
+
+enum FormatType
+{
+    FormatType_RGB32,
+    FormatType_RGB24,
+    FormatType_YUV
+};
+
+enum ChromaType
+{
+    ChromaType_None,
+    ChromaType_Planar,
+    ChromaType_SemiPlanar,
+    ChromaType_Packed
+};
+
+class ConvertFormat
+{
+    public:
+        AkVideoCaps::PixelFormat format;
+        FormatType type;
+        ChromaType chroma;
+        int xShift;
+        int yShift;
+        bool fullRange;
+        bool alpha;
+
+        // RGB32: bit shift of the r, g, b and a components.
+        // RGB24: byte offset of the r, g and b components.
+        // Packed YUV: byte offset of the y, u and v components.
+        // Semi-planar YUV: byte offset of the u and v components.
+        int components[4];
+
+        static inline const QVector<ConvertFormat> &formats()
+        {
+            static const QVector<ConvertFormat> convertFormats = {
+                {AkVideoCaps::Format_argb    , FormatType_RGB32, ChromaType_None      , 0, 0, true , true , {16,  8,  0, 24}},
+                {AkVideoCaps::Format_0rgb    , FormatType_RGB32, ChromaType_None      , 0, 0, true , false, {16,  8,  0, 24}},
+                {AkVideoCaps::Format_rgba    , FormatType_RGB32, ChromaType_None      , 0, 0, true , true , {24, 16,  8,  0}},
+                {AkVideoCaps::Format_rgb0    , FormatType_RGB32, ChromaType_None      , 0, 0, true , false, {24, 16,  8,  0}},
+                {AkVideoCaps::Format_abgr    , FormatType_RGB32, ChromaType_None      , 0, 0, true , true , { 0,  8, 16, 24}},
+                {AkVideoCaps::Format_0bgr    , FormatType_RGB32, ChromaType_None      , 0, 0, true , false, { 0,  8, 16, 24}},
+                {AkVideoCaps::Format_bgra    , FormatType_RGB32, ChromaType_None      , 0, 0, true , true , { 8, 16, 24,  0}},
+                {AkVideoCaps::Format_bgr0    , FormatType_RGB32, ChromaType_None      , 0, 0, true , false, { 8, 16, 24,  0}},
+                {AkVideoCaps::Format_rgb24   , FormatType_RGB24, ChromaType_None      , 0, 0, true , false, { 0,  1,  2,  0}},
+                {AkVideoCaps::Format_bgr24   , FormatType_RGB24, ChromaType_None      , 0, 0, true , false, { 2,  1,  0,  0}},
+                {AkVideoCaps::Format_gray    , FormatType_YUV  , ChromaType_None      , 0, 0, true , false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuv420p , FormatType_YUV  , ChromaType_Planar    , 1, 1, false, false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuvj420p, FormatType_YUV  , ChromaType_Planar    , 1, 1, true , false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuv422p , FormatType_YUV  , ChromaType_Planar    , 1, 0, false, false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuvj422p, FormatType_YUV  , ChromaType_Planar    , 1, 0, true , false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuv444p , FormatType_YUV  , ChromaType_Planar    , 0, 0, false, false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_yuvj444p, FormatType_YUV  , ChromaType_Planar    , 0, 0, true , false, { 0,  0,  0,  0}},
+                {AkVideoCaps::Format_nv12    , FormatType_YUV  , ChromaType_SemiPlanar, 1, 1, false, false, { 0,  1,  0,  0}},
+                {AkVideoCaps::Format_nv21    , FormatType_YUV  , ChromaType_SemiPlanar, 1, 1, false, false, { 1,  0,  0,  0}},
+                {AkVideoCaps::Format_nv16    , FormatType_YUV  , ChromaType_SemiPlanar, 1, 0, false, false, { 0,  1,  0,  0}},
+                {AkVideoCaps::Format_yuyv422 , FormatType_YUV  , ChromaType_Packed    , 1, 0, false, false, { 0,  1,  3,  0}},
+                {AkVideoCaps::Format_uyvy422 , FormatType_YUV  , ChromaType_Packed    , 1, 0, false, false, { 1,  0,  2,  0}},
+                {AkVideoCaps::Format_yvyu422 , FormatType_YUV  , ChromaType_Packed    , 1, 0, false, false, { 0,  3,  1,  0}},
+            };
+
+            return convertFormats;
+        }
+
+        static inline const ConvertFormat *byFormat(AkVideoCaps::PixelFormat format)
+        {
+            for (const ConvertFormat &convertFormat: formats())
+                if (convertFormat.format == format)
+                    return &convertFormat;
+
+            return nullptr;
+        }
+
+        // Returns the number of planes, and the size of the lines and the
+        // height of each plane.
+        inline int planes(int width, int height,
+                          int *lineSize, int *planeHeight) const
+        {
+            switch (this->type) {
+            case FormatType_RGB32:
+                lineSize[0] = 4 * width;
+                planeHeight[0] = height;
+
+                return 1;
+            case FormatType_RGB24:
+                lineSize[0] = 3 * width;
+                planeHeight[0] = height;
+
+                return 1;
+            default:
+                break;
+            }
+
+            int chromaWidth = (width + this->xShift) >> this->xShift;
+            int chromaHeight = (height + this->yShift) >> this->yShift;
+
+            switch (this->chroma) {
+            case ChromaType_None:
+                lineSize[0] = width;
+                planeHeight[0] = height;
+
+                return 1;
+            case ChromaType_Packed:
+                lineSize[0] = 2 * width;
+                planeHeight[0] = height;
+
+                return 1;
+            case ChromaType_SemiPlanar:
+                lineSize[0] = width;
+                planeHeight[0] = height;
+                lineSize[1] = 2 * chromaWidth;
+                planeHeight[1] = chromaHeight;
+
+                return 2;
+            default:
+                break;
+            }
+
+            lineSize[0] = width;
+            planeHeight[0] = height;
+
+            for (int i = 1; i < 3; i++) {
+                lineSize[i] = chromaWidth;
+                planeHeight[i] = chromaHeight;
+            }
+
+            return 3;
+        }
+};
+
+struct ConvertContextKey
+{
+    AkVideoCaps::PixelFormat iFormat;
+    AkVideoCaps::PixelFormat oFormat;
+    int width;
+    int height;
+    AkVideoConverter::YuvColorSpace colorSpace;
+    AkVideoConverter::YuvColorRange colorRange;
+    AkSimd::InstructionSet instructionSet;
+
+    inline bool operator ==(const ConvertContextKey &other) const
+    {
+        return this->iFormat == other.iFormat
+            && this->oFormat == other.oFormat
+            && this->width == other.width
+            && this->height == other.height
+            && this->colorSpace == other.colorSpace
+            && this->colorRange == other.colorRange
+            && this->instructionSet == other.instructionSet;
+    }
+};
+
+inline uint qHash(const ConvertContextKey &key, uint seed=0)
+{
+    return qHash(quint64(uint(key.iFormat)) << 32 | uint(key.oFormat), seed)
+         ^ qHash(quint64(uint(key.width)) << 32 | uint(key.height), seed)
+         ^ qHash(key.colorSpace << 16 | key.colorRange << 8 | key.instructionSet,
+                 seed);
+}
+
+struct SrcPlanes
+{
+    const quint8 *data[3];
+    int stride[3];
+};
+
+struct DstPlanes
+{
+    quint8 *data[3];
+    int stride[3];
+};
+
+struct ConvertBand
+{
+    int y0;
+    int y1;
+};
+
+// Everything needed to convert between two formats with a given frame size.
+// A context is immutable once created, so it can be used from many threads
+// at the same time.
+class ConvertContext
+{
+    public:
+        const ConvertFormat *m_iFormat;
+        const ConvertFormat *m_oFormat;
+        int m_width;
+        int m_height;
+        int m_iPlanes;
+        int m_iLineSize[3];
+        int m_iPlaneHeight[3];
+        int m_iFrameSize;
+        int m_oPlanes;
+        int m_oLineSize[3];
+        int m_oPlaneHeight[3];
+        int m_oFrameSize;
+        int m_oBpp;
+        ConvertKernels m_kernels;
+        YuvToRgbCoefficients m_yuvToRgb;
+        RgbToYuvCoefficients m_rgbToYuv;
+        SwizzleParameters m_iSwizzle;
+        SwizzleParameters m_oSwizzle;
+        SwizzleParameters m_swizzle;
+        bool m_iIsArgb;
+        bool m_oIsArgb;
+        bool m_rangeLut;
+        quint8 m_yLut[256];
+        quint8 m_cLut[256];
+        QVector<ConvertBand> m_bands;
+        int m_lineSize;
+
+        static ConvertContext *create(const ConvertContextKey &key);
+        bool mapInput(const QByteArray &buffer, SrcPlanes &planes) const;
+        DstPlanes mapOutput(quint8 *data) const;
+        bool convert(const SrcPlanes &src, const DstPlanes &dst) const;
+        bool convertBand(const SrcPlanes &src,
+                         const DstPlanes &dst,
+                         const ConvertBand &band) const;
+
+    private:
+        static SwizzleParameters swizzleParameters(const ConvertFormat *from,
+                                                   const ConvertFormat *to);
+        static void colorSpaceConstants(AkVideoConverter::YuvColorSpace colorSpace,
+                                        qreal &kr,
+                                        qreal &kb);
+        static YuvToRgbCoefficients yuvToRgbCoefficients(AkVideoConverter::YuvColorSpace colorSpace,
+                                                         bool fullRange);
+        static RgbToYuvCoefficients rgbToYuvCoefficients(AkVideoConverter::YuvColorSpace colorSpace,
+                                                         bool fullRange);
+        inline const quint32 *readArgb(const SrcPlanes &src,
+                                       int y,
+                                       quint32 *out,
+                                       quint8 **lines) const;
+        inline int readYuv(const SrcPlanes &src,
+                           int y,
+                           const quint8 **yLine,
+                           const quint8 **uLine,
+                           const quint8 **vLine,
+                           quint8 **lines) const;
+};
+
+class AkVideoConverterPrivate
+{
+    public:
+        AkVideoCaps m_outputCaps;
+        AkVideoConverter::YuvColorSpace m_yuvColorSpace;
+        AkVideoConverter::YuvColorRange m_yuvColorRange;
+
+        AkVideoConverterPrivate():
+            m_yuvColorSpace(AkVideoConverter::YuvColorSpace_BT601),
+            m_yuvColorRange(AkVideoConverter::YuvColorRange_Limited)
+        {
+        }
+};
+
+class AkVideoConverterGlobalPrivate
+{
+    public:
+        QMutex m_mutex;
+        QHash<ConvertContextKey, QSharedPointer<ConvertContext>> m_contexts;
+
+        QSharedPointer<ConvertContext> context(const ConvertContextKey &key);
+};
+
+Q_GLOBAL_STATIC(AkVideoConverterGlobalPrivate, akVideoConverterGlobal)
+
+AkVideoConverter::AkVideoConverter(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoConverterPrivate;
+}
+
+AkVideoConverter::AkVideoConverter(const AkVideoCaps &outputCaps,
+                                   QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoConverterPrivate;
+    this->d->m_outputCaps = outputCaps;
+}
+
+AkVideoConverter::~AkVideoConverter()
+{
+    delete this->d;
+}
+
+AkVideoCaps AkVideoConverter::outputCaps() const
+{
+    return this->d->m_outputCaps;
+}
+
+AkVideoConverter::YuvColorSpace AkVideoConverter::yuvColorSpace() const
+{
+    return this->d->m_yuvColorSpace;
+}
+
+AkVideoConverter::YuvColorRange AkVideoConverter::yuvColorRange() const
+{
+    return this->d->m_yuvColorRange;
+}
+
+AkVideoPacket AkVideoConverter::convert(const AkVideoPacket &packet) const
+{
+    return this->convert(packet, this->d->m_outputCaps.format());
+}
+
+AkVideoPacket AkVideoConverter::convert(const AkVideoPacket &packet,
+                                        AkVideoCaps::PixelFormat format) const
+{
+    const AkVideoCaps &iCaps = packet.caps();
+
+    if (iCaps.format() == format)
+        return packet;
+
+    ConvertContextKey key {
+        iCaps.format(),
+        format,
+        iCaps.width(),
+        iCaps.height(),
+        this->d->m_yuvColorSpace,
+        this->d->m_yuvColorRange,
+        AkSimd::instructionSet()
+    };
+
+    auto context = akVideoConverterGlobal->context(key);
+
+    if (!context)
+        return AkVideoPacket();
+
+    SrcPlanes src;
+
+    if (!context->mapInput(packet.buffer(), src))
+        return AkVideoPacket();
+
+    auto buffer = AkBufferPool::buffer(format,
+                                       key.width,
+                                       key.height,
+                                       1,
+                                       context->m_oFrameSize);
+
+    if (!buffer
+        || buffer.size() < context->m_oFrameSize
+        || !context->convert(src, context->mapOutput(buffer.data<quint8>())))
+        return AkVideoPacket();
+
+    AkVideoPacket oPacket(packet);
+    oPacket.caps().format() = format;
+    oPacket.caps().bpp() = context->m_oBpp;
+    buffer.attachTo(oPacket);
+
+    return oPacket;
+}
+
+bool AkVideoConverter::canConvert(AkVideoCaps::PixelFormat iFormat,
+                                  AkVideoCaps::PixelFormat oFormat)
+{
+    return ConvertFormat::byFormat(iFormat)
+        && ConvertFormat::byFormat(oFormat);
+}
+
+bool AkVideoConverter::isSupported(AkVideoCaps::PixelFormat format)
+{
+    return ConvertFormat::byFormat(format) != nullptr;
+}
+
+QList<AkVideoCaps::PixelFormat> AkVideoConverter::supportedFormats()
+{
+    QList<AkVideoCaps::PixelFormat> formats;
+
+    for (const ConvertFormat &format: ConvertFormat::formats())
+        formats << format.format;
+
+    return formats;
+}
+
+void AkVideoConverter::clearCache()
+{
+    QMutexLocker locker(&akVideoConverterGlobal->m_mutex);
+    akVideoConverterGlobal->m_contexts.clear();
+}
+
+void AkVideoConverter::setOutputCaps(const AkVideoCaps &outputCaps)
+{
+    if (this->d->m_outputCaps == outputCaps)
+        return;
+
+    this->d->m_outputCaps = outputCaps;
+    emit this->outputCapsChanged(outputCaps);
+}
+
+void AkVideoConverter::setYuvColorSpace(AkVideoConverter::YuvColorSpace yuvColorSpace)
+{
+    if (this->d->m_yuvColorSpace == yuvColorSpace)
+        return;
+
+    this->d->m_yuvColorSpace = yuvColorSpace;
+    emit this->yuvColorSpaceChanged(yuvColorSpace);
+}
+
+void AkVideoConverter::setYuvColorRange(AkVideoConverter::YuvColorRange yuvColorRange)
+{
+    if (this->d->m_yuvColorRange == yuvColorRange)
+        return;
+
+    this->d->m_yuvColorRange = yuvColorRange;
+    emit this->yuvColorRangeChanged(yuvColorRange);
+}
+
+void AkVideoConverter::resetOutputCaps()
+{
+    this->setOutputCaps(AkVideoCaps());
+}
+
+void AkVideoConverter::resetYuvColorSpace()
+{
+    this->setYuvColorSpace(YuvColorSpace_BT601);
+}
+
+void AkVideoConverter::resetYuvColorRange()
+{
+    this->setYuvColorRange(YuvColorRange_Limited);
+}
+
+QSharedPointer<ConvertContext> AkVideoConverterGlobalPrivate::context(const ConvertContextKey &key)
+{
+    QMutexLocker locker(&this->m_mutex);
+    auto it = this->m_contexts.constFind(key);
+
+    if (it != this->m_contexts.constEnd())
+        return it.value();
+
+    QSharedPointer<ConvertContext> context(ConvertContext::create(key));
+
+    if (!context)
+        return context;
+
+    if (this->m_contexts.size() >= MAX_CACHED_CONTEXTS)
+        this->m_contexts.clear();
+
+    this->m_contexts[key] = context;
+
+    return context;
+}
+
+ConvertContext *ConvertContext::create(const ConvertContextKey &key)
+{
+    auto iFormat = ConvertFormat::byFormat(key.iFormat);
+    auto oFormat = ConvertFormat::byFormat(key.oFormat);
+
+    if (!iFormat || !oFormat || key.width < 1 || key.height < 1)
+        return nullptr;
+
+    // Packed 4:2:2 formats can't store an odd number of pixels per line.
+    if ((key.width & 1)
+        && (iFormat->chroma == ChromaType_Packed
+            || oFormat->chroma == ChromaType_Packed))
+        return nullptr;
+
+    auto context = new ConvertContext;
+    context->m_iFormat = iFormat;
+    context->m_oFormat = oFormat;
+    context->m_width = key.width;
+    context->m_height = key.height;
+    context->m_iPlanes = iFormat->planes(key.width,
+                                         key.height,
+                                         context->m_iLineSize,
+                                         context->m_iPlaneHeight);
+    context->m_oPlanes = oFormat->planes(key.width,
+                                         key.height,
+                                         context->m_oLineSize,
+                                         context->m_oPlaneHeight);
+    context->m_iFrameSize = 0;
+
+    for (int i = 0; i < context->m_iPlanes; i++)
+        context->m_iFrameSize += context->m_iLineSize[i]
+                               * context->m_iPlaneHeight[i];
+
+    context->m_oFrameSize = 0;
+
+    for (int i = 0; i < context->m_oPlanes; i++)
+        context->m_oFrameSize += context->m_oLineSize[i]
+                               * context->m_oPlaneHeight[i];
+
+    context->m_oBpp = AkVideoCaps::bitsPerPixel(key.oFormat);
+    context->m_kernels = ConvertKernels::byInstructionSet(key.instructionSet);
+
+    // YUV to RGB uses the range of the source, RGB to YUV the range of the
+    // destination.
+    bool iFullRange = iFormat->fullRange
+                      || key.colorRange == AkVideoConverter::YuvColorRange_Full;
+    bool oFullRange = oFormat->fullRange
+                      || key.colorRange == AkVideoConverter::YuvColorRange_Full;
+    context->m_yuvToRgb = yuvToRgbCoefficients(key.colorSpace, iFullRange);
+    context->m_rgbToYuv = rgbToYuvCoefficients(key.colorSpace, oFullRange);
+
+    static const ConvertFormat argb = *ConvertFormat::byFormat(AkVideoCaps::Format_argb);
+    context->m_iIsArgb = iFormat->format == AkVideoCaps::Format_argb;
+    context->m_oIsArgb = oFormat->format == AkVideoCaps::Format_argb;
+    context->m_iSwizzle = swizzleParameters(iFormat, &argb);
+    context->m_oSwizzle = swizzleParameters(&argb, oFormat);
+    context->m_swizzle = swizzleParameters(iFormat, oFormat);
+
+    context->m_rangeLut = iFormat->type == FormatType_YUV
+                          && oFormat->type == FormatType_YUV
+                          && iFullRange != oFullRange;
+
+    for (int i = 0; i < 256; i++) {
+        if (oFullRange) {
+            context->m_yLut[i] = quint8(clamp8(qRound((i - 16) * 255.0 / 219.0)));
+            context->m_cLut[i] = quint8(clamp8(qRound((i - 128) * 255.0 / 224.0) + 128));
+        } else {
+            context->m_yLut[i] = quint8(qRound(i * 219.0 / 255.0) + 16);
+            context->m_cLut[i] = quint8(qRound((i - 128) * 224.0 / 255.0) + 128);
+        }
+    }
+
+    // Split the frame in bands of even height, so the 4:2:0 chroma lines are
+    // never shared between two threads.
+    int nBands = 1;
+
+    if (key.width * key.height >= MIN_PARALLEL_PIXELS)
+        nBands = qBound(1,
+                        AkScheduler::threadCount(),
+                        key.height / MIN_BAND_HEIGHT);
+
+    int bandHeight = (key.height + nBands - 1) / nBands;
+    bandHeight = (bandHeight + 1) & ~1;
+
+    for (int y = 0; y < key.height; y += bandHeight)
+        context->m_bands << ConvertBand {y, qMin(y + bandHeight, key.height)};
+
+    // Scratch lines, 64 bytes aligned.
+    context->m_lineSize = (4 * key.width + 63) & ~63;
+
+    return context;
+}
+
+bool ConvertContext::mapInput(const QByteArray &buffer, SrcPlanes &planes) const
+{
+    auto data = reinterpret_cast<const quint8 *>(buffer.constData());
+
+    if (!data || buffer.size() < this->m_iFrameSize)
+        return false;
+
+    // Single plane frames can have padding at the end of each line, as in
+    // QImage.
+    if (this->m_iPlanes == 1) {
+        planes.data[0] = data;
+        planes.stride[0] = this->m_iLineSize[0];
+
+        if (buffer.size() % this->m_height == 0)
+            planes.stride[0] = qMax(planes.stride[0],
+                                    buffer.size() / this->m_height);
+
+        return true;
+    }
+
+    for (int i = 0; i < this->m_iPlanes; i++) {
+        planes.data[i] = data;
+        planes.stride[i] = this->m_iLineSize[i];
+        data += this->m_iLineSize[i] * this->m_iPlaneHeight[i];
+    }
+
+    return true;
+}
+
+DstPlanes ConvertContext::mapOutput(quint8 *data) const
+{
+    DstPlanes planes;
+
+    for (int i = 0; i < this->m_oPlanes; i++) {
+        planes.data[i] = data;
+        planes.stride[i] = this->m_oLineSize[i];
+        data += this->m_oLineSize[i] * this->m_oPlaneHeight[i];
+    }
+
+    return planes;
+}
+
+// Returns false if a band couldn't get its scratch lines.
+bool ConvertContext::convert(const SrcPlanes &src, const DstPlanes &dst) const
+{
+    if (this->m_bands.size() < 2)
+        return this->convertBand(src, dst, this->m_bands.first());
+
+    QAtomicInt failed(0);
+
+    AkScheduler::parallelFor(this->m_bands.size(),
+                             1,
+                             [this, &src, &dst, &failed] (int begin, int end) {
+        for (int i = begin; i < end; i++)
+            if (!this->convertBand(src, dst, this->m_bands[i]))
+                failed.store(1);
+    });
+
+    return !failed.load();
+}
+
+// Scratch lines used by convertBand.
+enum ScratchLine
+{
+    ScratchLine_Argb,
+    ScratchLine_Y,
+    ScratchLine_U,
+    ScratchLine_V,
+    ScratchLine_ResampledU,
+    ScratchLine_ResampledV,
+    ScratchLine_RangeY,
+    ScratchLine_RangeU,
+    ScratchLine_RangeV,
+    ScratchLine_PreviousU,
+    ScratchLine_PreviousV,
+    ScratchLine_AverageU,
+    ScratchLine_AverageV,
+    ScratchLine_Neutral,
+    ScratchLine_Count
+};
+
+bool ConvertContext::convertBand(const SrcPlanes &src,
+                                 const DstPlanes &dst,
+                                 const ConvertBand &band) const
+{
+    auto scratch = AkBufferPool::buffer(ScratchLine_Count * this->m_lineSize);
+
+    if (!scratch)
+        return false;
+
+    quint8 *lines[ScratchLine_Count];
+
+    for (int i = 0; i < ScratchLine_Count; i++)
+        lines[i] = scratch.data<quint8>() + i * this->m_lineSize;
+
+    memset(lines[ScratchLine_Neutral], 128, size_t(this->m_width));
+    auto argbLine = reinterpret_cast<quint32 *>(lines[ScratchLine_Argb]);
+    auto oFormat = this->m_oFormat;
+    auto &kernels = this->m_kernels;
+    int width = this->m_width;
+
+    if (oFormat->type != FormatType_YUV) {
+        for (int y = band.y0; y < band.y1; y++) {
+            quint8 *dstLine = dst.data[0] + y * dst.stride[0];
+
+            if (oFormat->type == FormatType_RGB32) {
+                auto oLine = reinterpret_cast<quint32 *>(dstLine);
+
+                if (this->m_iFormat->type == FormatType_RGB32) {
+                    kernels.swizzle(reinterpret_cast<const quint32 *>(src.data[0] + y * src.stride[0]),
+                                    oLine,
+                                    width,
+                                    this->m_swizzle);
+
+                    continue;
+                }
+
+                if (this->m_oIsArgb) {
+                    this->readArgb(src, y, oLine, lines);
+
+                    continue;
+                }
+
+                kernels.swizzle(this->readArgb(src, y, argbLine, lines),
+                                oLine,
+                                width,
+                                this->m_oSwizzle);
+            } else {
+                auto argb = this->readArgb(src, y, argbLine, lines);
+                int r = oFormat->components[0];
+                int g = oFormat->components[1];
+                int b = oFormat->components[2];
+
+                for (int x = 0; x < width; x++) {
+                    quint8 *pixel = dstLine + 3 * x;
+                    pixel[r] = quint8(argb[x] >> 16);
+                    pixel[g] = quint8(argb[x] >> 8);
+                    pixel[b] = quint8(argb[x]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    int xShift = oFormat->xShift;
+    int chromaWidth = (width + xShift) >> xShift;
+
+    for (int y = band.y0; y < band.y1; y++) {
+        const quint8 *yLine = nullptr;
+        const quint8 *uLine = nullptr;
+        const quint8 *vLine = nullptr;
+
+        if (this->m_iFormat->type == FormatType_YUV) {
+            int iXShift = this->readYuv(src, y, &yLine, &uLine, &vLine, lines);
+
+            if (oFormat->chroma != ChromaType_None && iXShift != xShift) {
+                auto rU = lines[ScratchLine_ResampledU];
+                auto rV = lines[ScratchLine_ResampledV];
+
+                if (iXShift > xShift) {
+                    for (int x = 0; x < width; x++) {
+                        rU[x] = uLine[x >> 1];
+                        rV[x] = vLine[x >> 1];
+                    }
+                } else {
+                    for (int x = 0; x < chromaWidth; x++) {
+                        int x1 = qMin(2 * x + 1, width - 1);
+                        rU[x] = quint8((uLine[2 * x] + uLine[x1] + 1) >> 1);
+                        rV[x] = quint8((vLine[2 * x] + vLine[x1] + 1) >> 1);
+                    }
+                }
+
+                uLine = rU;
+                vLine = rV;
+            }
+
+            if (this->m_rangeLut) {
+                auto lY = lines[ScratchLine_RangeY];
+
+                for (int x = 0; x < width; x++)
+                    lY[x] = this->m_yLut[yLine[x]];
+
+                yLine = lY;
+
+                if (oFormat->chroma != ChromaType_None) {
+                    auto lU = lines[ScratchLine_RangeU];
+                    auto lV = lines[ScratchLine_RangeV];
+
+                    for (int x = 0; x < chromaWidth; x++) {
+                        lU[x] = this->m_cLut[uLine[x]];
+                        lV[x] = this->m_cLut[vLine[x]];
+                    }
+
+                    uLine = lU;
+                    vLine = lV;
+                }
+            }
+        } else {
+            auto argb = this->readArgb(src, y, argbLine, lines);
+            kernels.argbToY(argb, lines[ScratchLine_Y], width, this->m_rgbToYuv);
+            yLine = lines[ScratchLine_Y];
+
+            if (oFormat->chroma != ChromaType_None) {
+                kernels.argbToUV(argb,
+                                 lines[ScratchLine_U],
+                                 lines[ScratchLine_V],
+                                 width,
+                                 xShift,
+                                 this->m_rgbToYuv);
+                uLine = lines[ScratchLine_U];
+                vLine = lines[ScratchLine_V];
+            }
+        }
+
+        if (oFormat->chroma == ChromaType_Packed) {
+            kernels.mergePacked(yLine,
+                                uLine,
+                                vLine,
+                                dst.data[0] + y * dst.stride[0],
+                                width,
+                                {oFormat->components[0],
+                                 oFormat->components[1],
+                                 oFormat->components[2]});
+
+            continue;
+        }
+
+        memcpy(dst.data[0] + y * dst.stride[0], yLine, size_t(width));
+
+        if (oFormat->chroma == ChromaType_None)
+            continue;
+
+        // In 4:2:0 formats the chroma of each pair of lines is averaged.
+        if (oFormat->yShift) {
+            if ((y & 1) == 0 && y + 1 < band.y1) {
+                memcpy(lines[ScratchLine_PreviousU], uLine, size_t(chromaWidth));
+                memcpy(lines[ScratchLine_PreviousV], vLine, size_t(chromaWidth));
+
+                continue;
+            }
+
+            if (y & 1) {
+                kernels.average(lines[ScratchLine_PreviousU],
+                                uLine,
+                                lines[ScratchLine_AverageU],
+                                chromaWidth);
+                kernels.average(lines[ScratchLine_PreviousV],
+                                vLine,
+                                lines[ScratchLine_AverageV],
+                                chromaWidth);
+                uLine = lines[ScratchLine_AverageU];
+                vLine = lines[ScratchLine_AverageV];
+            }
+        }
+
+        int cy = y >> oFormat->yShift;
+
+        if (oFormat->chroma == ChromaType_SemiPlanar) {
+            bool uFirst = oFormat->components[0] < oFormat->components[1];
+            kernels.mergeUV(uFirst? uLine: vLine,
+                            uFirst? vLine: uLine,
+                            dst.data[1] + cy * dst.stride[1],
+                            chromaWidth);
+        } else {
+            memcpy(dst.data[1] + cy * dst.stride[1], uLine, size_t(chromaWidth));
+            memcpy(dst.data[2] + cy * dst.stride[2], vLine, size_t(chromaWidth));
+        }
+    }
+
+    return true;
+}
+
+SwizzleParameters ConvertContext::swizzleParameters(const ConvertFormat *from,
+                                                    const ConvertFormat *to)
+{
+    SwizzleParameters parameters;
+    memset(&parameters, 0, sizeof(SwizzleParameters));
+
+    if (from->type != FormatType_RGB32 || to->type != FormatType_RGB32)
+        return parameters;
+
+    for (int i = 0; i < 4; i++) {
+        parameters.srcShift[i] = from->components[i];
+        parameters.dstShift[i] = to->components[i];
+    }
+
+    if (from->alpha && to->alpha) {
+        parameters.components = 4;
+        parameters.opaque = 0;
+    } else {
+        parameters.components = 3;
+        parameters.opaque = 0xffu << to->components[3];
+    }
+
+    for (int pixel = 0; pixel < 4; pixel++)
+        for (int byte = 0; byte < 4; byte++) {
+            qint8 index = -128;
+
+            for (int i = 0; i < parameters.components; i++)
+                if (parameters.dstShift[i] / 8 == byte)
+                    index = qint8(4 * pixel + parameters.srcShift[i] / 8);
+
+            parameters.shuffle[4 * pixel + byte] = index;
+        }
+
+    return parameters;
+}
+
+void ConvertContext::colorSpaceConstants(AkVideoConverter::YuvColorSpace colorSpace,
+                                         qreal &kr,
+                                         qreal &kb)
+{
+    if (colorSpace == AkVideoConverter::YuvColorSpace_BT709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    } else {
+        kr = 0.299;
+        kb = 0.114;
+    }
+}
+
+YuvToRgbCoefficients ConvertContext::yuvToRgbCoefficients(AkVideoConverter::YuvColorSpace colorSpace,
+                                                          bool fullRange)
+{
+    qreal kr;
+    qreal kb;
+    colorSpaceConstants(colorSpace, kr, kb);
+    qreal kg = 1.0 - kr - kb;
+    qreal one = 1 << YUV2RGB_SHIFT;
+    qreal yScale = fullRange? 1.0: 255.0 / 219.0;
+    qreal cScale = fullRange? 1.0: 255.0 / 224.0;
+
+    YuvToRgbCoefficients c;
+    c.yOffset = fullRange? 0: 16;
+    c.yMul = qint16(qRound(one * yScale));
+    c.vr = qint16(qRound(one * cScale * 2.0 * (1.0 - kr)));
+    c.ug = qint16(qRound(one * cScale * 2.0 * kb * (1.0 - kb) / kg));
+    c.vg = qint16(qRound(one * cScale * 2.0 * kr * (1.0 - kr) / kg));
+    c.ub = qint16(qRound(one * cScale * 2.0 * (1.0 - kb)));
+
+    return c;
+}
+
+RgbToYuvCoefficients ConvertContext::rgbToYuvCoefficients(AkVideoConverter::YuvColorSpace colorSpace,
+                                                          bool fullRange)
+{
+    qreal kr;
+    qreal kb;
+    colorSpaceConstants(colorSpace, kr, kb);
+    qreal one = 1 << RGB2YUV_SHIFT;
+    qreal yScale = fullRange? 1.0: 219.0 / 255.0;
+    qreal cScale = fullRange? 1.0: 224.0 / 255.0;
+
+    // The rounding error is moved to the green coefficient, so gray pixels
+    // have exactly the expected luma and neutral chroma.
+    RgbToYuvCoefficients c;
+    c.yr = qint16(qRound(one * yScale * kr));
+    c.yb = qint16(qRound(one * yScale * kb));
+    c.yg = qint16(qRound(one * yScale) - c.yr - c.yb);
+    c.ub = qint16(qRound(one * cScale / 2.0));
+    c.ur = qint16(qRound(-one * cScale * kr / (2.0 * (1.0 - kb))));
+    c.ug = qint16(-c.ub - c.ur);
+    c.vr = qint16(qRound(one * cScale / 2.0));
+    c.vb = qint16(qRound(-one * cScale * kb / (2.0 * (1.0 - kr))));
+    c.vg = qint16(-c.vr - c.vb);
+    c.yOffset = fullRange? 0: 16;
+
+    return c;
+}
+
+const quint32 *ConvertContext::readArgb(const SrcPlanes &src,
+                                        int y,
+                                        quint32 *out,
+                                        quint8 **lines) const
+{
+    auto iFormat = this->m_iFormat;
+    const quint8 *srcLine = src.data[0] + y * src.stride[0];
+
+    if (iFormat->type == FormatType_RGB32) {
+        auto iLine = reinterpret_cast<const quint32 *>(srcLine);
+
+        if (this->m_iIsArgb)
+            return iLine;
+
+        this->m_kernels.swizzle(iLine, out, this->m_width, this->m_iSwizzle);
+
+        return out;
+    }
+
+    if (iFormat->type == FormatType_RGB24) {
+        int r = iFormat->components[0];
+        int g = iFormat->components[1];
+        int b = iFormat->components[2];
+
+        for (int x = 0; x < this->m_width; x++) {
+            const quint8 *pixel = srcLine + 3 * x;
+            out[x] = 0xff000000
+                   | quint32(pixel[r]) << 16
+                   | quint32(pixel[g]) << 8
+                   | quint32(pixel[b]);
+        }
+
+        return out;
+    }
+
+    const quint8 *yLine = nullptr;
+    const quint8 *uLine = nullptr;
+    const quint8 *vLine = nullptr;
+    int xShift = this->readYuv(src, y, &yLine, &uLine, &vLine, lines);
+    this->m_kernels.yuvToArgb(yLine,
+                              uLine,
+                              vLine,
+                              out,
+                              this->m_width,
+                              xShift,
+                              this->m_yuvToRgb);
+
+    return out;
+}
+
+int ConvertContext::readYuv(const SrcPlanes &src,
+                            int y,
+                            const quint8 **yLine,
+                            const quint8 **uLine,
+                            const quint8 **vLine,
+                            quint8 **lines) const
+{
+    auto iFormat = this->m_iFormat;
+    const quint8 *srcLine = src.data[0] + y * src.stride[0];
+    int cy = y >> iFormat->yShift;
+    int chromaWidth = (this->m_width + iFormat->xShift) >> iFormat->xShift;
+
+    switch (iFormat->chroma) {
+    case ChromaType_None:
+        *yLine = srcLine;
+        *uLine = lines[ScratchLine_Neutral];
+        *vLine = lines[ScratchLine_Neutral];
+
+        return 0;
+    case ChromaType_Packed: {
+        Packed422Layout layout {iFormat->components[0],
+                                iFormat->components[1],
+                                iFormat->components[2]};
+        this->m_kernels.splitPacked(srcLine,
+                                    lines[ScratchLine_Y],
+                                    lines[ScratchLine_U],
+                                    lines[ScratchLine_V],
+                                    this->m_width,
+                                    layout);
+        *yLine = lines[ScratchLine_Y];
+        *uLine = lines[ScratchLine_U];
+        *vLine = lines[ScratchLine_V];
+
+        break;
+    }
+    case ChromaType_SemiPlanar: {
+        bool uFirst = iFormat->components[0] < iFormat->components[1];
+        quint8 *first = lines[uFirst? ScratchLine_U: ScratchLine_V];
+        quint8 *second = lines[uFirst? ScratchLine_V: ScratchLine_U];
+        this->m_kernels.splitUV(src.data[1] + cy * src.stride[1],
+                                first,
+                                second,
+                                chromaWidth);
+        *yLine = srcLine;
+        *uLine = lines[ScratchLine_U];
+        *vLine = lines[ScratchLine_V];
+
+        break;
+    }
+    default:
+        *yLine = srcLine;
+        *uLine = src.data[1] + cy * src.stride[1];
+        *vLine = src.data[2] + cy * src.stride[2];
+
+        break;
+    }
+
+    return iFormat->xShift;
+}
+
+#include "moc_akvideoconverter.cpp"
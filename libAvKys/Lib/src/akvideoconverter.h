@@ -0,0 +1,112 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKVIDEOCONVERTER_H
+#define AKVIDEOCONVERTER_H
+
+#include "akvideocaps.h"
+
+class AkVideoConverterPrivate;
+class AkVideoPacket;
+
+// Converts raw video frames between pixel formats.
+//
+// Supported formats are the 8 bits per component RGB formats (argb, 0rgb,
+// rgba, rgb0, abgr, 0bgr, bgra, bgr0, rgb24 and bgr24), gray, the planar YUV
+// formats (yuv420p, yuv422p, yuv444p and its yuvj variants), nv12, nv21 and
+// the packed YUV 4:2:2 formats (yuyv422, uyvy422 and yvyu422).
+// 32 bits RGB formats are stored as native endian words, so argb matches
+// QImage::Format_ARGB32.
+class AKCOMMONS_EXPORT AkVideoConverter: public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(YuvColorSpace)
+    Q_ENUMS(YuvColorRange)
+    Q_PROPERTY(AkVideoCaps outputCaps
+               READ outputCaps
+               WRITE setOutputCaps
+               RESET resetOutputCaps
+               NOTIFY outputCapsChanged)
+    Q_PROPERTY(YuvColorSpace yuvColorSpace
+               READ yuvColorSpace
+               WRITE setYuvColorSpace
+               RESET resetYuvColorSpace
+               NOTIFY yuvColorSpaceChanged)
+    Q_PROPERTY(YuvColorRange yuvColorRange
+               READ yuvColorRange
+               WRITE setYuvColorRange
+               RESET resetYuvColorRange
+               NOTIFY yuvColorRangeChanged)
+
+    public:
+        enum YuvColorSpace
+        {
+            YuvColorSpace_BT601,
+            YuvColorSpace_BT709
+        };
+
+        // The yuvj formats are always full range.
+        enum YuvColorRange
+        {
+            YuvColorRange_Limited,
+            YuvColorRange_Full
+        };
+
+        explicit AkVideoConverter(QObject *parent=nullptr);
+        AkVideoConverter(const AkVideoCaps &outputCaps,
+                         QObject *parent=nullptr);
+        ~AkVideoConverter();
+
+        Q_INVOKABLE AkVideoCaps outputCaps() const;
+        Q_INVOKABLE YuvColorSpace yuvColorSpace() const;
+        Q_INVOKABLE YuvColorRange yuvColorRange() const;
+
+        // Converts the packet to outputCaps. Frame size and frame rate are
+        // taken from the input packet, only the format is changed.
+        Q_INVOKABLE AkVideoPacket convert(const AkVideoPacket &packet) const;
+        Q_INVOKABLE AkVideoPacket convert(const AkVideoPacket &packet,
+                                          AkVideoCaps::PixelFormat format) const;
+
+        Q_INVOKABLE static bool canConvert(AkVideoCaps::PixelFormat iFormat,
+                                           AkVideoCaps::PixelFormat oFormat);
+        Q_INVOKABLE static bool isSupported(AkVideoCaps::PixelFormat format);
+        static QList<AkVideoCaps::PixelFormat> supportedFormats();
+        Q_INVOKABLE static void clearCache();
+
+    private:
+        AkVideoConverterPrivate *d;
+
+    Q_SIGNALS:
+        void outputCapsChanged(const AkVideoCaps &outputCaps);
+        void yuvColorSpaceChanged(YuvColorSpace yuvColorSpace);
+        void yuvColorRangeChanged(YuvColorRange yuvColorRange);
+
+    public Q_SLOTS:
+        void setOutputCaps(const AkVideoCaps &outputCaps);
+        void setYuvColorSpace(YuvColorSpace yuvColorSpace);
+        void setYuvColorRange(YuvColorRange yuvColorRange);
+        void resetOutputCaps();
+        void resetYuvColorSpace();
+        void resetYuvColorRange();
+};
+
+Q_DECLARE_METATYPE(AkVideoConverter::YuvColorSpace)
+Q_DECLARE_METATYPE(AkVideoConverter::YuvColorRange)
+
+#endif // AKVIDEOCONVERTER_H
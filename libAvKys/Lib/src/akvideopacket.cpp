@@ -24,14 +24,14 @@
 #include "akcaps.h"
 #include "akvideocaps.h"
 
-class AkVideoPacketPrivate
+class AkVideoPacketPrivate: public QSharedData
 {
     public:
         AkVideoCaps m_caps;
 };
 
-AkVideoPacket::AkVideoPacket(QObject *parent):
-    AkPacket(parent)
+AkVideoPacket::AkVideoPacket():
+    AkPacket()
 {
     this->d = new AkVideoPacketPrivate();
 }
@@ -52,45 +52,35 @@ AkVideoPacket::AkVideoPacket(const AkVideoCaps &caps,
     this->id() = id;
 }
 
-AkVideoPacket::AkVideoPacket(const AkPacket &other)
+// Share the buffer, data and timestamps of the source packet, only the caps
+// are converted.
+AkVideoPacket::AkVideoPacket(const AkPacket &other):
+    AkPacket(other)
 {
     this->d = new AkVideoPacketPrivate();
     this->d->m_caps = other.caps();
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 }
 
 AkVideoPacket::AkVideoPacket(const AkVideoPacket &other):
-    AkPacket()
+    AkPacket(other),
+    d(other.d)
+{
+}
+
+AkVideoPacket::AkVideoPacket(AkVideoPacket &&other) noexcept:
+    AkPacket(std::move(other)),
+    d(std::move(other.d))
 {
-    this->d = new AkVideoPacketPrivate();
-    this->d->m_caps = other.d->m_caps;
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 }
 
 AkVideoPacket::~AkVideoPacket()
 {
-    delete this->d;
 }
 
 AkVideoPacket &AkVideoPacket::operator =(const AkPacket &other)
 {
+    AkPacket::operator =(other);
     this->d->m_caps = other.caps();
-    this->data() = other.data();
-    this->buffer() = other.buffer();
-    this->pts() = other.pts();
-    this->timeBase() = other.timeBase();
-    this->index() = other.index();
-    this->id() = other.id();
 
     return *this;
 }
@@ -98,13 +88,18 @@ AkVideoPacket &AkVideoPacket::operator =(const AkPacket &other)
 AkVideoPacket &AkVideoPacket::operator =(const AkVideoPacket &other)
 {
     if (this != &other) {
-        this->d->m_caps = other.d->m_caps;
-        this->data() = other.data();
-        this->buffer() = other.buffer();
-        this->pts() = other.pts();
-        this->timeBase() = other.timeBase();
-        this->index() = other.index();
-        this->id() = other.id();
+        AkPacket::operator =(other);
+        this->d = other.d;
+    }
+
+    return *this;
+}
+
+AkVideoPacket &AkVideoPacket::operator =(AkVideoPacket &&other) noexcept
+{
+    if (this != &other) {
+        AkPacket::operator =(std::move(other));
+        this->d.swap(other.d);
     }
 
     return *this;
@@ -164,24 +159,18 @@ QString AkVideoPacket::toString() const
 
 AkPacket AkVideoPacket::toPacket() const
 {
-    AkPacket packet;
-    packet.caps() =  this->d->m_caps.toCaps();
-    packet.buffer() = this->buffer();
-    packet.pts() = this->pts();
-    packet.timeBase() = this->timeBase();
-    packet.index() = this->index();
-    packet.id() = this->id();
+    AkPacket packet(*this);
+    packet.caps() = this->d->m_caps.toCaps();
 
     return packet;
 }
 
 void AkVideoPacket::setCaps(const AkVideoCaps &caps)
 {
-    if (this->d->m_caps == caps)
+    if (this->d.constData()->m_caps == caps)
         return;
 
     this->d->m_caps = caps;
-    emit this->capsChanged(caps);
 }
 
 void AkVideoPacket::resetCaps()
@@ -0,0 +1,966 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <cmath>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QVarLengthArray>
+
+#include "akvideoscaler.h"
+#include "akvideopacket.h"
+#include "akbufferpool.h"
+#include "aksimd.h"
+#include "akscheduler.h"
+
+#ifdef AK_SIMD_X86
+    #define AK_VIDEOSCALER_SIMD
+    #include <immintrin.h>
+#endif
+
+// Frames smaller than this number of pixels are scaled in the calling thread.
+#define MIN_PARALLEL_PIXELS (320 * 240)
+
+// Minimum number of rows processed by a thread.
+#define MIN_BAND_HEIGHT 16
+
+#define MAX_CACHED_TABLES 128
+
+// Fractional bits of the filter weights.
+#define WEIGHT_SHIFT 14
+#define WEIGHT_ROUND (1 << (WEIGHT_SHIFT - 1))
+
+static inline quint8 clamp8(int value)
+{
+    return quint8(qBound(0, value, 255));
+}
+
+// Scalar kernels
+
+// Vertical pass, every byte of the line is filtered independently, so it
+// works with any number of channels.
+static void verticalScalar(const quint8 *const *lines,
+                           const qint16 *weights,
+                           int taps,
+                           quint8 *dst,
+                           int size)
+{
+    for (int x = 0; x < size; x++) {
+        int sum = 0;
+
+        for (int k = 0; k < taps; k++)
+            sum += weights[k] * lines[k][x];
+
+        dst[x] = clamp8((sum + WEIGHT_ROUND) >> WEIGHT_SHIFT);
+    }
+}
+
+static void horizontalScalar(const quint8 *src,
+                             quint8 *dst,
+                             int width,
+                             int channels,
+                             const int *start,
+                             const qint16 *weights,
+                             int taps)
+{
+    for (int x = 0; x < width; x++) {
+        const quint8 *pixel = src + channels * start[x];
+        const qint16 *w = weights + x * taps;
+
+        for (int c = 0; c < channels; c++) {
+            int sum = 0;
+
+            for (int k = 0; k < taps; k++)
+                sum += w[k] * pixel[k * channels + c];
+
+            dst[x * channels + c] = clamp8((sum + WEIGHT_ROUND) >> WEIGHT_SHIFT);
+        }
+    }
+}
+
+#ifdef AK_VIDEOSCALER_SIMD
+static inline int load32(const void *data)
+{
+    int value;
+    memcpy(&value, data, sizeof(int));
+
+    return value;
+}
+
+static inline void store32(void *data, int value)
+{
+    memcpy(data, &value, sizeof(int));
+}
+
+// Packs two weights, so they can be multiplied with a pair of 16 bits
+// values with madd.
+static inline int weightPair(qint16 w0, qint16 w1)
+{
+    return int(quint32(quint16(w0)) | quint32(quint16(w1)) << 16);
+}
+
+// SSE2 kernels
+
+AK_SIMD_TARGET("sse2")
+static void verticalSSE2(const quint8 *const *lines,
+                         const qint16 *weights,
+                         int taps,
+                         quint8 *dst,
+                         int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(WEIGHT_ROUND);
+    int x = 0;
+
+    for (; x + 8 <= size; x += 8) {
+        __m128i sum0 = zero;
+        __m128i sum1 = zero;
+        int k = 0;
+
+        for (; k + 1 < taps; k += 2) {
+            __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lines[k] + x));
+            __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lines[k + 1] + x));
+            __m128i w = _mm_set1_epi32(weightPair(weights[k], weights[k + 1]));
+            a = _mm_unpacklo_epi8(a, zero);
+            b = _mm_unpacklo_epi8(b, zero);
+            sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), w));
+            sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), w));
+        }
+
+        if (k < taps) {
+            __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lines[k] + x));
+            __m128i w = _mm_set1_epi32(weightPair(weights[k], 0));
+            a = _mm_unpacklo_epi8(a, zero);
+            sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), w));
+            sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(a, zero), w));
+        }
+
+        sum0 = _mm_srai_epi32(_mm_add_epi32(sum0, round), WEIGHT_SHIFT);
+        sum1 = _mm_srai_epi32(_mm_add_epi32(sum1, round), WEIGHT_SHIFT);
+        __m128i out = _mm_packs_epi32(sum0, sum1);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + x),
+                         _mm_packus_epi16(out, out));
+    }
+
+    QVarLengthArray<const quint8 *, 64> tail(taps);
+
+    for (int k = 0; k < taps; k++)
+        tail[k] = lines[k] + x;
+
+    verticalScalar(tail.constData(), weights, taps, dst + x, size - x);
+}
+
+// Horizontal pass for 4 channels pixels, each pair of taps is multiplied
+// with madd.
+AK_SIMD_TARGET("sse2")
+static void horizontal4SSE2(const quint8 *src,
+                            quint8 *dst,
+                            int width,
+                            const int *start,
+                            const qint16 *weights,
+                            int taps)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(WEIGHT_ROUND);
+
+    for (int x = 0; x < width; x++) {
+        const quint8 *pixel = src + 4 * start[x];
+        const qint16 *w = weights + x * taps;
+        __m128i sum = zero;
+        int k = 0;
+
+        for (; k + 1 < taps; k += 2) {
+            __m128i p0 = _mm_cvtsi32_si128(load32(pixel + 4 * k));
+            __m128i p1 = _mm_cvtsi32_si128(load32(pixel + 4 * k + 4));
+            __m128i p = _mm_unpacklo_epi8(_mm_unpacklo_epi8(p0, p1), zero);
+            sum = _mm_add_epi32(sum,
+                                _mm_madd_epi16(p, _mm_set1_epi32(weightPair(w[k], w[k + 1]))));
+        }
+
+        if (k < taps) {
+            __m128i p0 = _mm_cvtsi32_si128(load32(pixel + 4 * k));
+            __m128i p = _mm_unpacklo_epi8(_mm_unpacklo_epi8(p0, zero), zero);
+            sum = _mm_add_epi32(sum,
+                                _mm_madd_epi16(p, _mm_set1_epi32(weightPair(w[k], 0))));
+        }
+
+        sum = _mm_srai_epi32(_mm_add_epi32(sum, round), WEIGHT_SHIFT);
+        sum = _mm_packs_epi32(sum, sum);
+        store32(dst + 4 * x, _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+    }
+}
+
+// AVX2 kernels
+
+AK_SIMD_TARGET("avx2")
+static void verticalAVX2(const quint8 *const *lines,
+                         const qint16 *weights,
+                         int taps,
+                         quint8 *dst,
+                         int size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(WEIGHT_ROUND);
+    int x = 0;
+
+    for (; x + 16 <= size; x += 16) {
+        __m256i sum0 = zero;
+        __m256i sum1 = zero;
+        int k = 0;
+
+        // The unpacks work in each 128 bits lane, the low lane holds the
+        // bytes 0 to 7 and the high lane the bytes 8 to 15.
+        for (; k + 1 < taps; k += 2) {
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[k] + x)));
+            __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[k + 1] + x)));
+            __m256i w = _mm256_set1_epi32(weightPair(weights[k], weights[k + 1]));
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+        }
+
+        if (k < taps) {
+            __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lines[k] + x)));
+            __m256i w = _mm256_set1_epi32(weightPair(weights[k], 0));
+            sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, zero), w));
+            sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, zero), w));
+        }
+
+        sum0 = _mm256_srai_epi32(_mm256_add_epi32(sum0, round), WEIGHT_SHIFT);
+        sum1 = _mm256_srai_epi32(_mm256_add_epi32(sum1, round), WEIGHT_SHIFT);
+        __m256i out = _mm256_packs_epi32(sum0, sum1);
+        out = _mm256_packus_epi16(out, out);
+        out = _mm256_permute4x64_epi64(out, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x),
+                         _mm256_castsi256_si128(out));
+    }
+
+    QVarLengthArray<const quint8 *, 64> tail(taps);
+
+    for (int k = 0; k < taps; k++)
+        tail[k] = lines[k] + x;
+
+    verticalSSE2(tail.constData(), weights, taps, dst + x, size - x);
+}
+#endif
+
+struct ScaleKernels
+{
+    void (*vertical)(const quint8 *const *lines,
+                     const qint16 *weights,
+                     int taps,
+                     quint8 *dst,
+                     int size);
+    void (*horizontal)(const quint8 *src,
+                       quint8 *dst,
+                       int width,
+                       int channels,
+                       const int *start,
+                       const qint16 *weights,
+                       int taps);
+    void (*horizontal4)(const quint8 *src,
+                        quint8 *dst,
+                        int width,
+                        const int *start,
+                        const qint16 *weights,
+                        int taps);
+
+    static ScaleKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        ScaleKernels kernels = {
+            verticalScalar,
+            horizontalScalar,
+            nullptr
+        };
+
+#ifdef AK_VIDEOSCALER_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_SSE2) {
+            kernels.vertical = verticalSSE2;
+            kernels.horizontal4 = horizontal4SSE2;
+        }
+
+        if (instructionSet >= AkSimd::InstructionSet_AVX2)
+            kernels.vertical = verticalAVX2;
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
+
+// Filter weights for each destination pixel of a line, or each destination
+// line of a frame.
+class ScaleTable
+{
+    public:
+        int m_taps;
+        QVector<int> m_start;
+        QVector<qint16> m_weights;
+
+        static ScaleTable *create(int srcSize,
+                                  int dstSize,
+                                  AkVideoScaler::ScalingMode mode);
+
+    private:
+        static inline qreal filter(AkVideoScaler::ScalingMode mode, qreal x);
+        static inline qreal support(AkVideoScaler::ScalingMode mode);
+};
+
+struct ScaleTableKey
+{
+    int srcSize;
+    int dstSize;
+    AkVideoScaler::ScalingMode mode;
+
+    inline bool operator ==(const ScaleTableKey &other) const
+    {
+        return this->srcSize == other.srcSize
+            && this->dstSize == other.dstSize
+            && this->mode == other.mode;
+    }
+};
+
+inline uint qHash(const ScaleTableKey &key, uint seed=0)
+{
+    return qHash(quint64(uint(key.srcSize)) << 32 | uint(key.dstSize), seed)
+         ^ qHash(int(key.mode), seed);
+}
+
+class ScaleFormat
+{
+    public:
+        AkVideoCaps::PixelFormat format;
+        int planes;
+        int channels;
+        int xShift;
+        int yShift;
+
+        static inline const QVector<ScaleFormat> &formats()
+        {
+            static const QVector<ScaleFormat> scaleFormats = {
+                {AkVideoCaps::Format_argb    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_0rgb    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_rgba    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_rgb0    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_abgr    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_0bgr    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_bgra    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_bgr0    , 1, 4, 0, 0},
+                {AkVideoCaps::Format_rgb24   , 1, 3, 0, 0},
+                {AkVideoCaps::Format_bgr24   , 1, 3, 0, 0},
+                {AkVideoCaps::Format_gray    , 1, 1, 0, 0},
+                {AkVideoCaps::Format_yuv420p , 3, 1, 1, 1},
+                {AkVideoCaps::Format_yuvj420p, 3, 1, 1, 1},
+                {AkVideoCaps::Format_yuv422p , 3, 1, 1, 0},
+                {AkVideoCaps::Format_yuvj422p, 3, 1, 1, 0},
+                {AkVideoCaps::Format_yuv444p , 3, 1, 0, 0},
+                {AkVideoCaps::Format_yuvj444p, 3, 1, 0, 0},
+            };
+
+            return scaleFormats;
+        }
+
+        static inline const ScaleFormat *byFormat(AkVideoCaps::PixelFormat format)
+        {
+            for (const ScaleFormat &scaleFormat: formats())
+                if (scaleFormat.format == format)
+                    return &scaleFormat;
+
+            return nullptr;
+        }
+
+        // Size of each plane, chroma planes are rounded up.
+        inline void planeSize(int plane,
+                              int width,
+                              int height,
+                              int *planeWidth,
+                              int *planeHeight) const
+        {
+            if (plane == 0) {
+                *planeWidth = width;
+                *planeHeight = height;
+            } else {
+                *planeWidth = (width + this->xShift) >> this->xShift;
+                *planeHeight = (height + this->yShift) >> this->yShift;
+            }
+        }
+
+        inline int frameSize(int width, int height) const
+        {
+            int size = 0;
+
+            for (int plane = 0; plane < this->planes; plane++) {
+                int planeWidth;
+                int planeHeight;
+                this->planeSize(plane, width, height, &planeWidth, &planeHeight);
+                size += this->channels * planeWidth * planeHeight;
+            }
+
+            return size;
+        }
+};
+
+struct ScalePlane
+{
+    const quint8 *src;
+    int srcStride;
+    int srcWidth;
+    int srcHeight;
+    quint8 *dst;
+    int dstStride;
+    int dstWidth;
+    int dstHeight;
+    int channels;
+};
+
+class AkVideoScalerPrivate
+{
+    public:
+        AkVideoScaler::ScalingMode m_scalingMode;
+
+        AkVideoScalerPrivate():
+            m_scalingMode(AkVideoScaler::ScalingMode_Bilinear)
+        {
+        }
+
+        bool scale(const ScalePlane &plane) const;
+        void scaleNearest(const ScalePlane &plane) const;
+
+        template<typename Function>
+        static void parallelRows(int rows, qint64 pixels, Function function);
+};
+
+class AkVideoScalerGlobalPrivate
+{
+    public:
+        QMutex m_mutex;
+        QHash<ScaleTableKey, QSharedPointer<ScaleTable>> m_tables;
+
+        QSharedPointer<ScaleTable> table(const ScaleTableKey &key);
+};
+
+Q_GLOBAL_STATIC(AkVideoScalerGlobalPrivate, akVideoScalerGlobal)
+
+template<typename Function>
+void AkVideoScalerPrivate::parallelRows(int rows,
+                                        qint64 pixels,
+                                        Function function)
+{
+    if (pixels < MIN_PARALLEL_PIXELS) {
+        function(0, rows);
+
+        return;
+    }
+
+    AkScheduler::parallelFor(rows, MIN_BAND_HEIGHT, function);
+}
+
+AkVideoScaler::AkVideoScaler(QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoScalerPrivate;
+}
+
+AkVideoScaler::AkVideoScaler(AkVideoScaler::ScalingMode scalingMode,
+                             QObject *parent):
+    QObject(parent)
+{
+    this->d = new AkVideoScalerPrivate;
+    this->d->m_scalingMode = scalingMode;
+}
+
+AkVideoScaler::~AkVideoScaler()
+{
+    delete this->d;
+}
+
+AkVideoScaler::ScalingMode AkVideoScaler::scalingMode() const
+{
+    return this->d->m_scalingMode;
+}
+
+AkVideoPacket AkVideoScaler::scale(const AkVideoPacket &packet,
+                                   const QSize &size) const
+{
+    return this->scale(packet, size.width(), size.height());
+}
+
+AkVideoPacket AkVideoScaler::scale(const AkVideoPacket &packet,
+                                   int width,
+                                   int height) const
+{
+    const AkVideoCaps &iCaps = packet.caps();
+
+    if (iCaps.width() == width && iCaps.height() == height)
+        return packet;
+
+    auto format = ScaleFormat::byFormat(iCaps.format());
+
+    if (!format
+        || width < 1
+        || height < 1
+        || iCaps.width() < 1
+        || iCaps.height() < 1)
+        return AkVideoPacket();
+
+    const QByteArray &buffer = packet.buffer();
+    int iFrameSize = format->frameSize(iCaps.width(), iCaps.height());
+
+    if (buffer.size() < iFrameSize)
+        return AkVideoPacket();
+
+    int oFrameSize = format->frameSize(width, height);
+    auto oBuffer = AkBufferPool::buffer(iCaps.format(),
+                                        width,
+                                        height,
+                                        1,
+                                        oFrameSize);
+
+    if (!oBuffer)
+        return AkVideoPacket();
+
+    auto src = reinterpret_cast<const quint8 *>(buffer.constData());
+    auto dst = oBuffer.data<quint8>();
+
+    for (int i = 0; i < format->planes; i++) {
+        ScalePlane plane;
+        format->planeSize(i,
+                          iCaps.width(),
+                          iCaps.height(),
+                          &plane.srcWidth,
+                          &plane.srcHeight);
+        format->planeSize(i,
+                          width,
+                          height,
+                          &plane.dstWidth,
+                          &plane.dstHeight);
+        plane.channels = format->channels;
+        plane.src = src;
+        plane.srcStride = format->channels * plane.srcWidth;
+        plane.dst = dst;
+        plane.dstStride = format->channels * plane.dstWidth;
+
+        // Single plane frames can have padding at the end of each line, as
+        // in QImage.
+        if (format->planes == 1 && buffer.size() % plane.srcHeight == 0)
+            plane.srcStride = qMax(plane.srcStride,
+                                   buffer.size() / plane.srcHeight);
+
+        if (!this->d->scale(plane))
+            return AkVideoPacket();
+
+        src += plane.srcStride * plane.srcHeight;
+        dst += plane.dstStride * plane.dstHeight;
+    }
+
+    AkVideoPacket oPacket(packet);
+    oPacket.caps().width() = width;
+    oPacket.caps().height() = height;
+    oBuffer.attachTo(oPacket);
+
+    return oPacket;
+}
+
+QImage AkVideoScaler::scale(const QImage &image, const QSize &size) const
+{
+    return this->scale(image, size.width(), size.height());
+}
+
+QImage AkVideoScaler::scale(const QImage &image, int width, int height) const
+{
+    if (image.width() == width && image.height() == height)
+        return image;
+
+    if (image.isNull() || width < 1 || height < 1)
+        return QImage();
+
+    if (!AkVideoScaler::canScale(image.format()))
+        return image.scaled(width,
+                            height,
+                            Qt::IgnoreAspectRatio,
+                            this->d->m_scalingMode == ScalingMode_Nearest?
+                                Qt::FastTransformation:
+                                Qt::SmoothTransformation);
+
+    QImage oImage = AkBufferPool::image(width, height, image.format());
+
+    if (oImage.isNull())
+        return QImage();
+
+    ScalePlane plane;
+    plane.src = image.constBits();
+    plane.srcStride = image.bytesPerLine();
+    plane.srcWidth = image.width();
+    plane.srcHeight = image.height();
+    plane.dst = oImage.bits();
+    plane.dstStride = oImage.bytesPerLine();
+    plane.dstWidth = width;
+    plane.dstHeight = height;
+    plane.channels = image.depth() / 8;
+
+    if (!this->d->scale(plane))
+        return QImage();
+
+    return oImage;
+}
+
+bool AkVideoScaler::canScale(AkVideoCaps::PixelFormat format)
+{
+    return ScaleFormat::byFormat(format) != nullptr;
+}
+
+bool AkVideoScaler::canScale(QImage::Format format)
+{
+    static const QVector<QImage::Format> formats = {
+        QImage::Format_RGB32,
+        QImage::Format_ARGB32,
+        QImage::Format_ARGB32_Premultiplied,
+        QImage::Format_RGBX8888,
+        QImage::Format_RGBA8888,
+        QImage::Format_RGBA8888_Premultiplied,
+        QImage::Format_RGB888,
+        QImage::Format_Grayscale8
+    };
+
+    return formats.contains(format);
+}
+
+void AkVideoScaler::clearCache()
+{
+    QMutexLocker locker(&akVideoScalerGlobal->m_mutex);
+    akVideoScalerGlobal->m_tables.clear();
+}
+
+void AkVideoScaler::setScalingMode(AkVideoScaler::ScalingMode scalingMode)
+{
+    if (this->d->m_scalingMode == scalingMode)
+        return;
+
+    this->d->m_scalingMode = scalingMode;
+    emit this->scalingModeChanged(scalingMode);
+}
+
+void AkVideoScaler::resetScalingMode()
+{
+    this->setScalingMode(ScalingMode_Bilinear);
+}
+
+// Returns false if the intermediate lines couldn't be allocated.
+bool AkVideoScalerPrivate::scale(const ScalePlane &plane) const
+{
+    if (this->m_scalingMode == AkVideoScaler::ScalingMode_Nearest) {
+        this->scaleNearest(plane);
+
+        return true;
+    }
+
+    auto kernels = ScaleKernels::byInstructionSet(AkSimd::instructionSet());
+    QSharedPointer<ScaleTable> hTable;
+    QSharedPointer<ScaleTable> vTable;
+
+    if (plane.srcWidth != plane.dstWidth)
+        hTable = akVideoScalerGlobal->table({plane.srcWidth,
+                                             plane.dstWidth,
+                                             this->m_scalingMode});
+
+    if (plane.srcHeight != plane.dstHeight)
+        vTable = akVideoScalerGlobal->table({plane.srcHeight,
+                                             plane.dstHeight,
+                                             this->m_scalingMode});
+
+    int channels = plane.channels;
+
+    // Horizontal pass, goes to the destination directly if the height does
+    // not change.
+    const quint8 *lines = plane.src;
+    int linesStride = plane.srcStride;
+    AkPoolBuffer buffer;
+
+    if (hTable) {
+        quint8 *hDst = plane.dst;
+        int hStride = plane.dstStride;
+
+        if (vTable) {
+            hStride = channels * plane.dstWidth;
+            buffer = AkBufferPool::buffer(hStride * plane.srcHeight);
+
+            if (!buffer)
+                return false;
+
+            hDst = buffer.data<quint8>();
+        }
+
+        auto table = hTable.data();
+        parallelRows(plane.srcHeight,
+                     qint64(plane.dstWidth) * plane.srcHeight,
+                     [&] (int y0, int y1) {
+            for (int y = y0; y < y1; y++) {
+                const quint8 *srcLine = plane.src + y * plane.srcStride;
+                quint8 *dstLine = hDst + y * hStride;
+
+                if (channels == 4 && kernels.horizontal4)
+                    kernels.horizontal4(srcLine,
+                                        dstLine,
+                                        plane.dstWidth,
+                                        table->m_start.constData(),
+                                        table->m_weights.constData(),
+                                        table->m_taps);
+                else
+                    kernels.horizontal(srcLine,
+                                       dstLine,
+                                       plane.dstWidth,
+                                       channels,
+                                       table->m_start.constData(),
+                                       table->m_weights.constData(),
+                                       table->m_taps);
+            }
+        });
+
+        lines = hDst;
+        linesStride = hStride;
+    }
+
+    if (!vTable) {
+        // Only the height changes, or nothing at all.
+        if (!hTable)
+            for (int y = 0; y < plane.dstHeight; y++)
+                memcpy(plane.dst + y * plane.dstStride,
+                       plane.src + y * plane.srcStride,
+                       size_t(channels * plane.dstWidth));
+
+        return true;
+    }
+
+    auto table = vTable.data();
+    parallelRows(plane.dstHeight,
+                 qint64(plane.dstWidth) * plane.dstHeight,
+                 [&] (int y0, int y1) {
+        QVarLengthArray<const quint8 *, 64> srcLines(table->m_taps);
+
+        for (int y = y0; y < y1; y++) {
+            const quint8 *srcLine = lines + table->m_start[y] * linesStride;
+
+            for (int k = 0; k < table->m_taps; k++)
+                srcLines[k] = srcLine + k * linesStride;
+
+            kernels.vertical(srcLines.constData(),
+                             table->m_weights.constData() + y * table->m_taps,
+                             table->m_taps,
+                             plane.dst + y * plane.dstStride,
+                             channels * plane.dstWidth);
+        }
+    });
+
+    return true;
+}
+
+void AkVideoScalerPrivate::scaleNearest(const ScalePlane &plane) const
+{
+    // Sample the pixel at the center of each destination pixel.
+    QVarLengthArray<int, 4096> srcX(plane.dstWidth);
+
+    for (int x = 0; x < plane.dstWidth; x++)
+        srcX[x] = qMin(int((2 * qint64(x) + 1) * plane.srcWidth
+                           / (2 * qint64(plane.dstWidth))),
+                       plane.srcWidth - 1);
+
+    int channels = plane.channels;
+
+    parallelRows(plane.dstHeight,
+                 qint64(plane.dstWidth) * plane.dstHeight,
+                 [&] (int y0, int y1) {
+        for (int y = y0; y < y1; y++) {
+            int sy = qMin(int((2 * qint64(y) + 1) * plane.srcHeight
+                              / (2 * qint64(plane.dstHeight))),
+                          plane.srcHeight - 1);
+            const quint8 *srcLine = plane.src + sy * plane.srcStride;
+            quint8 *dstLine = plane.dst + y * plane.dstStride;
+
+            // Consecutive lines usually come from the same source line.
+            if (y > y0) {
+                int prevY = qMin(int((2 * qint64(y - 1) + 1) * plane.srcHeight
+                                     / (2 * qint64(plane.dstHeight))),
+                                 plane.srcHeight - 1);
+
+                if (prevY == sy) {
+                    memcpy(dstLine,
+                           dstLine - plane.dstStride,
+                           size_t(channels * plane.dstWidth));
+
+                    continue;
+                }
+            }
+
+            switch (channels) {
+            case 4: {
+                auto src = reinterpret_cast<const quint32 *>(srcLine);
+                auto dst = reinterpret_cast<quint32 *>(dstLine);
+
+                for (int x = 0; x < plane.dstWidth; x++)
+                    dst[x] = src[srcX[x]];
+
+                break;
+            }
+            case 1:
+                for (int x = 0; x < plane.dstWidth; x++)
+                    dstLine[x] = srcLine[srcX[x]];
+
+                break;
+            default:
+                for (int x = 0; x < plane.dstWidth; x++)
+                    memcpy(dstLine + channels * x,
+                           srcLine + channels * srcX[x],
+                           size_t(channels));
+
+                break;
+            }
+        }
+    });
+}
+
+QSharedPointer<ScaleTable> AkVideoScalerGlobalPrivate::table(const ScaleTableKey &key)
+{
+    QMutexLocker locker(&this->m_mutex);
+    auto it = this->m_tables.constFind(key);
+
+    if (it != this->m_tables.constEnd())
+        return it.value();
+
+    QSharedPointer<ScaleTable> table(ScaleTable::create(key.srcSize,
+                                                        key.dstSize,
+                                                        key.mode));
+
+    if (this->m_tables.size() >= MAX_CACHED_TABLES)
+        this->m_tables.clear();
+
+    this->m_tables[key] = table;
+
+    return table;
+}
+
+ScaleTable *ScaleTable::create(int srcSize,
+                               int dstSize,
+                               AkVideoScaler::ScalingMode mode)
+{
+    // When downscaling, the filter is stretched to cover all the source
+    // pixels that fall in a destination pixel.
+    qreal scale = qreal(srcSize) / dstSize;
+    qreal filterScale = qMax(scale, 1.0);
+    qreal filterSupport = support(mode) * filterScale;
+
+    QVector<int> start(dstSize);
+    QVector<int> count(dstSize);
+    QVector<QVector<qreal>> weights(dstSize);
+    int taps = 0;
+
+    for (int i = 0; i < dstSize; i++) {
+        qreal center = (i + 0.5) * scale;
+        int first = qMax(int(center - filterSupport + 0.5), 0);
+        int last = qMin(int(center + filterSupport + 0.5), srcSize);
+        qreal sum = 0;
+
+        for (int j = first; j < last; j++) {
+            qreal weight = filter(mode, (j - center + 0.5) / filterScale);
+            weights[i] << weight;
+            sum += weight;
+        }
+
+        if (qFuzzyIsNull(sum)) {
+            // Can happen in the borders with the box filter, take the
+            // nearest pixel instead.
+            first = qBound(0, int(center), srcSize - 1);
+            weights[i] = {1.0};
+        } else {
+            for (qreal &weight: weights[i])
+                weight /= sum;
+        }
+
+        start[i] = first;
+        count[i] = weights[i].size();
+        taps = qMax(taps, count[i]);
+    }
+
+    auto table = new ScaleTable;
+    table->m_taps = taps;
+    table->m_start.resize(dstSize);
+    table->m_weights.fill(0, dstSize * taps);
+
+    for (int i = 0; i < dstSize; i++) {
+        // All the rows have the same number of taps, move the window back
+        // when it goes past the end, the extra taps get zero weight.
+        int first = qMin(start[i], srcSize - taps);
+        int offset = start[i] - first;
+        qint16 *weight = table->m_weights.data() + i * taps + offset;
+        int sum = 0;
+        int maxTap = 0;
+
+        for (int j = 0; j < count[i]; j++) {
+            weight[j] = qint16(qRound(weights[i][j] * (1 << WEIGHT_SHIFT)));
+            sum += weight[j];
+
+            if (weight[j] > weight[maxTap])
+                maxTap = j;
+        }
+
+        // Put the rounding error in the largest weight, so flat areas keep
+        // its value.
+        weight[maxTap] = qint16(weight[maxTap] + (1 << WEIGHT_SHIFT) - sum);
+        table->m_start[i] = first;
+    }
+
+    return table;
+}
+
+qreal ScaleTable::filter(AkVideoScaler::ScalingMode mode, qreal x)
+{
+    x = qAbs(x);
+
+    switch (mode) {
+    case AkVideoScaler::ScalingMode_Area:
+        return x < 0.5? 1.0: 0.0;
+    case AkVideoScaler::ScalingMode_Bicubic: {
+        // Keys cubic convolution with a = -0.5.
+        const qreal a = -0.5;
+
+        if (x < 1.0)
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+
+        if (x < 2.0)
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+
+        return 0.0;
+    }
+    default:
+        return x < 1.0? 1.0 - x: 0.0;
+    }
+}
+
+qreal ScaleTable::support(AkVideoScaler::ScalingMode mode)
+{
+    switch (mode) {
+    case AkVideoScaler::ScalingMode_Area:
+        return 0.5;
+    case AkVideoScaler::ScalingMode_Bicubic:
+        return 2.0;
+    default:
+        return 1.0;
+    }
+}
+
+#include "moc_akvideoscaler.cpp"
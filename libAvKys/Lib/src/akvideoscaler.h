@@ -0,0 +1,89 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef AKVIDEOSCALER_H
+#define AKVIDEOSCALER_H
+
+#include <QImage>
+
+#include "akvideocaps.h"
+
+class AkVideoScalerPrivate;
+class AkVideoPacket;
+
+// Resizes raw video frames and images.
+//
+// The scaler works with the 8 bits per component RGB formats, gray, and the
+// planar YUV formats. In QImage it supports the 32 bits RGB formats,
+// Format_RGB888 and Format_Grayscale8; other formats are scaled with
+// QImage::scaled.
+class AKCOMMONS_EXPORT AkVideoScaler: public QObject
+{
+    Q_OBJECT
+    Q_ENUMS(ScalingMode)
+    Q_PROPERTY(ScalingMode scalingMode
+               READ scalingMode
+               WRITE setScalingMode
+               RESET resetScalingMode
+               NOTIFY scalingModeChanged)
+
+    public:
+        enum ScalingMode
+        {
+            ScalingMode_Nearest,
+            ScalingMode_Bilinear,
+            ScalingMode_Area,
+            ScalingMode_Bicubic
+        };
+
+        explicit AkVideoScaler(QObject *parent=nullptr);
+        AkVideoScaler(ScalingMode scalingMode, QObject *parent=nullptr);
+        ~AkVideoScaler();
+
+        Q_INVOKABLE ScalingMode scalingMode() const;
+
+        Q_INVOKABLE AkVideoPacket scale(const AkVideoPacket &packet,
+                                        const QSize &size) const;
+        Q_INVOKABLE AkVideoPacket scale(const AkVideoPacket &packet,
+                                        int width,
+                                        int height) const;
+        Q_INVOKABLE QImage scale(const QImage &image,
+                                 const QSize &size) const;
+        Q_INVOKABLE QImage scale(const QImage &image,
+                                 int width,
+                                 int height) const;
+
+        Q_INVOKABLE static bool canScale(AkVideoCaps::PixelFormat format);
+        static bool canScale(QImage::Format format);
+        Q_INVOKABLE static void clearCache();
+
+    private:
+        AkVideoScalerPrivate *d;
+
+    Q_SIGNALS:
+        void scalingModeChanged(ScalingMode scalingMode);
+
+    public Q_SLOTS:
+        void setScalingMode(ScalingMode scalingMode);
+        void resetScalingMode();
+};
+
+Q_DECLARE_METATYPE(AkVideoScaler::ScalingMode)
+
+#endif // AKVIDEOSCALER_H
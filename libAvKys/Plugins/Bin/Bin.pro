@@ -31,6 +31,7 @@ CONFIG += plugin
 HEADERS = \
     src/bin.h \
     src/binelement.h \
+    src/fusedelement.h \
     src/pipeline.h
 
 INCLUDEPATH += \
@@ -46,6 +47,7 @@ QT += qml
 SOURCES = \
     src/bin.cpp \
     src/binelement.cpp \
+    src/fusedelement.cpp \
     src/pipeline.cpp
 
 DESTDIR = $${OUT_PWD}
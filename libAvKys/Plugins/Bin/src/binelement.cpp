@@ -157,7 +157,7 @@ AkPacket BinElement::iStream(const AkPacket &packet)
 {
     if (!this->d->m_description.isEmpty())
         for (const AkElementPtr &element: this->d->m_inputs)
-            element->iStream(packet);
+            (*element)(packet);
     else if (!this->d->m_blocking)
         akSend(packet)
 
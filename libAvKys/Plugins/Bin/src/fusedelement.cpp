@@ -0,0 +1,53 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <akpacket.h>
+#include <akpointoperator.h>
+
+#include "fusedelement.h"
+
+FusedElement::FusedElement(const QList<AkElementPtr> &elements):
+    AkElement(),
+    m_elements(elements)
+{
+}
+
+QList<AkElementPtr> FusedElement::elements() const
+{
+    return this->m_elements;
+}
+
+AkPointOperator FusedElement::pointOperator() const
+{
+    auto pointOperator = AkPointOperator::identity();
+
+    for (const AkElementPtr &element: this->m_elements)
+        pointOperator = pointOperator.then(element->pointOperator());
+
+    return pointOperator;
+}
+
+AkPacket FusedElement::iStream(const AkPacket &packet)
+{
+    auto oPacket = AkPointOperator::run(this->m_elements, packet);
+
+    akSend(oPacket)
+}
+
+#include "moc_fusedelement.cpp"
@@ -0,0 +1,46 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef FUSEDELEMENT_H
+#define FUSEDELEMENT_H
+
+#include <akelement.h>
+
+// Runs a chain of point operators linked one after the other in the
+// pipeline, taking the place of the whole chain in the links. The frames are
+// processed with AkPointOperator::run(), so if fusion is disabled or an
+// element stops being a point operator, the elements are called one by one.
+class FusedElement: public AkElement
+{
+    Q_OBJECT
+
+    public:
+        explicit FusedElement(const QList<AkElementPtr> &elements);
+
+        QList<AkElementPtr> elements() const;
+        AkPointOperator pointOperator() const;
+
+    private:
+        QList<AkElementPtr> m_elements;
+
+    public slots:
+        AkPacket iStream(const AkPacket &packet);
+};
+
+#endif // FUSEDELEMENT_H
@@ -33,8 +33,11 @@
 #include <QUrl>
 #include <QBitArray>
 #include <akfrac.h>
+#include <akqueuedlink.h>
+#include <akpointoperator.h>
 
 #include "pipeline.h"
+#include "fusedelement.h"
 
 class PipelinePrivate
 {
@@ -45,10 +48,21 @@ class PipelinePrivate
         QVariantMap m_properties;
         QString m_error;
 
+        // Chains of point operators replaced by a FusedElement, indexed by
+        // the name of the first element, the last one, and every element.
+        QMap<QString, AkElementPtr> m_fusedHeads;
+        QMap<QString, AkElementPtr> m_fusedTails;
+        QMap<QString, AkElementPtr> m_fusedElements;
+
         inline QMetaMethod methodByName(QObject *object,
                                         const QString &methodName,
                                         QMetaMethod::MethodType methodType);
         inline QVariant solveProperty(const QVariant &property) const;
+        inline QString connectionType(const QJsonObject &connection) const;
+        inline void fuseElements();
+        inline bool isFusedLink(const QStringList &link) const;
+        inline AkElementPtr linkSource(const QString &elementName) const;
+        inline AkElementPtr linkSink(const QString &elementName) const;
 };
 
 Pipeline::Pipeline(QObject *parent):
@@ -217,13 +231,24 @@ bool Pipeline::parse(const QString &description)
                             pipeStr << ref + ".";
                         } else
                             pipeStr << ref;
+                    } else if (elementObject.contains("connectionType")) {
+                        if (element == pipeArray.size() - 1) {
+                            this->d->m_error =
+                                    QString("Error: Connection type to nothing: %1")
+                                    .arg(elementObject["connectionType"].toString());
+
+                            return false;
+                        }
+
+                        pipeStr << this->d->connectionType(elementObject) + "?";
                     } else {
                         QString error;
                         QDebug debug(&error);
 
                         debug.nospace() << "Error: Malformed element, "
-                                           "must contain 'pluginId' or "
-                                           "'alias' key: " << elementObject;
+                                           "must contain 'pluginId', "
+                                           "'alias' or 'connectionType' key: "
+                                        << elementObject;
 
                         this->d->m_error = error;
 
@@ -314,6 +339,13 @@ QString Pipeline::addElement(const AkElementPtr &element)
 
 void Pipeline::removeElement(const QString &elementName)
 {
+    // Removing an element breaks its fused chain, so the pipeline is linked
+    // again without it.
+    bool relink = this->d->m_fusedElements.contains(elementName);
+
+    if (relink)
+        this->unlinkAll();
+
     auto connections = this->d->m_connections;
 
     for (const QStringList &connection: connections)
@@ -338,11 +370,18 @@ void Pipeline::removeElement(const QString &elementName)
     for (const QStringList &link: links)
         if (link[0] == elementName
             || link[1] == elementName) {
-            this->d->m_elements[link[0]]->unlink(this->d->m_elements[link[1]]);
+            if (!relink
+                && link[0] != "IN."
+                && link[1] != "OUT.")
+                this->d->linkSource(link[0])->unlink(this->d->linkSink(link[1]));
+
             this->d->m_links.removeOne(link);
         }
 
     this->d->m_elements.remove(elementName);
+
+    if (relink)
+        this->linkAll();
 }
 
 QList<AkElementPtr> Pipeline::inputs() const
@@ -351,7 +390,7 @@ QList<AkElementPtr> Pipeline::inputs() const
 
     for (const QStringList &link: this->d->m_links)
         if (link[0] == "IN.")
-            inputs << this->d->m_elements[link[1]];
+            inputs << this->d->linkSink(link[1]);
 
     return inputs;
 }
@@ -362,7 +401,7 @@ QList<AkElementPtr> Pipeline::outputs() const
 
     for (const QStringList &link: this->d->m_links)
         if (link[1] == "OUT.")
-            outputs << this->d->m_elements[link[0]];
+            outputs << this->d->linkSource(link[0]);
 
     return outputs;
 }
@@ -654,30 +693,138 @@ QVariant PipelinePrivate::solveProperty(const QVariant &property) const
     return QVariant(QVariantList());
 }
 
+// A connection between elements can be given as an object, the
+// "QueuedLink" connection type accepts the queue depth and the drop policy
+// ("DropOldest", "DropNewest" or "Block"):
+//
+// {"connectionType": "QueuedLink", "depth": 4, "dropPolicy": "DropOldest"}
+QString PipelinePrivate::connectionType(const QJsonObject &connection) const
+{
+    auto connectionType = connection["connectionType"].toString();
+
+    if (connectionType != "QueuedLink")
+        return connectionType;
+
+    return QString("%1:%2:%3")
+            .arg(connectionType)
+            .arg(connection["depth"].toInt(8))
+            .arg(connection["dropPolicy"].toString("DropOldest"));
+}
+
+void PipelinePrivate::fuseElements()
+{
+    this->m_fusedHeads.clear();
+    this->m_fusedTails.clear();
+    this->m_fusedElements.clear();
+
+    if (!AkPointOperator::fusionEnabled())
+        return;
+
+    QMap<QString, int> inputs;
+    QMap<QString, int> outputs;
+
+    for (const QStringList &link: this->m_links) {
+        outputs[link[0]]++;
+        inputs[link[1]]++;
+    }
+
+    // An element can be fused with the next one only if the link between them
+    // is direct and is the only path for the frames.
+    QMap<QString, QString> next;
+
+    for (const QStringList &link: this->m_links) {
+        auto connectionType = link.value(2, "AutoConnection");
+
+        if (connectionType != "AutoConnection"
+            && connectionType != "DirectConnection")
+            continue;
+
+        auto src = this->m_elements.value(link[0]);
+        auto dst = this->m_elements.value(link[1]);
+
+        if (src && dst
+            && outputs[link[0]] == 1
+            && inputs[link[1]] == 1
+            && src->pointOperator()
+            && dst->pointOperator())
+            next[link[0]] = link[1];
+    }
+
+    auto values = next.values();
+
+    for (auto it = next.begin(); it != next.end(); it++) {
+        // Start only at the first element of the chain.
+        if (values.contains(it.key()))
+            continue;
+
+        QStringList chain {it.key()};
+        QList<AkElementPtr> elements {this->m_elements[it.key()]};
+
+        for (auto element = next.value(it.key());
+             !element.isEmpty();
+             element = next.value(element)) {
+            chain << element;
+            elements << this->m_elements[element];
+        }
+
+        AkElementPtr fused(new FusedElement(elements));
+        this->m_fusedHeads[chain.first()] = fused;
+        this->m_fusedTails[chain.last()] = fused;
+
+        for (const QString &element: chain)
+            this->m_fusedElements[element] = fused;
+    }
+}
+
+bool PipelinePrivate::isFusedLink(const QStringList &link) const
+{
+    auto fused = this->m_fusedElements.value(link[0]);
+
+    return fused
+           && fused == this->m_fusedElements.value(link[1])
+           && !this->m_fusedTails.contains(link[0]);
+}
+
+AkElementPtr PipelinePrivate::linkSource(const QString &elementName) const
+{
+    auto fused = this->m_fusedTails.value(elementName);
+
+    return fused? fused: this->m_elements.value(elementName);
+}
+
+AkElementPtr PipelinePrivate::linkSink(const QString &elementName) const
+{
+    auto fused = this->m_fusedHeads.value(elementName);
+
+    return fused? fused: this->m_elements.value(elementName);
+}
+
 void Pipeline::addLinks(const QStringList &links)
 {
     QStringList link;
-    QString connectionType = "AutoConnection";
+    QStringList connectionType {"AutoConnection"};
 
     for (QString element:  links) {
         if (element.endsWith("?"))
-            connectionType = element.remove("?");
+            connectionType = element.remove("?").split(':');
         else
             link << element;
 
         if (link.length() == 2) {
-            link << connectionType;
-            this->d->m_links << link;
+            this->d->m_links << link + connectionType;
             link.removeFirst();
-            link.removeLast();
         }
     }
 }
 
 bool Pipeline::linkAll()
 {
+    this->d->fuseElements();
+
     for (const QStringList &link: this->d->m_links)
-        if (link[0] != "IN." && link[1] != "OUT.") {
+        if (link[0] != "IN."
+            && link[1] != "OUT."
+            && !this->d->isFusedLink(link)) {
             if (!this->d->m_elements.contains(link[0])) {
                 this->d->m_error =
                         QString("No element named '%1'").arg(link[0]);
@@ -696,6 +843,18 @@ bool Pipeline::linkAll()
                 else
                     connectionTypeString = "AutoConnection";
 
+                if (connectionTypeString == "QueuedLink") {
+                    int depth = link.value(3).toInt();
+                    auto dropPolicy =
+                            AkQueuedLink::dropPolicyFromString(link.value(4));
+                    AkQueuedLink::link(this->d->linkSource(link[0]).data(),
+                                       this->d->linkSink(link[1]).data(),
+                                       depth > 0? depth: 8,
+                                       dropPolicy);
+
+                    continue;
+                }
+
                 int index = this->staticQtMetaObject.indexOfEnumerator("ConnectionType");
                 QMetaEnum enumerator = this->staticQtMetaObject.enumerator(index);
 
@@ -711,8 +870,8 @@ bool Pipeline::linkAll()
 
                 Qt::ConnectionType connectionType = static_cast<Qt::ConnectionType>(value);
 
-                this->d->m_elements[link[0]]->link(this->d->m_elements[link[1]],
-                        connectionType);
+                this->d->linkSource(link[0])->link(this->d->linkSink(link[1]),
+                                                   connectionType);
             }
         }
 
@@ -723,7 +882,8 @@ bool Pipeline::unlinkAll()
 {
     for (const QStringList &link: this->d->m_links)
         if (link[0] != "IN."
-            && link[1] != "OUT.") {
+            && link[1] != "OUT."
+            && !this->d->isFusedLink(link)) {
             if (!this->d->m_elements.contains(link[0])) {
                 this->d->m_error =
                         QString("No element named '%1'").arg(link[0]);
@@ -735,9 +895,13 @@ bool Pipeline::unlinkAll()
 
                 return false;
             } else
-                this->d->m_elements[link[0]]->unlink(this->d->m_elements[link[1]]);
+                this->d->linkSource(link[0])->unlink(this->d->linkSink(link[1]));
         }
 
+    this->d->m_fusedHeads.clear();
+    this->d->m_fusedTails.clear();
+    this->d->m_fusedElements.clear();
+
     return true;
 }
 
@@ -35,8 +35,7 @@ CONFIG += plugin
 
 HEADERS = \
     src/blur.h \
-    src/blurelement.h \
-    src/pixel.h
+    src/blurelement.h
 
 INCLUDEPATH += \
     ../../Lib/src
@@ -56,4 +56,17 @@ GridLayout {
 
         onRvalueChanged: Blur.radius = rvalue
     }
+
+    // Gaussian
+    Label {
+        text: qsTr("Gaussian")
+    }
+    CheckBox {
+        id: chkGaussian
+        checked: Blur.gaussian
+
+        onCheckedChanged: Blur.gaussian = checked
+    }
+    Label {
+    }
 }
@@ -19,25 +19,264 @@
 
 #include <QImage>
 #include <QQmlContext>
+#include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
+#include <aksimd.h>
 #include <akpacket.h>
 
 #include "blurelement.h"
-#include "pixel.h"
+
+#ifdef AK_SIMD_X86
+    #define BLUR_SIMD
+    #include <immintrin.h>
+#endif
+
+// Minimum number of rows processed by a thread.
+#define MIN_BAND_HEIGHT 16
+
+// Number of box blurs approximating a gaussian blur.
+#define GAUSSIAN_PASSES 3
+
+// The box blur is done a band of lines at a time. Each band keeps the sums
+// of the lines in the window for every column, and slides them down one line
+// per output line. Then a window slides along the column sums giving the sum
+// of the box for every pixel. Every byte of a line is summed independently,
+// so the four ARGB components are blurred the same way.
+
+// Calculates mul and shift so that value / divisor is equal to
+// (value * mul) >> shift for every value up to 255 * divisor, as described
+// in "Division by Invariant Integers using Multiplication" by Granlund and
+// Montgomery. Returns false if mul doesn't fit in 32 bits.
+static inline bool reciprocal(quint32 divisor, quint32 *mul, int *shift)
+{
+    quint64 maxValue = 255 * quint64(divisor);
+    int valueBits = 0;
+
+    while ((quint64(1) << valueBits) <= maxValue)
+        valueBits++;
+
+    if (valueBits > 31)
+        return false;
+
+    int divisorBits = 0;
+
+    while ((quint64(1) << divisorBits) < divisor)
+        divisorBits++;
+
+    *shift = valueBits + divisorBits;
+    *mul = quint32(((quint64(1) << *shift) + divisor - 1) / divisor);
+
+    return true;
+}
+
+// Scalar kernels
+
+template<bool subtract>
+static void accumulateScalar(quint32 *sums, const quint8 *line, int size)
+{
+    if (subtract) {
+        for (int i = 0; i < size; i++)
+            sums[i] -= line[i];
+    } else {
+        for (int i = 0; i < size; i++)
+            sums[i] += line[i];
+    }
+}
+
+// Slides the window from begin to end - 1, where it fits completely in the
+// line.
+static void blurSpanScalar(const quint32 *sums,
+                           quint32 *windowSum,
+                           quint8 *dst,
+                           int begin,
+                           int end,
+                           int radius,
+                           quint32 mul,
+                           int shift)
+{
+    for (int x = begin; x < end; x++) {
+        const quint32 *in = sums + 4 * (x + radius);
+        const quint32 *out = sums + 4 * (x - radius - 1);
+
+        for (int c = 0; c < 4; c++) {
+            windowSum[c] += in[c] - out[c];
+            dst[4 * x + c] = quint8((quint64(windowSum[c]) * mul) >> shift);
+        }
+    }
+}
+
+#ifdef BLUR_SIMD
+// SSE2 kernels
+
+template<bool subtract>
+AK_SIMD_TARGET("sse2")
+static void accumulateSSE2(quint32 *sums, const quint8 *line, int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + i));
+        __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+        __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+        __m128i values[4] = {
+            _mm_unpacklo_epi16(lo, zero),
+            _mm_unpackhi_epi16(lo, zero),
+            _mm_unpacklo_epi16(hi, zero),
+            _mm_unpackhi_epi16(hi, zero),
+        };
+
+        for (int k = 0; k < 4; k++) {
+            auto sumsPtr = reinterpret_cast<__m128i *>(sums + i + 4 * k);
+            __m128i sum = _mm_loadu_si128(sumsPtr);
+
+            if (subtract)
+                sum = _mm_sub_epi32(sum, values[k]);
+            else
+                sum = _mm_add_epi32(sum, values[k]);
+
+            _mm_storeu_si128(sumsPtr, sum);
+        }
+    }
+
+    accumulateScalar<subtract>(sums + i, line + i, size - i);
+}
+
+// The four components of a pixel are divided at once, _mm_mul_epu32()
+// multiplies the components 0 and 2, and gives 64 bits results.
+AK_SIMD_TARGET("sse2")
+static void blurSpanSSE2(const quint32 *sums,
+                         quint32 *windowSum,
+                         quint8 *dst,
+                         int begin,
+                         int end,
+                         int radius,
+                         quint32 mul,
+                         int shift)
+{
+    const __m128i mulValue = _mm_set1_epi32(int(mul));
+    const __m128i shiftValue = _mm_cvtsi32_si128(shift);
+    __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i *>(windowSum));
+
+    for (int x = begin; x < end; x++) {
+        sum = _mm_add_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + 4 * (x + radius))));
+        sum = _mm_sub_epi32(sum, _mm_loadu_si128(reinterpret_cast<const __m128i *>(sums + 4 * (x - radius - 1))));
+        __m128i even = _mm_srl_epi64(_mm_mul_epu32(sum, mulValue), shiftValue);
+        __m128i odd = _mm_srl_epi64(_mm_mul_epu32(_mm_srli_epi64(sum, 32), mulValue), shiftValue);
+        __m128i mean = _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+        mean = _mm_packs_epi32(mean, mean);
+        mean = _mm_packus_epi16(mean, mean);
+        int pixel = _mm_cvtsi128_si32(mean);
+        memcpy(dst + 4 * x, &pixel, sizeof(int));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(windowSum), sum);
+}
+
+// AVX2 kernels
+
+template<bool subtract>
+AK_SIMD_TARGET("avx2")
+static void accumulateAVX2(quint32 *sums, const quint8 *line, int size)
+{
+    int i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(line + i));
+        __m256i values[2] = {
+            _mm256_cvtepu8_epi32(bytes),
+            _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)),
+        };
+
+        for (int k = 0; k < 2; k++) {
+            auto sumsPtr = reinterpret_cast<__m256i *>(sums + i + 8 * k);
+            __m256i sum = _mm256_loadu_si256(sumsPtr);
+
+            if (subtract)
+                sum = _mm256_sub_epi32(sum, values[k]);
+            else
+                sum = _mm256_add_epi32(sum, values[k]);
+
+            _mm256_storeu_si256(sumsPtr, sum);
+        }
+    }
+
+    accumulateScalar<subtract>(sums + i, line + i, size - i);
+}
+#endif
+
+struct BlurKernels
+{
+    void (*add)(quint32 *sums, const quint8 *line, int size);
+    void (*subtract)(quint32 *sums, const quint8 *line, int size);
+    void (*blurSpan)(const quint32 *sums,
+                     quint32 *windowSum,
+                     quint8 *dst,
+                     int begin,
+                     int end,
+                     int radius,
+                     quint32 mul,
+                     int shift);
+
+    static BlurKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        BlurKernels kernels = {
+            accumulateScalar<false>,
+            accumulateScalar<true>,
+            blurSpanScalar
+        };
+
+#ifdef BLUR_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_SSE2) {
+            kernels.add = accumulateSSE2<false>;
+            kernels.subtract = accumulateSSE2<true>;
+            kernels.blurSpan = blurSpanSSE2;
+        }
+
+        if (instructionSet >= AkSimd::InstructionSet_AVX2) {
+            kernels.add = accumulateAVX2<false>;
+            kernels.subtract = accumulateAVX2<true>;
+        }
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
 
 class BlurElementPrivate
 {
     public:
         int m_radius;
+        bool m_gaussian;
 
         BlurElementPrivate():
-            m_radius(5)
+            m_radius(5),
+            m_gaussian(false)
         {
         }
 
-        inline void integralImage(const QImage &image,
-                                  int oWidth, int oHeight,
-                                  PixelU32 *integral);
+        inline static void gaussianRadii(int radius, int *radii);
+        inline static void blurPixel(const quint32 *sums,
+                                     quint32 *windowSum,
+                                     quint8 *dst,
+                                     int x,
+                                     int width,
+                                     int radius,
+                                     quint32 kh);
+        inline static void blurLine(const BlurKernels &kernels,
+                                    const quint32 *sums,
+                                    quint8 *dst,
+                                    int width,
+                                    int radius,
+                                    quint32 kh);
+        static void boxBlur(const BlurKernels &kernels,
+                            const QImage &src,
+                            QImage &dst,
+                            int radius);
 };
 
 BlurElement::BlurElement():
@@ -56,33 +295,139 @@ int BlurElement::radius() const
     return this->d->m_radius;
 }
 
-void BlurElementPrivate::integralImage(const QImage &image,
-                                       int oWidth, int oHeight,
-                                       PixelU32 *integral)
+bool BlurElement::gaussian() const
+{
+    return this->d->m_gaussian;
+}
+
+// Radii of the box blurs approximating a gaussian blur with the same
+// variance of the box blur of the given radius.
+void BlurElementPrivate::gaussianRadii(int radius, int *radii)
+{
+    qreal variance = radius * (radius + 1) / 3.0;
+    int passes = GAUSSIAN_PASSES;
+    int lower = int(qSqrt(12 * variance / passes + 1));
+
+    if (lower % 2 == 0)
+        lower--;
+
+    int upper = lower + 2;
+    qreal lowerPasses = (12 * variance
+                         - passes * lower * lower
+                         - 4 * passes * lower
+                         - 3 * passes)
+                        / (-4 * lower - 4);
+
+    for (int i = 0; i < passes; i++)
+        radii[i] = ((i < qRound(lowerPasses)? lower: upper) - 1) / 2;
+}
+
+// Slides the window one pixel and divides the sums, used for the borders
+// where the window size changes.
+void BlurElementPrivate::blurPixel(const quint32 *sums,
+                                   quint32 *windowSum,
+                                   quint8 *dst,
+                                   int x,
+                                   int width,
+                                   int radius,
+                                   quint32 kh)
+{
+    if (x > 0) {
+        if (x + radius < width)
+            for (int c = 0; c < 4; c++)
+                windowSum[c] += sums[4 * (x + radius) + c];
+
+        if (x - radius - 1 >= 0)
+            for (int c = 0; c < 4; c++)
+                windowSum[c] -= sums[4 * (x - radius - 1) + c];
+    }
+
+    int xp = qMax(x - radius, 0);
+    quint32 ks = quint32(qMin(x + radius, width - 1) - xp + 1) * kh;
+
+    for (int c = 0; c < 4; c++)
+        dst[4 * x + c] = quint8(windowSum[c] / ks);
+}
+
+void BlurElementPrivate::blurLine(const BlurKernels &kernels,
+                                  const quint32 *sums,
+                                  quint8 *dst,
+                                  int width,
+                                  int radius,
+                                  quint32 kh)
 {
-    for (int y = 1; y < oHeight; y++) {
-        auto line = reinterpret_cast<const QRgb *>(image.constScanLine(y - 1));
+    quint32 windowSum[4] = {0, 0, 0, 0};
 
-        // Reset current line summation.
-        PixelU32 sum;
+    for (int x = 0; x <= qMin(radius, width - 1); x++)
+        for (int c = 0; c < 4; c++)
+            windowSum[c] += sums[4 * x + c];
 
-        for (int x = 1; x < oWidth; x++) {
-            QRgb pixel = line[x - 1];
+    // The window fits completely in the line from spanBegin to spanEnd - 1.
+    int spanBegin = qMin(radius + 1, width);
+    int spanEnd = qMax(width - radius, spanBegin);
 
-            // Accumulate pixels in current line.
-            sum += pixel;
+    for (int x = 0; x < spanBegin; x++)
+        blurPixel(sums, windowSum, dst, x, width, radius, kh);
 
-            // Offset to the current line.
-            int offset = x + y * oWidth;
+    quint32 mul = 0;
+    int shift = 0;
 
-            // Offset to the previous line.
-            // equivalent to x + (y - 1) * oWidth;
-            int offsetPrevious = offset - oWidth;
+    if (reciprocal(quint32(2 * radius + 1) * kh, &mul, &shift))
+        kernels.blurSpan(sums, windowSum, dst,
+                         spanBegin, spanEnd,
+                         radius, mul, shift);
+    else
+        for (int x = spanBegin; x < spanEnd; x++)
+            blurPixel(sums, windowSum, dst, x, width, radius, kh);
 
-            // Accumulate current line and previous line.
-            integral[offset] = sum + integral[offsetPrevious];
+    for (int x = spanEnd; x < width; x++)
+        blurPixel(sums, windowSum, dst, x, width, radius, kh);
+}
+
+void BlurElementPrivate::boxBlur(const BlurKernels &kernels,
+                                 const QImage &src,
+                                 QImage &dst,
+                                 int radius)
+{
+    int width = src.width();
+    int height = src.height();
+    int lineSize = 4 * width;
+    auto iBits = src.constBits();
+    int iLineSize = src.bytesPerLine();
+
+    // Don't detach the output frame from the worker threads.
+    auto oBits = dst.bits();
+    int oLineSize = dst.bytesPerLine();
+
+    // Every band sums the window of its first line from scratch, so keep the
+    // bands taller than the window.
+    int bandHeight = qMax(MIN_BAND_HEIGHT, 2 * radius + 1);
+
+    AkScheduler::parallelFor(height, bandHeight, [&] (int begin, int end) {
+        auto sumsBuffer = AkBufferPool::buffer(lineSize * int(sizeof(quint32)));
+        auto sums = sumsBuffer.data<quint32>();
+        memset(sums, 0, size_t(lineSize) * sizeof(quint32));
+
+        for (int y = qMax(begin - radius, 0);
+             y <= qMin(begin + radius, height - 1);
+             y++)
+            kernels.add(sums, iBits + y * iLineSize, lineSize);
+
+        for (int y = begin; y < end; y++) {
+            // Slide the window one line down.
+            if (y > begin) {
+                if (y + radius < height)
+                    kernels.add(sums, iBits + (y + radius) * iLineSize, lineSize);
+
+                if (y - radius - 1 >= 0)
+                    kernels.subtract(sums, iBits + (y - radius - 1) * iLineSize, lineSize);
+            }
+
+            int yp = qMax(y - radius, 0);
+            auto kh = quint32(qMin(y + radius, height - 1) - yp + 1);
+            blurLine(kernels, sums, oBits + y * oLineSize, width, radius, kh);
         }
-    }
+    });
 }
 
 QString BlurElement::controlInterfaceProvide(const QString &controlId) const
@@ -110,11 +455,25 @@ void BlurElement::setRadius(int radius)
     emit this->radiusChanged(radius);
 }
 
+void BlurElement::setGaussian(bool gaussian)
+{
+    if (this->d->m_gaussian == gaussian)
+        return;
+
+    this->d->m_gaussian = gaussian;
+    emit this->gaussianChanged(gaussian);
+}
+
 void BlurElement::resetRadius()
 {
     this->setRadius(5);
 }
 
+void BlurElement::resetGaussian()
+{
+    this->setGaussian(false);
+}
+
 AkPacket BlurElement::iStream(const AkPacket &packet)
 {
     QImage src = AkUtils::packetToImage(packet);
@@ -123,33 +482,35 @@ AkPacket BlurElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    int radius = this->d->m_radius;
 
-    int oWidth = src.width() + 1;
-    int oHeight = src.height() + 1;
-    PixelU32 *integral = new PixelU32[oWidth * oHeight];
-    this->d->integralImage(src, oWidth, oHeight, integral);
+    if (radius < 1) {
+        AkPacket oPacket = AkUtils::imageToPacket(src, packet);
+        akSend(oPacket)
+    }
 
-    int radius = this->d->m_radius;
+    int radii[GAUSSIAN_PASSES];
+    int passes = 1;
 
-    for (int y = 0; y < src.height(); y++) {
-        QRgb *oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-        int yp = qMax(y - radius, 0);
-        int kh = qMin(y + radius, src.height() - 1) - yp + 1;
+    if (this->d->m_gaussian) {
+        BlurElementPrivate::gaussianRadii(radius, radii);
+        passes = GAUSSIAN_PASSES;
+    } else {
+        radii[0] = radius;
+    }
 
-        for (int x = 0; x < src.width(); x++) {
-            int xp = qMax(x - radius, 0);
-            int kw = qMin(x + radius, src.width() - 1) - xp + 1;
+    auto kernels = BlurKernels::byInstructionSet(AkSimd::instructionSet());
+    QImage oFrame = src;
 
-            PixelU32 sum = integralSum(integral, oWidth, xp, yp, kw, kh);
-            PixelU32 mean = sum / quint32(kw * kh);
+    for (int i = 0; i < passes; i++) {
+        if (radii[i] < 1)
+            continue;
 
-            oLine[x] = qRgba(int(mean.r), int(mean.g), int(mean.b), int(mean.a));
-        }
+        QImage frame = AkBufferPool::image(src.size(), src.format());
+        BlurElementPrivate::boxBlur(kernels, oFrame, frame, radii[i]);
+        oFrame = frame;
     }
 
-    delete [] integral;
-
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
 }
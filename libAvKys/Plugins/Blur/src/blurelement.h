@@ -32,12 +32,18 @@ class BlurElement: public AkElement
                WRITE setRadius
                RESET resetRadius
                NOTIFY radiusChanged)
+    Q_PROPERTY(bool gaussian
+               READ gaussian
+               WRITE setGaussian
+               RESET resetGaussian
+               NOTIFY gaussianChanged)
 
     public:
         explicit BlurElement();
         ~BlurElement();
 
         Q_INVOKABLE int radius() const;
+        Q_INVOKABLE bool gaussian() const;
 
     private:
         BlurElementPrivate *d;
@@ -49,10 +55,13 @@ class BlurElement: public AkElement
 
     signals:
         void radiusChanged(int radius);
+        void gaussianChanged(bool gaussian);
 
     public slots:
         void setRadius(int radius);
+        void setGaussian(bool gaussian);
         void resetRadius();
+        void resetGaussian();
         AkPacket iStream(const AkPacket &packet);
 };
 
@@ -24,7 +24,10 @@
 #include <QMutex>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
+#include <akvideoscaler.h>
 
 #include "cartoonelement.h"
 
@@ -42,6 +45,7 @@ class CartoonElementPrivate
         qint64 m_id;
         qint64 m_lastTime;
         QMutex m_mutex;
+        AkVideoScaler m_scaler;
 
         CartoonElementPrivate():
             m_ncolors(8),
@@ -52,7 +56,8 @@ class CartoonElementPrivate
             m_lineColor(qRgb(0, 0, 0)),
             m_scanSize(QSize(320, 240)),
             m_id(-1),
-            m_lastTime(0)
+            m_lastTime(0),
+            m_scaler(AkVideoScaler::ScalingMode_Nearest)
         {
         }
 
@@ -449,7 +454,7 @@ AkPacket CartoonElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (this->d->m_id != packet.id()) {
         this->d->m_id = packet.id();
@@ -458,18 +463,27 @@ AkPacket CartoonElement::iStream(const AkPacket &packet)
     }
 
     // Palettize image.
+    QImage scanFrame =
+            this->d->m_scaler.scale(src,
+                                    src.size().scaled(scanSize,
+                                                      Qt::KeepAspectRatio));
     QVector<QRgb> palette =
-            this->d->palette(src.scaled(scanSize, Qt::KeepAspectRatio),
+            this->d->palette(scanFrame,
                              this->d->m_ncolors,
                              this->d->m_colorDiff);
 
-    for (int y = 0; y < src.height(); y++) {
-        const QRgb *srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *dstLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-        for (int x = 0; x < src.width(); x++)
-            dstLine[x] = palette[this->d->rgb24Torgb16(srcLine[x])];
-    }
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const QRgb *srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+            QRgb *dstLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
+
+            for (int x = 0; x < src.width(); x++)
+                dstLine[x] = palette[this->d->rgb24Torgb16(srcLine[x])];
+        }
+    });
 
     // Draw the edges.
     if (this->d->m_showEdges) {
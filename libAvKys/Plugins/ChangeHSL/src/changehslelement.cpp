@@ -21,6 +21,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "changehslelement.h"
@@ -109,7 +110,7 @@ AkPacket ChangeHSLElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     QVector<qreal> kernel = this->d->m_kernel;
 
     for (int y = 0; y < src.height(); y++) {
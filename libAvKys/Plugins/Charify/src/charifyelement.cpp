@@ -22,7 +22,9 @@
 #include <QQmlContext>
 #include <QMutex>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
+#include <akvideoscaler.h>
 
 #include "charifyelement.h"
 
@@ -98,6 +100,7 @@ class CharifyElementPrivate
         QVector<Character> m_characters;
         QSize m_fontSize;
         QMutex m_mutex;
+        AkVideoScaler m_scaler;
         bool m_reversed;
 
         CharifyElementPrivate():
@@ -105,6 +108,7 @@ class CharifyElementPrivate
             m_font(QApplication::font()),
             m_foregroundColor(qRgb(255, 255, 255)),
             m_backgroundColor(qRgb(0, 0, 0)),
+            m_scaler(AkVideoScaler::ScalingMode_Nearest),
             m_reversed(false)
         {
         }
@@ -436,16 +440,16 @@ AkPacket CharifyElement::iStream(const AkPacket &packet)
     int outWidth = textWidth * fontSize.width();
     int outHeight = textHeight * fontSize.height();
 
-    QImage oFrame(outWidth, outHeight, src.format());
+    QImage oFrame = AkBufferPool::image(outWidth, outHeight, src.format());
 
     if (characters.isEmpty()) {
-        oFrame.fill(qRgb(0, 0, 0));
-        auto oPacket = AkUtils::imageToPacket(oFrame.scaled(src.size()),
-                                              packet);
+        QImage blackFrame = AkBufferPool::image(src.size(), src.format());
+        blackFrame.fill(qRgb(0, 0, 0));
+        auto oPacket = AkUtils::imageToPacket(blackFrame, packet);
         akSend(oPacket)
     }
 
-    QImage textImage = src.scaled(textWidth, textHeight);
+    QImage textImage = this->d->m_scaler.scale(src, textWidth, textHeight);
     const QRgb *textImageBits = reinterpret_cast<const QRgb *>(textImage.constBits());
     int textArea = textImage.width() * textImage.height();
     QPainter painter;
@@ -21,6 +21,7 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "cinemaelement.h"
@@ -93,7 +94,7 @@ AkPacket CinemaElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     int cy = src.height() >> 1;
 
     for (int y = 0; y < src.height(); y++) {
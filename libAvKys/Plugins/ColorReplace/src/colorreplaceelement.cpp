@@ -21,6 +21,7 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "colorreplaceelement.h"
@@ -136,7 +137,7 @@ AkPacket ColorReplaceElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     for (int y = 0; y < src.height(); y++) {
         const QRgb *srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
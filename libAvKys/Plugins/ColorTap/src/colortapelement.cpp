@@ -22,7 +22,9 @@
 #include <QQmlContext>
 #include <QStandardPaths>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
+#include <akvideoscaler.h>
 
 #include "colortapelement.h"
 
@@ -32,13 +34,20 @@ class ColorTapElementPrivate
         QImage m_table;
         QString m_tableName;
         QMutex m_mutex;
+        AkVideoScaler m_scaler;
+
+        ColorTapElementPrivate():
+            m_scaler(AkVideoScaler::ScalingMode_Nearest)
+        {
+        }
 };
 
 ColorTapElement::ColorTapElement(): AkElement()
 {
     this->d = new ColorTapElementPrivate;
     this->d->m_tableName = ":/ColorTap/share/tables/base.bmp";
-    this->d->m_table = QImage(this->d->m_tableName).scaled(16, 16);
+    this->d->m_table = this->d->m_scaler.scale(QImage(this->d->m_tableName),
+                                               16, 16);
 }
 
 ColorTapElement::~ColorTapElement()
@@ -86,7 +95,7 @@ void ColorTapElement::setTable(const QString &table)
                 return;
         } else {
             tableName = table;
-            tableImg = tableImg.scaled(16, 16);
+            tableImg = this->d->m_scaler.scale(tableImg, 16, 16);
         }
     }
 
@@ -120,7 +129,7 @@ AkPacket ColorTapElement::iStream(const AkPacket &packet)
     }
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     auto tableBits = reinterpret_cast<const QRgb *>(this->d->m_table.constBits());
 
     for (int y = 0; y < src.height(); y++) {
@@ -18,10 +18,11 @@
  */
 
 #include <QVector>
-#include <QImage>
 #include <QQmlContext>
-#include <akutils.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
+#include <akpixelview.h>
+#include <akpointoperator.h>
 
 #include "colortransformelement.h"
 
@@ -31,6 +32,27 @@ class ColorTransformElementPrivate
         QVector<qreal> m_kernel;
 };
 
+struct ColorTransformFilter
+{
+    QVector<qreal> m_kernel;
+
+    template<AkVideoCaps::PixelFormat Format>
+    inline void operator ()(const AkConstPixelView<Format> &src,
+                            const AkPixelView<Format> &dst) const
+    {
+        auto kernel = this->m_kernel.constData();
+
+        src.mapRgb(dst, [kernel] (int &r, int &g, int &b) {
+            int rt = int(r * kernel[0] + g * kernel[1] + b * kernel[2]  + kernel[3]);
+            int gt = int(r * kernel[4] + g * kernel[5] + b * kernel[6]  + kernel[7]);
+            int bt = int(r * kernel[8] + g * kernel[9] + b * kernel[10] + kernel[11]);
+            r = rt;
+            g = gt;
+            b = bt;
+        });
+    }
+};
+
 ColorTransformElement::ColorTransformElement(): AkElement()
 {
     this->d = new ColorTransformElementPrivate;
@@ -57,6 +79,16 @@ QVariantList ColorTransformElement::kernel() const
     return kernel;
 }
 
+AkPointOperator ColorTransformElement::pointOperator() const
+{
+    auto kernel = this->d->m_kernel;
+
+    if (kernel.size() < 12)
+        return AkPointOperator::identity();
+
+    return AkPointOperator::fromMatrix(kernel.constData());
+}
+
 QString ColorTransformElement::controlInterfaceProvide(const QString &controlId) const
 {
     Q_UNUSED(controlId)
@@ -103,37 +135,8 @@ AkPacket ColorTransformElement::iStream(const AkPacket &packet)
     if (this->d->m_kernel.size() < 12)
         akSend(packet)
 
-    QImage src = AkUtils::packetToImage(packet);
-
-    if (src.isNull())
-        return AkPacket();
-
-    src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
-    auto kernel = this->d->m_kernel;
-
-    for (int y = 0; y < src.height(); y++) {
-        auto srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        auto dstLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-
-        for (int x = 0; x < src.width(); x++) {
-            int r = qRed(srcLine[x]);
-            int g = qGreen(srcLine[x]);
-            int b = qBlue(srcLine[x]);
-
-            int rt = int(r * kernel[0] + g * kernel[1] + b * kernel[2]  + kernel[3]);
-            int gt = int(r * kernel[4] + g * kernel[5] + b * kernel[6]  + kernel[7]);
-            int bt = int(r * kernel[8] + g * kernel[9] + b * kernel[10] + kernel[11]);
-
-            rt = qBound(0, rt, 255);
-            gt = qBound(0, gt, 255);
-            bt = qBound(0, bt, 255);
-
-            dstLine[x] = qRgba(rt, gt, bt, qAlpha(srcLine[x]));
-        }
-    }
-
-    AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
+    AkPacket oPacket =
+            akPixelMapRgb(packet, ColorTransformFilter {this->d->m_kernel});
     akSend(oPacket)
 }
 
@@ -38,6 +38,7 @@ class ColorTransformElement: public AkElement
         ~ColorTransformElement();
 
         Q_INVOKABLE QVariantList kernel() const;
+        AkPointOperator pointOperator() const;
 
     private:
         ColorTransformElementPrivate *d;
@@ -35,7 +35,8 @@ CONFIG += plugin
 
 HEADERS = \
     src/convolve.h \
-    src/convolveelement.h
+    src/convolveelement.h \
+    src/fft.h
 
 INCLUDEPATH += \
     ../../Lib/src
@@ -51,7 +52,8 @@ RESOURCES += \
 
 SOURCES = \
     src/convolve.cpp \
-    src/convolveelement.cpp
+    src/convolveelement.cpp \
+    src/fft.cpp
 
 lupdate_only {
     SOURCES += $$files(share/qml/*.qml)
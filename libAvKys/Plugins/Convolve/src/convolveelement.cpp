@@ -20,13 +20,209 @@
 #include <QVariant>
 #include <QVector>
 #include <QMutex>
+#include <QSharedPointer>
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
+#include <aksimd.h>
 #include <akfrac.h>
 #include <akpacket.h>
 
 #include "convolveelement.h"
+#include "fft.h"
+
+#ifdef AK_SIMD_X86
+    #define CONVOLVE_SIMD
+    #include <immintrin.h>
+#endif
+
+// Minimum number of rows processed by a thread.
+#define MIN_BAND_HEIGHT 16
+
+// Non separable kernels with at least this number of non zero taps are
+// applied in the frequency domain.
+#define MIN_FFT_TAPS 512
+
+// Smallest FFT used for the frequency domain convolution.
+#define MIN_FFT_SIZE 64
+
+// Multiply-accumulate kernels, acc[x] += weight * src[x].
+
+// Scalar kernels
+
+static void macLine8Scalar(int *acc, const quint8 *src, int weight, int size)
+{
+    for (int x = 0; x < size; x++)
+        acc[x] += weight * src[x];
+}
+
+static void macLine32Scalar(int *acc, const int *src, int weight, int size)
+{
+    for (int x = 0; x < size; x++)
+        acc[x] += weight * src[x];
+}
+
+#ifdef CONVOLVE_SIMD
+// SSE2 kernels
+
+// SSE2 lacks a 32 bits multiplication keeping the low half of the result.
+AK_SIMD_TARGET("sse2")
+static inline __m128i mulLo32SSE2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+AK_SIMD_TARGET("sse2")
+static void macLine8SSE2(int *acc, const quint8 *src, int weight, int size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i w = _mm_set1_epi32(weight);
+    int x = 0;
+
+    for (; x + 8 <= size; x += 8) {
+        __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x)), zero);
+        auto accLo = reinterpret_cast<__m128i *>(acc + x);
+        auto accHi = reinterpret_cast<__m128i *>(acc + x + 4);
+        _mm_storeu_si128(accLo, _mm_add_epi32(_mm_loadu_si128(accLo),
+                                              mulLo32SSE2(_mm_unpacklo_epi16(pixels, zero), w)));
+        _mm_storeu_si128(accHi, _mm_add_epi32(_mm_loadu_si128(accHi),
+                                              mulLo32SSE2(_mm_unpackhi_epi16(pixels, zero), w)));
+    }
+
+    macLine8Scalar(acc + x, src + x, weight, size - x);
+}
+
+AK_SIMD_TARGET("sse2")
+static void macLine32SSE2(int *acc, const int *src, int weight, int size)
+{
+    const __m128i w = _mm_set1_epi32(weight);
+    int x = 0;
+
+    for (; x + 4 <= size; x += 4) {
+        auto accPtr = reinterpret_cast<__m128i *>(acc + x);
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+        _mm_storeu_si128(accPtr, _mm_add_epi32(_mm_loadu_si128(accPtr),
+                                               mulLo32SSE2(values, w)));
+    }
+
+    macLine32Scalar(acc + x, src + x, weight, size - x);
+}
+
+// AVX2 kernels
+
+AK_SIMD_TARGET("avx2")
+static void macLine8AVX2(int *acc, const quint8 *src, int weight, int size)
+{
+    const __m256i w = _mm256_set1_epi32(weight);
+    int x = 0;
+
+    for (; x + 8 <= size; x += 8) {
+        auto accPtr = reinterpret_cast<__m256i *>(acc + x);
+        __m256i pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x)));
+        _mm256_storeu_si256(accPtr, _mm256_add_epi32(_mm256_loadu_si256(accPtr),
+                                                     _mm256_mullo_epi32(pixels, w)));
+    }
+
+    macLine8Scalar(acc + x, src + x, weight, size - x);
+}
+
+AK_SIMD_TARGET("avx2")
+static void macLine32AVX2(int *acc, const int *src, int weight, int size)
+{
+    const __m256i w = _mm256_set1_epi32(weight);
+    int x = 0;
+
+    for (; x + 8 <= size; x += 8) {
+        auto accPtr = reinterpret_cast<__m256i *>(acc + x);
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + x));
+        _mm256_storeu_si256(accPtr, _mm256_add_epi32(_mm256_loadu_si256(accPtr),
+                                                     _mm256_mullo_epi32(values, w)));
+    }
+
+    macLine32Scalar(acc + x, src + x, weight, size - x);
+}
+#endif
+
+struct ConvolveKernels
+{
+    void (*macLine8)(int *acc, const quint8 *src, int weight, int size);
+    void (*macLine32)(int *acc, const int *src, int weight, int size);
+
+    static ConvolveKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        ConvolveKernels kernels = {
+            macLine8Scalar,
+            macLine32Scalar
+        };
+
+#ifdef CONVOLVE_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_SSE2) {
+            kernels.macLine8 = macLine8SSE2;
+            kernels.macLine32 = macLine32SSE2;
+        }
+
+        if (instructionSet >= AkSimd::InstructionSet_AVX2) {
+            kernels.macLine8 = macLine8AVX2;
+            kernels.macLine32 = macLine32AVX2;
+        }
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
+
+struct ConvolveTap
+{
+    int x;
+    int y;
+    int weight;
+};
+
+// How the kernel is applied, it's built every time the kernel changes.
+//
+// The frame is padded repeating its borders, so the output pixel (x, y) is
+// the sum of weight * padded(x + tap.x, y + tap.y) for every tap.
+class ConvolvePlan
+{
+    public:
+        enum Method
+        {
+            Method_Direct,
+            Method_Separable,
+            Method_FFT
+        };
+
+        Method m_method;
+        int m_width;
+        int m_height;
+        int m_left;
+        int m_top;
+
+        // Non zero taps of the kernel.
+        QVector<ConvolveTap> m_taps;
+
+        // Taps of the horizontal and vertical passes of a separable kernel.
+        QVector<ConvolveTap> m_rowTaps;
+        QVector<ConvolveTap> m_columnTaps;
+
+        // Conjugated spectrum of the kernel, divided by the number of
+        // elements of the FFT.
+        Fft m_fft;
+        QVector<Complex> m_spectrum;
+
+        ConvolvePlan(const QVector<int> &kernel, const QSize &kernelSize);
+
+    private:
+        bool separate(const QVector<int> &kernel);
+};
 
 class ConvolveElementPrivate
 {
@@ -36,6 +232,7 @@ class ConvolveElementPrivate
         AkFrac m_factor;
         QMutex m_mutex;
         int m_bias;
+        QSharedPointer<ConvolvePlan> m_plan;
 
         ConvolveElementPrivate():
             m_kernelSize(QSize(3, 3)),
@@ -43,8 +240,156 @@ class ConvolveElementPrivate
             m_bias(0)
         {
         }
+
+        inline void updatePlan();
+        inline static void padFrame(const QImage &src,
+                                    const ConvolvePlan &plan,
+                                    quint8 *const *planes,
+                                    int paddedWidth,
+                                    int begin,
+                                    int end);
+        inline static void writeLine(const int *const *sums,
+                                     const QRgb *iLine,
+                                     QRgb *oLine,
+                                     int width,
+                                     qint64 factorNum,
+                                     qint64 factorDen,
+                                     int bias);
+        static void convolveDirect(const ConvolveKernels &kernels,
+                                   const ConvolvePlan &plan,
+                                   const QImage &src,
+                                   const quint8 *const *planes,
+                                   int paddedWidth,
+                                   QImage &dst,
+                                   qint64 factorNum,
+                                   qint64 factorDen,
+                                   int bias);
+        static void convolveSeparable(const ConvolveKernels &kernels,
+                                      const ConvolvePlan &plan,
+                                      const QImage &src,
+                                      const quint8 *const *planes,
+                                      int paddedWidth,
+                                      QImage &dst,
+                                      qint64 factorNum,
+                                      qint64 factorDen,
+                                      int bias);
+        static void convolveFFT(const ConvolvePlan &plan,
+                                const QImage &src,
+                                const quint8 *const *planes,
+                                int paddedWidth,
+                                int paddedHeight,
+                                QImage &dst,
+                                qint64 factorNum,
+                                qint64 factorDen,
+                                int bias);
 };
 
+ConvolvePlan::ConvolvePlan(const QVector<int> &kernel, const QSize &kernelSize):
+    m_method(Method_Direct)
+{
+    // Even sizes have always been read as one tap less wide or high.
+    int minI = -(kernelSize.width() - 1) / 2;
+    int maxI = (kernelSize.width() + 1) / 2;
+    int minJ = -(kernelSize.height() - 1) / 2;
+    int maxJ = (kernelSize.height() + 1) / 2;
+    this->m_width = qMax(maxI - minI, 1);
+    this->m_height = qMax(maxJ - minJ, 1);
+    this->m_left = -minI;
+    this->m_top = -minJ;
+
+    QVector<int> weights(this->m_width * this->m_height, 0);
+
+    if (maxI > minI && maxJ > minJ)
+        for (int k = 0; k < qMin(weights.size(), kernel.size()); k++)
+            weights[k] = kernel[k];
+
+    for (int y = 0, k = 0; y < this->m_height; y++)
+        for (int x = 0; x < this->m_width; x++, k++)
+            if (weights[k])
+                this->m_taps << ConvolveTap {x, y, weights[k]};
+
+    if (this->separate(weights)
+        && this->m_rowTaps.size() + this->m_columnTaps.size() < this->m_taps.size()) {
+        this->m_method = Method_Separable;
+
+        return;
+    }
+
+    if (this->m_taps.size() < MIN_FFT_TAPS)
+        return;
+
+    this->m_method = Method_FFT;
+    int fftSize = Fft::nextPowerOf2(4 * qMax(this->m_width, this->m_height));
+    this->m_fft = Fft(qMax(fftSize, MIN_FFT_SIZE));
+    fftSize = this->m_fft.size();
+
+    this->m_spectrum.fill(Complex(), fftSize * fftSize);
+
+    for (auto &tap: this->m_taps)
+        this->m_spectrum[tap.y * fftSize + tap.x] = Complex(tap.weight, 0);
+
+    QVector<Complex> column(fftSize);
+    this->m_fft.transform2D(this->m_spectrum.data(), column.data());
+    qreal scale = 1.0 / (fftSize * fftSize);
+
+    for (auto &value: this->m_spectrum)
+        value = std::conj(value) * scale;
+}
+
+// Checks if the kernel is the product of a column and a row of integers.
+bool ConvolvePlan::separate(const QVector<int> &kernel)
+{
+    if (this->m_taps.isEmpty())
+        return false;
+
+    // The row is the first non zero row of the kernel divided by the greatest
+    // common divisor of its weights.
+    int firstRow = this->m_taps.first().y;
+    const int *row = kernel.constData() + firstRow * this->m_width;
+    qint64 divisor = 0;
+
+    for (int x = 0; x < this->m_width; x++) {
+        qint64 a = qAbs(qint64(row[x]));
+
+        while (a) {
+            qint64 remainder = divisor % a;
+            divisor = a;
+            a = remainder;
+        }
+    }
+
+    QVector<qint64> rowWeights(this->m_width);
+
+    for (int x = 0; x < this->m_width; x++)
+        rowWeights[x] = row[x] / divisor;
+
+    int firstColumn = this->m_taps.first().x;
+    QVector<qint64> columnWeights(this->m_height);
+
+    for (int y = 0; y < this->m_height; y++) {
+        const int *line = kernel.constData() + y * this->m_width;
+
+        if (line[firstColumn] % rowWeights[firstColumn])
+            return false;
+
+        columnWeights[y] = line[firstColumn] / rowWeights[firstColumn];
+
+        for (int x = 0; x < this->m_width; x++)
+            if (line[x] != columnWeights[y] * rowWeights[x])
+                return false;
+    }
+
+    for (int x = 0; x < this->m_width; x++)
+        if (rowWeights[x])
+            this->m_rowTaps << ConvolveTap {x, 0, int(rowWeights[x])};
+
+    for (int y = 0; y < this->m_height; y++)
+        if (columnWeights[y])
+            this->m_columnTaps << ConvolveTap {0, y, int(columnWeights[y])};
+
+    return true;
+}
+
 ConvolveElement::ConvolveElement(): AkElement()
 {
     this->d = new ConvolveElementPrivate;
@@ -54,6 +399,8 @@ ConvolveElement::ConvolveElement(): AkElement()
         0, 1, 0,
         0, 0, 0
     };
+
+    this->d->updatePlan();
 }
 
 ConvolveElement::~ConvolveElement()
@@ -112,8 +459,10 @@ void ConvolveElement::setKernel(const QVariantList &kernel)
     if (this->d->m_kernel == k)
         return;
 
-    QMutexLocker(&this->d->m_mutex);
+    this->d->m_mutex.lock();
     this->d->m_kernel = k;
+    this->d->updatePlan();
+    this->d->m_mutex.unlock();
     emit this->kernelChanged(kernel);
 }
 
@@ -122,8 +471,10 @@ void ConvolveElement::setKernelSize(const QSize &kernelSize)
     if (this->d->m_kernelSize == kernelSize)
         return;
 
-    QMutexLocker(&this->d->m_mutex);
+    this->d->m_mutex.lock();
     this->d->m_kernelSize = kernelSize;
+    this->d->updatePlan();
+    this->d->m_mutex.unlock();
     emit this->kernelSizeChanged(kernelSize);
 }
 
@@ -132,8 +483,9 @@ void ConvolveElement::setFactor(const AkFrac &factor)
     if (this->d->m_factor == factor)
         return;
 
-    QMutexLocker(&this->d->m_mutex);
+    this->d->m_mutex.lock();
     this->d->m_factor = factor;
+    this->d->m_mutex.unlock();
     emit this->factorChanged(factor);
 }
 
@@ -142,8 +494,9 @@ void ConvolveElement::setBias(int bias)
     if (this->d->m_bias == bias)
         return;
 
-    QMutexLocker(&this->d->m_mutex);
+    this->d->m_mutex.lock();
     this->d->m_bias = bias;
+    this->d->m_mutex.unlock();
     emit this->biasChanged(bias);
 }
 
@@ -173,71 +526,335 @@ void ConvolveElement::resetBias()
     this->setBias(0);
 }
 
-AkPacket ConvolveElement::iStream(const AkPacket &packet)
+void ConvolveElementPrivate::updatePlan()
 {
-    QImage src = AkUtils::packetToImage(packet);
+    this->m_plan = QSharedPointer<ConvolvePlan>::create(this->m_kernel,
+                                                        this->m_kernelSize);
+}
 
-    if (src.isNull())
-        return AkPacket();
+// Splits the frame in padded color planes.
+void ConvolveElementPrivate::padFrame(const QImage &src,
+                                      const ConvolvePlan &plan,
+                                      quint8 *const *planes,
+                                      int paddedWidth,
+                                      int begin,
+                                      int end)
+{
+    int width = src.width();
+
+    for (int y = begin; y < end; y++) {
+        int yp = qBound(0, y - plan.m_top, src.height() - 1);
+        auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(yp));
+        quint8 *lineR = planes[0] + y * paddedWidth;
+        quint8 *lineG = planes[1] + y * paddedWidth;
+        quint8 *lineB = planes[2] + y * paddedWidth;
+
+        for (int x = 0; x < paddedWidth; x++) {
+            QRgb pixel = iLine[qBound(0, x - plan.m_left, width - 1)];
+            lineR[x] = quint8(qRed(pixel));
+            lineG[x] = quint8(qGreen(pixel));
+            lineB[x] = quint8(qBlue(pixel));
+        }
+    }
+}
 
-    src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+void ConvolveElementPrivate::writeLine(const int *const *sums,
+                                       const QRgb *iLine,
+                                       QRgb *oLine,
+                                       int width,
+                                       qint64 factorNum,
+                                       qint64 factorDen,
+                                       int bias)
+{
+    if (!factorNum) {
+        for (int x = 0; x < width; x++)
+            oLine[x] = qRgba(255, 255, 255, qAlpha(iLine[x]));
 
-    this->d->m_mutex.lock();
-    QVector<int> kernel = this->d->m_kernel;
-    const int *kernelBits = kernel.constData();
-    qint64 factorNum = this->d->m_factor.num();
-    qint64 factorDen = this->d->m_factor.den();
-    int kernelWidth = this->d->m_kernelSize.width();
-    int kernelHeight = this->d->m_kernelSize.height();
-    this->d->m_mutex.unlock();
+        return;
+    }
+
+    for (int x = 0; x < width; x++) {
+        int r = int(factorNum * sums[0][x] / factorDen + bias);
+        int g = int(factorNum * sums[1][x] / factorDen + bias);
+        int b = int(factorNum * sums[2][x] / factorDen + bias);
+
+        r = qBound(0, r, 255);
+        g = qBound(0, g, 255);
+        b = qBound(0, b, 255);
+
+        oLine[x] = qRgba(r, g, b, qAlpha(iLine[x]));
+    }
+}
+
+void ConvolveElementPrivate::convolveDirect(const ConvolveKernels &kernels,
+                                            const ConvolvePlan &plan,
+                                            const QImage &src,
+                                            const quint8 *const *planes,
+                                            int paddedWidth,
+                                            QImage &dst,
+                                            qint64 factorNum,
+                                            qint64 factorDen,
+                                            int bias)
+{
+    int width = src.width();
+
+    // Don't detach the output frame from the worker threads.
+    auto oBits = dst.bits();
+    int oLineSize = dst.bytesPerLine();
+
+    AkScheduler::parallelFor(src.height(), MIN_BAND_HEIGHT, [&] (int begin, int end) {
+        auto sumsBuffer = AkBufferPool::buffer(3 * width * int(sizeof(int)));
+        int *sums[3];
+
+        for (int c = 0; c < 3; c++)
+            sums[c] = sumsBuffer.data<int>() + c * width;
 
-    int minI = -(kernelWidth - 1) / 2;
-    int maxI = (kernelWidth + 1) / 2;
-    int minJ = -(kernelHeight - 1) / 2;
-    int maxJ = (kernelHeight + 1) / 2;
+        for (int y = begin; y < end; y++) {
+            memset(sums[0], 0, 3 * size_t(width) * sizeof(int));
 
-    for (int y = 0; y < src.height(); y++) {
-        auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        auto oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
+            for (auto &tap: plan.m_taps) {
+                int offset = (y + tap.y) * paddedWidth + tap.x;
 
-        for (int x = 0; x < src.width(); x++) {
-            int r = 0;
-            int g = 0;
-            int b = 0;
+                for (int c = 0; c < 3; c++)
+                    kernels.macLine8(sums[c], planes[c] + offset, tap.weight, width);
+            }
+
+            writeLine(sums,
+                      reinterpret_cast<const QRgb *>(src.constScanLine(y)),
+                      reinterpret_cast<QRgb *>(oBits + y * oLineSize),
+                      width,
+                      factorNum,
+                      factorDen,
+                      bias);
+        }
+    });
+}
+
+// Filters the padded lines of the band with the row taps, and then the
+// filtered lines with the column taps.
+void ConvolveElementPrivate::convolveSeparable(const ConvolveKernels &kernels,
+                                               const ConvolvePlan &plan,
+                                               const QImage &src,
+                                               const quint8 *const *planes,
+                                               int paddedWidth,
+                                               QImage &dst,
+                                               qint64 factorNum,
+                                               qint64 factorDen,
+                                               int bias)
+{
+    int width = src.width();
+    auto oBits = dst.bits();
+    int oLineSize = dst.bytesPerLine();
+
+    AkScheduler::parallelFor(src.height(), MIN_BAND_HEIGHT, [&] (int begin, int end) {
+        int rows = end - begin + plan.m_height - 1;
+        auto rowsBuffer = AkBufferPool::buffer(3 * rows * width * int(sizeof(int)));
+        auto sumsBuffer = AkBufferPool::buffer(3 * width * int(sizeof(int)));
+        int *filtered[3];
+        int *sums[3];
+
+        for (int c = 0; c < 3; c++) {
+            filtered[c] = rowsBuffer.data<int>() + c * rows * width;
+            sums[c] = sumsBuffer.data<int>() + c * width;
+        }
+
+        memset(filtered[0], 0, 3 * size_t(rows) * size_t(width) * sizeof(int));
+
+        for (int row = 0; row < rows; row++)
+            for (auto &tap: plan.m_rowTaps) {
+                int offset = (begin + row) * paddedWidth + tap.x;
+
+                for (int c = 0; c < 3; c++)
+                    kernels.macLine8(filtered[c] + row * width,
+                                     planes[c] + offset,
+                                     tap.weight,
+                                     width);
+            }
 
-            for (int j = minJ, k = 0; j < maxJ; j++) {
-                int yp = qBound(0, y + j, src.height() - 1);
-                auto iLine =
-                        reinterpret_cast<const QRgb *>(src.constScanLine(yp));
+        for (int y = begin; y < end; y++) {
+            memset(sums[0], 0, 3 * size_t(width) * sizeof(int));
 
-                for (int i = minI; i < maxI; i++, k++) {
-                    int xp = qBound(0, x + i, src.width() - 1);
+            for (auto &tap: plan.m_columnTaps) {
+                int offset = (y - begin + tap.y) * width;
 
-                    if (kernelBits[k]) {
-                        r += kernelBits[k] * qRed(iLine[xp]);
-                        g += kernelBits[k] * qGreen(iLine[xp]);
-                        b += kernelBits[k] * qBlue(iLine[xp]);
+                for (int c = 0; c < 3; c++)
+                    kernels.macLine32(sums[c],
+                                      filtered[c] + offset,
+                                      tap.weight,
+                                      width);
+            }
+
+            writeLine(sums,
+                      reinterpret_cast<const QRgb *>(src.constScanLine(y)),
+                      reinterpret_cast<QRgb *>(oBits + y * oLineSize),
+                      width,
+                      factorNum,
+                      factorDen,
+                      bias);
+        }
+    });
+}
+
+// Overlap-save convolution, every tile of the padded frame is correlated
+// with the kernel in the frequency domain, and the part of the result not
+// affected by the wrap around is kept. The red and green planes are
+// transformed together as the real and imaginary parts of a single FFT.
+void ConvolveElementPrivate::convolveFFT(const ConvolvePlan &plan,
+                                         const QImage &src,
+                                         const quint8 *const *planes,
+                                         int paddedWidth,
+                                         int paddedHeight,
+                                         QImage &dst,
+                                         qint64 factorNum,
+                                         qint64 factorDen,
+                                         int bias)
+{
+    int width = src.width();
+    int height = src.height();
+    int fftSize = plan.m_fft.size();
+    int tileWidth = fftSize - plan.m_width + 1;
+    int tileHeight = fftSize - plan.m_height + 1;
+    int tilesX = (width + tileWidth - 1) / tileWidth;
+    int tilesY = (height + tileHeight - 1) / tileHeight;
+    auto oBits = dst.bits();
+    int oLineSize = dst.bytesPerLine();
+
+    AkScheduler::parallelFor(tilesX * tilesY, 1, [&] (int begin, int end) {
+        int fftArea = fftSize * fftSize;
+        auto fftBuffer = AkBufferPool::buffer((2 * fftArea + fftSize)
+                                              * int(sizeof(Complex)));
+        auto rg = fftBuffer.data<Complex>();
+        auto b = rg + fftArea;
+        auto column = b + fftArea;
+        auto sumsBuffer = AkBufferPool::buffer(3 * tileWidth * int(sizeof(int)));
+        int *sums[3];
+
+        for (int c = 0; c < 3; c++)
+            sums[c] = sumsBuffer.data<int>() + c * tileWidth;
+
+        for (int tile = begin; tile < end; tile++) {
+            int tileX = (tile % tilesX) * tileWidth;
+            int tileY = (tile / tilesX) * tileHeight;
+
+            for (int y = 0; y < fftSize; y++) {
+                Complex *rgLine = rg + y * fftSize;
+                Complex *bLine = b + y * fftSize;
+                int yp = tileY + y;
+                int x = 0;
+
+                if (yp < paddedHeight) {
+                    int offset = yp * paddedWidth + tileX;
+                    int columns = qMin(fftSize, paddedWidth - tileX);
+
+                    for (; x < columns; x++) {
+                        rgLine[x] = Complex(planes[0][offset + x],
+                                            planes[1][offset + x]);
+                        bLine[x] = Complex(planes[2][offset + x], 0);
                     }
                 }
+
+                for (; x < fftSize; x++) {
+                    rgLine[x] = Complex();
+                    bLine[x] = Complex();
+                }
             }
 
-            if (factorNum) {
-                r = int(factorNum * r / factorDen + this->d->m_bias);
-                g = int(factorNum * g / factorDen + this->d->m_bias);
-                b = int(factorNum * b / factorDen + this->d->m_bias);
-
-                r = qBound(0, r, 255);
-                g = qBound(0, g, 255);
-                b = qBound(0, b, 255);
-            } else {
-                r = 255;
-                g = 255;
-                b = 255;
+            plan.m_fft.transform2D(rg, column);
+            plan.m_fft.transform2D(b, column);
+
+            for (int i = 0; i < fftArea; i++) {
+                const Complex &k = plan.m_spectrum[i];
+                rg[i] = Complex(rg[i].real() * k.real() - rg[i].imag() * k.imag(),
+                                rg[i].real() * k.imag() + rg[i].imag() * k.real());
+                b[i] = Complex(b[i].real() * k.real() - b[i].imag() * k.imag(),
+                               b[i].real() * k.imag() + b[i].imag() * k.real());
             }
 
-            oLine[x] = qRgba(r, g, b, qAlpha(iLine[x]));
+            plan.m_fft.transform2D(rg, column, true);
+            plan.m_fft.transform2D(b, column, true);
+
+            int columns = qMin(tileWidth, width - tileX);
+            int rows = qMin(tileHeight, height - tileY);
+
+            for (int y = 0; y < rows; y++) {
+                const Complex *rgLine = rg + y * fftSize;
+                const Complex *bLine = b + y * fftSize;
+
+                // The sums are integers, round away the precision errors.
+                for (int x = 0; x < columns; x++) {
+                    sums[0][x] = qRound(rgLine[x].real());
+                    sums[1][x] = qRound(rgLine[x].imag());
+                    sums[2][x] = qRound(bLine[x].real());
+                }
+
+                auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(tileY + y));
+                auto oLine = reinterpret_cast<QRgb *>(oBits + (tileY + y) * oLineSize);
+                writeLine(sums,
+                          iLine + tileX,
+                          oLine + tileX,
+                          columns,
+                          factorNum,
+                          factorDen,
+                          bias);
+            }
         }
+    });
+}
+
+AkPacket ConvolveElement::iStream(const AkPacket &packet)
+{
+    QImage src = AkUtils::packetToImage(packet);
+
+    if (src.isNull())
+        return AkPacket();
+
+    src = src.convertToFormat(QImage::Format_ARGB32);
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
+
+    this->d->m_mutex.lock();
+    auto plan = this->d->m_plan;
+    qint64 factorNum = this->d->m_factor.num();
+    qint64 factorDen = this->d->m_factor.den();
+    int bias = this->d->m_bias;
+    this->d->m_mutex.unlock();
+
+    int paddedWidth = src.width() + plan->m_width - 1;
+    int paddedHeight = src.height() + plan->m_height - 1;
+    auto planesBuffer = AkBufferPool::buffer(3 * paddedWidth * paddedHeight);
+    quint8 *planes[3];
+
+    for (int c = 0; c < 3; c++)
+        planes[c] = planesBuffer.data<quint8>() + c * paddedWidth * paddedHeight;
+
+    AkScheduler::parallelFor(paddedHeight, MIN_BAND_HEIGHT, [&] (int begin, int end) {
+        ConvolveElementPrivate::padFrame(src, *plan, planes, paddedWidth, begin, end);
+    });
+
+    auto kernels = ConvolveKernels::byInstructionSet(AkSimd::instructionSet());
+
+    switch (plan->m_method) {
+    case ConvolvePlan::Method_Separable:
+        ConvolveElementPrivate::convolveSeparable(kernels, *plan,
+                                                  src, planes, paddedWidth,
+                                                  oFrame,
+                                                  factorNum, factorDen, bias);
+
+        break;
+    case ConvolvePlan::Method_FFT:
+        ConvolveElementPrivate::convolveFFT(*plan,
+                                            src, planes,
+                                            paddedWidth, paddedHeight,
+                                            oFrame,
+                                            factorNum, factorDen, bias);
+
+        break;
+    default:
+        ConvolveElementPrivate::convolveDirect(kernels, *plan,
+                                               src, planes, paddedWidth,
+                                               oFrame,
+                                               factorNum, factorDen, bias);
+
+        break;
     }
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
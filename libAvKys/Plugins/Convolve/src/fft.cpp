@@ -0,0 +1,123 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <QtMath>
+
+#include "fft.h"
+
+// std::complex multiplication checks for infinities and NaNs, which is way
+// slower.
+static inline Complex multiply(const Complex &a, const Complex &b)
+{
+    return Complex(a.real() * b.real() - a.imag() * b.imag(),
+                   a.real() * b.imag() + a.imag() * b.real());
+}
+
+Fft::Fft(int size):
+    m_size(size)
+{
+    int bits = 0;
+
+    while ((1 << bits) < size)
+        bits++;
+
+    this->m_bitReverse.resize(size);
+
+    for (int i = 0; i < size; i++) {
+        int reversed = 0;
+
+        for (int bit = 0; bit < bits; bit++)
+            if (i & (1 << bit))
+                reversed |= 1 << (bits - bit - 1);
+
+        this->m_bitReverse[i] = reversed;
+    }
+
+    this->m_twiddles.resize(qMax(size / 2, 1));
+
+    for (int i = 0; i < size / 2; i++) {
+        qreal angle = -2.0 * M_PI * i / size;
+        this->m_twiddles[i] = Complex(qCos(angle), qSin(angle));
+    }
+}
+
+int Fft::size() const
+{
+    return this->m_size;
+}
+
+void Fft::transform(Complex *data, bool inverse) const
+{
+    int size = this->m_size;
+    const int *bitReverse = this->m_bitReverse.constData();
+    const Complex *twiddles = this->m_twiddles.constData();
+
+    for (int i = 0; i < size; i++) {
+        int j = bitReverse[i];
+
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    for (int length = 2; length <= size; length <<= 1) {
+        int half = length >> 1;
+        int step = size / length;
+
+        for (int i = 0; i < size; i += length)
+            for (int k = 0; k < half; k++) {
+                Complex twiddle = twiddles[k * step];
+
+                if (inverse)
+                    twiddle = std::conj(twiddle);
+
+                Complex u = data[i + k];
+                Complex v = multiply(data[i + k + half], twiddle);
+                data[i + k] = u + v;
+                data[i + k + half] = u - v;
+            }
+    }
+}
+
+void Fft::transform2D(Complex *data, Complex *column, bool inverse) const
+{
+    int size = this->m_size;
+
+    for (int y = 0; y < size; y++)
+        this->transform(data + y * size, inverse);
+
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++)
+            column[y] = data[y * size + x];
+
+        this->transform(column, inverse);
+
+        for (int y = 0; y < size; y++)
+            data[y * size + x] = column[y];
+    }
+}
+
+int Fft::nextPowerOf2(int value)
+{
+    int power = 1;
+
+    while (power < value)
+        power <<= 1;
+
+    return power;
+}
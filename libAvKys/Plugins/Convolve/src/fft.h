@@ -0,0 +1,54 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <QVector>
+
+typedef std::complex<qreal> Complex;
+
+// Radix-2 fast Fourier transform of a fixed power of two size.
+//
+// The transforms are unnormalized, the inverse transform must be divided by
+// the number of elements. A Fft object can be shared between threads.
+class Fft
+{
+    public:
+        explicit Fft(int size=1);
+
+        int size() const;
+        void transform(Complex *data, bool inverse=false) const;
+
+        // Transforms a size x size matrix, column is a temporary buffer of
+        // size elements.
+        void transform2D(Complex *data,
+                         Complex *column,
+                         bool inverse=false) const;
+
+        static int nextPowerOf2(int value);
+
+    private:
+        int m_size;
+        QVector<int> m_bitReverse;
+        QVector<Complex> m_twiddles;
+};
+
+#endif // FFT_H
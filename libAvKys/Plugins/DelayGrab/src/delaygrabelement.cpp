@@ -25,6 +25,7 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "delaygrabelement.h"
@@ -178,7 +179,7 @@ AkPacket DelayGrabElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame = QImage(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     QRgb *destBits = reinterpret_cast<QRgb *>(oFrame.bits());
 
     if (src.size() != this->d->m_frameSize) {
@@ -46,7 +46,7 @@ LIBS += -L$${PWD}/../../Lib/ -l$${COMMONS_TARGET}
 
 OTHER_FILES += pspec.json
 
-QT += qml concurrent
+QT += qml
 
 RESOURCES += \
     Denoise.qrc
@@ -18,15 +18,226 @@
  */
 
 #include <QImage>
+#include <QMutex>
 #include <QQmlContext>
-#include <QtConcurrent>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
+#include <aksimd.h>
 #include <akpacket.h>
 
 #include "denoiseelement.h"
 #include "params.h"
 
+#ifdef AK_SIMD_X86
+    #define DENOISE_SIMD
+    #include <immintrin.h>
+#endif
+
+// Windows with at least this number of pixels are weighted from the
+// histogram of the window, smaller ones are weighted pixel by pixel.
+#define MIN_HISTOGRAM_PIXELS 64
+
+// Columns with at least this number of pixels are added to the window from
+// their histogram, shorter ones pixel by pixel.
+#define MIN_COLUMN_HISTOGRAM_HEIGHT 25
+
+// Minimum number of rows processed by a thread.
+#define MIN_BAND_HEIGHT 4
+
+// The weight only depends on the deviation and the distance between the
+// color component and the mean, so the table holds a line of weights for
+// each deviation, indexed by the distance plus 255. The weights of a window
+// are the 256 values of the line starting at 255 - mean.
+#define WEIGHTS_LINE_SIZE 511
+
+// The weight of a color component only depends on its value once the mean
+// and the deviation of the window are known, so the weighted sums of the
+// window can be calculated from its histogram:
+//
+//     sumW = sum(histogram[c] * weights[c])
+//     sum = sum(histogram[c] * weights[c] * c)
+//
+// Every column keeps the histogram and the sums of its pixels in the rows of
+// the window (Perreault-Hebert), moving down a row only adds and removes a
+// pixel from each column, and moving the window right adds and removes a
+// whole column, so the cost per pixel doesn't depend on the radius. Short
+// columns are cheaper to add pixel by pixel than as a 256 bins histogram.
+
+// Scalar kernels
+
+static void weightHistogramScalar(const int *histogram,
+                                  const int *weights,
+                                  int *sum,
+                                  int *sumW)
+{
+    quint32 s = 0;
+    quint32 sw = 0;
+
+    for (int c = 0; c < 256; c++) {
+        quint32 weight = quint32(histogram[c]) * quint32(weights[c]);
+        s += weight * quint32(c);
+        sw += weight;
+    }
+
+    *sum = int(s);
+    *sumW = int(sw);
+}
+
+static void slideHistogramScalar(int *histogram,
+                                 const quint16 *in,
+                                 const quint16 *out)
+{
+    for (int c = 0; c < 256; c++)
+        histogram[c] += int(in[c]) - int(out[c]);
+}
+
+#ifdef DENOISE_SIMD
+// SSE2 kernels
+
+// SSE2 lacks a 32 bits multiplication keeping the low half of the result.
+AK_SIMD_TARGET("sse2")
+static inline __m128i mulLo32SSE2(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+AK_SIMD_TARGET("sse2")
+static inline int horizontalSumSSE2(__m128i value)
+{
+    value = _mm_add_epi32(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2)));
+    value = _mm_add_epi32(value, _mm_shuffle_epi32(value, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(value);
+}
+
+AK_SIMD_TARGET("sse2")
+static void weightHistogramSSE2(const int *histogram,
+                                const int *weights,
+                                int *sum,
+                                int *sumW)
+{
+    const __m128i step = _mm_set1_epi32(4);
+    __m128i c = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i s = _mm_setzero_si128();
+    __m128i sw = _mm_setzero_si128();
+
+    for (int i = 0; i < 256; i += 4) {
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i *>(histogram + i));
+        __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+        __m128i weight = mulLo32SSE2(h, w);
+        s = _mm_add_epi32(s, mulLo32SSE2(weight, c));
+        sw = _mm_add_epi32(sw, weight);
+        c = _mm_add_epi32(c, step);
+    }
+
+    *sum = horizontalSumSSE2(s);
+    *sumW = horizontalSumSSE2(sw);
+}
+
+AK_SIMD_TARGET("sse2")
+static void slideHistogramSSE2(int *histogram,
+                               const quint16 *in,
+                               const quint16 *out)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int i = 0; i < 256; i += 8) {
+        auto h = reinterpret_cast<__m128i *>(histogram + i);
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i));
+        __m128i lo = _mm_sub_epi32(_mm_unpacklo_epi16(a, zero),
+                                   _mm_unpacklo_epi16(b, zero));
+        __m128i hi = _mm_sub_epi32(_mm_unpackhi_epi16(a, zero),
+                                   _mm_unpackhi_epi16(b, zero));
+        _mm_storeu_si128(h, _mm_add_epi32(_mm_loadu_si128(h), lo));
+        _mm_storeu_si128(h + 1, _mm_add_epi32(_mm_loadu_si128(h + 1), hi));
+    }
+}
+
+// AVX2 kernels
+
+AK_SIMD_TARGET("avx2")
+static void weightHistogramAVX2(const int *histogram,
+                                const int *weights,
+                                int *sum,
+                                int *sumW)
+{
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i c = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i s = _mm256_setzero_si256();
+    __m256i sw = _mm256_setzero_si256();
+
+    for (int i = 0; i < 256; i += 8) {
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(histogram + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+        __m256i weight = _mm256_mullo_epi32(h, w);
+        s = _mm256_add_epi32(s, _mm256_mullo_epi32(weight, c));
+        sw = _mm256_add_epi32(sw, weight);
+        c = _mm256_add_epi32(c, step);
+    }
+
+    *sum = horizontalSumSSE2(_mm_add_epi32(_mm256_castsi256_si128(s),
+                                           _mm256_extracti128_si256(s, 1)));
+    *sumW = horizontalSumSSE2(_mm_add_epi32(_mm256_castsi256_si128(sw),
+                                            _mm256_extracti128_si256(sw, 1)));
+}
+
+AK_SIMD_TARGET("avx2")
+static void slideHistogramAVX2(int *histogram,
+                               const quint16 *in,
+                               const quint16 *out)
+{
+    for (int i = 0; i < 256; i += 8) {
+        auto h = reinterpret_cast<__m256i *>(histogram + i);
+        __m256i a = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)));
+        __m256i b = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(out + i)));
+        _mm256_storeu_si256(h, _mm256_add_epi32(_mm256_loadu_si256(h),
+                                                _mm256_sub_epi32(a, b)));
+    }
+}
+#endif
+
+struct DenoiseKernels
+{
+    void (*weightHistogram)(const int *histogram,
+                            const int *weights,
+                            int *sum,
+                            int *sumW);
+    void (*slideHistogram)(int *histogram,
+                           const quint16 *in,
+                           const quint16 *out);
+
+    static DenoiseKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        DenoiseKernels kernels = {
+            weightHistogramScalar,
+            slideHistogramScalar
+        };
+
+#ifdef DENOISE_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_SSE2) {
+            kernels.weightHistogram = weightHistogramSSE2;
+            kernels.slideHistogram = slideHistogramSSE2;
+        }
+
+        if (instructionSet >= AkSimd::InstructionSet_AVX2) {
+            kernels.weightHistogram = weightHistogramAVX2;
+            kernels.slideHistogram = slideHistogramAVX2;
+        }
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
+
 class DenoiseElementPrivate
 {
     public:
@@ -34,38 +245,62 @@ class DenoiseElementPrivate
         int m_factor;
         int m_mu;
         qreal m_sigma;
-        int *m_weight;
+
+        // The table is never modified once built, a new one replaces it when
+        // the factor changes, so the frames being processed keep using their
+        // own copy.
+        QVector<int> m_weights;
+        QMutex m_mutex;
 
         DenoiseElementPrivate():
             m_radius(1),
             m_factor(1024),
             m_mu(0),
-            m_sigma(1.0),
-            m_weight(nullptr)
+            m_sigma(1.0)
         {
         }
 
-        inline void makeTable(int factor);
-        inline void integralImage(const QImage &image,
-                                  int oWidth, int oHeight,
-                                  PixelU8 *planes,
-                                  PixelU32 *integral,
-                                  PixelU64 *integral2);
-        inline static void denoise(const DenoiseStaticParams &staticParams,
-                                   const DenoiseParams *params);
+        inline static QVector<int> makeTable(int factor);
+        inline static void splitPlanes(const QImage &image,
+                                       quint8 *planes,
+                                       int begin,
+                                       int end);
+        inline static void updateColumns(const DenoiseStaticParams &staticParams,
+                                         const DenoiseColumns &columns,
+                                         int y, int begin, int end,
+                                         int count);
+        inline static void shiftColumn(const DenoiseStaticParams &staticParams,
+                                       const DenoiseColumns &columns,
+                                       int x, int y);
+        inline static void slideWindow(const DenoiseStaticParams &staticParams,
+                                       const DenoiseKernels &kernels,
+                                       const DenoiseColumns &columns,
+                                       DenoiseWindow &window,
+                                       int in, int out,
+                                       int yp, int kh);
+        inline static void weightWindow(const DenoiseStaticParams &staticParams,
+                                        const int *const *weights,
+                                        int xp, int yp, int kw, int kh,
+                                        int *sum,
+                                        int *sumW);
+        inline static void denoiseLine(const DenoiseStaticParams &staticParams,
+                                       const DenoiseKernels &kernels,
+                                       const DenoiseColumns &columns,
+                                       const QRgb *iLine,
+                                       QRgb *oLine,
+                                       int y,
+                                       bool shift);
 };
 
 DenoiseElement::DenoiseElement(): AkElement()
 {
     this->d = new DenoiseElementPrivate;
 
-    this->d->m_weight = new int[1 << 24];
-    this->d->makeTable(this->d->m_factor);
+    this->d->m_weights = DenoiseElementPrivate::makeTable(this->d->m_factor);
 }
 
 DenoiseElement::~DenoiseElement()
 {
-    delete [] this->d->m_weight;
     delete this->d;
 }
 
@@ -89,117 +324,260 @@ qreal DenoiseElement::sigma() const
     return this->d->m_sigma;
 }
 
-void DenoiseElementPrivate::integralImage(const QImage &image,
-                                          int oWidth, int oHeight,
-                                          PixelU8 *planes,
-                                          PixelU32 *integral,
-                                          PixelU64 *integral2)
+void DenoiseElementPrivate::splitPlanes(const QImage &image,
+                                        quint8 *planes,
+                                        int begin,
+                                        int end)
 {
-    for (int y = 1; y < oHeight; y++) {
-        auto line = reinterpret_cast<const QRgb *>(image.constScanLine(y - 1));
-        PixelU8 *planesLine = planes
-                              + (y - 1) * image.width();
-
-        // Reset current line summation.
-        PixelU32 sum;
-        PixelU64 sum2;
-
-        for (int x = 1; x < oWidth; x++) {
-            QRgb pixel = line[x - 1];
+    int planeSize = image.width() * image.height();
+    quint8 *planeR = planes;
+    quint8 *planeG = planeR + planeSize;
+    quint8 *planeB = planeG + planeSize;
+
+    for (int y = begin; y < end; y++) {
+        auto line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        int offset = y * image.width();
+
+        for (int x = 0; x < image.width(); x++) {
+            planeR[offset + x] = quint8(qRed(line[x]));
+            planeG[offset + x] = quint8(qGreen(line[x]));
+            planeB[offset + x] = quint8(qBlue(line[x]));
+        }
+    }
+}
 
-            // Accumulate pixels in current line.
-            sum += pixel;
-            sum2 += pow2(pixel);
+// Adds (count = 1) or removes (count = -1) the pixels of the row y, from
+// begin to end, to the columns.
+void DenoiseElementPrivate::updateColumns(const DenoiseStaticParams &staticParams,
+                                          const DenoiseColumns &columns,
+                                          int y, int begin, int end,
+                                          int count)
+{
+    for (int c = 0; c < 3; c++) {
+        const quint8 *line = staticParams.planes[c] + y * staticParams.width;
+
+        for (int x = begin; x < end; x++) {
+            int column = 3 * x + c;
+            quint32 value = line[x];
+
+            if (count > 0) {
+                columns.sum[column] += value;
+                columns.sum2[column] += value * value;
+            } else {
+                columns.sum[column] -= value;
+                columns.sum2[column] -= value * value;
+            }
 
-            // Offset to the current line.
-            int offset = x + y * oWidth;
+            if (staticParams.useColumnHistograms) {
+                quint16 &bin = columns.histograms[(column << 8) + value];
+                bin = quint16(bin + count);
+            }
+        }
+    }
+}
 
-            // Offset to the previous line.
-            // equivalent to x + (y - 1) * oWidth;
-            int offsetPrevious = offset - oWidth;
+// Moves the column x from the rows of the window of y - 1 to the ones of y.
+void DenoiseElementPrivate::shiftColumn(const DenoiseStaticParams &staticParams,
+                                        const DenoiseColumns &columns,
+                                        int x, int y)
+{
+    if (y - staticParams.radius - 1 >= 0)
+        updateColumns(staticParams, columns, y - staticParams.radius - 1,
+                      x, x + 1, -1);
 
-            planesLine[x - 1] = pixel;
+    if (y + staticParams.radius < staticParams.height)
+        updateColumns(staticParams, columns, y + staticParams.radius,
+                      x, x + 1, 1);
+}
 
-            // Accumulate current line and previous line.
-            integral[offset] = sum + integral[offsetPrevious];
-            integral2[offset] = sum2 + integral2[offsetPrevious];
+// Adds the column in and removes the column out from the window, the empty
+// column at x = width stands for a missing one.
+void DenoiseElementPrivate::slideWindow(const DenoiseStaticParams &staticParams,
+                                        const DenoiseKernels &kernels,
+                                        const DenoiseColumns &columns,
+                                        DenoiseWindow &window,
+                                        int in, int out,
+                                        int yp, int kh)
+{
+    int width = staticParams.width;
+
+    for (int c = 0; c < 3; c++) {
+        int columnIn = 3 * in + c;
+        int columnOut = 3 * out + c;
+        window.sum[c] += columns.sum[columnIn] - columns.sum[columnOut];
+        window.sum2[c] += columns.sum2[columnIn] - columns.sum2[columnOut];
+
+        if (staticParams.useColumnHistograms) {
+            kernels.slideHistogram(window.histogram[c],
+                                   columns.histograms + (columnIn << 8),
+                                   columns.histograms + (columnOut << 8));
+        } else if (staticParams.useHistogram) {
+            int *histogram = window.histogram[c];
+            const quint8 *plane = staticParams.planes[c] + yp * width;
+
+            if (in < width)
+                for (int j = 0; j < kh; j++)
+                    histogram[plane[j * width + in]]++;
+
+            if (out < width)
+                for (int j = 0; j < kh; j++)
+                    histogram[plane[j * width + out]]--;
         }
     }
 }
 
-void DenoiseElementPrivate::denoise(const DenoiseStaticParams &staticParams,
-                                    const DenoiseParams *params)
+// Weights the window pixel by pixel, faster than the histogram for small
+// windows.
+void DenoiseElementPrivate::weightWindow(const DenoiseStaticParams &staticParams,
+                                         const int *const *weights,
+                                         int xp, int yp, int kw, int kh,
+                                         int *sum,
+                                         int *sumW)
 {
-    PixelU32 sum = integralSum(staticParams.integral, staticParams.oWidth,
-                               params->xp, params->yp, params->kw, params->kh);
-    PixelU64 sum2 = integralSum(staticParams.integral2, staticParams.oWidth,
-                                params->xp, params->yp, params->kw, params->kh);
-    quint32 ks = quint32(params->kw * params->kh);
-
-    PixelU32 mean = sum / ks;
-    PixelU32 dev = sqrt(ks * sum2 - pow2(sum)) / ks;
+    quint32 s[3] = {0, 0, 0};
+    quint32 sw[3] = {0, 0, 0};
+    int offset = yp * staticParams.width + xp;
+
+    for (int j = 0; j < kh; j++, offset += staticParams.width) {
+        const quint8 *lineR = staticParams.planes[0] + offset;
+        const quint8 *lineG = staticParams.planes[1] + offset;
+        const quint8 *lineB = staticParams.planes[2] + offset;
+
+        for (int i = 0; i < kw; i++) {
+            quint32 weightR = quint32(weights[0][lineR[i]]);
+            quint32 weightG = quint32(weights[1][lineG[i]]);
+            quint32 weightB = quint32(weights[2][lineB[i]]);
+            s[0] += weightR * lineR[i];
+            s[1] += weightG * lineG[i];
+            s[2] += weightB * lineB[i];
+            sw[0] += weightR;
+            sw[1] += weightG;
+            sw[2] += weightB;
+        }
+    }
 
-    mean = bound(0u, mean + staticParams.mu, 255u);
-    dev = bound(0., mult(staticParams.sigma, dev), 127.);
+    for (int c = 0; c < 3; c++) {
+        sum[c] = int(s[c]);
+        sumW[c] = int(sw[c]);
+    }
+}
 
-    PixelU32 mdMask = (mean << 16) | (dev << 8);
+void DenoiseElementPrivate::denoiseLine(const DenoiseStaticParams &staticParams,
+                                        const DenoiseKernels &kernels,
+                                        const DenoiseColumns &columns,
+                                        const QRgb *iLine,
+                                        QRgb *oLine,
+                                        int y,
+                                        bool shift)
+{
+    int width = staticParams.width;
+    int radius = staticParams.radius;
+    int yp = qMax(y - radius, 0);
+    int kh = qMin(y + radius, staticParams.height - 1) - yp + 1;
 
-    PixelI32 pixel;
-    PixelI32 sumW;
+    DenoiseWindow window;
 
-    for (int j = 0; j < params->kh; j++) {
-        const PixelU8 *line = staticParams.planes
-                              + (params->yp + j) * staticParams.width;
+    if (staticParams.useHistogram)
+        memset(window.histogram, 0, sizeof(window.histogram));
 
-        for (int i = 0; i < params->kw; i++) {
-            PixelU8 pix = line[params->xp + i];
-            PixelU32 mask = mdMask | pix;
-            PixelI32 weight(staticParams.weights[mask.r],
-                            staticParams.weights[mask.g],
-                            staticParams.weights[mask.b]);
-            pixel += weight * pix;
-            sumW += weight;
-        }
+    for (int c = 0; c < 3; c++) {
+        window.sum[c] = 0;
+        window.sum2[c] = 0;
     }
 
-    if (sumW.r < 1)
-        pixel.r = params->iPixel.r;
-    else
-        pixel.r /= sumW.r;
+    // The columns are moved to the row right before entering the window, so
+    // the ones leaving it are still in cache.
+    for (int x = 0; x < qMin(radius, width); x++) {
+        if (shift)
+            shiftColumn(staticParams, columns, x, y);
 
-    if (sumW.g < 1)
-        pixel.g = params->iPixel.g;
-    else
-        pixel.g /= sumW.g;
+        slideWindow(staticParams, kernels, columns, window, x, width, yp, kh);
+    }
+
+    for (int x = 0; x < width; x++) {
+        // Slide the window one pixel to the right.
+        int in = x + radius < width? x + radius: width;
+        int out = x - radius - 1 >= 0? x - radius - 1: width;
+
+        if (shift && in < width)
+            shiftColumn(staticParams, columns, in, y);
+
+        if (in < width || out < width)
+            slideWindow(staticParams, kernels, columns, window,
+                        in, out, yp, kh);
+
+        int xp = qMax(x - radius, 0);
+        int kw = qMin(x + radius, width - 1) - xp + 1;
+
+        PixelU32 sum(window.sum[0], window.sum[1], window.sum[2]);
+        PixelU64 sum2(window.sum2[0], window.sum2[1], window.sum2[2]);
+        quint32 ks = quint32(kw * kh);
+
+        PixelU32 mean = sum / ks;
+        PixelU32 dev = sqrt(ks * sum2 - pow2(sum)) / ks;
+
+        mean = bound(0u, mean + staticParams.mu, 255u);
+        dev = bound(0., mult(staticParams.sigma, dev), 127.);
+
+        const int *weights[3] = {
+            staticParams.weights + (dev.r << 9) + 255 - mean.r,
+            staticParams.weights + (dev.g << 9) + 255 - mean.g,
+            staticParams.weights + (dev.b << 9) + 255 - mean.b,
+        };
+
+        int pixel[3];
+        int sumW[3];
+
+        if (staticParams.useHistogram) {
+            for (int c = 0; c < 3; c++)
+                kernels.weightHistogram(window.histogram[c],
+                                        weights[c],
+                                        pixel + c,
+                                        sumW + c);
+        } else {
+            weightWindow(staticParams, weights,
+                         xp, yp, kw, kh,
+                         pixel, sumW);
+        }
 
-    if (sumW.b < 1)
-        pixel.b = params->iPixel.b;
-    else
-        pixel.b /= sumW.b;
+        for (int c = 0; c < 3; c++) {
+            if (sumW[c] < 1)
+                pixel[c] = staticParams.planes[c][y * width + x];
+            else
+                pixel[c] /= sumW[c];
+        }
 
-    *params->oPixel = qRgba(pixel.r, pixel.g, pixel.b, params->alpha);
-    delete params;
+        oLine[x] = qRgba(pixel[0], pixel[1], pixel[2], qAlpha(iLine[x]));
+    }
 }
 
-void DenoiseElementPrivate::makeTable(int factor)
+QVector<int> DenoiseElementPrivate::makeTable(int factor)
 {
-    for (int s = 0; s < 128; s++) {
-        int h = -2 * s * s;
+    QVector<int> table(128 << 9);
+    auto tableData = table.data();
 
-        for (int m = 0; m < 256; m++)
-            for (int c = 0; c < 256; c++) {
-                if (s == 0) {
-                    this->m_weight[(m << 16) | (s << 8) | c] = 0;
+    AkScheduler::parallelFor(128, 8, [tableData, factor] (int begin, int end) {
+        for (int s = begin; s < end; s++) {
+            int *weights = tableData + (s << 9);
+
+            if (s == 0) {
+                memset(weights, 0, WEIGHTS_LINE_SIZE * sizeof(int));
+
+                continue;
+            }
 
-                    continue;
-                }
+            int h = -2 * s * s;
 
-                int d = c - m;
+            for (int i = 0; i < WEIGHTS_LINE_SIZE; i++) {
+                int d = i - 255;
                 d *= d;
 
-                this->m_weight[(m << 16) | (s << 8) | c] = qRound(factor * exp(qreal(d) / h));
+                weights[i] = qRound(factor * exp(qreal(d) / h));
             }
-    }
+        }
+    });
+
+    return table;
 }
 
 QString DenoiseElement::controlInterfaceProvide(const QString &controlId) const
@@ -232,7 +610,11 @@ void DenoiseElement::setFactor(int factor)
     if (this->d->m_factor == factor)
         return;
 
+    auto weights = DenoiseElementPrivate::makeTable(factor);
+    this->d->m_mutex.lock();
     this->d->m_factor = factor;
+    this->d->m_weights = weights;
+    this->d->m_mutex.unlock();
     emit this->factorChanged(factor);
 }
 
@@ -288,73 +670,98 @@ AkPacket DenoiseElement::iStream(const AkPacket &packet)
 
     src = src.convertToFormat(QImage::Format_ARGB32);
 
-    static int factor = 1024;
+    this->d->m_mutex.lock();
+    auto weights = this->d->m_weights;
+    this->d->m_mutex.unlock();
 
-    if (this->d->m_factor != factor) {
-        this->d->makeTable(factor);
-        factor = this->d->m_factor;
-    }
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
+
+    int planeSize = src.width() * src.height();
+    auto planesBuffer = AkBufferPool::buffer(3 * planeSize);
 
-    QImage oFrame(src.size(), src.format());
+    if (!planesBuffer)
+        return AkPacket();
 
-    int oWidth = src.width() + 1;
-    int oHeight = src.height() + 1;
-    PixelU8 *planes = new PixelU8[oWidth * oHeight];
-    PixelU32 *integral = new PixelU32[oWidth * oHeight];
-    PixelU64 *integral2 = new PixelU64[oWidth * oHeight];
-    this->d->integralImage(src,
-                           oWidth, oHeight,
-                           planes, integral, integral2);
+    auto planes = planesBuffer.data<quint8>();
+
+    AkScheduler::parallelFor(src.height(), MIN_BAND_HEIGHT, [&] (int begin, int end) {
+        DenoiseElementPrivate::splitPlanes(src, planes, begin, end);
+    });
+
+    int kernelSize = 2 * radius + 1;
 
     DenoiseStaticParams staticParams;
-    staticParams.planes = planes;
-    staticParams.integral = integral;
-    staticParams.integral2 = integral2;
+    staticParams.planes[0] = planes;
+    staticParams.planes[1] = planes + planeSize;
+    staticParams.planes[2] = planes + 2 * planeSize;
     staticParams.width = src.width();
-    staticParams.oWidth = oWidth;
-    staticParams.weights = this->d->m_weight;
+    staticParams.height = src.height();
+    staticParams.radius = radius;
+    staticParams.weights = weights.constData();
     staticParams.mu = this->d->m_mu;
     staticParams.sigma = this->d->m_sigma < 0.1? 0.1: this->d->m_sigma;
+    staticParams.useHistogram = kernelSize * kernelSize >= MIN_HISTOGRAM_PIXELS;
+    staticParams.useColumnHistograms =
+            staticParams.useHistogram
+            && kernelSize >= MIN_COLUMN_HISTOGRAM_HEIGHT;
 
-    QThreadPool threadPool;
-
-    if (threadPool.maxThreadCount() < 8)
-        threadPool.setMaxThreadCount(8);
-
-    for (int y = 0, pos = 0; y < src.height(); y++) {
-        const QRgb *iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-        int yp = qMax(y - radius, 0);
-        int kh = qMin(y + radius, src.height() - 1) - yp + 1;
-
-        for (int x = 0; x < src.width(); x++, pos++) {
-            int xp = qMax(x - radius, 0);
-            int kw = qMin(x + radius, src.width() - 1) - xp + 1;
-
-            auto params = new DenoiseParams();
-            params->xp = xp;
-            params->yp = yp;
-            params->kw = kw;
-            params->kh = kh;
-            params->iPixel = planes[pos];
-            params->oPixel = oLine + x;
-            params->alpha = qAlpha(iLine[x]);
-
-            if (radius >= 20)
-                QtConcurrent::run(&threadPool,
-                                  DenoiseElementPrivate::denoise,
-                                  staticParams,
-                                  params);
-            else
-                this->d->denoise(staticParams, params);
+    auto kernels = DenoiseKernels::byInstructionSet(AkSimd::instructionSet());
+
+    // Don't detach the output frame from the worker threads.
+    auto oBits = oFrame.bits();
+    auto oLineSize = oFrame.bytesPerLine();
+
+    // Every band keeps its own columns, plus the empty one.
+    int columnsCount = 3 * (src.width() + 1);
+    int sum2Size = columnsCount * int(sizeof(quint64));
+    int sumSize = columnsCount * int(sizeof(quint32));
+    int histogramsSize = staticParams.useColumnHistograms?
+                             columnsCount * 256 * int(sizeof(quint16)): 0;
+    QAtomicInt failed(0);
+
+    AkScheduler::parallelFor(src.height(), MIN_BAND_HEIGHT, [&] (int begin, int end) {
+        auto columnsBuffer =
+                AkBufferPool::buffer(sum2Size + sumSize + histogramsSize);
+
+        if (!columnsBuffer) {
+            failed.store(1);
+
+            return;
         }
-    }
 
-    threadPool.waitForDone();
+        auto columnsData = columnsBuffer.data<quint8>();
+        memset(columnsData, 0, size_t(sum2Size + sumSize + histogramsSize));
+
+        DenoiseColumns columns;
+        columns.sum2 = reinterpret_cast<quint64 *>(columnsData);
+        columns.sum = reinterpret_cast<quint32 *>(columnsData + sum2Size);
+        columns.histograms =
+                reinterpret_cast<quint16 *>(columnsData + sum2Size + sumSize);
+
+        int yp = qMax(begin - radius, 0);
+        int yEnd = qMin(begin + radius, src.height() - 1);
+
+        for (int y = yp; y <= yEnd; y++)
+            DenoiseElementPrivate::updateColumns(staticParams,
+                                                 columns,
+                                                 y, 0, src.width(),
+                                                 1);
+
+        for (int y = begin; y < end; y++) {
+            auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+            auto oLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
+            DenoiseElementPrivate::denoiseLine(staticParams,
+                                               kernels,
+                                               columns,
+                                               iLine,
+                                               oLine,
+                                               y,
+                                               y > begin);
+        }
+    });
 
-    delete [] planes;
-    delete [] integral;
-    delete [] integral2;
+    if (failed.load())
+        return AkPacket();
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -22,30 +22,44 @@
 
 #include "pixel.h"
 
-struct DenoiseParams
-{
-    int xp;
-    int yp;
-    int kw;
-    int kh;
-    PixelU8 iPixel;
-    QRgb *oPixel;
-    int alpha;
-};
-
 struct DenoiseStaticParams
 {
-    const PixelU8 *planes;
-    const PixelU32 *integral;
-    const PixelU64 *integral2;
+    // One plane per color component.
+    const quint8 *planes[3];
 
     int width;
-    int oWidth;
+    int height;
+    int radius;
 
     const int *weights;
 
     int mu;
     qreal sigma;
+
+    // Weight the pixels from the window histogram instead of one by one.
+    bool useHistogram;
+
+    // Add the histograms of the columns to the window instead of their
+    // pixels.
+    bool useColumnHistograms;
+};
+
+// Histograms and sums of the rows of the window of every column, indexed by
+// 3 * x + component. The column at x = width is kept empty, and stands for
+// the columns out of the frame.
+struct DenoiseColumns
+{
+    quint64 *sum2;
+    quint32 *sum;
+    quint16 *histograms;
+};
+
+// Sliding window of a row.
+struct DenoiseWindow
+{
+    int histogram[3][256];
+    quint32 sum[3];
+    quint64 sum2[3];
 };
 
 #endif // PARAMS_H
@@ -171,19 +171,6 @@ template<typename T> Pixel<T> bound(T min, const Pixel<T> &pixel, T max)
                     qBound(min, pixel.b, max));
 }
 
-template<typename T> inline Pixel<T> integralSum(const Pixel<T> *integral,
-                                                 int lineWidth,
-                                                 int x, int y, int kw, int kh)
-{
-
-    const Pixel<T> *p0 = integral + x + y * lineWidth;
-    const Pixel<T> *p1 = p0 + kw;
-    const Pixel<T> *p2 = p0 + kh * lineWidth;
-    const Pixel<T> *p3 = p2 + kw;
-
-    return *p0 + *p3 - *p1 - *p2;
-}
-
 template <typename T> inline Pixel<quint32> operator *(quint32 c, const Pixel<T> &pixel)
 {
     return Pixel<quint32>(c * pixel.r,
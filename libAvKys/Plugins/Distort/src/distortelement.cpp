@@ -23,6 +23,8 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
 
 #include "distortelement.h"
@@ -178,7 +180,7 @@ AkPacket DistortElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame = QImage(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     const QRgb *srcBits = reinterpret_cast<const QRgb *>(src.constBits());
     QRgb *destBits = reinterpret_cast<QRgb *>(oFrame.bits());
@@ -191,59 +193,61 @@ AkPacket DistortElement::iStream(const AkPacket &packet)
     int gridX = src.width() / gridSize;
     int gridY = src.height() / gridSize;
 
-    for (int y = 0; y < gridY; y++)
-        for (int x = 0; x < gridX; x++) {
-            int offset = x + y * (gridX + 1);
+    AkScheduler::parallelFor(gridY, 1, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++)
+            for (int x = 0; x < gridX; x++) {
+                int offset = x + y * (gridX + 1);
 
-            QPoint upperLeft  = grid[offset];
-            QPoint lowerLeft  = grid[offset + gridX + 1];
-            QPoint upperRight = grid[offset + 1];
-            QPoint lowerRight = grid[offset + gridX + 2];
+                QPoint upperLeft  = grid[offset];
+                QPoint lowerLeft  = grid[offset + gridX + 1];
+                QPoint upperRight = grid[offset + 1];
+                QPoint lowerRight = grid[offset + gridX + 2];
 
-            int startColXX = upperLeft.x();
-            int startColYY = upperLeft.y();
-            int endColXX = upperRight.x();
-            int endColYY = upperRight.y();
+                int startColXX = upperLeft.x();
+                int startColYY = upperLeft.y();
+                int endColXX = upperRight.x();
+                int endColYY = upperRight.y();
 
-            int stepStartColX = (lowerLeft.x() - upperLeft.x())
-                                >> gridSizeLog;
+                int stepStartColX = (lowerLeft.x() - upperLeft.x())
+                                    >> gridSizeLog;
 
-            int stepStartColY = (lowerLeft.y() - upperLeft.y())
-                                >> gridSizeLog;
+                int stepStartColY = (lowerLeft.y() - upperLeft.y())
+                                    >> gridSizeLog;
 
-            int stepEndColX = (lowerRight.x() - upperRight.x())
-                              >> gridSizeLog;
+                int stepEndColX = (lowerRight.x() - upperRight.x())
+                                  >> gridSizeLog;
 
-            int stepEndColY = (lowerRight.y() - upperRight.y())
-                              >> gridSizeLog;
+                int stepEndColY = (lowerRight.y() - upperRight.y())
+                                  >> gridSizeLog;
 
-            int pos = (y << gridSizeLog) * src.width() + (x << gridSizeLog);
+                int pos = (y << gridSizeLog) * src.width() + (x << gridSizeLog);
 
-            for (int blockY = 0; blockY < gridSize; blockY++) {
-                int xLineIndex = startColXX;
-                int yLineIndex = startColYY;
+                for (int blockY = 0; blockY < gridSize; blockY++) {
+                    int xLineIndex = startColXX;
+                    int yLineIndex = startColYY;
 
-                int stepLineX = (endColXX - startColXX) >> gridSizeLog;
-                int stepLineY = (endColYY - startColYY) >> gridSizeLog;
+                    int stepLineX = (endColXX - startColXX) >> gridSizeLog;
+                    int stepLineY = (endColYY - startColYY) >> gridSizeLog;
 
-                for (int i = 0, blockX = 0; blockX < gridSize; i++, blockX++) {
-                    int xx = qBound(0, xLineIndex, src.width() - 1);
-                    int yy = qBound(0, yLineIndex, src.height() - 1);
+                    for (int i = 0, blockX = 0; blockX < gridSize; i++, blockX++) {
+                        int xx = qBound(0, xLineIndex, src.width() - 1);
+                        int yy = qBound(0, yLineIndex, src.height() - 1);
 
-                    xLineIndex += stepLineX;
-                    yLineIndex += stepLineY;
+                        xLineIndex += stepLineX;
+                        yLineIndex += stepLineY;
 
-                    destBits[pos + i] = srcBits[xx + yy * src.width()];
-                }
+                        destBits[pos + i] = srcBits[xx + yy * src.width()];
+                    }
 
-                startColXX += stepStartColX;
-                endColXX   += stepEndColX;
-                startColYY += stepStartColY;
-                endColYY   += stepEndColY;
+                    startColXX += stepStartColX;
+                    endColXX   += stepEndColX;
+                    startColYY += stepStartColY;
+                    endColYY   += stepEndColY;
 
-                pos += src.width() - gridSize + gridSize;
+                    pos += src.width() - gridSize + gridSize;
+                }
             }
-        }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
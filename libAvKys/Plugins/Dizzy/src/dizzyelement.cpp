@@ -21,6 +21,7 @@
 #include <QPainter>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "dizzyelement.h"
@@ -137,7 +138,7 @@ AkPacket DizzyElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     oFrame.fill(0);
 
     if (this->d->m_prevFrame.isNull()) {
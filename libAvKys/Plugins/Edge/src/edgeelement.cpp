@@ -22,7 +22,9 @@
 #include <QVector>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
 
 #include "edgeelement.h"
 
@@ -67,18 +69,21 @@ bool EdgeElement::invert() const
 QVector<quint8> EdgeElement::equalize(const QImage &image)
 {
     int videoArea = image.width() * image.height();
-    const quint8 *imgPtr = image.constBits();
     QVector<quint8> out(videoArea);
     quint8 *outPtr = out.data();
     int minGray = 255;
     int maxGray = 0;
 
-    for (int i = 0; i < videoArea; i++) {
-        if (imgPtr[i] < minGray)
-            minGray = imgPtr[i];
+    for (int y = 0; y < image.height(); y++) {
+        const quint8 *imgLine = image.constScanLine(y);
 
-        if (imgPtr[i] > maxGray)
-            maxGray = imgPtr[i];
+        for (int x = 0; x < image.width(); x++) {
+            if (imgLine[x] < minGray)
+                minGray = imgLine[x];
+
+            if (imgLine[x] > maxGray)
+                maxGray = imgLine[x];
+        }
     }
 
     if (maxGray == minGray)
@@ -86,8 +91,13 @@ QVector<quint8> EdgeElement::equalize(const QImage &image)
     else {
         int diffGray = maxGray - minGray;
 
-        for (int i = 0; i < videoArea; i++)
-            outPtr[i] = quint8(255 * (imgPtr[i] - minGray) / diffGray);
+        for (int y = 0; y < image.height(); y++) {
+            const quint8 *imgLine = image.constScanLine(y);
+            quint8 *outLine = outPtr + y * image.width();
+
+            for (int x = 0; x < image.width(); x++)
+                outLine[x] = quint8(255 * (imgLine[x] - minGray) / diffGray);
+        }
     }
 
     return out;
@@ -406,22 +416,24 @@ void EdgeElement::resetInvert()
 
 AkPacket EdgeElement::iStream(const AkPacket &packet)
 {
-    QImage src = AkUtils::packetToImage(packet);
+    QImage src = AkUtils::lumaImage(packet);
 
     if (src.isNull())
         return AkPacket();
 
-    src = src.convertToFormat(QImage::Format_Grayscale8);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     QVector<quint8> in;
 
     if (this->m_equalize)
         in = this->equalize(src);
     else {
-        int videoArea = src.width() * src.height();
-        in.resize(videoArea);
-        memcpy(in.data(), src.constBits(), size_t(videoArea));
+        in.resize(src.width() * src.height());
+
+        for (int y = 0; y < src.height(); y++)
+            memcpy(in.data() + y * src.width(),
+                   src.constScanLine(y),
+                   size_t(src.width()));
     }
 
     QVector<quint16> gradient;
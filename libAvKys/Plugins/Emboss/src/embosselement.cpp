@@ -21,7 +21,10 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
 
 #include "embosselement.h"
 
@@ -87,50 +90,54 @@ void EmbossElement::resetBias()
 
 AkPacket EmbossElement::iStream(const AkPacket &packet)
 {
-    QImage src = AkUtils::packetToImage(packet);
+    QImage src = AkUtils::lumaImage(packet);
 
     if (src.isNull())
         return AkPacket();
 
-    src = src.convertToFormat(QImage::Format_Grayscale8);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
-    for (int y = 0; y < src.height(); y++) {
-        int y_m1 = y - 1;
-        int y_p1 = y + 1;
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-        if (y_m1 < 0)
-            y_m1 = 0;
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            int y_m1 = y - 1;
+            int y_p1 = y + 1;
 
-        if (y_p1 >= src.height())
-            y_p1 = src.height() - 1;
+            if (y_m1 < 0)
+                y_m1 = 0;
 
-        const quint8 *srcLine_m1 = src.constScanLine(y_m1);
-        const quint8 *srcLine = src.constScanLine(y);
-        const quint8 *srcLine_p1 = src.constScanLine(y_p1);
-        quint8 *dstLine = oFrame.scanLine(y);
+            if (y_p1 >= src.height())
+                y_p1 = src.height() - 1;
 
-        for (int x = 0; x < src.width(); x++) {
-            int x_m1 = x - 1;
-            int x_p1 = x + 1;
+            const quint8 *srcLine_m1 = src.constScanLine(y_m1);
+            const quint8 *srcLine = src.constScanLine(y);
+            const quint8 *srcLine_p1 = src.constScanLine(y_p1);
+            quint8 *dstLine = oBits + y * oLineSize;
 
-            if (x_m1 < 0)
-                x_m1 = 0;
+            for (int x = 0; x < src.width(); x++) {
+                int x_m1 = x - 1;
+                int x_p1 = x + 1;
 
-            if (x_p1 >= src.width())
-                x_p1 = src.width() - 1;
+                if (x_m1 < 0)
+                    x_m1 = 0;
 
-            int gray = srcLine_m1[x_m1] * 2
-                     + srcLine_m1[x]
-                     + srcLine[x_m1]
-                     - srcLine[x_p1]
-                     - srcLine_p1[x]
-                     - srcLine_p1[x_p1] * 2;
+                if (x_p1 >= src.width())
+                    x_p1 = src.width() - 1;
 
-            gray = qRound(this->m_factor * gray + this->m_bias);
-            dstLine[x] = quint8(qBound(0, gray, 255));
+                int gray = srcLine_m1[x_m1] * 2
+                         + srcLine_m1[x]
+                         + srcLine[x_m1]
+                         - srcLine[x_p1]
+                         - srcLine_p1[x]
+                         - srcLine_p1[x_p1] * 2;
+
+                gray = qRound(this->m_factor * gray + this->m_bias);
+                dstLine[x] = quint8(qBound(0, gray, 255));
+            }
         }
-    }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -20,6 +20,7 @@
 #include <QImage>
 #include <QVector>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "equalizeelement.h"
@@ -82,7 +83,7 @@ AkPacket EqualizeElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     QVector<quint8> equTable = this->equalizationTable(src);
 
     for (int y = 0; y < src.height(); y++) {
@@ -36,6 +36,7 @@ CONFIG += plugin
 HEADERS = \
     src/facedetect.h \
     src/facedetectelement.h \
+    src/facetracker.h \
     src/haar/haarcascade.h \
     src/haar/haardetector.h \
     src/haar/haarfeature.h \
@@ -49,7 +50,7 @@ LIBS += -L$${PWD}/../../Lib/ -l$${COMMONS_TARGET}
 
 OTHER_FILES += pspec.json
 
-QT += qml widgets concurrent
+QT += qml widgets
 
 RESOURCES += \
     FaceDetect.qrc \
@@ -59,6 +60,7 @@ RESOURCES += \
 SOURCES = \
     src/facedetect.cpp \
     src/facedetectelement.cpp \
+    src/facetracker.cpp \
     src/haar/haarcascade.cpp \
     src/haar/haardetector.cpp \
     src/haar/haarfeature.cpp \
@@ -224,6 +224,34 @@ GridLayout {
         onTextChanged: FaceDetect.scanSize = strToSize(text)
     }
 
+    // Detect interval.
+    Label {
+        text: qsTr("Detect every N frames")
+    }
+    TextField {
+        text: FaceDetect.detectInterval
+        validator: RegExpValidator {
+            regExp: /\d+/
+        }
+        Layout.fillWidth: true
+
+        onTextChanged: FaceDetect.detectInterval = text
+    }
+
+    // Track radius.
+    Label {
+        text: qsTr("Tracking radius")
+    }
+    TextField {
+        text: FaceDetect.trackRadius
+        validator: RegExpValidator {
+            regExp: /\d+/
+        }
+        Layout.fillWidth: true
+
+        onTextChanged: FaceDetect.trackRadius = text
+    }
+
     // Marker type.
     Label {
         text: qsTr("Marker type")
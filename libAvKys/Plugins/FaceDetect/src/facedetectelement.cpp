@@ -19,14 +19,20 @@
 
 #include <QVariant>
 #include <QMap>
+#include <QElapsedTimer>
 #include <QDir>
 #include <QStandardPaths>
 #include <QPainter>
 #include <QQmlContext>
 #include <akutils.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
+#include <akvideoscaler.h>
+#include <akscheduler.h>
+#include <aklatencyhistogram.h>
 
 #include "facedetectelement.h"
+#include "facetracker.h"
 #include "haar/haardetector.h"
 
 typedef QMap<FaceDetectElement::MarkerType, QString> MarkerTypeMap;
@@ -75,6 +81,30 @@ class FaceDetectElementPrivate
         QSize m_scanSize;
         AkElementPtr m_blurFilter;
         HaarDetector m_cascadeClassifier;
+        AkVideoScaler m_scaler;
+        int m_detectInterval {1};
+        int m_trackRadius {8};
+        int m_framesToDetect {0};
+        FaceTracker m_tracker;
+
+        // Tracking stats, times are in nanoseconds since m_timer started.
+        QElapsedTimer m_timer;
+        AkLatencyHistogram m_detectTime;
+        AkLatencyHistogram m_trackTime;
+        AkLatencyHistogram m_reacquireTime;
+        QAtomicInteger<qint64> m_framesDetected {0};
+        QAtomicInteger<qint64> m_framesTracked {0};
+        QAtomicInteger<qint64> m_facesLost {0};
+        QAtomicInteger<qint64> m_busyTime {0};
+        QAtomicInteger<qint64> m_cpuTime {0};
+        QAtomicInteger<qint64> m_firstTime {-1};
+        QAtomicInteger<qint64> m_lastTime {-1};
+        QAtomicInteger<qint64> m_lostTime {-1};
+
+        // CPU time of the detector when the stats were reset.
+        QAtomicInteger<qint64> m_detectorCpuTime {0};
+
+        void faceLost(qint64 time);
 };
 
 FaceDetectElement::FaceDetectElement(): AkElement()
@@ -90,8 +120,10 @@ FaceDetectElement::FaceDetectElement(): AkElement()
     this->d->m_markerImg = QImage(this->d->m_markerImage);
     this->d->m_pixelGridSize = QSize(32, 32);
     this->d->m_scanSize = QSize(160, 120);
+    this->d->m_scaler.setScalingMode(AkVideoScaler::ScalingMode_Nearest);
     this->d->m_blurFilter = AkElement::create("Blur");
     this->d->m_blurFilter->setProperty("radius", 32);
+    this->d->m_timer.start();
 
     QObject::connect(this->d->m_blurFilter.data(),
                      SIGNAL(radiusChanged(int)),
@@ -152,6 +184,39 @@ QSize FaceDetectElement::scanSize() const
     return this->d->m_scanSize;
 }
 
+int FaceDetectElement::detectInterval() const
+{
+    return this->d->m_detectInterval;
+}
+
+int FaceDetectElement::trackRadius() const
+{
+    return this->d->m_trackRadius;
+}
+
+QVariantMap FaceDetectElement::trackingStats() const
+{
+    qint64 duration = this->d->m_lastTime.load() - this->d->m_firstTime.load();
+    qreal busyFraction = duration > 0?
+                             qreal(this->d->m_busyTime.load()) / duration: 0.0;
+    qint64 cpuTime = this->d->m_cpuTime.load()
+                     + this->d->m_cascadeClassifier.cpuTime()
+                     - this->d->m_detectorCpuTime.load();
+    qreal cpuLoad = duration > 0? qreal(cpuTime) / duration: 0.0;
+
+    return QVariantMap {
+        {"framesDetected", this->d->m_framesDetected.load()},
+        {"framesTracked" , this->d->m_framesTracked.load() },
+        {"facesLost"     , this->d->m_facesLost.load()     },
+        {"busyFraction"  , busyFraction                    },
+        {"cpuTime"       , cpuTime                         },
+        {"cpuLoad"       , cpuLoad                         },
+        {"detectTime"    , this->d->m_detectTime.toMap()   },
+        {"trackTime"     , this->d->m_trackTime.toMap()    },
+        {"reacquireTime" , this->d->m_reacquireTime.toMap()},
+    };
+}
+
 QString FaceDetectElement::controlInterfaceProvide(const QString &controlId) const
 {
     Q_UNUSED(controlId)
@@ -265,6 +330,24 @@ void FaceDetectElement::setScanSize(const QSize &scanSize)
     emit this->scanSizeChanged(scanSize);
 }
 
+void FaceDetectElement::setDetectInterval(int detectInterval)
+{
+    if (this->d->m_detectInterval == detectInterval)
+        return;
+
+    this->d->m_detectInterval = detectInterval;
+    emit this->detectIntervalChanged(detectInterval);
+}
+
+void FaceDetectElement::setTrackRadius(int trackRadius)
+{
+    if (this->d->m_trackRadius == trackRadius)
+        return;
+
+    this->d->m_trackRadius = trackRadius;
+    emit this->trackRadiusChanged(trackRadius);
+}
+
 void FaceDetectElement::resetHaarFile()
 {
     this->setHaarFile(":/FaceDetect/share/haarcascades/haarcascade_frontalface_alt.xml");
@@ -310,6 +393,32 @@ void FaceDetectElement::resetScanSize()
     this->setScanSize(QSize(160, 120));
 }
 
+void FaceDetectElement::resetDetectInterval()
+{
+    this->setDetectInterval(1);
+}
+
+void FaceDetectElement::resetTrackRadius()
+{
+    this->setTrackRadius(8);
+}
+
+void FaceDetectElement::resetTrackingStats()
+{
+    this->d->m_detectTime.reset();
+    this->d->m_trackTime.reset();
+    this->d->m_reacquireTime.reset();
+    this->d->m_framesDetected.store(0);
+    this->d->m_framesTracked.store(0);
+    this->d->m_facesLost.store(0);
+    this->d->m_busyTime.store(0);
+    this->d->m_cpuTime.store(0);
+    this->d->m_detectorCpuTime.store(this->d->m_cascadeClassifier.cpuTime());
+    this->d->m_firstTime.store(-1);
+    this->d->m_lastTime.store(-1);
+    this->d->m_lostTime.store(-1);
+}
+
 AkPacket FaceDetectElement::iStream(const AkPacket &packet)
 {
     QSize scanSize(this->d->m_scanSize);
@@ -318,27 +427,89 @@ AkPacket FaceDetectElement::iStream(const AkPacket &packet)
         || scanSize.isEmpty())
         akSend(packet)
 
-    QImage src = AkUtils::packetToImage(packet);
+    // The detector only needs the luma, so the frame is only converted to
+    // ARGB if there are markers to draw.
+    QImage luma = AkUtils::lumaImage(packet);
 
-    if (src.isNull())
+    if (luma.isNull())
         return AkPacket();
 
-    QImage oFrame = src.convertToFormat(QImage::Format_ARGB32);
     qreal scale = 1;
 
-    QImage scanFrame(src.scaled(scanSize, Qt::KeepAspectRatio));
+    QImage scanFrame =
+            this->d->m_scaler.scale(luma,
+                                    luma.size().scaled(scanSize,
+                                                       Qt::KeepAspectRatio));
 
     if (scanFrame.width() == scanSize.width())
-        scale = qreal(src.width() / scanSize.width());
+        scale = qreal(luma.width() / scanSize.width());
     else
-        scale = qreal(src.height() / scanSize.height());
+        scale = qreal(luma.height() / scanSize.height());
+
+    qint64 frameTime = this->d->m_timer.nsecsElapsed();
+    this->d->m_firstTime.testAndSetRelaxed(-1, frameTime);
+    QVector<QRect> vecFaces;
+    bool tracked = false;
+
+    {
+        AkCpuTimer cpuTimer(&this->d->m_cpuTime);
+
+        if (this->d->m_framesToDetect > 0) {
+            this->d->m_framesToDetect--;
+            tracked = this->d->m_tracker.track(scanFrame,
+                                               this->d->m_trackRadius,
+                                               &vecFaces);
+            this->d->m_trackTime.record(this->d->m_timer.nsecsElapsed()
+                                        - frameTime);
+
+            if (tracked)
+                this->d->m_framesTracked.fetchAndAddRelaxed(1);
+            else
+                this->d->faceLost(frameTime);
+        }
+
+        if (!tracked) {
+            qint64 detectTime = this->d->m_timer.nsecsElapsed();
+            this->d->m_cascadeClassifier.setEqualize(true);
+            vecFaces = this->d->m_cascadeClassifier.detect(scanFrame);
+            qint64 now = this->d->m_timer.nsecsElapsed();
+            this->d->m_detectTime.record(now - detectTime);
+            this->d->m_framesDetected.fetchAndAddRelaxed(1);
+
+            if (vecFaces.isEmpty()) {
+                if (!this->d->m_tracker.isEmpty())
+                    this->d->faceLost(frameTime);
+
+                this->d->m_framesToDetect = 0;
+            } else {
+                qint64 lostTime = this->d->m_lostTime.fetchAndStoreRelaxed(-1);
+
+                if (lostTime >= 0)
+                    this->d->m_reacquireTime.record(now - lostTime);
 
-    this->d->m_cascadeClassifier.setEqualize(true);
-    QVector<QRect> vecFaces = this->d->m_cascadeClassifier.detect(scanFrame);
+                this->d->m_framesToDetect = this->d->m_detectInterval - 1;
+            }
+
+            this->d->m_tracker.setFaces(scanFrame, vecFaces);
+        }
+    }
+
+    qint64 now = this->d->m_timer.nsecsElapsed();
+    this->d->m_busyTime.fetchAndAddRelaxed(now - frameTime);
+    this->d->m_lastTime.store(now);
 
     if (vecFaces.isEmpty())
         akSend(packet)
 
+    QImage src =
+            AkUtils::packetToImage(AkUtils::convertVideo(packet,
+                                                         AkVideoCaps::Format_argb).toPacket());
+
+    if (src.isNull())
+        return AkPacket();
+
+    QImage oFrame = src;
+
     QPainter painter;
     painter.begin(&oFrame);
 
@@ -361,14 +532,12 @@ AkPacket FaceDetectElement::iStream(const AkPacket &packet)
             qreal sh = 1.0 / this->d->m_pixelGridSize.height();
             QImage imagePixelate = src.copy(rect);
 
-            imagePixelate = imagePixelate.scaled(int(sw * imagePixelate.width()),
-                                                 int(sh * imagePixelate.height()),
-                                                 Qt::IgnoreAspectRatio,
-                                                 Qt::FastTransformation)
-                                         .scaled(imagePixelate.width(),
-                                                 imagePixelate.height(),
-                                                 Qt::IgnoreAspectRatio,
-                                                 Qt::FastTransformation);
+            QImage blocks =
+                    this->d->m_scaler.scale(imagePixelate,
+                                            int(sw * imagePixelate.width()),
+                                            int(sh * imagePixelate.height()));
+            imagePixelate = this->d->m_scaler.scale(blocks,
+                                                    imagePixelate.size());
 
             painter.drawImage(rect, imagePixelate);
         } else if (this->d->m_markerType == MarkerTypeBlur) {
@@ -386,4 +555,11 @@ AkPacket FaceDetectElement::iStream(const AkPacket &packet)
     akSend(oPacket)
 }
 
+void FaceDetectElementPrivate::faceLost(qint64 time)
+{
+    // Only the first frame without faces counts, until they are found again.
+    if (this->m_lostTime.testAndSetRelaxed(-1, time))
+        this->m_facesLost.fetchAndAddRelaxed(1);
+}
+
 #include "moc_facedetectelement.cpp"
@@ -74,6 +74,19 @@ class FaceDetectElement: public AkElement
                    WRITE setScanSize
                    RESET resetScanSize
                    NOTIFY scanSizeChanged)
+        Q_PROPERTY(int detectInterval
+                   READ detectInterval
+                   WRITE setDetectInterval
+                   RESET resetDetectInterval
+                   NOTIFY detectIntervalChanged)
+        Q_PROPERTY(int trackRadius
+                   READ trackRadius
+                   WRITE setTrackRadius
+                   RESET resetTrackRadius
+                   NOTIFY trackRadiusChanged)
+        Q_PROPERTY(QVariantMap trackingStats
+                   READ trackingStats
+                   RESET resetTrackingStats)
 
     public:
         enum MarkerType
@@ -98,6 +111,24 @@ class FaceDetectElement: public AkElement
         Q_INVOKABLE int blurRadius() const;
         Q_INVOKABLE QSize scanSize() const;
 
+        // Faces are fully detected once every detectInterval frames, and
+        // tracked in the frames in between, up to trackRadius pixels of the
+        // scan frame around their last position. If the tracker loses any of
+        // the faces, or there are no faces to track, the faces are detected
+        // in that same frame.
+        Q_INVOKABLE int detectInterval() const;
+        Q_INVOKABLE int trackRadius() const;
+
+        // Frames detected and tracked, their processing time, the time taken
+        // to find the faces again after losing them, and busyFraction, the
+        // fraction of the stream time spent detecting and tracking. It's
+        // wall-clock busy time, not CPU use: it includes the time waiting for
+        // the scheduler threads or being preempted. cpuTime is the CPU time
+        // used detecting and tracking, in nanoseconds, summed over all the
+        // threads including the detector tasks, and cpuLoad is cpuTime over
+        // the stream time, it goes above 1 when using more than one core.
+        Q_INVOKABLE QVariantMap trackingStats() const;
+
     private:
         FaceDetectElementPrivate *d;
 
@@ -116,6 +147,8 @@ class FaceDetectElement: public AkElement
         void pixelGridSizeChanged(const QSize &pixelGridSize);
         void blurRadiusChanged(int blurRadius);
         void scanSizeChanged(const QSize &scanSize);
+        void detectIntervalChanged(int detectInterval);
+        void trackRadiusChanged(int trackRadius);
 
     public slots:
         void setHaarFile(const QString &haarFile);
@@ -127,6 +160,8 @@ class FaceDetectElement: public AkElement
         void setPixelGridSize(const QSize &pixelGridSize);
         void setBlurRadius(int blurRadius);
         void setScanSize(const QSize &scanSize);
+        void setDetectInterval(int detectInterval);
+        void setTrackRadius(int trackRadius);
         void resetHaarFile();
         void resetMarkerType();
         void resetMarkerColor();
@@ -136,6 +171,9 @@ class FaceDetectElement: public AkElement
         void resetPixelGridSize();
         void resetBlurRadius();
         void resetScanSize();
+        void resetDetectInterval();
+        void resetTrackRadius();
+        void resetTrackingStats();
         AkPacket iStream(const AkPacket &packet);
 };
 
@@ -0,0 +1,162 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#include <climits>
+
+#include "facetracker.h"
+
+// Maximum number of pixels sampled in each side of a face.
+#define TEMPLATE_SIZE 24
+
+// Mean absolute difference, in gray levels, above which a face is considered
+// lost.
+#define MAX_TRACKING_ERROR 24
+
+FaceTracker::FaceTracker():
+    m_lineSize(0)
+{
+}
+
+bool FaceTracker::isEmpty() const
+{
+    return this->m_faces.isEmpty();
+}
+
+void FaceTracker::setFaces(const QImage &frame, const QVector<QRect> &faces)
+{
+    this->clear();
+
+    if (frame.format() != QImage::Format_Grayscale8)
+        return;
+
+    this->m_frameSize = frame.size();
+    this->m_lineSize = frame.bytesPerLine();
+    QRect frameRect = frame.rect();
+
+    for (const QRect &face: faces) {
+        if (face.isEmpty() || !frameRect.contains(face))
+            continue;
+
+        // Big faces are sampled in a sparse grid, the search costs the same
+        // whatever the size of the face.
+        int stepX = qMax(1, (face.width() + TEMPLATE_SIZE - 1) / TEMPLATE_SIZE);
+        int stepY = qMax(1, (face.height() + TEMPLATE_SIZE - 1) / TEMPLATE_SIZE);
+        int columns = (face.width() + stepX - 1) / stepX;
+        int rows = (face.height() + stepY - 1) / stepY;
+
+        QVector<int> offsets(columns * rows);
+        QVector<quint8> values(columns * rows);
+        int i = 0;
+
+        for (int y = 0; y < face.height(); y += stepY) {
+            auto line = frame.constScanLine(face.y() + y) + face.x();
+
+            for (int x = 0; x < face.width(); x += stepX, i++) {
+                offsets[i] = y * this->m_lineSize + x;
+                values[i] = line[x];
+            }
+        }
+
+        this->m_faces << face;
+        this->m_offsets << offsets;
+        this->m_values << values;
+        this->m_columns << columns;
+    }
+}
+
+bool FaceTracker::track(const QImage &frame, int radius, QVector<QRect> *faces)
+{
+    if (this->m_faces.isEmpty()
+        || frame.format() != QImage::Format_Grayscale8
+        || frame.size() != this->m_frameSize
+        || frame.bytesPerLine() != this->m_lineSize)
+        return false;
+
+    radius = qMax(radius, 0);
+    auto bits = frame.constBits();
+
+    for (int i = 0; i < this->m_faces.size(); i++) {
+        QRect &face = this->m_faces[i];
+        int minX = qMax(face.x() - radius, 0);
+        int maxX = qMin(face.x() + radius, frame.width() - face.width());
+        int minY = qMax(face.y() - radius, 0);
+        int maxY = qMin(face.y() + radius, frame.height() - face.height());
+
+        // Start from the last position, so the face stays still unless there
+        // is a better match.
+        int bestX = face.x();
+        int bestY = face.y();
+        int bestSad = this->sad(bits + bestY * this->m_lineSize + bestX,
+                                i,
+                                INT_MAX);
+
+        for (int y = minY; y <= maxY; y++) {
+            auto line = bits + y * this->m_lineSize;
+
+            for (int x = minX; x <= maxX; x++) {
+                int sad = this->sad(line + x, i, bestSad);
+
+                if (sad < bestSad) {
+                    bestSad = sad;
+                    bestX = x;
+                    bestY = y;
+                }
+            }
+        }
+
+        if (bestSad > MAX_TRACKING_ERROR * this->m_values[i].size())
+            return false;
+
+        face.moveTo(bestX, bestY);
+    }
+
+    *faces = this->m_faces;
+
+    return true;
+}
+
+void FaceTracker::clear()
+{
+    this->m_frameSize = QSize();
+    this->m_lineSize = 0;
+    this->m_faces.clear();
+    this->m_offsets.clear();
+    this->m_values.clear();
+    this->m_columns.clear();
+}
+
+int FaceTracker::sad(const quint8 *window, int face, int maxSad) const
+{
+    auto offsets = this->m_offsets[face].constData();
+    auto values = this->m_values[face].constData();
+    int size = this->m_values[face].size();
+    int columns = this->m_columns[face];
+    int sad = 0;
+
+    // Stop as soon as the position can't be better than the best one so far.
+    for (int i = 0; i < size;) {
+        for (int end = i + columns; i < end; i++)
+            sad += qAbs(int(window[offsets[i]]) - int(values[i]));
+
+        if (sad >= maxSad)
+            break;
+    }
+
+    return sad;
+}
@@ -0,0 +1,60 @@
+/* Webcamoid, webcam capture application.
+ * Copyright (C) 2011-2017  Gonzalo Exequiel Pedone
+ *
+ * Webcamoid is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Webcamoid is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Webcamoid. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Web-Site: http://webcamoid.github.io/
+ */
+
+#ifndef FACETRACKER_H
+#define FACETRACKER_H
+
+#include <QImage>
+
+// Follows the faces found by the detector in the frames between two
+// detections.
+//
+// Each face keeps a template sampled from the frame it was detected in, and in
+// the following frames it's searched in a neighbourhood of its last position,
+// picking the position with the minimum sum of absolute differences. The
+// frames must be in Format_Grayscale8.
+class FaceTracker
+{
+    public:
+        FaceTracker();
+
+        bool isEmpty() const;
+        void setFaces(const QImage &frame, const QVector<QRect> &faces);
+
+        // Moves the faces to their new position in frame, searching up to
+        // radius pixels around the last one. Returns false if any of the faces
+        // is lost, in which case the faces must be detected again.
+        bool track(const QImage &frame, int radius, QVector<QRect> *faces);
+        void clear();
+
+    private:
+        QSize m_frameSize;
+        int m_lineSize;
+        QVector<QRect> m_faces;
+
+        // Pixels sampled from each face, as offsets relative to the top left
+        // corner of the face and their values, in rows of m_columns[i].
+        QVector<QVector<int>> m_offsets;
+        QVector<QVector<quint8>> m_values;
+        QVector<int> m_columns;
+
+        int sad(const quint8 *window, int face, int maxSad) const;
+};
+
+#endif // FACETRACKER_H
@@ -57,19 +57,303 @@
  *     the use of this software, even if advised of the possibility of such damage.
  */
 
+#include <climits>
 #include <QtMath>
 
 #include <QFile>
 #include <QXmlStreamReader>
 #include <QStringList>
+#include <QVarLengthArray>
+#include <aksimd.h>
 
 #include "haarcascade.h"
 
+#ifdef AK_SIMD_X86
+    #define HAAR_SIMD
+    #include <immintrin.h>
+#endif
+
+// Scalar kernels
+
+static inline qreal featureSumScalar(const HaarCascadeHID *cascade,
+                                     int node,
+                                     qint32 offset)
+{
+    auto integral = cascade->m_nodeIntegrals[node] + offset;
+    int rect = node * HAAR_FEATURE_MAX;
+    auto corners = cascade->m_rectOffsets.constData() + 4 * rect;
+    auto weights = cascade->m_rectWeights.constData() + rect;
+    int rects = cascade->m_nodeRects[node];
+    qreal featureSum = 0;
+
+    for (int i = 0; i < rects; i++, corners += 4)
+        featureSum += (integral[corners[0]]
+                     - integral[corners[1]]
+                     - integral[corners[2]]
+                     + integral[corners[3]])
+                    * weights[i];
+
+    return featureSum;
+}
+
+static inline qreal evalTreeScalar(const HaarCascadeHID *cascade,
+                                   int tree,
+                                   qint32 offset,
+                                   qreal varianceNormFactor)
+{
+    int firstNode = cascade->m_treeNodes[tree];
+    int node = firstNode;
+
+    forever {
+        int child = 2 * node;
+
+        if (!(featureSumScalar(cascade, node, offset)
+              < cascade->m_nodeThresholds[node] * varianceNormFactor))
+            child++;
+
+        if (cascade->m_nodeChilds[child] < 0)
+            return cascade->m_nodeValues[child];
+
+        node = firstNode + cascade->m_nodeChilds[child];
+    }
+}
+
+static inline bool passWindowScalar(const HaarCascadeHID *cascade,
+                                    int stage,
+                                    qint32 offset,
+                                    qreal varianceNormFactor)
+{
+    qreal sum = 0;
+
+    for (int tree = cascade->m_stageTrees[stage];
+         tree < cascade->m_stageTrees[stage + 1];
+         tree++)
+        sum += evalTreeScalar(cascade, tree, offset, varianceNormFactor);
+
+    return sum >= cascade->m_stageThresholds[stage];
+}
+
+static int passStageScalar(const HaarCascadeHID *cascade,
+                           int stage,
+                           const qint32 *offsets,
+                           const qreal *varianceNormFactor)
+{
+    return passWindowScalar(cascade,
+                            stage,
+                            offsets[0],
+                            varianceNormFactor[0]);
+}
+
+#ifdef HAAR_SIMD
+// The windows are evaluated with the same double precision operations, and in
+// the same order than the scalar kernels, so the detections don't depend on
+// the instruction set. The rect sums are computed with 32 bits wrap around
+// arithmetic, and converted to double as unsigned integers. SSE2 holds just
+// 2 doubles per register, and it's not faster than the scalar kernels.
+
+// AVX2 kernels
+
+// Expands the 4 lowest bits of the mask to the lanes of a vector.
+AK_SIMD_TARGET("avx2")
+static inline __m256d laneMaskAVX2(int mask)
+{
+    const __m256i bits = _mm256_set_epi64x(8, 4, 2, 1);
+    __m256i lanes = _mm256_and_si256(_mm256_set1_epi64x(mask), bits);
+
+    return _mm256_castsi256_pd(_mm256_cmpeq_epi64(lanes, bits));
+}
+
+// Tests the node in 8 windows, and sets the lanes of the windows that go to
+// the left child. The corners of the rects are gathered from the integral
+// image.
+AK_SIMD_TARGET("avx2")
+static inline void goLeftAVX2(const HaarCascadeHID *cascade,
+                              int node,
+                              __m256i offsets,
+                              __m256d varianceNormFactor0,
+                              __m256d varianceNormFactor1,
+                              __m256d &left0,
+                              __m256d &left1)
+{
+    const __m256i sign = _mm256_set1_epi32(INT_MIN);
+    const __m256d bias = _mm256_set1_pd(2147483648.0);
+    auto integral = reinterpret_cast<const int *>(cascade->m_nodeIntegrals[node]);
+    int rect = node * HAAR_FEATURE_MAX;
+    auto corners = cascade->m_rectOffsets.constData() + 4 * rect;
+    auto weights = cascade->m_rectWeights.constData() + rect;
+    int rects = cascade->m_nodeRects[node];
+    __m256d featureSum0 = _mm256_setzero_pd();
+    __m256d featureSum1 = _mm256_setzero_pd();
+
+    for (int i = 0; i < rects; i++, corners += 4) {
+        __m256i values[4];
+
+        for (int j = 0; j < 4; j++) {
+            __m256i index = _mm256_add_epi32(offsets, _mm256_set1_epi32(corners[j]));
+            values[j] = _mm256_i32gather_epi32(integral, index, 4);
+        }
+
+        __m256i sum = _mm256_sub_epi32(values[0], values[1]);
+        sum = _mm256_sub_epi32(sum, values[2]);
+        sum = _mm256_add_epi32(sum, values[3]);
+        sum = _mm256_xor_si256(sum, sign);
+        __m256d sum0 = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum)), bias);
+        __m256d sum1 = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum, 1)), bias);
+        __m256d weight = _mm256_set1_pd(weights[i]);
+        featureSum0 = _mm256_add_pd(featureSum0, _mm256_mul_pd(sum0, weight));
+        featureSum1 = _mm256_add_pd(featureSum1, _mm256_mul_pd(sum1, weight));
+    }
+
+    __m256d threshold = _mm256_set1_pd(cascade->m_nodeThresholds[node]);
+    left0 = _mm256_cmp_pd(featureSum0,
+                          _mm256_mul_pd(threshold, varianceNormFactor0),
+                          _CMP_LT_OQ);
+    left1 = _mm256_cmp_pd(featureSum1,
+                          _mm256_mul_pd(threshold, varianceNormFactor1),
+                          _CMP_LT_OQ);
+}
+
+AK_SIMD_TARGET("avx2")
+static inline void evalTreeAVX2(const HaarCascadeHID *cascade,
+                                int tree,
+                                __m256i offsets,
+                                __m256d varianceNormFactor0,
+                                __m256d varianceNormFactor1,
+                                __m256d &sum0,
+                                __m256d &sum1)
+{
+    int firstNode = cascade->m_treeNodes[tree];
+    int nodes = cascade->m_treeNodes[tree + 1] - firstNode;
+    __m256d left0;
+    __m256d left1;
+
+    // Most of the trees are stumps, select the leaf without branching.
+    if (nodes == 1) {
+        goLeftAVX2(cascade,
+                   firstNode,
+                   offsets,
+                   varianceNormFactor0,
+                   varianceNormFactor1,
+                   left0,
+                   left1);
+        __m256d leftVal = _mm256_set1_pd(cascade->m_nodeValues[2 * firstNode]);
+        __m256d rightVal = _mm256_set1_pd(cascade->m_nodeValues[2 * firstNode + 1]);
+        sum0 = _mm256_add_pd(sum0, _mm256_blendv_pd(rightVal, leftVal, left0));
+        sum1 = _mm256_add_pd(sum1, _mm256_blendv_pd(rightVal, leftVal, left1));
+
+        return;
+    }
+
+    // Otherwise follow the windows that reach each node, the children come
+    // always after their parent.
+    QVarLengthArray<int, 8> reach(nodes);
+    std::fill(reach.begin(), reach.end(), 0);
+    reach[0] = 0xff;
+    __m256d value0 = _mm256_setzero_pd();
+    __m256d value1 = _mm256_setzero_pd();
+
+    for (int node = 0; node < nodes; node++) {
+        if (!reach[node])
+            continue;
+
+        int i = firstNode + node;
+        goLeftAVX2(cascade,
+                   i,
+                   offsets,
+                   varianceNormFactor0,
+                   varianceNormFactor1,
+                   left0,
+                   left1);
+        int left = (_mm256_movemask_pd(left0) | (_mm256_movemask_pd(left1) << 4))
+                 & reach[node];
+        int right = reach[node] & ~left;
+
+        if (cascade->m_nodeChilds[2 * i] < 0) {
+            __m256d leftVal = _mm256_set1_pd(cascade->m_nodeValues[2 * i]);
+            value0 = _mm256_or_pd(value0, _mm256_and_pd(laneMaskAVX2(left), leftVal));
+            value1 = _mm256_or_pd(value1, _mm256_and_pd(laneMaskAVX2(left >> 4), leftVal));
+        } else {
+            reach[cascade->m_nodeChilds[2 * i]] |= left;
+        }
+
+        if (cascade->m_nodeChilds[2 * i + 1] < 0) {
+            __m256d rightVal = _mm256_set1_pd(cascade->m_nodeValues[2 * i + 1]);
+            value0 = _mm256_or_pd(value0, _mm256_and_pd(laneMaskAVX2(right), rightVal));
+            value1 = _mm256_or_pd(value1, _mm256_and_pd(laneMaskAVX2(right >> 4), rightVal));
+        } else {
+            reach[cascade->m_nodeChilds[2 * i + 1]] |= right;
+        }
+    }
+
+    sum0 = _mm256_add_pd(sum0, value0);
+    sum1 = _mm256_add_pd(sum1, value1);
+}
+
+AK_SIMD_TARGET("avx2")
+static int passStageAVX2(const HaarCascadeHID *cascade,
+                         int stage,
+                         const qint32 *offsets,
+                         const qreal *varianceNormFactor)
+{
+    __m256i offsetsValue = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(offsets));
+    __m256d varianceNormFactor0 = _mm256_loadu_pd(varianceNormFactor);
+    __m256d varianceNormFactor1 = _mm256_loadu_pd(varianceNormFactor + 4);
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+
+    for (int tree = cascade->m_stageTrees[stage];
+         tree < cascade->m_stageTrees[stage + 1];
+         tree++)
+        evalTreeAVX2(cascade,
+                     tree,
+                     offsetsValue,
+                     varianceNormFactor0,
+                     varianceNormFactor1,
+                     sum0,
+                     sum1);
+
+    __m256d threshold = _mm256_set1_pd(cascade->m_stageThresholds[stage]);
+
+    return _mm256_movemask_pd(_mm256_cmp_pd(sum0, threshold, _CMP_GE_OQ))
+         | (_mm256_movemask_pd(_mm256_cmp_pd(sum1, threshold, _CMP_GE_OQ)) << 4);
+}
+#endif
+
+struct HaarKernels
+{
+    // Number of windows evaluated at the same time.
+    int lanes;
+
+    // Evaluates a stage in a group of windows, and returns the mask of the
+    // windows that passed it.
+    int (*passStage)(const HaarCascadeHID *cascade,
+                     int stage,
+                     const qint32 *offsets,
+                     const qreal *varianceNormFactor);
+
+    static HaarKernels byInstructionSet(AkSimd::InstructionSet instructionSet)
+    {
+        HaarKernels kernels = {
+            1,
+            passStageScalar
+        };
+
+#ifdef HAAR_SIMD
+        if (instructionSet >= AkSimd::InstructionSet_AVX2) {
+            kernels.lanes = 8;
+            kernels.passStage = passStageAVX2;
+        }
+#else
+        Q_UNUSED(instructionSet)
+#endif
+
+        return kernels;
+    }
+};
+
 HaarCascadeHID::HaarCascadeHID(const HaarCascade &cascade,
                                int startX,
                                int endX,
-                               int startY,
-                               int endY,
                                int windowWidth,
                                int windowHeight,
                                int oWidth,
@@ -86,13 +370,20 @@ HaarCascadeHID::HaarCascadeHID(const HaarCascade &cascade,
                                QList<QRect> *roi,
                                QMutex *mutex)
 {
-    this->m_count = cascade.m_stages.size();
-    this->m_stages = new HaarStageHID *[this->m_count];
+    this->m_count = cascade.m_stageThresholds.size();
+    this->m_stageTrees = cascade.m_stageTrees.constData();
+    this->m_stageThresholds = cascade.m_stageThresholds.constData();
+    this->m_stageParents = cascade.m_stageParents.constData();
+    this->m_stageNexts = cascade.m_stageNexts.constData();
+    this->m_stageChilds = cascade.m_stageChilds.constData();
+    this->m_treeNodes = cascade.m_treeNodes.constData();
+    this->m_nodeRects = cascade.m_nodeRects.constData();
+    this->m_nodeThresholds = cascade.m_nodeThresholds.constData();
+    this->m_nodeChilds = cascade.m_nodeChilds.constData();
+    this->m_nodeValues = cascade.m_nodeValues.constData();
 
     this->m_startX = startX;
     this->m_endX = endX;
-    this->m_startY = startY;
-    this->m_endY = endY;
     this->m_windowWidth = windowWidth;
     this->m_windowHeight = windowHeight;
     this->m_oWidth = oWidth;
@@ -110,115 +401,238 @@ HaarCascadeHID::HaarCascadeHID(const HaarCascade &cascade,
         this->m_icp[i] = icp[i];
     }
 
-    for (int i = 0; i < this->m_count; i++)
-        this->m_stages[i] = new HaarStageHID(cascade.m_stages[i],
-                                             oWidth,
-                                             integral,
-                                             tiltedIntegral,
-                                             invArea,
-                                             scale);
-
-    for (int i = 0; i < this->m_count; i++) {
-        int parent = cascade.m_stages[i].parentStage();
-        this->m_stages[i]->m_parentStagePtr = parent < 0? nullptr: this->m_stages[parent];
-        int next = cascade.m_stages[i].nextStage();
-        this->m_stages[i]->m_nextStagePtr = next < 0? nullptr: this->m_stages[next];
-        int child = cascade.m_stages[i].childStage();
-        this->m_stages[i]->m_childStagePtr = child < 0? nullptr: this->m_stages[child];
+    // Scale the rects of the features.
+    int nodes = cascade.m_nodeRects.size();
+    this->m_nodeIntegrals.resize(nodes);
+
+    this->m_rectOffsets.fill(0, 4 * nodes * HAAR_FEATURE_MAX);
+    this->m_rectWeights.fill(0, nodes * HAAR_FEATURE_MAX);
+
+    for (int node = 0; node < nodes; node++) {
+        bool tilted = cascade.m_nodeTilted[node];
+        this->m_nodeIntegrals[node] = tilted? tiltedIntegral: integral;
+        qreal area0 = 0;
+        qreal sum0 = 0;
+        int rect = node * HAAR_FEATURE_MAX;
+
+        for (int i = 0; i < cascade.m_nodeRects[node]; i++) {
+            const QRect &featureRect = cascade.m_rects[rect + i];
+            int rectX = qRound(scale * featureRect.x());
+            int rectY = qRound(scale * featureRect.y());
+            int rectWidth = qRound(scale * featureRect.width());
+            int rectHeight = qRound(scale * featureRect.height());
+
+            auto corners = this->m_rectOffsets.data() + 4 * (rect + i);
+
+            if (tilted) {
+                corners[0] = rectX
+                           + rectY * oWidth;
+                corners[1] = rectX - rectHeight
+                           + (rectY + rectHeight) * oWidth;
+                corners[2] = rectX + rectWidth
+                           + (rectY + rectWidth) * oWidth;
+                corners[3] = rectX + rectWidth - rectHeight
+                           + (rectY + rectWidth + rectHeight) * oWidth;
+            } else {
+                corners[0] = rectX
+                           + rectY * oWidth;
+                corners[1] = rectX + rectWidth
+                           + rectY * oWidth;
+                corners[2] = rectX
+                           + (rectY + rectHeight) * oWidth;
+                corners[3] = rectX + rectWidth
+                           + (rectY + rectHeight) * oWidth;
+            }
+
+            this->m_rectWeights[rect + i] = (tilted? 0.5: 1)
+                                          * cascade.m_rectWeights[rect + i]
+                                          * invArea;
+
+            int rectArea = rectWidth * rectHeight;
+
+            if (i == 0)
+                area0 = rectArea;
+            else
+                sum0 += this->m_rectWeights[rect + i] * rectArea;
+        }
+
+        this->m_rectWeights[rect] = -sum0 / area0;
     }
 }
 
 HaarCascadeHID::~HaarCascadeHID()
 {
-    for (int i = 0; i < this->m_count; i++)
-        delete this->m_stages[i];
-
-    delete [] this->m_stages;
 }
 
-void HaarCascadeHID::run(HaarCascadeHID *cascade)
+void HaarCascadeHID::run(int startY, int endY) const
 {
-    for (int j = cascade->m_startY; j < cascade->m_endY; j++) {
-        int y = qRound(j * cascade->m_step);
-        int iStep = 1;
+    auto kernels = HaarKernels::byInstructionSet(AkSimd::instructionSet());
+
+    // The stages of tree cascades depend on the result of the previous ones,
+    // so those are evaluated one window at a time.
+    int lanes = this->m_isTree? 1: kernels.lanes;
+
+    // Candidate windows of the current row, with room for a group of windows
+    // past the end.
+    int windows = qMax(this->m_endX - this->m_startX, 0) + lanes;
+    QVector<qint32> x(windows);
+    QVector<qint32> offsets(windows);
+    RealVector varianceNormFactor(windows);
+
+    for (int j = startY; j < endY; j++) {
+        int y = qRound(j * this->m_step);
+        int candidates = 0;
+
+        // The window next to a window rejected in the first stage is
+        // skipped.
+        bool skip = false;
+
+        // Evaluate the first stage in groups of adjacent windows, and keep
+        // the windows that passed it.
+        for (int i = this->m_startX; i < this->m_endX; i += lanes) {
+            if (lanes == 1 && skip) {
+                skip = false;
+
+                continue;
+            }
 
-        for (int i = cascade->m_startX; i < cascade->m_endX; i += iStep) {
-            int x = qRound(i * cascade->m_step);
-            size_t offset = size_t(x + y * cascade->m_oWidth);
+            int groupSize = qMin(lanes, this->m_endX - i);
+            int mask = 0;
 
-            if (cascade->m_cannyPruning) {
-                quint32 sum = cascade->m_ip[0][offset]
-                            - cascade->m_ip[1][offset]
-                            - cascade->m_ip[2][offset]
-                            + cascade->m_ip[3][offset];
+            for (int lane = 0; lane < lanes; lane++) {
+                int k = candidates + lane;
 
-                quint32 sumCanny = cascade->m_icp[0][offset]
-                                 - cascade->m_icp[1][offset]
-                                 - cascade->m_icp[2][offset]
-                                 + cascade->m_icp[3][offset];
+                // Repeat the last window of the row in the unused lanes.
+                x[k] = qRound(qMin(i + lane, this->m_endX - 1) * this->m_step);
+                qint32 offset = x[k] + y * this->m_oWidth;
+                offsets[k] = offset;
+                varianceNormFactor[k] = 1.0;
 
-                if (sum < 20 || sumCanny < 100) {
-                    iStep = 2;
+                if (this->m_cannyPruning) {
+                    quint32 sum = this->m_ip[0][offset]
+                                - this->m_ip[1][offset]
+                                - this->m_ip[2][offset]
+                                + this->m_ip[3][offset];
 
-                    continue;
+                    quint32 sumCanny = this->m_icp[0][offset]
+                                     - this->m_icp[1][offset]
+                                     - this->m_icp[2][offset]
+                                     + this->m_icp[3][offset];
+
+                    if (sum < 20 || sumCanny < 100)
+                        continue;
                 }
+
+                quint32 sum = this->m_p[0][offset]
+                            - this->m_p[1][offset]
+                            - this->m_p[2][offset]
+                            + this->m_p[3][offset];
+
+                quint64 sum2 = this->m_pq[0][offset]
+                             - this->m_pq[1][offset]
+                             - this->m_pq[2][offset]
+                             + this->m_pq[3][offset];
+
+                qreal mean = sum * this->m_invArea;
+                qreal variance = sum2 * this->m_invArea - mean * mean;
+                varianceNormFactor[k] = (variance >= 0.0)? sqrt(variance): 1.0;
+
+                if (lane < groupSize)
+                    mask |= 1 << lane;
             }
 
-            quint32 sum = cascade->m_p[0][offset]
-                        - cascade->m_p[1][offset]
-                        - cascade->m_p[2][offset]
-                        + cascade->m_p[3][offset];
+            if (mask && this->m_isTree)
+                mask = this->passTree(offsets[candidates],
+                                      varianceNormFactor[candidates]);
+            else if (mask && this->m_count > 0)
+                mask &= kernels.passStage(this,
+                                          0,
+                                          offsets.constData() + candidates,
+                                          varianceNormFactor.constData() + candidates);
+
+            int group = candidates;
+
+            for (int lane = 0; lane < groupSize; lane++)
+                if (skip) {
+                    skip = false;
+                } else {
+                    skip = !(mask & (1 << lane));
+
+                    if (skip)
+                        continue;
+
+                    x[candidates] = x[group + lane];
+                    offsets[candidates] = offsets[group + lane];
+                    varianceNormFactor[candidates] = varianceNormFactor[group + lane];
+                    candidates++;
+                }
+        }
 
-            quint64 sum2 = cascade->m_pq[0][offset]
-                         - cascade->m_pq[1][offset]
-                         - cascade->m_pq[2][offset]
-                         + cascade->m_pq[3][offset];
+        // Evaluate the next stages in groups of the remaining windows, so the
+        // lanes are kept busy, until all of them are rejected.
+        for (int stage = 1;
+             stage < this->m_count && candidates > 0 && !this->m_isTree;
+             stage++) {
+            for (int k = candidates; k < candidates + lanes; k++) {
+                offsets[k] = offsets[0];
+                varianceNormFactor[k] = varianceNormFactor[0];
+            }
 
-            qreal mean = sum * cascade->m_invArea;
-            qreal varianceNormFactor = sum2 * cascade->m_invArea - mean * mean;
-            varianceNormFactor = (varianceNormFactor >= 0.0)? sqrt(varianceNormFactor): 1.0;
-            int stageResult = 1;
+            int passed = 0;
+
+            for (int k = 0; k < candidates; k += lanes) {
+                int mask =
+                        kernels.passStage(this,
+                                          stage,
+                                          offsets.constData() + k,
+                                          varianceNormFactor.constData() + k);
+
+                for (int lane = 0; lane < lanes && k + lane < candidates; lane++)
+                    if (mask & (1 << lane)) {
+                        x[passed] = x[k + lane];
+                        offsets[passed] = offsets[k + lane];
+                        varianceNormFactor[passed] = varianceNormFactor[k + lane];
+                        passed++;
+                    }
+            }
 
-            if (cascade->m_isTree) {
-                HaarStageHID *haarStage = cascade->m_stages[0];
+            candidates = passed;
+        }
 
-                while (haarStage) {
-                    if (haarStage->pass(offset, varianceNormFactor))
-                        haarStage = haarStage->m_childStagePtr;
-                    else {
-                        while (haarStage && haarStage->m_nextStagePtr == nullptr)
-                            haarStage = haarStage->m_parentStagePtr;
+        if (candidates < 1)
+            continue;
 
-                        if (haarStage == nullptr) {
-                            stageResult = 0;
+        this->m_mutex->lock();
 
-                            break;
-                        }
+        for (int k = 0; k < candidates; k++)
+            this->m_roi->append(QRect(x[k],
+                                      y,
+                                      this->m_windowWidth,
+                                      this->m_windowHeight));
 
-                        haarStage = haarStage->m_nextStagePtr;
-                    }
-                }
-            } else for (int stage = 0; stage < cascade->m_count; stage++)
-                if (!cascade->m_stages[stage]->pass(offset, varianceNormFactor)) {
-                    stageResult = -stage;
+        this->m_mutex->unlock();
+    }
+}
 
-                    break;
-                }
+bool HaarCascadeHID::passTree(qint32 offset, qreal varianceNormFactor) const
+{
+    int stage = 0;
 
-            if (stageResult > 0) {
-                cascade->m_mutex->lock();
-                cascade->m_roi->append(QRect(x,
-                                             y,
-                                             cascade->m_windowWidth,
-                                             cascade->m_windowHeight));
-                cascade->m_mutex->unlock();
-            }
+    while (stage >= 0) {
+        if (passWindowScalar(this, stage, offset, varianceNormFactor)) {
+            stage = this->m_stageChilds[stage];
+        } else {
+            while (stage >= 0 && this->m_stageNexts[stage] < 0)
+                stage = this->m_stageParents[stage];
 
-            iStep = stageResult != 0? 1: 2;
+            if (stage < 0)
+                return false;
+
+            stage = this->m_stageNexts[stage];
         }
     }
 
-    delete cascade;
+    return true;
 }
 
 HaarCascade::HaarCascade(QObject *parent):
@@ -235,6 +649,7 @@ HaarCascade::HaarCascade(const HaarCascade &other):
     this->m_stages = other.m_stages;
     this->m_errorString = other.m_errorString;
     this->m_isTree = other.m_isTree;
+    this->compile();
 }
 
 HaarCascade::~HaarCascade()
@@ -305,6 +720,8 @@ bool HaarCascade::load(const QString &fileName)
                 emit this->errorStringChanged(haarReader.errorString());
             }
 
+            this->compile();
+
             return false;
         } else if (token == QXmlStreamReader::StartElement) {
             pathList << haarReader.name().toString();
@@ -381,6 +798,8 @@ bool HaarCascade::load(const QString &fileName)
         path = pathList.join("/");
     }
 
+    this->compile();
+
     return true;
 }
 
@@ -392,6 +811,7 @@ HaarCascade &HaarCascade::operator =(const HaarCascade &other)
         this->m_stages = other.m_stages;
         this->m_errorString = other.m_errorString;
         this->m_isTree = other.m_isTree;
+        this->compile();
     }
 
     return *this;
@@ -437,6 +857,7 @@ void HaarCascade::setStages(const HaarStageVector &stages)
         return;
 
     this->m_stages = stages;
+    this->compile();
     emit this->stagesChanged(stages);
 }
 
@@ -454,3 +875,76 @@ void HaarCascade::resetStages()
 {
     this->setStages(HaarStageVector());
 }
+
+void HaarCascade::compile()
+{
+    static const qreal thresholdBias = 0.0001;
+
+    this->m_stageTrees = {0};
+    this->m_stageThresholds.clear();
+    this->m_stageParents.clear();
+    this->m_stageNexts.clear();
+    this->m_stageChilds.clear();
+    this->m_treeNodes = {0};
+    this->m_nodeRects.clear();
+    this->m_nodeTilted.clear();
+    this->m_nodeThresholds.clear();
+    this->m_nodeChilds.clear();
+    this->m_nodeValues.clear();
+    this->m_rects.clear();
+    this->m_rectWeights.clear();
+
+    const HaarStageVector &stages = this->m_stages;
+
+    for (auto &stage: stages) {
+        const HaarTreeVector trees = stage.trees();
+
+        for (auto &tree: trees) {
+            const HaarFeatureVector features = tree.features();
+
+            // Store the nodes in preorder, so the children come always after
+            // their parent.
+            QVector<int> order;
+            QVector<int> index(features.size(), -1);
+            QVector<int> stack {0};
+
+            while (!stack.isEmpty()) {
+                int node = stack.takeLast();
+
+                if (node < 0 || node >= features.size() || index[node] >= 0)
+                    continue;
+
+                index[node] = order.size();
+                order << node;
+                stack << features[node].rightNode() << features[node].leftNode();
+            }
+
+            for (auto &node: order) {
+                auto &feature = features[node];
+                auto rects = feature.rects();
+                auto weight = feature.weight();
+                this->m_nodeRects << rects.size();
+                this->m_nodeTilted << feature.tilted();
+                this->m_nodeThresholds << feature.threshold();
+                this->m_nodeChilds << (feature.leftNode() < 0?
+                                           -1: index[feature.leftNode()]);
+                this->m_nodeChilds << (feature.rightNode() < 0?
+                                           -1: index[feature.rightNode()]);
+                this->m_nodeValues << feature.leftVal() << feature.rightVal();
+
+                for (int i = 0; i < HAAR_FEATURE_MAX; i++) {
+                    this->m_rects << (i < rects.size()? rects[i]: QRect());
+                    this->m_rectWeights << (i < weight.size()? weight[i]: 0);
+                }
+            }
+
+            this->m_treeNodes << this->m_nodeRects.size();
+        }
+
+        this->m_stageTrees << this->m_treeNodes.size() - 1;
+        this->m_stageThresholds << stage.threshold() - thresholdBias;
+        this->m_stageParents << stage.parentStage();
+        this->m_stageNexts << stage.nextStage();
+        this->m_stageChilds << stage.childStage();
+    }
+}
@@ -32,8 +32,6 @@ class HaarCascadeHID
         explicit HaarCascadeHID(const HaarCascade &cascade,
                                 int startX,
                                 int endX,
-                                int startY,
-                                int endY,
                                 int windowWidth,
                                 int windowHeight,
                                 int oWidth,
@@ -51,15 +49,33 @@ class HaarCascadeHID
                                 QMutex *mutex);
         ~HaarCascadeHID();
 
-        static void run(HaarCascadeHID *cascade);
+        // Scans the windows starting in the rows [startY, endY), can be
+        // called from several threads at the same time.
+        void run(int startY, int endY) const;
 
-    private:
+        // Tables of the cascade scaled to the current window size, read by
+        // the kernels. The stage, tree and node tables are shared with the
+        // cascade. The weights of the rects have HAAR_FEATURE_MAX entries per
+        // node, and the offsets have the 4 corners of each rect, relative to
+        // the window.
         int m_count;
-        HaarStageHID **m_stages;
+        const int *m_stageTrees;
+        const qreal *m_stageThresholds;
+        const int *m_stageParents;
+        const int *m_stageNexts;
+        const int *m_stageChilds;
+        const int *m_treeNodes;
+        const int *m_nodeRects;
+        const qreal *m_nodeThresholds;
+        const int *m_nodeChilds;
+        const qreal *m_nodeValues;
+        QVector<const quint32 *> m_nodeIntegrals;
+        QVector<qint32> m_rectOffsets;
+        RealVector m_rectWeights;
+
+    private:
         int m_startX;
         int m_endX;
-        int m_startY;
-        int m_endY;
         int m_windowWidth;
         int m_windowHeight;
         int m_oWidth;
@@ -73,6 +89,8 @@ class HaarCascadeHID
         const quint32 *m_icp[4];
         QList<QRect> *m_roi;
         QMutex *m_mutex;
+
+        bool passTree(qint32 offset, qreal varianceNormFactor) const;
 };
 
 class HaarCascade: public QObject
@@ -122,6 +140,28 @@ class HaarCascade: public QObject
         QString m_errorString;
         bool m_isTree;
 
+        // The stages compiled into flat arrays, so the windows can be
+        // evaluated without walking the object tree. The trees of the stage
+        // i are [m_stageTrees[i], m_stageTrees[i + 1]), and the nodes of the
+        // tree j are [m_treeNodes[j], m_treeNodes[j + 1]) in preorder. Each
+        // node has the left and right child, relative to the first node of
+        // the tree, and the left and right leaf values.
+        QVector<int> m_stageTrees;
+        RealVector m_stageThresholds;
+        QVector<int> m_stageParents;
+        QVector<int> m_stageNexts;
+        QVector<int> m_stageChilds;
+        QVector<int> m_treeNodes;
+        QVector<int> m_nodeRects;
+        QVector<bool> m_nodeTilted;
+        RealVector m_nodeThresholds;
+        QVector<int> m_nodeChilds;
+        RealVector m_nodeValues;
+        RectVector m_rects;
+        RealVector m_rectWeights;
+
+        void compile();
+
     signals:
         void nameChanged(const QString &name);
         void windowSizeChanged(const QSize &windowSize);
@@ -58,7 +58,8 @@
  */
 
 #include <QtMath>
-#include <QtConcurrent>
+#include <QSharedPointer>
+#include <akscheduler.h>
 
 #include "haarcascade.h"
 #include "haardetector.h"
@@ -77,6 +78,7 @@ class HaarDetectorPrivate
         int m_minNeighbors;
         QVector<int> m_weight;
         QMutex m_mutex;
+        QAtomicInteger<qint64> m_cpuTime;
 
         QVector<int> makeWeightTable(int factor) const;
         void computeGray(const QImage &src, bool equalize,
@@ -167,29 +169,52 @@ void HaarDetectorPrivate::computeGray(const QImage &src, bool equalize,
                                       QVector<quint8> &gray) const
 {
     gray.resize(src.width() * src.height());
-    QImage image;
-
-    if (src.format() == QImage::Format_ARGB32)
-        image = src;
-    else
-        image = src.convertToFormat(QImage::Format_ARGB32);
-
-    const QRgb *imageBits = reinterpret_cast<const QRgb *>(image.constBits());
     int minGray = 255;
     int maxGray = 0;
 
-    for (int i = 0; i < gray.size(); i++) {
-        int pixel = qGray(imageBits[i]);
+    if (src.format() == QImage::Format_Grayscale8) {
+        // The luma was already extracted, just copy it.
+        for (int y = 0; y < src.height(); y++) {
+            const quint8 *srcLine = src.constScanLine(y);
+            quint8 *grayLine = gray.data() + y * src.width();
+
+            for (int x = 0; x < src.width(); x++) {
+                int pixel = srcLine[x];
 
-        if (equalize) {
-            if (pixel < minGray)
-                minGray = pixel;
+                if (equalize) {
+                    if (pixel < minGray)
+                        minGray = pixel;
+
+                    if (pixel > maxGray)
+                        maxGray = pixel;
+                }
 
-            if (pixel > maxGray)
-                maxGray = pixel;
+                grayLine[x] = quint8(pixel);
+            }
         }
+    } else {
+        QImage image;
+
+        if (src.format() == QImage::Format_ARGB32)
+            image = src;
+        else
+            image = src.convertToFormat(QImage::Format_ARGB32);
+
+        const QRgb *imageBits = reinterpret_cast<const QRgb *>(image.constBits());
+
+        for (int i = 0; i < gray.size(); i++) {
+            int pixel = qGray(imageBits[i]);
 
-        gray[i] = quint8(pixel);
+            if (equalize) {
+                if (pixel < minGray)
+                    minGray = pixel;
+
+                if (pixel > maxGray)
+                    maxGray = pixel;
+            }
+
+            gray[i] = quint8(pixel);
+        }
     }
 
     if (!equalize || maxGray == minGray)
@@ -1129,12 +1154,10 @@ QVector<QRect> HaarDetector::detect(const QImage &image, qreal scaleFactor,
     const quint32 *icp[4];
 
     QList<QRect> roi;
-    QThreadPool threadPool;
     QMutex mutex;
     static const int border = 1;
-
-    if (threadPool.maxThreadCount() < 8)
-        threadPool.setMaxThreadCount(8);
+    AkTaskGroup taskGroup;
+    auto cpuTime = &this->d->m_cpuTime;
 
     this->d->m_mutex.lock();
 
@@ -1211,29 +1234,44 @@ QVector<QRect> HaarDetector::detect(const QImage &image, qreal scaleFactor,
         int endX = qRound((image.width() - windowWidth) / step);
         int endY = qRound((image.height() - windowHeight) / step);
 
-        HaarCascadeHID *cascade = new HaarCascadeHID(this->d->m_cascade,
-                                                     startX, endX, startY, endY,
-                                                     windowWidth, windowHeight,
-                                                     oWidth,
-                                                     integral.constData(),
-                                                     tiltedIntegral.constData(),
-                                                     step,
-                                                     invArea,
-                                                     scale,
-                                                     cannyPruning,
-                                                     p, pq, ip, icp,
-                                                     &roi,
-                                                     &mutex);
-
-        QtConcurrent::run(&threadPool, HaarCascadeHID::run, cascade);
+        auto cascade =
+                QSharedPointer<HaarCascadeHID>::create(this->d->m_cascade,
+                                                       startX, endX,
+                                                       windowWidth, windowHeight,
+                                                       oWidth,
+                                                       integral.constData(),
+                                                       tiltedIntegral.constData(),
+                                                       step,
+                                                       invArea,
+                                                       scale,
+                                                       cannyPruning,
+                                                       p, pq, ip, icp,
+                                                       &roi,
+                                                       &mutex);
+
+        // Scan all scales at the same time, and split the rows of every scale
+        // between the idle threads.
+        taskGroup.run([cascade, startY, endY, cpuTime] () {
+            AkScheduler::parallelFor(endY - startY,
+                                     4,
+                                     [&cascade, startY, cpuTime] (int begin, int end) {
+                AkCpuTimer timer(cpuTime);
+                cascade->run(startY + begin, startY + end);
+            });
+        });
     }
 
-    threadPool.waitForDone();
+    taskGroup.wait();
     this->d->m_mutex.unlock();
 
     return this->d->groupRectangles(roi.toVector(), this->d->m_minNeighbors);
 }
 
+qint64 HaarDetector::cpuTime() const
+{
+    return this->d->m_cpuTime.load();
+}
+
 void HaarDetector::setEqualize(bool equalize)
 {
     if (this->d->m_equalize == equalize)
@@ -94,6 +94,11 @@ class HaarDetector: public QObject
                                           QSize minObjectSize=QSize(),
                                           QSize maxObjectSize=QSize()) const;
 
+        // CPU time spent scanning the frames in the scheduler threads, in
+        // nanoseconds. The scans run while detect() is timed with an
+        // AkCpuTimer are not counted twice.
+        Q_INVOKABLE qint64 cpuTime() const;
+
     private:
         HaarDetectorPrivate *d;
 
@@ -59,72 +59,6 @@
 
 #include "haarfeature.h"
 
-HaarFeatureHID::HaarFeatureHID(const HaarFeature &feature,
-                               int oWidth,
-                               const quint32 *integral,
-                               const quint32 *tiltedIntegral,
-                               qreal invArea,
-                               qreal scale)
-{
-    this->m_count = feature.m_count;
-    this->m_tilted = feature.m_tilted;
-    this->m_threshold = feature.m_threshold;
-    this->m_leftNode = feature.m_leftNode;
-    this->m_leftVal = feature.m_leftVal;
-    this->m_rightNode = feature.m_rightNode;
-    this->m_rightVal = feature.m_rightVal;
-
-    qreal area0 = 0;
-    qreal sum0 = 0;
-
-    for (int i = 0; i < this->m_count; i++) {
-        int rectX = qRound(scale * feature.m_rects[i].x());
-        int rectY = qRound(scale * feature.m_rects[i].y());
-        int rectWidth = qRound(scale * feature.m_rects[i].width());
-        int rectHeight = qRound(scale * feature.m_rects[i].height());
-
-        if (this->m_tilted) {
-            this->m_p0[i] = const_cast<quint32 *>(tiltedIntegral)
-                            +  rectX
-                            +  rectY * oWidth;
-            this->m_p1[i] = const_cast<quint32 *>(tiltedIntegral)
-                            +  rectX - rectHeight
-                            + (rectY + rectHeight) * oWidth;
-            this->m_p2[i] = const_cast<quint32 *>(tiltedIntegral)
-                            +  rectX + rectWidth
-                            + (rectY + rectWidth) * oWidth;
-            this->m_p3[i] = const_cast<quint32 *>(tiltedIntegral)
-                            +  rectX + rectWidth - rectHeight
-                            + (rectY + rectWidth + rectHeight) * oWidth;
-        } else {
-            this->m_p0[i] = const_cast<quint32 *>(integral)
-                            + rectX
-                            + rectY * oWidth;
-            this->m_p1[i] = const_cast<quint32 *>(integral)
-                            + rectX + rectWidth
-                            + rectY * oWidth;
-            this->m_p2[i] = const_cast<quint32 *>(integral)
-                            +  rectX
-                            + (rectY + rectHeight) * oWidth;
-            this->m_p3[i] = const_cast<quint32 *>(integral)
-                            +  rectX + rectWidth
-                            + (rectY + rectHeight) * oWidth;
-        }
-
-        this->m_weight[i] = (this->m_tilted? 0.5: 1)
-                               * feature.m_weight[i] * invArea;
-
-        int rectArea = rectWidth * rectHeight;
-
-        if (i == 0)
-            area0 = rectArea;
-        else
-            sum0 += this->m_weight[i] * rectArea;
-    }
-
-    this->m_weight[0] = -sum0 / area0;
-}
-
 HaarFeature::HaarFeature(QObject *parent):
     QObject(parent)
 {
@@ -32,44 +32,6 @@ typedef QVector<QRect> RectVector;
 typedef QVector<qreal> RealVector;
 typedef QVector<HaarFeature> HaarFeatureVector;
 
-class HaarFeatureHID
-{
-    public:
-        explicit HaarFeatureHID(const HaarFeature &feature,
-                                int oWidth,
-                                const quint32 *integral,
-                                const quint32 *tiltedIntegral,
-                                qreal invArea,
-                                qreal scale);
-
-        int m_count;
-        bool m_tilted;
-        qreal m_threshold;
-        int m_leftNode;
-        qreal m_leftVal;
-        int m_rightNode;
-        qreal m_rightVal;
-
-        quint32 *m_p0[HAAR_FEATURE_MAX];
-        quint32 *m_p1[HAAR_FEATURE_MAX];
-        quint32 *m_p2[HAAR_FEATURE_MAX];
-        quint32 *m_p3[HAAR_FEATURE_MAX];
-        qreal m_weight[HAAR_FEATURE_MAX];
-
-        inline bool goLeft(size_t offset, qreal varianceNormFactor) const
-        {
-            qreal featureSum = 0;
-
-            for (int i = 0; i < this->m_count; i++)
-                featureSum += (this->m_p0[i][offset]
-                             - this->m_p1[i][offset]
-                             - this->m_p2[i][offset]
-                             + this->m_p3[i][offset]) * this->m_weight[i];
-
-            return featureSum < this->m_threshold * varianceNormFactor;
-        }
-};
-
 class HaarFeature: public QObject
 {
     Q_OBJECT
@@ -136,8 +98,6 @@ class HaarFeature: public QObject
         void resetLeftVal();
         void resetRightNode();
         void resetRightVal();
-
-    friend class HaarFeatureHID;
 };
 
 #endif // HAARFEATURE_H
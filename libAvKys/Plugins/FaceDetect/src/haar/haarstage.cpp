@@ -59,39 +59,6 @@
 
 #include "haarstage.h"
 
-HaarStageHID::HaarStageHID(const HaarStage &stage,
-                           int oWidth,
-                           const quint32 *integral,
-                           const quint32 *tiltedIntegral,
-                           qreal invArea,
-                           qreal scale)
-{
-    this->m_count = stage.m_trees.size();
-    this->m_trees = new HaarTreeHID *[this->m_count];
-    static const qreal thresholdBias = 0.0001;
-    this->m_threshold = stage.m_threshold - thresholdBias;
-
-    this->m_parentStagePtr = nullptr;
-    this->m_nextStagePtr = nullptr;
-    this->m_childStagePtr = nullptr;
-
-    for (int i = 0; i < this->m_count; i++)
-        this->m_trees[i] = new HaarTreeHID(stage.m_trees[i],
-                                              oWidth,
-                                              integral,
-                                              tiltedIntegral,
-                                              invArea,
-                                              scale);
-}
-
-HaarStageHID::~HaarStageHID()
-{
-    for (int i = 0; i < this->m_count; i++)
-        delete this->m_trees[i];
-
-    delete [] this->m_trees;
-}
-
 HaarStage::HaarStage(QObject *parent): QObject(parent)
 {
     this->m_threshold = 0;
@@ -26,35 +26,6 @@ class HaarStage;
 
 typedef QVector<HaarStage> HaarStageVector;
 
-class HaarStageHID
-{
-    public:
-        explicit HaarStageHID(const HaarStage &stage,
-                              int oWidth,
-                              const quint32 *integral,
-                              const quint32 *tiltedIntegral,
-                              qreal invArea,
-                              qreal scale);
-        ~HaarStageHID();
-
-        int m_count;
-        HaarTreeHID **m_trees;
-        qreal m_threshold;
-        HaarStageHID *m_parentStagePtr;
-        HaarStageHID *m_nextStagePtr;
-        HaarStageHID *m_childStagePtr;
-
-        inline bool pass(size_t offset, qreal varianceNormFactor) const
-        {
-            qreal sum = 0;
-
-            for (int i = 0; i < this->m_count; i++)
-                sum += this->m_trees[i]->eval(offset, varianceNormFactor);
-
-            return sum >= this->m_threshold;
-        }
-};
-
 class HaarStage: public QObject
 {
     Q_OBJECT
@@ -107,8 +78,6 @@ class HaarStage: public QObject
         void resetParentStage();
         void resetNextStage();
         void resetChildStage();
-
-    friend class HaarStageHID;
 };
 
 #endif // HAARSTAGE_H
@@ -59,33 +59,6 @@
 
 #include "haartree.h"
 
-HaarTreeHID::HaarTreeHID(const HaarTree &tree,
-                         int oWidth,
-                         const quint32 *integral,
-                         const quint32 *tiltedIntegral,
-                         qreal invArea,
-                         qreal scale)
-{
-    this->m_count = tree.m_features.size();
-    this->m_features = new HaarFeatureHID *[this->m_count];
-
-    for (int i = 0; i < this->m_count; i++)
-        this->m_features[i] = new HaarFeatureHID(tree.m_features[i],
-                                                    oWidth,
-                                                    integral,
-                                                    tiltedIntegral,
-                                                    invArea,
-                                                    scale);
-}
-
-HaarTreeHID::~HaarTreeHID()
-{
-    for (int i = 0; i < this->m_count; i++)
-        delete this->m_features[i];
-
-    delete [] this->m_features;
-}
-
 HaarTree::HaarTree(QObject *parent): QObject(parent)
 {
 }
@@ -26,51 +26,6 @@ class HaarTree;
 
 typedef QVector<HaarTree> HaarTreeVector;
 
-class HaarTreeHID
-{
-    public:
-        explicit HaarTreeHID(const HaarTree &tree,
-                             int oWidth,
-                             const quint32 *integral,
-                             const quint32 *tiltedIntegral,
-                             qreal invArea,
-                             qreal scale);
-        ~HaarTreeHID();
-
-        int m_count;
-        HaarFeatureHID **m_features;
-
-        inline qreal eval(size_t offset, qreal varianceNormFactor) const
-        {
-            int idx = 0;
-            qreal treeValue;
-
-            forever {
-                const HaarFeatureHID *feature = this->m_features[idx];
-
-                if (feature->goLeft(offset, varianceNormFactor)) {
-                    if (feature->m_leftNode < 0) {
-                        treeValue = feature->m_leftVal;
-
-                        break;
-                    }
-                    else
-                        idx = feature->m_leftNode;
-                } else {
-                    if (feature->m_rightNode < 0) {
-                        treeValue = feature->m_rightVal;
-
-                        break;
-                    }
-                    else
-                        idx = feature->m_rightNode;
-                }
-            }
-
-            return treeValue;
-        }
-};
-
 class HaarTree: public QObject
 {
     Q_OBJECT
@@ -96,8 +51,6 @@ class HaarTree: public QObject
     public slots:
         void setFeatures(const HaarFeatureVector &features);
         void resetFeatures();
-
-    friend class HaarTreeHID;
 };
 
 #endif // HAARTREE_H
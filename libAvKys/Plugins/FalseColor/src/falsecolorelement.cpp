@@ -21,6 +21,7 @@
 #include <QVariant>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "falsecolorelement.h"
@@ -133,7 +134,7 @@ AkPacket FalseColorElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_Grayscale8);
-    QImage oFrame(src.size(), QImage::Format_ARGB32);
+    QImage oFrame = AkBufferPool::image(src.size(), QImage::Format_ARGB32);
 
     QRgb table[256];
     QList<QRgb> tableRgb = this->d->m_table;
@@ -23,6 +23,7 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "fireelement.h"
@@ -467,7 +468,7 @@ AkPacket FireElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_framSize) {
         this->d->m_fireBuffer = QImage();
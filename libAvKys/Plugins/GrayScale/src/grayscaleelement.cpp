@@ -17,25 +17,86 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
-#include <QImage>
-#include <akutils.h>
+#include <QColor>
 #include <akpacket.h>
+#include <akvideopacket.h>
+#include <akpixelview.h>
 
 #include "grayscaleelement.h"
 
+using GrayView = AkPixelView<AkVideoCaps::Format_gray>;
+
+template<AkVideoCaps::PixelFormat Format>
+inline typename std::enable_if<AkPixelView<Format>::IsRgb>::type
+toGray(const AkConstPixelView<Format> &src, const GrayView &dst)
+{
+    using View = AkPixelView<Format>;
+
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            auto srcLine = src.line(y);
+            auto dstLine = dst.line(y);
+
+            for (int x = 0; x < src.width(); x++)
+                dstLine[x] = quint8(qGray(View::red(srcLine, x),
+                                          View::green(srcLine, x),
+                                          View::blue(srcLine, x)));
+        }
+    });
+}
+
+// The luma is already the gray level, it's just expanded to full range.
+template<AkVideoCaps::PixelFormat Format>
+inline typename std::enable_if<AkPixelView<Format>::IsYuv>::type
+toGray(const AkConstPixelView<Format> &src, const GrayView &dst)
+{
+    using View = AkPixelView<Format>;
+    quint8 lumaTable[256];
+
+    for (int i = 0; i < 256; i++)
+        lumaTable[i] =
+                quint8(qBound(0,
+                              255 * (i - View::MinLuma)
+                              / (View::MaxLuma - View::MinLuma),
+                              255));
+
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            auto srcLine = src.line(y);
+            auto dstLine = dst.line(y);
+
+            for (int x = 0; x < src.width(); x++)
+                dstLine[x] = lumaTable[View::luma(srcLine, x)];
+        }
+    });
+}
+
+struct GrayScaleFilter
+{
+    template<AkVideoCaps::PixelFormat Format>
+    inline void operator ()(const AkConstPixelView<Format> &src,
+                            const GrayView &dst) const
+    {
+        toGray(src, dst);
+    }
+};
+
 GrayScaleElement::GrayScaleElement(): AkElement()
 {
 }
 
 AkPacket GrayScaleElement::iStream(const AkPacket &packet)
 {
-    QImage src = AkUtils::packetToImage(packet);
+    AkVideoCaps caps(packet.caps());
 
-    if (src.isNull())
+    if (!caps)
         return AkPacket();
 
-    QImage oFrame = src.convertToFormat(QImage::Format_Grayscale8);
-    AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
+    if (caps.format() == AkVideoCaps::Format_gray)
+        akSend(packet)
+
+    AkPacket oPacket =
+            akPixelMap<AkVideoCaps::Format_gray>(packet, GrayScaleFilter());
     akSend(oPacket)
 }
 
@@ -22,6 +22,7 @@
 #include <QMutex>
 #include <QStandardPaths>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "halftoneelement.h"
@@ -231,7 +232,7 @@ AkPacket HalftoneElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     this->d->m_mutex.lock();
 
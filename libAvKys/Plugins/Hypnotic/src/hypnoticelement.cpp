@@ -22,6 +22,7 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "hypnoticelement.h"
@@ -241,7 +242,7 @@ AkPacket HypnoticElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_frameSize) {
         this->d->m_speed = 16;
@@ -21,6 +21,8 @@
 #include <QtMath>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
 
 #include "implodeelement.h"
@@ -73,37 +75,42 @@ AkPacket ImplodeElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     int xc = src.width() >> 1;
     int yc = src.height() >> 1;
     int radius = qMin(xc, yc);
 
-    for (int y = 0; y < src.height(); y++) {
-        const QRgb *iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-        int yDiff = y - yc;
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-        for (int x = 0; x < src.width(); x++) {
-            int xDiff = x - xc;
-            qreal distance = sqrt(xDiff * xDiff + yDiff * yDiff);
+    AkScheduler::parallelFor(src.height(), 8, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const QRgb *iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+            QRgb *oLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
+            int yDiff = y - yc;
 
-            if (distance >= radius)
-                oLine[x] = iLine[x];
-            else {
-                qreal factor = pow(distance / radius, this->m_amount);
+            for (int x = 0; x < src.width(); x++) {
+                int xDiff = x - xc;
+                qreal distance = sqrt(xDiff * xDiff + yDiff * yDiff);
 
-                int xp = int(factor * xDiff + xc);
-                int yp = int(factor * yDiff + yc);
+                if (distance >= radius)
+                    oLine[x] = iLine[x];
+                else {
+                    qreal factor = pow(distance / radius, this->m_amount);
 
-                xp = qBound(0, xp, oFrame.width() - 1);
-                yp = qBound(0, yp, oFrame.height() - 1);
+                    int xp = int(factor * xDiff + xc);
+                    int yp = int(factor * yDiff + yc);
 
-                const QRgb *line = reinterpret_cast<const QRgb *>(src.constScanLine(yp));
-                oLine[x] = line[xp];
+                    xp = qBound(0, xp, oFrame.width() - 1);
+                    yp = qBound(0, yp, oFrame.height() - 1);
+
+                    const QRgb *line = reinterpret_cast<const QRgb *>(src.constScanLine(yp));
+                    oLine[x] = line[xp];
+                }
             }
         }
-    }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
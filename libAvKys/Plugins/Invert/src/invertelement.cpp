@@ -17,27 +17,68 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
-#include <QImage>
-#include <akutils.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
+#include <akpixelview.h>
+#include <akpointoperator.h>
 
 #include "invertelement.h"
 
+template<AkVideoCaps::PixelFormat Format>
+inline typename std::enable_if<AkPixelView<Format>::IsRgb>::type
+invert(const AkConstPixelView<Format> &src, const AkPixelView<Format> &dst)
+{
+    src.mapRgb(dst, [] (int &r, int &g, int &b) {
+        r = 255 - r;
+        g = 255 - g;
+        b = 255 - b;
+    });
+}
+
+// The luma is inverted inside its range, and the chroma around its center.
+template<AkVideoCaps::PixelFormat Format>
+inline typename std::enable_if<AkPixelView<Format>::IsYuv>::type
+invert(const AkConstPixelView<Format> &src, const AkPixelView<Format> &dst)
+{
+    using View = AkPixelView<Format>;
+    quint8 lumaTable[256];
+    quint8 chromaTable[256];
+
+    for (int i = 0; i < 256; i++) {
+        lumaTable[i] = quint8(qBound(0, View::MinLuma + View::MaxLuma - i, 255));
+        chromaTable[i] = quint8(qMin(256 - i, 255));
+    }
+
+    src.mapYuv(dst, lumaTable, chromaTable);
+}
+
+struct InvertFilter
+{
+    template<AkVideoCaps::PixelFormat Format>
+    inline void operator ()(const AkConstPixelView<Format> &src,
+                            const AkPixelView<Format> &dst) const
+    {
+        invert(src, dst);
+    }
+};
+
 InvertElement::InvertElement(): AkElement()
 {
 }
 
-AkPacket InvertElement::iStream(const AkPacket &packet)
+AkPointOperator InvertElement::pointOperator() const
 {
-    QImage src = AkUtils::packetToImage(packet);
+    quint8 table[256];
 
-    if (src.isNull())
-        return AkPacket();
+    for (int i = 0; i < 256; i++)
+        table[i] = quint8(255 - i);
 
-    QImage oFrame = src.convertToFormat(QImage::Format_ARGB32);
-    oFrame.invertPixels();
+    return AkPointOperator::fromTables(table, table, table);
+}
 
-    AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
+AkPacket InvertElement::iStream(const AkPacket &packet)
+{
+    AkPacket oPacket = akPixelMap(packet, InvertFilter());
     akSend(oPacket)
 }
 
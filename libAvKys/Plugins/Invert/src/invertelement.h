@@ -29,6 +29,8 @@ class InvertElement: public AkElement
     public:
         explicit InvertElement();
 
+        AkPointOperator pointOperator() const;
+
     public slots:
         AkPacket iStream(const AkPacket &packet);
 };
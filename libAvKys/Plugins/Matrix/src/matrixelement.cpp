@@ -23,7 +23,9 @@
 #include <QFontMetrics>
 #include <QMutex>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
+#include <akvideoscaler.h>
 
 #include "matrixelement.h"
 #include "character.h"
@@ -89,6 +91,7 @@ class MatrixElementPrivate
         QSize m_fontSize;
         QList<RainDrop> m_rain;
         QMutex m_mutex;
+        AkVideoScaler m_scaler;
 
         QSize fontSize(const QString &chrTable, const QFont &font) const;
         QImage drawChar(const QChar &chr, const QFont &font,
@@ -118,6 +121,7 @@ MatrixElement::MatrixElement(): AkElement()
     this->d->m_minSpeed = 0.5;
     this->d->m_maxSpeed = 5.0;
     this->d->m_showCursor = false;
+    this->d->m_scaler.setScalingMode(AkVideoScaler::ScalingMode_Nearest);
 
     this->updateCharTable();
 
@@ -589,19 +593,19 @@ AkPacket MatrixElement::iStream(const AkPacket &packet)
     int outWidth = textWidth * this->d->m_fontSize.width();
     int outHeight = textHeight * this->d->m_fontSize.height();
 
-    QImage oFrame(outWidth, outHeight, src.format());
+    QImage oFrame = AkBufferPool::image(outWidth, outHeight, src.format());
 
     QList<Character> characters(this->d->m_characters);
     this->d->m_mutex.unlock();
 
     if (characters.size() < 256) {
-        oFrame.fill(this->d->m_backgroundColor);
-        AkPacket oPacket = AkUtils::imageToPacket(oFrame.scaled(src.size()),
-                                                  packet);
+        QImage background = AkBufferPool::image(src.size(), src.format());
+        background.fill(this->d->m_backgroundColor);
+        AkPacket oPacket = AkUtils::imageToPacket(background, packet);
         akSend(oPacket)
     }
 
-    QImage textImage = src.scaled(textWidth, textHeight);
+    QImage textImage = this->d->m_scaler.scale(src, textWidth, textHeight);
     QRgb *textImageBits = reinterpret_cast<QRgb *>(textImage.bits());
     int textArea = textImage.width() * textImage.height();
     QPainter painter;
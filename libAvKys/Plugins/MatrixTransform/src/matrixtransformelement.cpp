@@ -23,6 +23,7 @@
 #include <QMutex>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "matrixtransformelement.h"
@@ -107,7 +108,7 @@ AkPacket MatrixTransformElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame = QImage(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     this->d->m_mutex.lock();
     QVector<qreal> kernel = this->d->m_kernel;
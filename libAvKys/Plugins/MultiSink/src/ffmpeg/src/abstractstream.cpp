@@ -25,6 +25,7 @@
 #include <QFuture>
 #include <QWaitCondition>
 #include <akpacket.h>
+#include <aktracer.h>
 
 extern "C"
 {
@@ -195,6 +196,8 @@ void AbstractStream::packetEnqueue(const AkPacket &packet)
     if (!this->d->m_runConvertLoop)
         return;
 
+    AK_TRACE_PACKET_SCOPE("sink", "AbstractStream::packetEnqueue", packet);
+
     this->d->m_convertMutex.lock();
     bool enqueue = true;
 
@@ -277,8 +280,10 @@ void AbstractStreamPrivate::convertLoop()
 
         this->m_convertMutex.unlock();
 
-        if (packet)
+        if (packet) {
+            AK_TRACE_PACKET_SCOPE("sink", "AbstractStream::convertPacket", packet);
             self->convertPacket(packet);
+        }
     }
 }
 
@@ -286,6 +291,7 @@ void AbstractStreamPrivate::encodeLoop()
 {
     while (this->m_runEncodeLoop) {
         if (auto frame = self->dequeueFrame()) {
+            AK_TRACE_SCOPE("sink", "AbstractStream::encodeData");
             self->encodeData(frame);
             self->deleteFrame(&frame);
         }
@@ -276,7 +276,7 @@ void VideoStream::convertPacket(const AkPacket &packet)
     if (av_image_fill_pointers(reinterpret_cast<uint8_t **>(iFrame.data),
                                iFormat,
                                iHeight,
-                               reinterpret_cast<uint8_t *>(videoPacket.buffer().data()),
+                               reinterpret_cast<uint8_t *>(const_cast<char *>(videoPacket.buffer().constData())),
                                iFrame.linesize) < 0) {
         return;
     }
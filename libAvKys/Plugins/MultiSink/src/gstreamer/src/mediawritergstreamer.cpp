@@ -2107,11 +2107,11 @@ void MediaWriterGStreamer::enqueuePacket(const AkPacket &packet)
     if (!this->d->m_isRecording)
         return;
 
-    if (packet.caps().mimeType() == "audio/x-raw") {
+    if (packet.caps().type() == AkCaps::CapsAudio) {
         this->writeAudioPacket(AkAudioPacket(packet));
-    } else if (packet.caps().mimeType() == "video/x-raw") {
+    } else if (packet.caps().type() == AkCaps::CapsVideo) {
         this->writeVideoPacket(AkVideoPacket(packet));
-    } else if (packet.caps().mimeType() == "text/x-raw") {
+    } else if (packet.caps().type() == AkCaps::CapsSubtitle) {
         this->writeSubtitlePacket(packet);
     }
 }
@@ -69,7 +69,7 @@ void SubtitleStream::processPacket(AVPacket *packet)
 
     // Some subtitles seams to have a problem when decoding.
     AkCaps caps(this->caps());
-    caps.setProperty("type", "ass");
+    caps.setCapsProperty("type", "ass");
 
     QByteArray oBuffer(packet->size, 0);
     memcpy(oBuffer.data(), packet->data, size_t(packet->size));
@@ -101,12 +101,12 @@ void SubtitleStream::processData(AVSubtitle *subtitle)
             } else
                 continue;
 
-            caps.setProperty("type", "bitmap");
-            caps.setProperty("x", subtitle->rects[i]->x);
-            caps.setProperty("y", subtitle->rects[i]->y);
-            caps.setProperty("width", subtitle->rects[i]->w);
-            caps.setProperty("height", subtitle->rects[i]->h);
-            caps.setProperty("format", format);
+            caps.setCapsProperty("type", "bitmap");
+            caps.setCapsProperty("x", subtitle->rects[i]->x);
+            caps.setCapsProperty("y", subtitle->rects[i]->y);
+            caps.setCapsProperty("width", subtitle->rects[i]->w);
+            caps.setCapsProperty("height", subtitle->rects[i]->h);
+            caps.setCapsProperty("format", format);
 
             AVFrame frame;
             memset(&frame, 0, sizeof(AVFrame));
@@ -154,13 +154,13 @@ void SubtitleStream::processData(AVSubtitle *subtitle)
                           subtitle->rects[i]->w,
                           subtitle->rects[i]->h);
         } else if (subtitle->rects[i]->type == SUBTITLE_TEXT) {
-            caps.setProperty("type", "text");
+            caps.setCapsProperty("type", "text");
             int textLenght = sizeof(subtitle->rects[i]->text);
 
             oBuffer.resize(textLenght);
             memcpy(oBuffer.data(), subtitle->rects[i]->text, size_t(textLenght));
         } else if (subtitle->rects[i]->type == SUBTITLE_ASS) {
-            caps.setProperty("type", "ass");
+            caps.setCapsProperty("type", "ass");
             int assLenght = sizeof(subtitle->rects[i]->ass);
 
             oBuffer.resize(assLenght);
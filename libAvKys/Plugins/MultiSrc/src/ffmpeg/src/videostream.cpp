@@ -23,6 +23,7 @@
 #include <akvideocaps.h>
 #include <akpacket.h>
 #include <akvideopacket.h>
+#include <akbufferpool.h>
 
 extern "C"
 {
@@ -252,12 +253,19 @@ AkPacket VideoStreamPrivate::convert(AVFrame *iFrame)
                                            nullptr,
                                            oFrame.linesize);
 
-    QByteArray oBuffer(frameSize, 0);
+    auto oBuffer = AkBufferPool::buffer(AkVideoCaps::Format_rgb24,
+                                        iFrame->width,
+                                        iFrame->height,
+                                        1,
+                                        frameSize);
+
+    if (!oBuffer)
+        return AkPacket();
 
     if (av_image_fill_pointers(reinterpret_cast<uint8_t **>(oFrame.data),
                                outPixFormat,
                                iFrame->height,
-                               reinterpret_cast<uint8_t *>(oBuffer.data()),
+                               oBuffer.data<uint8_t>(),
                                oFrame.linesize) < 0) {
         return AkPacket();
     }
@@ -282,7 +290,7 @@ AkPacket VideoStreamPrivate::convert(AVFrame *iFrame)
     // Create packet
     AkVideoPacket oPacket;
     oPacket.caps() = caps;
-    oPacket.buffer() = oBuffer;
+    oBuffer.attachTo(oPacket);
     oPacket.pts() = iFrame->pts;
     oPacket.timeBase() = self->timeBase();
     oPacket.index() = int(self->index());
@@ -503,7 +503,7 @@ GstFlowReturn MediaSourceGStreamerPrivate::subtitlesBufferCallback(GstElement *s
     AkPacket packet;
     packet.caps().isValid() = true;
     packet.caps().setMimeType("text/x-raw");
-    packet.caps().setProperty("type", format);
+    packet.caps().setCapsProperty("type", format);
 
     GstBuffer *buf = gst_sample_get_buffer(sample);
     GstMapInfo map;
@@ -914,7 +914,7 @@ bool MediaSourceGStreamer::setState(AkElement::ElementState state)
                         AkCaps subtitlesCaps;
                         subtitlesCaps.isValid() = true;
                         subtitlesCaps.setMimeType("text/x-raw");
-                        subtitlesCaps.setProperty("type", format);
+                        subtitlesCaps.setCapsProperty("type", format);
                         this->d->m_streamInfo << Stream(subtitlesCaps,
                                                         languages[stream]);
                     }
@@ -21,6 +21,8 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
 
 #include "photocopyelement.h"
@@ -93,29 +95,38 @@ AkPacket PhotocopyElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
 
-    for (int y = 0; y < src.height(); y++) {
-        const QRgb *srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *dstLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
+    // Compute the sigmoidal transfer for every luma level.
+    quint8 transfer[256];
 
-        for (int x = 0; x < src.width(); x++) {
-            int r = qRed(srcLine[x]);
-            int g = qGreen(srcLine[x]);
-            int b = qBlue(srcLine[x]);
+    for (int i = 0; i < 256; i++) {
+        qreal val = i / 255.0;
+        val = 255.0 / (1 + exp(this->m_contrast * (0.5 - val)));
+        val = val * this->m_brightness;
+        transfer[i] = quint8(qBound(0.0, val, 255.0));
+    }
+
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-            //desaturate
-            int luma = this->rgbToLuma(r, g, b);
+    AkScheduler::parallelFor(src.height(), 16, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            auto srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+            auto dstLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
 
-            //compute sigmoidal transfer
-            qreal val = luma / 255.0;
-            val = 255.0 / (1 + exp(this->m_contrast * (0.5 - val)));
-            val = val * this->m_brightness;
-            luma = int(qBound(0.0, val, 255.0));
+            for (int x = 0; x < src.width(); x++) {
+                int r = qRed(srcLine[x]);
+                int g = qGreen(srcLine[x]);
+                int b = qBlue(srcLine[x]);
 
-            dstLine[x] = qRgba(luma, luma, luma, qAlpha(srcLine[x]));
+                //desaturate
+                int luma = transfer[this->rgbToLuma(r, g, b)];
+
+                dstLine[x] = qRgba(luma, luma, luma, qAlpha(srcLine[x]));
+            }
         }
-    }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -21,6 +21,7 @@
 #include <QQmlContext>
 #include <akutils.h>
 #include <akpacket.h>
+#include <akvideoscaler.h>
 
 #include "pixelateelement.h"
 
@@ -28,9 +29,11 @@ class PixelateElementPrivate
 {
     public:
         QSize m_blockSize;
+        AkVideoScaler m_scaler;
 
         PixelateElementPrivate():
-            m_blockSize(QSize(8, 8))
+            m_blockSize(QSize(8, 8)),
+            m_scaler(AkVideoScaler::ScalingMode_Nearest)
         {
         }
 };
@@ -97,14 +100,10 @@ AkPacket PixelateElement::iStream(const AkPacket &packet)
     qreal sw = 1.0 / blockSize.width();
     qreal sh = 1.0 / blockSize.height();
 
-    oFrame = oFrame.scaled(int(sw * oFrame.width()),
-                           int(sh * oFrame.height()),
-                           Qt::IgnoreAspectRatio,
-                           Qt::FastTransformation)
-                   .scaled(oFrame.width(),
-                           oFrame.height(),
-                           Qt::IgnoreAspectRatio,
-                           Qt::FastTransformation);
+    QImage blocks = this->d->m_scaler.scale(oFrame,
+                                            int(sw * oFrame.width()),
+                                            int(sh * oFrame.height()));
+    oFrame = this->d->m_scaler.scale(blocks, oFrame.size());
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -20,6 +20,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "primariescolorselement.h"
@@ -72,7 +73,7 @@ AkPacket PrimariesColorsElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     int f = this->m_factor + 1;
     int factor127 = (f * f - 3) * 127;
@@ -20,6 +20,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "quarkelement.h"
@@ -89,7 +90,7 @@ AkPacket QuarkElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_frameSize) {
         this->d->m_frames.clear();
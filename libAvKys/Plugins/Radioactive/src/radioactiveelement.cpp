@@ -21,6 +21,7 @@
 #include <QPainter>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "radioactiveelement.h"
@@ -333,7 +334,7 @@ AkPacket RadioactiveElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_frameSize) {
         this->d->m_blurZoomBuffer = QImage();
@@ -21,6 +21,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akcaps.h>
 #include <akpacket.h>
 
@@ -481,7 +482,7 @@ AkPacket RippleElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (packet.caps() != this->d->m_caps) {
         this->d->m_prevFrame = QImage();
@@ -20,6 +20,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "scanlineselement.h"
@@ -112,7 +113,7 @@ AkPacket ScanLinesElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     int showSize = this->m_showSize;
     int hideSize = this->m_hideSize;
@@ -21,6 +21,7 @@
 #include <QPainter>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "scrollelement.h"
@@ -133,7 +134,7 @@ AkPacket ScrollElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame = QImage(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_curSize) {
         this->d->m_offset = 0.0;
@@ -21,6 +21,8 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
 
 #include "swirlelement.h"
@@ -73,7 +75,7 @@ AkPacket SwirlElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     qreal xScale = 1.0;
     qreal yScale = 1.0;
@@ -88,33 +90,38 @@ AkPacket SwirlElement::iStream(const AkPacket &packet)
 
     qreal degrees = M_PI * this->m_degrees / 180.0;
 
-    for (int y = 0; y < src.height(); y++) {
-        const QRgb *iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-        qreal yDistance = yScale * (y - yCenter);
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-        for (int x = 0; x < src.width(); x++) {
-            qreal xDistance = xScale * (x - xCenter);
-            qreal distance = xDistance * xDistance + yDistance * yDistance;
+    AkScheduler::parallelFor(src.height(), 8, [&] (int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const QRgb *iLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
+            QRgb *oLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
+            qreal yDistance = yScale * (y - yCenter);
 
-            if (distance >= radius * radius)
-                oLine[x] = iLine[x];
-            else {
-                qreal factor = 1.0 - sqrt(distance) / radius;
-                qreal sine = sin(degrees * factor * factor);
-                qreal cosine = cos(degrees * factor * factor);
+            for (int x = 0; x < src.width(); x++) {
+                qreal xDistance = xScale * (x - xCenter);
+                qreal distance = xDistance * xDistance + yDistance * yDistance;
 
-                int xp = int((cosine * xDistance - sine * yDistance) / xScale + xCenter);
-                int yp = int((sine * xDistance + cosine * yDistance) / yScale + yCenter);
+                if (distance >= radius * radius)
+                    oLine[x] = iLine[x];
+                else {
+                    qreal factor = 1.0 - sqrt(distance) / radius;
+                    qreal sine = sin(degrees * factor * factor);
+                    qreal cosine = cos(degrees * factor * factor);
 
-                if (!oFrame.rect().contains(xp, yp))
-                    continue;
+                    int xp = int((cosine * xDistance - sine * yDistance) / xScale + xCenter);
+                    int yp = int((sine * xDistance + cosine * yDistance) / yScale + yCenter);
 
-                const QRgb *line = reinterpret_cast<const QRgb *>(src.constScanLine(yp));
-                oLine[x] = line[xp];
+                    if (!oFrame.rect().contains(xp, yp))
+                        continue;
+
+                    const QRgb *line = reinterpret_cast<const QRgb *>(src.constScanLine(yp));
+                    oLine[x] = line[xp];
+                }
             }
         }
-    }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -17,11 +17,12 @@
  * Web-Site: http://webcamoid.github.io/
  */
 
-#include <QImage>
 #include <QQmlContext>
 #include <QtMath>
-#include <akutils.h>
 #include <akpacket.h>
+#include <akvideopacket.h>
+#include <akpixelview.h>
+#include <akpointoperator.h>
 
 #include "temperatureelement.h"
 
@@ -54,6 +55,28 @@ inline void colorFromTemperature(qreal temperature, qreal *r, qreal *g, qreal *b
         *b = 0.54320679 * qLn(temperature - 10) - 1.1962541;
 }
 
+struct TemperatureFilter
+{
+    qreal m_kr;
+    qreal m_kg;
+    qreal m_kb;
+
+    template<AkVideoCaps::PixelFormat Format>
+    inline void operator ()(const AkConstPixelView<Format> &src,
+                            const AkPixelView<Format> &dst) const
+    {
+        qreal kr = this->m_kr;
+        qreal kg = this->m_kg;
+        qreal kb = this->m_kb;
+
+        src.mapRgb(dst, [kr, kg, kb] (int &r, int &g, int &b) {
+            r = int(kr * r);
+            g = int(kg * g);
+            b = int(kb * b);
+        });
+    }
+};
+
 TemperatureElement::TemperatureElement(): AkElement()
 {
     this->m_temperature = 6500;
@@ -66,6 +89,17 @@ qreal TemperatureElement::temperature() const
     return this->m_temperature;
 }
 
+AkPointOperator TemperatureElement::pointOperator() const
+{
+    qreal matrix[] = {
+        this->m_kr, 0         , 0         , 0,
+        0         , this->m_kg, 0         , 0,
+        0         , 0         , this->m_kb, 0
+    };
+
+    return AkPointOperator::fromMatrix(matrix);
+}
+
 QString TemperatureElement::controlInterfaceProvide(const QString &controlId) const
 {
     Q_UNUSED(controlId)
@@ -100,32 +134,10 @@ void TemperatureElement::resetTemperature()
 
 AkPacket TemperatureElement::iStream(const AkPacket &packet)
 {
-    QImage src = AkUtils::packetToImage(packet);
-
-    if (src.isNull())
-        return AkPacket();
-
-    src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
-
-    for (int y = 0; y < src.height(); y++) {
-        const QRgb *srcLine = reinterpret_cast<const QRgb *>(src.constScanLine(y));
-        QRgb *destLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
-
-        for (int x = 0; x < src.width(); x++) {
-            int r = int(this->m_kr * qRed(srcLine[x]));
-            int g = int(this->m_kg * qGreen(srcLine[x]));
-            int b = int(this->m_kb * qBlue(srcLine[x]));
-
-            r = qBound(0, r, 255);
-            g = qBound(0, g, 255);
-            b = qBound(0, b, 255);
-
-            destLine[x] = qRgba(r, g, b, qAlpha(srcLine[x]));
-        }
-    }
-
-    AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
+    AkPacket oPacket =
+            akPixelMapRgb(packet, TemperatureFilter {this->m_kr,
+                                                     this->m_kg,
+                                                     this->m_kb});
     akSend(oPacket)
 }
 
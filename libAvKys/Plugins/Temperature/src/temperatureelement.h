@@ -35,6 +35,7 @@ class TemperatureElement: public AkElement
         explicit TemperatureElement();
 
         Q_INVOKABLE qreal temperature() const;
+        AkPointOperator pointOperator() const;
 
     private:
         qreal m_temperature;
@@ -383,12 +383,12 @@ QString CaptureDShow::capsDescription(const AkCaps &caps) const
     if (caps.mimeType() != "video/unknown")
         return QString();
 
-    AkFrac fps = caps.property("fps").toString();
+    AkFrac fps = caps.capsProperty("fps").toString();
 
     return QString("%1, %2x%3, %4 FPS")
-                .arg(caps.property("fourcc").toString())
-                .arg(caps.property("width").toString())
-                .arg(caps.property("height").toString())
+                .arg(caps.capsProperty("fourcc").toString())
+                .arg(caps.capsProperty("width").toString())
+                .arg(caps.capsProperty("height").toString())
                 .arg(qRound(fps.value()));
 }
 
@@ -634,11 +634,11 @@ AkCaps CaptureDShowPrivate::capsFromMediaType(const AM_MEDIA_TYPE *mediaType) co
 
     AkCaps videoCaps;
     videoCaps.setMimeType("video/unknown");
-    videoCaps.setProperty("fourcc", fourcc);
-    videoCaps.setProperty("width", int(videoInfoHeader->bmiHeader.biWidth));
-    videoCaps.setProperty("height", int(videoInfoHeader->bmiHeader.biHeight));
+    videoCaps.setCapsProperty("fourcc", fourcc);
+    videoCaps.setCapsProperty("width", int(videoInfoHeader->bmiHeader.biWidth));
+    videoCaps.setCapsProperty("height", int(videoInfoHeader->bmiHeader.biHeight));
     AkFrac fps(TIME_BASE, videoInfoHeader->AvgTimePerFrame);
-    videoCaps.setProperty("fps", fps.toString());
+    videoCaps.setCapsProperty("fps", fps.toString());
 
     return videoCaps;
 }
@@ -1324,7 +1324,7 @@ bool CaptureDShow::init()
 
     this->d->m_id = Ak::id();
     AkCaps caps = this->d->capsFromMediaType(mediaType);
-    this->d->m_timeBase = AkFrac(caps.property("fps").toString()).invert();
+    this->d->m_timeBase = AkFrac(caps.capsProperty("fps").toString()).invert();
 
     if (FAILED(control->Run())) {
         control->Release();
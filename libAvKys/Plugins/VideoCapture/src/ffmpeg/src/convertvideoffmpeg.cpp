@@ -27,6 +27,7 @@
 #include <akvideocaps.h>
 #include <akpacket.h>
 #include <akvideopacket.h>
+#include <aktracer.h>
 
 extern "C"
 {
@@ -255,6 +256,7 @@ bool ConvertVideoFFmpeg::showLog() const
 
 void ConvertVideoFFmpeg::packetEnqueue(const AkPacket &packet)
 {
+    AK_TRACE_PACKET_SCOPE("capture", "ConvertVideoFFmpeg::packetEnqueue", packet);
     this->d->m_packetMutex.lock();
 
     if (this->d->m_packetQueueSize >= this->d->m_maxPacketQueueSize)
@@ -280,7 +282,7 @@ void ConvertVideoFFmpeg::dataEnqueue(AVFrame *frame)
 
 bool ConvertVideoFFmpeg::init(const AkCaps &caps)
 {
-    QString fourcc = caps.property("fourcc").toString();
+    QString fourcc = caps.capsProperty("fourcc").toString();
 
     if (!rawToFF->contains(fourcc)
         && !compressedToFF->contains(fourcc))
@@ -305,9 +307,9 @@ bool ConvertVideoFFmpeg::init(const AkCaps &caps)
 #endif
 
     this->d->m_codecContext->pix_fmt = rawToFF->value(fourcc, AV_PIX_FMT_NONE);
-    this->d->m_codecContext->width = caps.property("width").toInt();
-    this->d->m_codecContext->height = caps.property("height").toInt();
-    this->d->m_fps = caps.property("fps").toString();
+    this->d->m_codecContext->width = caps.capsProperty("width").toInt();
+    this->d->m_codecContext->height = caps.capsProperty("height").toInt();
+    this->d->m_fps = caps.capsProperty("fps").toString();
 #ifdef HAVE_CONTEXTFRAMERATE
     this->d->m_codecContext->framerate.num = int(this->d->m_fps.num());
     this->d->m_codecContext->framerate.den = int(this->d->m_fps.den());
@@ -397,10 +399,14 @@ void ConvertVideoFFmpegPrivate::packetLoop(ConvertVideoFFmpeg *stream)
 
         if (!stream->d->m_packets.isEmpty()) {
             AkPacket packet = stream->d->m_packets.dequeue();
+            AK_TRACE_PACKET_SCOPE("capture", "ConvertVideoFFmpeg::decode", packet);
 
             AVPacket videoPacket;
             av_init_packet(&videoPacket);
-            videoPacket.data = reinterpret_cast<uint8_t *>(packet.buffer().data());
+            // The buffer may wrap a pool buffer, data() would deep copy it,
+            // and the decoder doesn't write to its input.
+            videoPacket.data =
+                    reinterpret_cast<uint8_t *>(const_cast<char *>(packet.buffer().constData()));
             videoPacket.size = packet.buffer().size();
             videoPacket.pts = packet.pts();
 
@@ -533,6 +539,8 @@ void ConvertVideoFFmpegPrivate::processData(const FramePtr &frame)
 
 void ConvertVideoFFmpegPrivate::convert(const FramePtr &frame)
 {
+    AK_TRACE_SCOPE("capture", "ConvertVideoFFmpeg::convert");
+    AK_TRACE_SET_PACKET(this->m_id, frame->pts);
     AVPixelFormat outPixFormat = AV_PIX_FMT_RGB24;
 
     // Initialize rescaling context.
@@ -170,10 +170,10 @@ void ConvertVideoGStreamer::packetEnqueue(const AkPacket &packet)
 
 bool ConvertVideoGStreamer::init(const AkCaps &caps)
 {
-    QString fourcc = caps.property("fourcc").toString();
-    int width = caps.property("width").toInt();
-    int height = caps.property("height").toInt();
-    AkFrac fps = caps.property("fps").toString();
+    QString fourcc = caps.capsProperty("fourcc").toString();
+    int width = caps.capsProperty("width").toInt();
+    int height = caps.capsProperty("height").toInt();
+    AkFrac fps = caps.capsProperty("fps").toString();
 
     AkCaps gstCaps = fourCCToGst->value(fourcc);
     GstCaps *inCaps = nullptr;
@@ -183,9 +183,9 @@ bool ConvertVideoGStreamer::init(const AkCaps &caps)
         || gstCaps.mimeType() == "video/x-pwc1"
         || gstCaps.mimeType() == "video/x-pwc2"
         || gstCaps.mimeType() == "video/x-sonix") {
-        gstCaps.setProperty("width", width);
-        gstCaps.setProperty("height", height);
-        gstCaps.setProperty("framerate", fps.toString());
+        gstCaps.setCapsProperty("width", width);
+        gstCaps.setCapsProperty("height", height);
+        gstCaps.setCapsProperty("framerate", fps.toString());
         inCaps = gst_caps_from_string(gstCaps.toString().toStdString().c_str());
     } else if (!gstCaps.mimeType().isEmpty()) {
         inCaps = gst_caps_from_string(gstCaps.toString().toStdString().c_str());
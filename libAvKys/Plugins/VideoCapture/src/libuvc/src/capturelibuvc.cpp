@@ -291,12 +291,12 @@ QString CaptureLibUVC::capsDescription(const AkCaps &caps) const
     if (caps.mimeType() != "video/unknown")
         return QString();
 
-    AkFrac fps = caps.property("fps").toString();
+    AkFrac fps = caps.capsProperty("fps").toString();
 
     return QString("%1, %2x%3, %4 FPS")
-                .arg(caps.property("fourcc").toString())
-                .arg(caps.property("width").toString())
-                .arg(caps.property("height").toString())
+                .arg(caps.capsProperty("fourcc").toString())
+                .arg(caps.capsProperty("width").toString())
+                .arg(caps.capsProperty("height").toString())
                 .arg(qRound(fps.value()));
 }
 
@@ -660,10 +660,10 @@ void CaptureLibUVCPrivate::frameCallback(uvc_frame *frame, void *userData)
 
     AkCaps caps;
     caps.setMimeType("video/unknown");
-    caps.setProperty("fourcc", fourccToUvc->key(frame->frame_format));
-    caps.setProperty("width", frame->width);
-    caps.setProperty("height", frame->height);
-    caps.setProperty("fps", self->d->m_fps.toString());
+    caps.setCapsProperty("fourcc", fourccToUvc->key(frame->frame_format));
+    caps.setCapsProperty("width", frame->width);
+    caps.setCapsProperty("height", frame->height);
+    caps.setCapsProperty("fps", self->d->m_fps.toString());
 
     QByteArray buffer(reinterpret_cast<const char *>(frame->data),
                        int(frame->data_bytes));
@@ -732,14 +732,14 @@ bool CaptureLibUVC::init()
 
     QVariantList supportedCaps = this->caps(this->d->m_device);
     AkCaps caps = supportedCaps[streams[0]].value<AkCaps>();
-    int fps = qRound(AkFrac(caps.property("fps").toString()).value());
+    int fps = qRound(AkFrac(caps.capsProperty("fps").toString()).value());
 
     uvc_stream_ctrl_t streamCtrl;
     error = uvc_get_stream_ctrl_format_size(this->d->m_deviceHnd,
                                             &streamCtrl,
-                                            fourccToUvc->value(caps.property("fourcc").toString()),
-                                            caps.property("width").toInt(),
-                                            caps.property("height").toInt(),
+                                            fourccToUvc->value(caps.capsProperty("fourcc").toString()),
+                                            caps.capsProperty("width").toInt(),
+                                            caps.capsProperty("height").toInt(),
                                             fps);
 
     if (error != UVC_SUCCESS) {
@@ -956,13 +956,13 @@ void CaptureLibUVC::updateDevices()
             if (!fourccToUvc->contains(fourCC))
                 continue;
 
-            videoCaps.setProperty("fourcc", fourCC);
+            videoCaps.setCapsProperty("fourcc", fourCC);
 
             for (auto description = formatDescription->frame_descs;
                  description;
                  description = description->next) {
-                videoCaps.setProperty("width", description->wWidth);
-                videoCaps.setProperty("height", description->wHeight);
+                videoCaps.setCapsProperty("width", description->wWidth);
+                videoCaps.setCapsProperty("height", description->wHeight);
 
                 if (description->intervals) {
                     int prevInterval = 0;
@@ -972,7 +972,7 @@ void CaptureLibUVC::updateDevices()
                         auto fpsValue = qRound(fps.value());
 
                         if (prevInterval != fpsValue) {
-                            videoCaps.setProperty("fps", fps.toString());
+                            videoCaps.setCapsProperty("fps", fps.toString());
                             devicesCaps[deviceId] << QVariant::fromValue(videoCaps);
                         }
 
@@ -989,7 +989,7 @@ void CaptureLibUVC::updateDevices()
                         auto fpsValue = qRound(fps.value());
 
                         if (prevInterval != fpsValue) {
-                            videoCaps.setProperty("fps", fps.toString());
+                            videoCaps.setCapsProperty("fps", fps.toString());
                             devicesCaps[deviceId] << QVariant::fromValue(videoCaps);
                         }
 
@@ -997,7 +997,7 @@ void CaptureLibUVC::updateDevices()
                     }
                 } else {
                     auto fps = AkFrac(100e5, description->dwDefaultFrameInterval);
-                    videoCaps.setProperty("fps", fps.toString());
+                    videoCaps.setCapsProperty("fps", fps.toString());
                     devicesCaps[deviceId] << QVariant::fromValue(videoCaps);
                 }
             }
@@ -350,12 +350,12 @@ QString CaptureMMF::capsDescription(const AkCaps &caps) const
     if (caps.mimeType() != "video/unknown")
         return QString();
 
-    AkFrac fps = caps.property("fps").toString();
+    AkFrac fps = caps.capsProperty("fps").toString();
 
     return QString("%1, %2x%3, %4 FPS")
-                .arg(caps.property("fourcc").toString())
-                .arg(caps.property("width").toString())
-                .arg(caps.property("height").toString())
+                .arg(caps.capsProperty("fourcc").toString())
+                .arg(caps.capsProperty("width").toString())
+                .arg(caps.capsProperty("height").toString())
                 .arg(qRound(fps.value()));
 }
 
@@ -1089,11 +1089,11 @@ AkCaps CaptureMMFPrivate::capsFromMediaType(IMFMediaType *mediaType) const
 
     AkCaps videoCaps;
     videoCaps.setMimeType("video/unknown");
-    videoCaps.setProperty("fourcc", fourcc);
-    videoCaps.setProperty("width", int(width));
-    videoCaps.setProperty("height", int(height));
+    videoCaps.setCapsProperty("fourcc", fourcc);
+    videoCaps.setCapsProperty("width", int(width));
+    videoCaps.setCapsProperty("height", int(height));
     AkFrac fps(fpsNum, fpsDen);
-    videoCaps.setProperty("fps", fps.toString());
+    videoCaps.setCapsProperty("fps", fps.toString());
 
     return videoCaps;
 }
@@ -27,6 +27,8 @@
 #include <akfrac.h>
 #include <akcaps.h>
 #include <akpacket.h>
+#include <akvideocaps.h>
+#include <akbufferpool.h>
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
@@ -236,12 +238,12 @@ QString CaptureV4L2::capsDescription(const AkCaps &caps) const
     if (caps.mimeType() != "video/unknown")
         return QString();
 
-    AkFrac fps = caps.property("fps").toString();
+    AkFrac fps = caps.capsProperty("fps").toString();
 
     return QString("%1, %2x%3, %4 FPS")
-                .arg(caps.property("fourcc").toString())
-                .arg(caps.property("width").toString())
-                .arg(caps.property("height").toString())
+                .arg(caps.capsProperty("fourcc").toString())
+                .arg(caps.capsProperty("width").toString())
+                .arg(caps.capsProperty("height").toString())
                 .arg(qRound(fps.value()));
 }
 
@@ -462,9 +464,9 @@ QVariantList CaptureV4L2Private::capsFps(int fd,
 
         AkCaps videoCaps;
         videoCaps.setMimeType("video/unknown");
-        videoCaps.setProperty("fourcc", this->fourccToStr(format.pixelformat));
-        videoCaps.setProperty("width", width);
-        videoCaps.setProperty("height", height);
+        videoCaps.setCapsProperty("fourcc", this->fourccToStr(format.pixelformat));
+        videoCaps.setCapsProperty("width", width);
+        videoCaps.setCapsProperty("height", height);
         AkFrac fps;
 
         if (frmival.type == V4L2_FRMIVAL_TYPE_DISCRETE)
@@ -472,7 +474,7 @@ QVariantList CaptureV4L2Private::capsFps(int fd,
         else
             fps = AkFrac(frmival.stepwise.min.denominator, frmival.stepwise.max.numerator);
 
-        videoCaps.setProperty("fps", fps.toString());
+        videoCaps.setCapsProperty("fps", fps.toString());
         caps << QVariant::fromValue(videoCaps);
     }
 #else
@@ -485,11 +487,11 @@ QVariantList CaptureV4L2Private::capsFps(int fd,
 
         AkCaps videoCaps;
         videoCaps.setMimeType("video/unknown");
-        videoCaps.setProperty("fourcc", this->fourccToStr(format.pixelformat));
-        videoCaps.setProperty("width", width);
-        videoCaps.setProperty("height", height);
-        videoCaps.setProperty("fps", AkFrac(standard.frameperiod.denominator,
-                                            standard.frameperiod.numerator).toString());
+        videoCaps.setCapsProperty("fourcc", this->fourccToStr(format.pixelformat));
+        videoCaps.setCapsProperty("width", width);
+        videoCaps.setCapsProperty("height", height);
+        videoCaps.setCapsProperty("fps", AkFrac(standard.frameperiod.denominator,
+                                                standard.frameperiod.numerator).toString());
         caps << QVariant::fromValue(videoCaps);
     }
 #endif
@@ -969,8 +971,21 @@ AkPacket CaptureV4L2Private::processFrame(const char *buffer,
                                           size_t bufferSize,
                                           qint64 pts) const
 {
-    QByteArray oBuffer(buffer, int(bufferSize));
-    AkPacket oPacket(this->m_caps, oBuffer);
+    // The driver buffer is queued again right after this, so the frame must
+    // be copied, but the destination memory is recycled from the pool.
+    AkVideoCaps caps(this->m_caps);
+    auto oBuffer = AkBufferPool::buffer(caps.format(),
+                                        caps.width(),
+                                        caps.height(),
+                                        1,
+                                        int(bufferSize));
+
+    if (!oBuffer)
+        return AkPacket();
+
+    memcpy(oBuffer.data(), buffer, bufferSize);
+    AkPacket oPacket(this->m_caps);
+    oBuffer.attachTo(oPacket);
 
     oPacket.setPts(pts);
     oPacket.setTimeBase(this->m_timeBase);
@@ -1018,9 +1033,9 @@ bool CaptureV4L2::init()
 
     if (this->d->xioctl(this->d->m_fd, VIDIOC_G_FMT, &fmt) == 0) {
         fmt.fmt.pix.pixelformat =
-                this->d->strToFourCC(caps.property("fourcc").toString());
-        fmt.fmt.pix.width = caps.property("width").toUInt();
-        fmt.fmt.pix.height = caps.property("height").toUInt();
+                this->d->strToFourCC(caps.capsProperty("fourcc").toString());
+        fmt.fmt.pix.width = caps.capsProperty("width").toUInt();
+        fmt.fmt.pix.height = caps.capsProperty("height").toUInt();
 
         if (this->d->xioctl(this->d->m_fd, VIDIOC_S_FMT, &fmt) < 0) {
             qDebug() << "VideoCapture: Can't set format:"
@@ -1031,7 +1046,7 @@ bool CaptureV4L2::init()
         }
     }
 
-    this->d->setFps(this->d->m_fd, caps.property("fps").toString());
+    this->d->setFps(this->d->m_fd, caps.capsProperty("fps").toString());
 
     if (this->d->xioctl(this->d->m_fd, VIDIOC_S_FMT, &fmt) < 0) {
         qDebug() << "VideoCapture: Can't set format:"
@@ -1042,7 +1057,7 @@ bool CaptureV4L2::init()
     }
 
     this->d->m_caps = caps;
-    this->d->m_fps = caps.property("fps").toString();
+    this->d->m_fps = caps.capsProperty("fps").toString();
     this->d->m_timeBase = this->d->m_fps.invert();
 
     if (this->d->m_ioMethod == IoMethodReadWrite
@@ -29,6 +29,7 @@
 #include <akcaps.h>
 #include <akfrac.h>
 #include <akpacket.h>
+#include <aktracer.h>
 
 #include "videocaptureelement.h"
 #include "videocaptureglobals.h"
@@ -197,9 +198,9 @@ AkCaps VideoCaptureElement::caps(int stream)
     videoCaps.isValid() = true;
     videoCaps.format() = AkVideoCaps::Format_rgb24;
     videoCaps.bpp() = AkVideoCaps::bitsPerPixel(videoCaps.format());
-    videoCaps.width() = caps.property("width").toInt();
-    videoCaps.height() = caps.property("height").toInt();
-    videoCaps.fps() = caps.property("fps").toString();
+    videoCaps.width() = caps.capsProperty("width").toInt();
+    videoCaps.height() = caps.capsProperty("height").toInt();
+    videoCaps.fps() = caps.capsProperty("fps").toString();
 
     return videoCaps;
 }
@@ -322,7 +323,13 @@ void VideoCaptureElementPrivate::cameraLoop()
                 continue;
             }
 
-            AkPacket packet = this->m_capture->readFrame();
+            AkPacket packet;
+
+            {
+                AK_TRACE_SCOPE("capture", "VideoCapture::readFrame");
+                packet = this->m_capture->readFrame();
+                AK_TRACE_SET_PACKET(packet);
+            }
 
             if (!packet)
                 continue;
@@ -331,7 +338,7 @@ void VideoCaptureElementPrivate::cameraLoop()
                 AkCaps caps = packet.caps();
 
 #ifdef Q_OS_WIN32
-                QString fourcc = caps.property("fourcc").toString();
+                QString fourcc = caps.capsProperty("fourcc").toString();
                 this->m_mirror = mirrorFormats->contains(fourcc);
                 this->m_swapRgb = swapRgbFormats->contains(fourcc);
 #endif
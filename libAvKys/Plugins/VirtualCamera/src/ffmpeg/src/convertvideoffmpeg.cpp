@@ -111,7 +111,7 @@ AkPacket ConvertVideoFFmpeg::convert(const AkPacket &packet, const AkCaps &oCaps
     if (av_image_fill_pointers(reinterpret_cast<uint8_t **>(iFrame.data),
                                iFormat,
                                videoPacket.caps().height(),
-                               reinterpret_cast<uint8_t *>(videoPacket.buffer().data()),
+                               reinterpret_cast<uint8_t *>(const_cast<char *>(videoPacket.buffer().constData())),
                                iFrame.linesize) < 0) {
         return AkPacket();
     }
@@ -20,6 +20,7 @@
 #include <QImage>
 #include <QQmlContext>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "warholelement.h"
@@ -95,7 +96,7 @@ AkPacket WarholElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame = QImage(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     int nFrames = this->d->m_nFrames;
 
     for (int y = 0; y < src.height(); y++) {
@@ -21,6 +21,8 @@
 #include <QQmlContext>
 #include <QtMath>
 #include <akutils.h>
+#include <akbufferpool.h>
+#include <akscheduler.h>
 #include <akpacket.h>
 
 #include "warpelement.h"
@@ -91,7 +93,7 @@ AkPacket WarpElement::iStream(const AkPacket &packet)
         return AkPacket();
 
     src = src.convertToFormat(QImage::Format_ARGB32);
-    QImage oFrame(src.size(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
 
     if (src.size() != this->d->m_frameSize) {
         int cx = src.width() >> 1;
@@ -122,22 +124,27 @@ AkPacket WarpElement::iStream(const AkPacket &packet)
     tval = (tval + 1) & 511;
     qreal *phiTable = this->d->m_phiTable.data();
 
-    for (int y = 0, i = 0; y < src.height(); y++) {
-        auto oLine = reinterpret_cast<QRgb *>(oFrame.scanLine(y));
+    auto oBits = oFrame.bits();
+    int oLineSize = oFrame.bytesPerLine();
 
-        for (int x = 0; x < src.width(); x++, i++) {
-            qreal phi = ripples * phiTable[i];
+    AkScheduler::parallelFor(src.height(), 8, [&] (int begin, int end) {
+        for (int y = begin, i = begin * src.width(); y < end; y++) {
+            auto oLine = reinterpret_cast<QRgb *>(oBits + y * oLineSize);
 
-            int xOrig = int(dx * cos(phi) + x);
-            int yOrig = int(dy * sin(phi) + y);
+            for (int x = 0; x < src.width(); x++, i++) {
+                qreal phi = ripples * phiTable[i];
 
-            xOrig = qBound(0, xOrig, src.width());
-            yOrig = qBound(0, yOrig, src.height());
+                int xOrig = int(dx * cos(phi) + x);
+                int yOrig = int(dy * sin(phi) + y);
 
-            auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(yOrig));
-            oLine[x] = iLine[xOrig];
+                xOrig = qBound(0, xOrig, src.width());
+                yOrig = qBound(0, yOrig, src.height());
+
+                auto iLine = reinterpret_cast<const QRgb *>(src.constScanLine(yOrig));
+                oLine[x] = iLine[xOrig];
+            }
         }
-    }
+    });
 
     AkPacket oPacket = AkUtils::imageToPacket(oFrame, packet);
     akSend(oPacket)
@@ -22,6 +22,7 @@
 #include <QtMath>
 #include <QMutex>
 #include <akutils.h>
+#include <akbufferpool.h>
 #include <akpacket.h>
 
 #include "waveelement.h"
@@ -180,7 +181,7 @@ AkPacket WaveElement::iStream(const AkPacket &packet)
     src = src.convertToFormat(QImage::Format_ARGB32);
     qreal amplitude = this->d->m_amplitude;
 
-    QImage oFrame(src.width(), src.height(), src.format());
+    QImage oFrame = AkBufferPool::image(src.size(), src.format());
     oFrame.fill(this->d->m_background);
 
     if (amplitude <= 0.0)
@@ -110,6 +110,8 @@ SUBDIRS += \
     AkQml \
     Plugins
 
+!isEqual(BUILDBENCHMARKS, 0): SUBDIRS += Benchmarks
+
 # Install rules
 
 INSTALLS += \